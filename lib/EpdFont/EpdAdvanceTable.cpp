@@ -0,0 +1,42 @@
+#include "EpdAdvanceTable.h"
+
+#include <Utf8.h>
+
+#include <cstdlib>
+
+#include "EpdFont.h"
+
+bool EpdAdvanceTable::build(const EpdFont& font) {
+  reset();
+  metrics = static_cast<Metrics*>(malloc(ENTRY_COUNT * sizeof(Metrics)));
+  if (!metrics) {
+    return false;
+  }
+  this->font = &font;
+
+  const EpdGlyph* replacement = font.getGlyph(REPLACEMENT_GLYPH);
+  const auto fill = [&](const uint32_t first, const uint32_t last, const size_t offset) {
+    for (uint32_t cp = first; cp <= last; cp++) {
+      const EpdGlyph* glyph = font.getGlyph(cp);
+      if (!glyph) {
+        glyph = replacement;
+      }
+      Metrics& entry = metrics[offset + cp - first];
+      if (!glyph || glyph->left <= SLOW_PATH || glyph->left > INT8_MAX) {
+        entry = {0, 0, SLOW_PATH};
+      } else {
+        entry = {glyph->advanceX, glyph->width, static_cast<int8_t>(glyph->left)};
+      }
+    }
+  };
+  fill(LATIN_FIRST, LATIN_LAST, 0);
+  fill(CYRILLIC_FIRST, CYRILLIC_LAST, CYRILLIC_OFFSET);
+  fill(PUNCTUATION_FIRST, PUNCTUATION_LAST, PUNCTUATION_OFFSET);
+  return true;
+}
+
+void EpdAdvanceTable::reset() {
+  free(metrics);
+  metrics = nullptr;
+  font = nullptr;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+class EpdFont;
+
+// Dense glyph metrics for the Latin, Cyrillic and general punctuation blocks of one font. Measuring text in those
+// scripts becomes an array index per code point instead of a binary search over the font's unicode intervals.
+class EpdAdvanceTable {
+ public:
+  struct Metrics {
+    uint8_t advanceX;
+    uint8_t width;
+    int8_t left;  // SLOW_PATH if the glyph has to go through EpdFont::getGlyph
+  };
+  static constexpr int8_t SLOW_PATH = INT8_MIN;
+
+  EpdAdvanceTable() = default;
+  ~EpdAdvanceTable() { reset(); }
+  EpdAdvanceTable(const EpdAdvanceTable&) = delete;
+  EpdAdvanceTable& operator=(const EpdAdvanceTable&) = delete;
+
+  bool build(const EpdFont& font);
+  void reset();
+  const EpdFont* getFont() const { return font; }
+  static size_t memoryUsage() { return ENTRY_COUNT * sizeof(Metrics); }
+
+  // Metrics for the code point, nullptr if the table doesn't cover it
+  const Metrics* lookup(const uint32_t cp) const {
+    if (cp >= LATIN_FIRST && cp <= LATIN_LAST) {
+      return &metrics[cp - LATIN_FIRST];
+    }
+    if (cp >= CYRILLIC_FIRST && cp <= CYRILLIC_LAST) {
+      return &metrics[CYRILLIC_OFFSET + cp - CYRILLIC_FIRST];
+    }
+    if (cp >= PUNCTUATION_FIRST && cp <= PUNCTUATION_LAST) {
+      return &metrics[PUNCTUATION_OFFSET + cp - PUNCTUATION_FIRST];
+    }
+    return nullptr;
+  }
+
+ private:
+  // Basic Latin through Latin Extended-A, all of Cyrillic, and dashes/quotes/bullets/ellipsis
+  static constexpr uint32_t LATIN_FIRST = 0x20, LATIN_LAST = 0x17F;
+  static constexpr uint32_t CYRILLIC_FIRST = 0x400, CYRILLIC_LAST = 0x4FF;
+  static constexpr uint32_t PUNCTUATION_FIRST = 0x2010, PUNCTUATION_LAST = 0x203A;
+  static constexpr size_t CYRILLIC_OFFSET = LATIN_LAST - LATIN_FIRST + 1;
+  static constexpr size_t PUNCTUATION_OFFSET = CYRILLIC_OFFSET + CYRILLIC_LAST - CYRILLIC_FIRST + 1;
+  static constexpr size_t ENTRY_COUNT = PUNCTUATION_OFFSET + PUNCTUATION_LAST - PUNCTUATION_FIRST + 1;
+
+  const EpdFont* font = nullptr;
+  Metrics* metrics = nullptr;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Print.h>
+#include <ZipFile.h>
 
 #include <memory>
 #include <string>
@@ -9,8 +10,6 @@
 
 #include "Epub/BookMetadataCache.h"
 
-class ZipFile;
-
 class Epub {
   // the ncx file (EPUB 2)
   std::string tocNcxItem;
@@ -24,6 +23,8 @@ class Epub {
   std::string cachePath;
   // Spine and TOC cache
   std::unique_ptr<BookMetadataCache> bookMetadataCache;
+  // Zip session kept open while the book is, so chapter loads don't reopen the file and re-parse the archive
+  mutable std::unique_ptr<ZipFile> zip;
 
   bool findContentOpfFile(std::string* contentOpfFile) const;
   bool parseContentOpf(BookMetadataCache::BookMetadata& bookMetadata);
@@ -35,12 +36,17 @@ class Epub {
     // create a cache key based on the filepath
     cachePath = cacheDir + "/epub_" + std::to_string(std::hash<std::string>{}(this->filepath));
   }
-  ~Epub() = default;
+  ~Epub();
   std::string& getBasePath() { return contentBasePath; }
   bool load(bool buildIfMissing = true);
   bool clearCache() const;
   void setupCacheDir() const;
   const std::string& getCachePath() const;
+  // Sorted central directory index of the EPUB zip, built on first lookup
+  std::string getZipIndexPath() const;
+  // The book's long-lived zip session, opened on first use. Not thread safe: callers streaming from it on another
+  // task (e.g. section builds) must hold the same lock as everyone else reading the book.
+  ZipFile& getZip() const;
   const std::string& getPath() const;
   const std::string& getTitle() const;
   const std::string& getAuthor() const;
@@ -55,6 +61,8 @@ class Epub {
   bool getItemSize(const std::string& itemHref, size_t* size) const;
   BookMetadataCache::SpineEntry getSpineItem(int spineIndex) const;
   BookMetadataCache::TocEntry getTocItem(int tocIndex) const;
+  // Same as getTocItem(tocIndex).title, but memoized so per-page callers don't read the SD card
+  std::string getTocTitle(int tocIndex) const;
   int getSpineItemsCount() const;
   int getTocItemsCount() const;
   int getSpineIndexForTocIndex(int tocIndex) const;
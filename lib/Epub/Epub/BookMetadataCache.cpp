@@ -1,6 +1,7 @@
 #include "BookMetadataCache.h"
 
 #include <HardwareSerial.h>
+#include <HeapWatch.h>
 #include <Serialization.h>
 #include <ZipFile.h>
 
@@ -29,10 +30,15 @@ bool BookMetadataCache::beginContentOpfPass() {
   Serial.printf("[%lu] [BMC] Beginning content opf pass\n", millis());
 
   // Open spine file for writing
-  return SdMan.openFileForWrite("BMC", cachePath + tmpSpineBinFile, spineFile);
+  if (!SdMan.openFileForWrite("BMC", cachePath + tmpSpineBinFile, spineFile)) {
+    return false;
+  }
+  spineWriter.reset(new serialization::BufferedFileWriter(spineFile));
+  return true;
 }
 
 bool BookMetadataCache::endContentOpfPass() {
+  spineWriter.reset();
   spineFile.close();
   return true;
 }
@@ -47,13 +53,15 @@ bool BookMetadataCache::beginTocPass() {
     spineFile.close();
     return false;
   }
+  spineReader.reset(new serialization::BufferedFileReader(spineFile));
+  tocWriter.reset(new serialization::BufferedFileWriter(tocFile));
 
   if (spineCount >= LARGE_SPINE_THRESHOLD) {
     spineHrefIndex.clear();
     spineHrefIndex.reserve(spineCount);
-    spineFile.seek(0);
+    spineReader->seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto entry = readSpineEntry(spineFile);
+      auto entry = readSpineEntry(*spineReader);
       SpineHrefIndexEntry idx;
       idx.hrefHash = fnvHash64(entry.href);
       idx.hrefLen = static_cast<uint16_t>(entry.href.size());
@@ -64,7 +72,7 @@ bool BookMetadataCache::beginTocPass() {
               [](const SpineHrefIndexEntry& a, const SpineHrefIndexEntry& b) {
                 return a.hrefHash < b.hrefHash || (a.hrefHash == b.hrefHash && a.hrefLen < b.hrefLen);
               });
-    spineFile.seek(0);
+    spineReader->seek(0);
     useSpineHrefIndex = true;
     Serial.printf("[%lu] [BMC] Using fast index for %d spine items\n", millis(), spineCount);
   } else {
@@ -75,6 +83,8 @@ bool BookMetadataCache::beginTocPass() {
 }
 
 bool BookMetadataCache::endTocPass() {
+  tocWriter.reset();
+  spineReader.reset();
   tocFile.close();
   spineFile.close();
 
@@ -96,7 +106,7 @@ bool BookMetadataCache::endWrite() {
   return true;
 }
 
-bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMetadata& metadata) {
+bool BookMetadataCache::buildBookBin(ZipFile& zip, const BookMetadata& metadata) {
   // Open all three files, writing to meta, reading from spine and toc
   if (!SdMan.openFileForWrite("BMC", cachePath + bookBinFile, bookFile)) {
     return false;
@@ -113,6 +123,11 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     return false;
   }
 
+  // On the heap: three sector buffers are a lot for the stack of the task opening the book
+  std::unique_ptr<serialization::BufferedFileWriter> book(new serialization::BufferedFileWriter(bookFile));
+  std::unique_ptr<serialization::BufferedFileReader> spine(new serialization::BufferedFileReader(spineFile));
+  std::unique_ptr<serialization::BufferedFileReader> toc(new serialization::BufferedFileReader(tocFile));
+
   constexpr uint32_t headerASize =
       sizeof(BOOK_CACHE_VERSION) + /* LUT Offset */ sizeof(uint32_t) + sizeof(spineCount) + sizeof(tocCount);
   const uint32_t metadataSize = metadata.title.size() + metadata.author.size() + metadata.language.size() +
@@ -122,31 +137,31 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
   const uint32_t lutOffset = headerASize + metadataSize;
 
   // Header A
-  serialization::writePod(bookFile, BOOK_CACHE_VERSION);
-  serialization::writePod(bookFile, lutOffset);
-  serialization::writePod(bookFile, spineCount);
-  serialization::writePod(bookFile, tocCount);
+  serialization::writePod(*book, BOOK_CACHE_VERSION);
+  serialization::writePod(*book, lutOffset);
+  serialization::writePod(*book, spineCount);
+  serialization::writePod(*book, tocCount);
   // Metadata
-  serialization::writeString(bookFile, metadata.title);
-  serialization::writeString(bookFile, metadata.author);
-  serialization::writeString(bookFile, metadata.language);
-  serialization::writeString(bookFile, metadata.coverItemHref);
-  serialization::writeString(bookFile, metadata.textReferenceHref);
+  serialization::writeString(*book, metadata.title);
+  serialization::writeString(*book, metadata.author);
+  serialization::writeString(*book, metadata.language);
+  serialization::writeString(*book, metadata.coverItemHref);
+  serialization::writeString(*book, metadata.textReferenceHref);
 
   // Loop through spine entries, writing LUT positions
-  spineFile.seek(0);
+  spine->seek(0);
   for (int i = 0; i < spineCount; i++) {
-    uint32_t pos = spineFile.position();
-    auto spineEntry = readSpineEntry(spineFile);
-    serialization::writePod(bookFile, pos + lutOffset + lutSize);
+    uint32_t pos = spine->position();
+    auto spineEntry = readSpineEntry(*spine);
+    serialization::writePod(*book, pos + lutOffset + lutSize);
   }
 
   // Loop through toc entries, writing LUT positions
-  tocFile.seek(0);
+  toc->seek(0);
   for (int i = 0; i < tocCount; i++) {
-    uint32_t pos = tocFile.position();
-    auto tocEntry = readTocEntry(tocFile);
-    serialization::writePod(bookFile, pos + lutOffset + lutSize + static_cast<uint32_t>(spineFile.position()));
+    uint32_t pos = toc->position();
+    auto tocEntry = readTocEntry(*toc);
+    serialization::writePod(*book, pos + lutOffset + lutSize + spine->position());
   }
 
   // LUTs complete
@@ -154,9 +169,9 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
 
   // Build spineIndex->tocIndex mapping in one pass (O(n) instead of O(n*m))
   std::vector<int16_t> spineToTocIndex(spineCount, -1);
-  tocFile.seek(0);
+  toc->seek(0);
   for (int j = 0; j < tocCount; j++) {
-    auto tocEntry = readTocEntry(tocFile);
+    auto tocEntry = readTocEntry(*toc);
     if (tocEntry.spineIndex >= 0 && tocEntry.spineIndex < spineCount) {
       if (spineToTocIndex[tocEntry.spineIndex] == -1) {
         spineToTocIndex[tocEntry.spineIndex] = static_cast<int16_t>(j);
@@ -164,22 +179,20 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     }
   }
 
-  ZipFile zip(epubPath);
-  // Pre-open zip file to speed up size calculations
-  if (!zip.open()) {
+  // Pre-open zip file to speed up size calculations (it is usually the book's session and already open)
+  const bool wasOpen = zip.isOpen();
+  if (!wasOpen && !zip.open()) {
     Serial.printf("[%lu] [BMC] Could not open EPUB zip for size calculations\n", millis());
     bookFile.close();
     spineFile.close();
     tocFile.close();
     return false;
   }
-  // NOTE: We intentionally skip calling loadAllFileStatSlims() here.
-  // For large EPUBs (2000+ chapters), pre-loading all ZIP central directory entries
-  // into memory causes OOM crashes on ESP32-C3's limited ~380KB RAM.
-  // Instead, for large books we use a one-pass batch lookup that scans the ZIP
-  // central directory once and matches against spine targets using hash comparison.
-  // This is O(n*log(m)) instead of O(n*m) while avoiding memory exhaustion.
-  // See: https://github.com/crosspoint-reader/crosspoint-reader/issues/134
+  // NOTE: Pre-loading all ZIP central directory entries into memory causes OOM crashes on ESP32-C3's limited ~380KB
+  // RAM for large EPUBs (2000+ chapters), see https://github.com/crosspoint-reader/crosspoint-reader/issues/134.
+  // Single lookups go through the on-disk central directory index (O(log n) small reads each). For large books we
+  // still use a one-pass batch lookup that scans the central directory once and matches against spine targets using
+  // hash comparison, which beats thousands of separate binary searches.
 
   std::vector<uint32_t> spineSizes;
   bool useBatchSizes = false;
@@ -190,9 +203,9 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     std::vector<ZipFile::SizeTarget> targets;
     targets.reserve(spineCount);
 
-    spineFile.seek(0);
+    spine->seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto entry = readSpineEntry(spineFile);
+      auto entry = readSpineEntry(*spine);
       std::string path = FsHelpers::normalisePath(entry.href);
 
       ZipFile::SizeTarget t;
@@ -217,10 +230,11 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
   }
 
   uint32_t cumSize = 0;
-  spineFile.seek(0);
+  spine->seek(0);
   int lastSpineTocIndex = -1;
+  heapwatch::sample();  // The spine and TOC tables are all allocated by now
   for (int i = 0; i < spineCount; i++) {
-    auto spineEntry = readSpineEntry(spineFile);
+    auto spineEntry = readSpineEntry(*spine);
 
     spineEntry.tocIndex = spineToTocIndex[i];
 
@@ -254,22 +268,29 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     spineEntry.cumulativeSize = cumSize;
 
     // Write out spine data to book.bin
-    writeSpineEntry(bookFile, spineEntry);
+    writeSpineEntry(*book, spineEntry);
   }
   // Close opened zip file
-  zip.close();
+  if (!wasOpen) {
+    zip.close();
+  }
 
   // Loop through toc entries from toc file writing to book.bin
-  tocFile.seek(0);
+  toc->seek(0);
   for (int i = 0; i < tocCount; i++) {
-    auto tocEntry = readTocEntry(tocFile);
-    writeTocEntry(bookFile, tocEntry);
+    auto tocEntry = readTocEntry(*toc);
+    writeTocEntry(*book, tocEntry);
   }
 
+  const bool written = book->flush();
   bookFile.close();
   spineFile.close();
   tocFile.close();
 
+  if (!written) {
+    Serial.printf("[%lu] [BMC] Failed to write book.bin\n", millis());
+    return false;
+  }
   Serial.printf("[%lu] [BMC] Successfully built book.bin\n", millis());
   return true;
 }
@@ -284,40 +305,36 @@ bool BookMetadataCache::cleanupTmpFiles() const {
   return true;
 }
 
-uint32_t BookMetadataCache::writeSpineEntry(FsFile& file, const SpineEntry& entry) const {
-  const uint32_t pos = file.position();
-  serialization::writeString(file, entry.href);
-  serialization::writePod(file, entry.cumulativeSize);
-  serialization::writePod(file, entry.tocIndex);
-  return pos;
+void BookMetadataCache::writeSpineEntry(serialization::BufferedFileWriter& writer, const SpineEntry& entry) const {
+  serialization::writeString(writer, entry.href);
+  serialization::writePod(writer, entry.cumulativeSize);
+  serialization::writePod(writer, entry.tocIndex);
 }
 
-uint32_t BookMetadataCache::writeTocEntry(FsFile& file, const TocEntry& entry) const {
-  const uint32_t pos = file.position();
-  serialization::writeString(file, entry.title);
-  serialization::writeString(file, entry.href);
-  serialization::writeString(file, entry.anchor);
-  serialization::writePod(file, entry.level);
-  serialization::writePod(file, entry.spineIndex);
-  return pos;
+void BookMetadataCache::writeTocEntry(serialization::BufferedFileWriter& writer, const TocEntry& entry) const {
+  serialization::writeString(writer, entry.title);
+  serialization::writeString(writer, entry.href);
+  serialization::writeString(writer, entry.anchor);
+  serialization::writePod(writer, entry.level);
+  serialization::writePod(writer, entry.spineIndex);
 }
 
 // Note: for the LUT to be accurate, this **MUST** be called for all spine items before `addTocEntry` is ever called
 // this is because in this function we're marking positions of the items
 void BookMetadataCache::createSpineEntry(const std::string& href) {
-  if (!buildMode || !spineFile) {
+  if (!buildMode || !spineWriter) {
     Serial.printf("[%lu] [BMC] createSpineEntry called but not in build mode\n", millis());
     return;
   }
 
   const SpineEntry entry(href, 0, -1);
-  writeSpineEntry(spineFile, entry);
+  writeSpineEntry(*spineWriter, entry);
   spineCount++;
 }
 
 void BookMetadataCache::createTocEntry(const std::string& title, const std::string& href, const std::string& anchor,
                                        const uint8_t level) {
-  if (!buildMode || !tocFile || !spineFile) {
+  if (!buildMode || !tocWriter || !spineReader) {
     Serial.printf("[%lu] [BMC] createTocEntry called but not in build mode\n", millis());
     return;
   }
@@ -343,9 +360,9 @@ void BookMetadataCache::createTocEntry(const std::string& title, const std::stri
       Serial.printf("[%lu] [BMC] createTocEntry: Could not find spine item for TOC href %s\n", millis(), href.c_str());
     }
   } else {
-    spineFile.seek(0);
+    spineReader->seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto spineEntry = readSpineEntry(spineFile);
+      auto spineEntry = readSpineEntry(*spineReader);
       if (spineEntry.href == href) {
         spineIndex = static_cast<int16_t>(i);
         break;
@@ -357,7 +374,7 @@ void BookMetadataCache::createTocEntry(const std::string& title, const std::stri
   }
 
   const TocEntry entry(title, href, anchor, level, spineIndex);
-  writeTocEntry(tocFile, entry);
+  writeTocEntry(*tocWriter, entry);
   tocCount++;
 }
 
@@ -368,23 +385,37 @@ bool BookMetadataCache::load() {
     return false;
   }
 
+  serialization::BufferedFileReader reader(bookFile);
   uint8_t version;
-  serialization::readPod(bookFile, version);
+  serialization::readPod(reader, version);
   if (version != BOOK_CACHE_VERSION) {
     Serial.printf("[%lu] [BMC] Cache version mismatch: expected %d, got %d\n", millis(), BOOK_CACHE_VERSION, version);
     bookFile.close();
     return false;
   }
 
-  serialization::readPod(bookFile, lutOffset);
-  serialization::readPod(bookFile, spineCount);
-  serialization::readPod(bookFile, tocCount);
+  serialization::readPod(reader, lutOffset);
+  serialization::readPod(reader, spineCount);
+  serialization::readPod(reader, tocCount);
+
+  serialization::readString(reader, coreMetadata.title);
+  serialization::readString(reader, coreMetadata.author);
+  serialization::readString(reader, coreMetadata.language);
+  serialization::readString(reader, coreMetadata.coverItemHref);
+  serialization::readString(reader, coreMetadata.textReferenceHref);
 
-  serialization::readString(bookFile, coreMetadata.title);
-  serialization::readString(bookFile, coreMetadata.author);
-  serialization::readString(bookFile, coreMetadata.language);
-  serialization::readString(bookFile, coreMetadata.coverItemHref);
-  serialization::readString(bookFile, coreMetadata.textReferenceHref);
+  // Spine entries follow the LUTs back to back, one sequential read fills the RAM table
+  spineCumulativeSizes.resize(spineCount);
+  spineTocIndexes.resize(spineCount);
+  reader.seek(lutOffset + sizeof(uint32_t) * spineCount + sizeof(uint32_t) * tocCount);
+  for (int i = 0; i < spineCount; i++) {
+    const auto entry = readSpineEntry(reader);
+    spineCumulativeSizes[i] = static_cast<uint32_t>(entry.cumulativeSize);
+    spineTocIndexes[i] = entry.tocIndex;
+  }
+  for (auto& memo : tocTitleMemo) {
+    memo.tocIndex = -1;
+  }
 
   loaded = true;
   Serial.printf("[%lu] [BMC] Loaded cache data: %d spine, %d TOC entries\n", millis(), spineCount, tocCount);
@@ -407,7 +438,8 @@ BookMetadataCache::SpineEntry BookMetadataCache::getSpineEntry(const int index)
   uint32_t spineEntryPos;
   serialization::readPod(bookFile, spineEntryPos);
   bookFile.seek(spineEntryPos);
-  return readSpineEntry(bookFile);
+  serialization::BufferedFileReader reader(bookFile);
+  return readSpineEntry(reader);
 }
 
 BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
@@ -426,23 +458,54 @@ BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
   uint32_t tocEntryPos;
   serialization::readPod(bookFile, tocEntryPos);
   bookFile.seek(tocEntryPos);
-  return readTocEntry(bookFile);
+  serialization::BufferedFileReader reader(bookFile);
+  return readTocEntry(reader);
+}
+
+uint32_t BookMetadataCache::getCumulativeSize(const int index) const {
+  if (index < 0 || index >= static_cast<int>(spineCumulativeSizes.size())) {
+    Serial.printf("[%lu] [BMC] getCumulativeSize index %d out of range\n", millis(), index);
+    return 0;
+  }
+  return spineCumulativeSizes[index];
+}
+
+int16_t BookMetadataCache::getSpineTocIndex(const int index) const {
+  if (index < 0 || index >= static_cast<int>(spineTocIndexes.size())) {
+    Serial.printf("[%lu] [BMC] getSpineTocIndex index %d out of range\n", millis(), index);
+    return -1;
+  }
+  return spineTocIndexes[index];
+}
+
+const std::string& BookMetadataCache::getTocTitle(const int index) {
+  for (const auto& memo : tocTitleMemo) {
+    if (memo.tocIndex == index && index >= 0) {
+      return memo.title;
+    }
+  }
+
+  TocTitleMemo& memo = tocTitleMemo[nextTocTitleMemo];
+  nextTocTitleMemo = (nextTocTitleMemo + 1) % TOC_TITLE_MEMO_SIZE;
+  memo.title = getTocEntry(index).title;
+  memo.tocIndex = static_cast<int16_t>(index);
+  return memo.title;
 }
 
-BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(FsFile& file) const {
+BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(serialization::BufferedFileReader& reader) const {
   SpineEntry entry;
-  serialization::readString(file, entry.href);
-  serialization::readPod(file, entry.cumulativeSize);
-  serialization::readPod(file, entry.tocIndex);
+  serialization::readString(reader, entry.href);
+  serialization::readPod(reader, entry.cumulativeSize);
+  serialization::readPod(reader, entry.tocIndex);
   return entry;
 }
 
-BookMetadataCache::TocEntry BookMetadataCache::readTocEntry(FsFile& file) const {
+BookMetadataCache::TocEntry BookMetadataCache::readTocEntry(serialization::BufferedFileReader& reader) const {
   TocEntry entry;
-  serialization::readString(file, entry.title);
-  serialization::readString(file, entry.href);
-  serialization::readString(file, entry.anchor);
-  serialization::readPod(file, entry.level);
-  serialization::readPod(file, entry.spineIndex);
+  serialization::readString(reader, entry.title);
+  serialization::readString(reader, entry.href);
+  serialization::readString(reader, entry.anchor);
+  serialization::readPod(reader, entry.level);
+  serialization::readPod(reader, entry.spineIndex);
   return entry;
 }
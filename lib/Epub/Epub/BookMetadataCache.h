@@ -1,11 +1,15 @@
 #pragma once
 
+#include <BufferedFile.h>
 #include <SDCardManager.h>
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
+class ZipFile;
+
 class BookMetadataCache {
  public:
   struct BookMetadata {
@@ -44,16 +48,19 @@ class BookMetadataCache {
 
  private:
   std::string cachePath;
-  size_t lutOffset;
+  uint32_t lutOffset;  // Stored as 4 bytes in book.bin
   uint16_t spineCount;
   uint16_t tocCount;
   bool loaded;
   bool buildMode;
 
   FsFile bookFile;
-  // Temp file handles during build
+  // Temp file handles during build, written and scanned through sector-sized buffers
   FsFile spineFile;
   FsFile tocFile;
+  std::unique_ptr<serialization::BufferedFileWriter> spineWriter;
+  std::unique_ptr<serialization::BufferedFileReader> spineReader;
+  std::unique_ptr<serialization::BufferedFileWriter> tocWriter;
 
   // Index for fast href→spineIndex lookup (used only for large EPUBs)
   struct SpineHrefIndexEntry {
@@ -64,6 +71,20 @@ class BookMetadataCache {
   std::vector<SpineHrefIndexEntry> spineHrefIndex;
   bool useSpineHrefIndex = false;
 
+  // Href-less copy of the spine kept in RAM after load (6 bytes per item), so progress and chapter lookups done on
+  // every page render don't go to the SD card
+  std::vector<uint32_t> spineCumulativeSizes;
+  std::vector<int16_t> spineTocIndexes;
+
+  // TOC titles read on demand, the last few are kept (the status bar asks for the same one on every page)
+  struct TocTitleMemo {
+    int16_t tocIndex = -1;
+    std::string title;
+  };
+  static constexpr size_t TOC_TITLE_MEMO_SIZE = 4;
+  TocTitleMemo tocTitleMemo[TOC_TITLE_MEMO_SIZE];
+  uint8_t nextTocTitleMemo = 0;
+
   static constexpr uint16_t LARGE_SPINE_THRESHOLD = 400;
 
   // FNV-1a 64-bit hash function
@@ -76,10 +97,10 @@ class BookMetadataCache {
     return hash;
   }
 
-  uint32_t writeSpineEntry(FsFile& file, const SpineEntry& entry) const;
-  uint32_t writeTocEntry(FsFile& file, const TocEntry& entry) const;
-  SpineEntry readSpineEntry(FsFile& file) const;
-  TocEntry readTocEntry(FsFile& file) const;
+  void writeSpineEntry(serialization::BufferedFileWriter& writer, const SpineEntry& entry) const;
+  void writeTocEntry(serialization::BufferedFileWriter& writer, const TocEntry& entry) const;
+  SpineEntry readSpineEntry(serialization::BufferedFileReader& reader) const;
+  TocEntry readTocEntry(serialization::BufferedFileReader& reader) const;
 
  public:
   BookMetadata coreMetadata;
@@ -100,12 +121,17 @@ class BookMetadataCache {
   bool cleanupTmpFiles() const;
 
   // Post-processing to update mappings and sizes
-  bool buildBookBin(const std::string& epubPath, const BookMetadata& metadata);
+  bool buildBookBin(ZipFile& zip, const BookMetadata& metadata);
 
   // Reading phase (read mode)
   bool load();
   SpineEntry getSpineEntry(int index);
   TocEntry getTocEntry(int index);
+  // RAM-only counterparts of getSpineEntry(index).cumulativeSize / .tocIndex
+  uint32_t getCumulativeSize(int index) const;
+  int16_t getSpineTocIndex(int index) const;
+  // getTocEntry(index).title, memoized
+  const std::string& getTocTitle(int index);
   int getSpineCount() const { return spineCount; }
   int getTocCount() const { return tocCount; }
   bool isLoaded() const { return loaded; }
@@ -0,0 +1,145 @@
+#include "BookPageIndex.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+#include <Trace.h>
+
+#include <algorithm>
+
+#include "../Epub.h"
+#include "Section.h"
+
+namespace {
+constexpr uint8_t PAGE_INDEX_FILE_VERSION = 1;
+constexpr char PAGE_INDEX_FILE[] = "/pages.bin";
+}  // namespace
+
+BookPageIndex::BookPageIndex(std::shared_ptr<Epub> epub, std::string profileDir)
+    : epub(std::move(epub)), profileDir(std::move(profileDir)) {
+  reset();
+}
+
+void BookPageIndex::reset() {
+  pageCounts.assign(epub->getSpineItemsCount(), UNKNOWN);
+  missing = static_cast<int>(pageCounts.size());
+  startPages.clear();
+  updateStartPages();
+}
+
+bool BookPageIndex::load() {
+  reset();
+  FsFile file;
+  if (!SdMan.openFileForRead("BPI", profileDir + PAGE_INDEX_FILE, file)) {
+    return false;
+  }
+  uint8_t version = 0;
+  uint16_t count = 0;
+  serialization::readPod(file, version);
+  serialization::readPod(file, count);
+  if (version != PAGE_INDEX_FILE_VERSION || count != pageCounts.size()) {
+    file.close();
+    Serial.printf("[%lu] [BPI] Page index does not match the book, starting over\n", millis());
+    return false;
+  }
+  const int bytes = count * sizeof(uint16_t);
+  const bool ok = file.read(reinterpret_cast<uint8_t*>(pageCounts.data()), bytes) == bytes;
+  file.close();
+  if (!ok) {
+    reset();
+    return false;
+  }
+  missing = 0;
+  for (const auto pageCount : pageCounts) {
+    missing += pageCount == UNKNOWN;
+  }
+  updateStartPages();
+  return true;
+}
+
+bool BookPageIndex::save() const {
+  FsFile file;
+  if (!SdMan.openFileForWrite("BPI", profileDir + PAGE_INDEX_FILE, file)) {
+    return false;
+  }
+  serialization::writePod(file, PAGE_INDEX_FILE_VERSION);
+  serialization::writePod(file, static_cast<uint16_t>(pageCounts.size()));
+  const size_t bytes = pageCounts.size() * sizeof(uint16_t);
+  const bool ok = file.write(reinterpret_cast<const uint8_t*>(pageCounts.data()), bytes) == bytes;
+  file.close();
+  return ok;
+}
+
+void BookPageIndex::updateStartPages() {
+  if (missing != 0) {
+    return;
+  }
+  startPages.resize(pageCounts.size() + 1);
+  startPages[0] = 0;
+  for (size_t i = 0; i < pageCounts.size(); i++) {
+    startPages[i + 1] = startPages[i] + pageCounts[i];
+  }
+}
+
+bool BookPageIndex::record(const int spineIndex, const uint16_t pageCount) {
+  if (spineIndex < 0 || spineIndex >= static_cast<int>(pageCounts.size()) || pageCount == UNKNOWN ||
+      pageCounts[spineIndex] == pageCount) {
+    return true;
+  }
+  missing -= pageCounts[spineIndex] == UNKNOWN;
+  pageCounts[spineIndex] = pageCount;
+  updateStartPages();
+  if (missing == 0) {
+    Serial.printf("[%lu] [BPI] Page index complete: %lu pages\n", millis(), static_cast<unsigned long>(totalPages()));
+  }
+  return save();
+}
+
+int BookPageIndex::firstMissing() const {
+  if (missing == 0) {
+    return -1;
+  }
+  for (size_t i = 0; i < pageCounts.size(); i++) {
+    if (pageCounts[i] == UNKNOWN) return static_cast<int>(i);
+  }
+  return -1;
+}
+
+uint32_t BookPageIndex::pagesBefore(const int spineIndex) const {
+  if (startPages.empty() || spineIndex < 0) {
+    return 0;
+  }
+  return startPages[std::min(static_cast<size_t>(spineIndex), startPages.size() - 1)];
+}
+
+bool BookPageIndex::indexNextChapter(GfxRenderer& renderer, const int fontId, const float lineCompression,
+                                     const bool extraParagraphSpacing, const uint8_t paragraphAlignment,
+                                     const uint16_t viewportWidth, const uint16_t viewportHeight,
+                                     const bool hyphenationEnabled, const std::function<bool()>& abortFn) {
+  const int spineIndex = firstMissing();
+  if (spineIndex < 0) {
+    return false;
+  }
+
+  Section section(epub, spineIndex, renderer);
+  const bool loaded = section.loadSectionFile(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment,
+                                              viewportWidth, viewportHeight, hyphenationEnabled);
+  if (section.getProfileDir() != profileDir) {
+    return false;
+  }
+  if (loaded) {
+    return record(spineIndex, section.pageCount);
+  }
+
+  trace::Scope span(trace::Span::PAGE_INDEX, spineIndex);
+  if (section.createSectionFile(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                                viewportHeight, hyphenationEnabled, nullptr, nullptr, abortFn)) {
+    return record(spineIndex, section.pageCount);
+  }
+  if (abortFn && abortFn()) {
+    return false;
+  }
+  // A chapter that won't build counts as no pages rather than holding up the rest of the index
+  Serial.printf("[%lu] [BPI] Could not index spine index %d\n", millis(), spineIndex);
+  return record(spineIndex, 0);
+}
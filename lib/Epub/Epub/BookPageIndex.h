@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Epub;
+class GfxRenderer;
+
+// Page count of every chapter of a book for one layout profile, so the reader can number pages across the whole book.
+// Filled in a chapter at a time, by the reader as it opens chapters and by a background worker laying out the rest,
+// which may take several sessions. Stored in the profile's directory, so it goes away along with its section files.
+class BookPageIndex {
+ public:
+  static constexpr uint16_t UNKNOWN = 0xFFFF;
+
+  BookPageIndex(std::shared_ptr<Epub> epub, std::string profileDir);
+
+  const std::string& getProfileDir() const { return profileDir; }
+  // Reads the page counts recorded so far. Starts empty when there are none or they are for a different spine.
+  bool load();
+  // Records a chapter's page count, saving the table when it changed
+  bool record(int spineIndex, uint16_t pageCount);
+  // First chapter without a page count, or -1 once every chapter has one
+  int firstMissing() const;
+  bool isComplete() const { return missing == 0; }
+  // Pages in the chapters before spineIndex. Only meaningful once complete.
+  uint32_t pagesBefore(int spineIndex) const;
+  uint32_t totalPages() const { return pagesBefore(static_cast<int>(pageCounts.size())); }
+  // Loads or builds the section file of the first chapter without a page count with the given layout and records its
+  // page count. Returns false when there was nothing left to index, the layout no longer matches this profile, or
+  // abortFn stopped the build; the chapter is then tried again next time.
+  bool indexNextChapter(GfxRenderer& renderer, int fontId, float lineCompression, bool extraParagraphSpacing,
+                        uint8_t paragraphAlignment, uint16_t viewportWidth, uint16_t viewportHeight,
+                        bool hyphenationEnabled, const std::function<bool()>& abortFn = nullptr);
+
+ private:
+  std::shared_ptr<Epub> epub;
+  std::string profileDir;
+  std::vector<uint16_t> pageCounts;
+  // Running total of pageCounts, rebuilt once the last count is in
+  std::vector<uint32_t> startPages;
+  int missing = 0;
+
+  void reset();
+  bool save() const;
+  void updateStartPages();
+};
@@ -3,25 +3,33 @@
 #include <HardwareSerial.h>
 #include <Serialization.h>
 
+#include <cstring>
+
+namespace {
+// Far above any real page, guards the allocation against a corrupt length
+constexpr uint32_t MAX_PAGE_RECORD_SIZE = 64 * 1024;
+}  // namespace
+
 void PageLine::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
   block->render(renderer, fontId, xPos + xOffset, yPos + yOffset);
 }
 
-bool PageLine::serialize(FsFile& file) {
-  serialization::writePod(file, xPos);
-  serialization::writePod(file, yPos);
+bool PageLine::serialize(std::vector<uint8_t>& record) {
+  serialization::writeSignedVarint(record, xPos);
+  serialization::writeSignedVarint(record, yPos);
 
   // serialize TextBlock pointed to by PageLine
-  return block->serialize(file);
+  return block->serialize(record);
 }
 
-std::unique_ptr<PageLine> PageLine::deserialize(FsFile& file) {
-  int16_t xPos;
-  int16_t yPos;
-  serialization::readPod(file, xPos);
-  serialization::readPod(file, yPos);
+std::unique_ptr<PageLine> PageLine::deserialize(serialization::RecordReader& reader) {
+  const auto xPos = static_cast<int16_t>(reader.readSignedVarint());
+  const auto yPos = static_cast<int16_t>(reader.readSignedVarint());
 
-  auto tb = TextBlock::deserialize(file);
+  auto tb = TextBlock::deserialize(reader);
+  if (!tb) {
+    return nullptr;
+  }
   return std::unique_ptr<PageLine>(new PageLine(std::move(tb), xPos, yPos));
 }
 
@@ -32,32 +40,50 @@ void Page::render(GfxRenderer& renderer, const int fontId, const int xOffset, co
 }
 
 bool Page::serialize(FsFile& file) const {
-  const uint16_t count = elements.size();
-  serialization::writePod(file, count);
+  std::vector<uint8_t> record;
+  record.reserve(1024);
+  record.resize(sizeof(uint32_t));  // Placeholder for the record length
+  serialization::writeVarint(record, elements.size());
 
   for (const auto& el : elements) {
     // Only PageLine exists currently
-    serialization::writePod(file, static_cast<uint8_t>(TAG_PageLine));
-    if (!el->serialize(file)) {
+    record.push_back(TAG_PageLine);
+    if (!el->serialize(record)) {
       return false;
     }
   }
 
-  return true;
+  const uint32_t length = record.size() - sizeof(uint32_t);
+  memcpy(record.data(), &length, sizeof(length));
+  return file.write(record.data(), record.size()) == record.size();
 }
 
 std::unique_ptr<Page> Page::deserialize(FsFile& file) {
-  auto page = std::unique_ptr<Page>(new Page());
+  uint32_t length;
+  serialization::readPod(file, length);
+  if (length == 0 || length > MAX_PAGE_RECORD_SIZE) {
+    Serial.printf("[%lu] [PGE] Deserialization failed: Bad record length %u\n", millis(), length);
+    return nullptr;
+  }
 
-  uint16_t count;
-  serialization::readPod(file, count);
+  std::vector<uint8_t> record(length);
+  if (file.read(record.data(), length) != static_cast<int>(length)) {
+    Serial.printf("[%lu] [PGE] Deserialization failed: Short read\n", millis());
+    return nullptr;
+  }
+
+  auto page = std::unique_ptr<Page>(new Page());
+  serialization::RecordReader reader(record.data(), record.size());
+  const uint32_t count = reader.readVarint();
 
-  for (uint16_t i = 0; i < count; i++) {
-    uint8_t tag;
-    serialization::readPod(file, tag);
+  for (uint32_t i = 0; i < count && !reader.hasFailed(); i++) {
+    const uint8_t tag = reader.readByte();
 
     if (tag == TAG_PageLine) {
-      auto pl = PageLine::deserialize(file);
+      auto pl = PageLine::deserialize(reader);
+      if (!pl) {
+        return nullptr;
+      }
       page->elements.push_back(std::move(pl));
     } else {
       Serial.printf("[%lu] [PGE] Deserialization failed: Unknown tag %u\n", millis(), tag);
@@ -65,5 +91,9 @@ std::unique_ptr<Page> Page::deserialize(FsFile& file) {
     }
   }
 
+  if (reader.hasFailed()) {
+    Serial.printf("[%lu] [PGE] Deserialization failed: Record truncated\n", millis());
+    return nullptr;
+  }
   return page;
 }
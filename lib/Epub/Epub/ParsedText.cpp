@@ -1,25 +1,35 @@
 #include "ParsedText.h"
 
 #include <GfxRenderer.h>
+#include <Trace.h>
+#include <Utf8.h>
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <functional>
-#include <iterator>
 #include <limits>
 #include <vector>
 
+#include "hyphenation/HyphenationCommon.h"
 #include "hyphenation/Hyphenator.h"
 
-constexpr int MAX_COST = std::numeric_limits<int>::max();
-
 namespace {
 
+// Demerits are kept in 32 bits to halve the per-breakpoint state, saturating just below NO_PATH. The parser flushes
+// paragraphs long before that could matter.
+constexpr uint32_t NO_PATH = std::numeric_limits<uint32_t>::max();
+// Demerits for ending a line on a hyphen, in the same squared pixels as the slack, and more when the line before also
+// ended on one
+constexpr uint32_t HYPHEN_DEMERITS = 24 * 24;
+constexpr uint32_t CONSECUTIVE_HYPHEN_DEMERITS = 48 * 48;
+constexpr uint16_t UNMEASURED = UINT16_MAX;
+
 // Soft hyphen byte pattern used throughout EPUBs (UTF-8 for U+00AD).
 constexpr char SOFT_HYPHEN_UTF8[] = "\xC2\xAD";
 constexpr size_t SOFT_HYPHEN_BYTES = 2;
 
-bool containsSoftHyphen(const std::string& word) { return word.find(SOFT_HYPHEN_UTF8) != std::string::npos; }
+bool containsSoftHyphen(const std::string_view word) { return word.find(SOFT_HYPHEN_UTF8) != std::string_view::npos; }
 
 // Removes every soft hyphen in-place so rendered glyphs match measured widths.
 void stripSoftHyphensInPlace(std::string& word) {
@@ -30,30 +40,49 @@ void stripSoftHyphensInPlace(std::string& word) {
 }
 
 // Returns the rendered width for a word while ignoring soft hyphen glyphs and optionally appending a visible hyphen.
-uint16_t measureWordWidth(const GfxRenderer& renderer, const int fontId, const std::string& word,
-                          const EpdFontFamily::Style style, const bool appendHyphen = false) {
+// The word may be a prefix of a longer NUL-terminated string; it is only copied into scratch when it has to be.
+uint16_t measureWordWidth(const GfxRenderer& renderer, const int fontId, const std::string_view word,
+                          const EpdFontFamily::Style style, std::string& scratch, const bool appendHyphen = false) {
   const bool hasSoftHyphen = containsSoftHyphen(word);
-  if (!hasSoftHyphen && !appendHyphen) {
-    return renderer.getTextWidth(fontId, word.c_str(), style);
+  if (!hasSoftHyphen && !appendHyphen && word.data()[word.size()] == '\0') {
+    return renderer.getTextWidth(fontId, word.data(), style);
   }
 
-  std::string sanitized = word;
+  scratch.assign(word);
   if (hasSoftHyphen) {
-    stripSoftHyphensInPlace(sanitized);
+    stripSoftHyphensInPlace(scratch);
   }
   if (appendHyphen) {
-    sanitized.push_back('-');
+    scratch.push_back('-');
   }
-  return renderer.getTextWidth(fontId, sanitized.c_str(), style);
+  return renderer.getTextWidth(fontId, scratch.c_str(), style);
 }
 
 }  // namespace
 
-void ParsedText::addWord(std::string word, const EpdFontFamily::Style fontStyle) {
+void ParsedText::addWord(const std::string_view word, const EpdFontFamily::Style fontStyle) {
   if (word.empty()) return;
 
-  words.push_back(std::move(word));
-  wordStyles.push_back(fontStyle);
+  const auto offset = static_cast<uint32_t>(arena.size());
+  arena.append(word);
+  arena.push_back('\0');
+  words.push_back({offset, static_cast<uint16_t>(word.size()), 0, fontStyle});
+}
+
+// Copies the first length bytes of a word to the end of the arena with an optional prefix and trailing hyphen, and
+// returns the new offset. The arena is grown first so the source bytes stay put while they are copied.
+uint32_t ParsedText::copyWordToArena(const Word& source, const uint16_t length, const char* prefix,
+                                     const bool appendHyphen) {
+  const size_t prefixLength = strlen(prefix);
+  arena.reserve(arena.size() + prefixLength + length + 2);
+  const auto offset = static_cast<uint32_t>(arena.size());
+  arena.append(prefix, prefixLength);
+  arena.append(wordText(source), length);
+  if (appendHyphen) {
+    arena.push_back('-');
+  }
+  arena.push_back('\0');
+  return offset;
 }
 
 // Consumes data to minimize memory usage
@@ -63,135 +92,319 @@ void ParsedText::layoutAndExtractLines(const GfxRenderer& renderer, const int fo
   if (words.empty()) {
     return;
   }
+  trace::Scope span(trace::Span::LAYOUT);
 
   // Apply fixed transforms before any per-line layout work.
   applyParagraphIndent();
 
   const int pageWidth = viewportWidth;
   const int spaceWidth = renderer.getSpaceWidth(fontId);
-  auto wordWidths = calculateWordWidths(renderer, fontId);
-  std::vector<size_t> lineBreakIndices;
-  if (hyphenationEnabled) {
-    // Use greedy layout that can split words mid-loop when a hyphenated prefix fits.
-    lineBreakIndices = computeHyphenatedLineBreaks(renderer, fontId, pageWidth, spaceWidth, wordWidths);
-  } else {
-    lineBreakIndices = computeLineBreaks(renderer, fontId, pageWidth, spaceWidth, wordWidths);
-  }
+  calculateWordWidths(renderer, fontId);
+  const auto lineBreakIndices = computeLineBreaks(renderer, fontId, pageWidth, spaceWidth);
   const size_t lineCount = includeLastLine ? lineBreakIndices.size() : lineBreakIndices.size() - 1;
+  span.setValue(lineCount);
+  trace::add(trace::Counter::LAID_OUT_LINES, lineCount);
 
   for (size_t i = 0; i < lineCount; ++i) {
-    extractLine(i, pageWidth, spaceWidth, wordWidths, lineBreakIndices, processLine);
+    extractLine(i, pageWidth, spaceWidth, lineBreakIndices, processLine);
   }
+  dropWords(lineCount > 0 ? lineBreakIndices[lineCount - 1] : 0);
 }
 
-std::vector<uint16_t> ParsedText::calculateWordWidths(const GfxRenderer& renderer, const int fontId) {
-  const size_t totalWordCount = words.size();
-
-  std::vector<uint16_t> wordWidths;
-  wordWidths.reserve(totalWordCount);
+// Removes the first count words, compacting what is left of the arena
+void ParsedText::dropWords(const size_t count) {
+  if (count >= words.size()) {
+    words.clear();
+    arena.clear();
+    return;
+  }
+  if (count == 0) {
+    return;
+  }
 
-  auto wordsIt = words.begin();
-  auto wordStylesIt = wordStyles.begin();
+  size_t keptSize = 0;
+  for (size_t i = count; i < words.size(); i++) {
+    keptSize += words[i].length + 1;
+  }
+  std::string kept;
+  kept.reserve(keptSize);
+  for (size_t i = count; i < words.size(); i++) {
+    const auto offset = static_cast<uint32_t>(kept.size());
+    kept.append(wordText(words[i]), words[i].length + 1);
+    words[i].offset = offset;
+  }
+  words.erase(words.begin(), words.begin() + count);
+  arena.swap(kept);
+}
 
-  while (wordsIt != words.end()) {
-    wordWidths.push_back(measureWordWidth(renderer, fontId, *wordsIt, *wordStylesIt));
+void ParsedText::calculateWordWidths(const GfxRenderer& renderer, const int fontId) {
+  for (auto& word : words) {
+    word.width = measureWordWidth(renderer, fontId, {wordText(word), word.length}, word.style, scratch);
+  }
+}
 
-    std::advance(wordsIt, 1);
-    std::advance(wordStylesIt, 1);
+// State of one total-fit search. Nodes are the breakpoints a line can end on: 0..wordCount for the boundary before
+// each word (wordCount being the end of the paragraph), then one per hyphenation point found so far.
+struct ParsedText::BreakSearch {
+  struct Node {
+    uint32_t cost;  // Demerits of the best way from the start of the paragraph to this breakpoint
+    uint32_t previous;
+  };
+
+  int pageWidth;
+  int spaceWidth;
+  // Only lines at most about twice as loose as natural spacing (and the fullest lines from each breakpoint) are
+  // followed, which keeps the set of active breakpoints to a window of a few per line
+  bool bounded;
+  size_t wordCount;
+  std::vector<uint32_t> prefixWidths;  // Per word, the widths of the words before it, each with a space
+  size_t fullestLast = 0;
+  std::vector<Node> nodes;
+  std::vector<HyphenBreak> hyphenBreaks;
+  // Lines are tried in paragraph order and where they overflow never moves backwards, so the words looked up so far
+  // are all before lookedUpWord and its hyphenation points are the tail of hyphenBreaks from lookedUpFirst
+  size_t lookedUpWord = std::numeric_limits<size_t>::max();
+  size_t lookedUpFirst = 0;
+  std::vector<LineEnd> lineEnds;
+
+  // Whether a line with this many gaps (counting one for the slack at its end) is spaced within the bound of one
+  // extra space per gap, or within two and a half
+  bool withinBound(const int slack, const size_t gaps) const {
+    return !bounded || slack <= static_cast<int>(gaps) * spaceWidth;
+  }
+  bool withinLooseBound(const int slack, const size_t gaps) const {
+    return !bounded || 2 * slack <= 5 * static_cast<int>(gaps) * spaceWidth;
   }
+  bool isHyphenBreak(const uint32_t node) const { return node > wordCount; }
+  HyphenBreak& hyphenBreak(const uint32_t node) { return hyphenBreaks[node - wordCount - 1]; }
+  uint32_t hyphenBreakNode(const size_t index) const { return wordCount + 1 + index; }
+};
+
+// Hyphenation points of a word, each prefix measured once however many lines try to end on it. Remainders are only
+// measured once a line actually starts with one.
+void ParsedText::findHyphenBreaks(BreakSearch& search, const size_t wordIndex, const GfxRenderer& renderer,
+                                  const int fontId) {
+  if (search.lookedUpWord == wordIndex) {
+    return;
+  }
+  search.lookedUpWord = wordIndex;
+  search.lookedUpFirst = search.hyphenBreaks.size();
 
-  return wordWidths;
+  const Word& word = words[wordIndex];
+  const std::string_view text(wordText(word), word.length);
+  for (const auto& info : Hyphenator::breakOffsets(text, false)) {
+    if (info.byteOffset == 0 || info.byteOffset >= text.size()) {
+      continue;
+    }
+    const uint16_t prefixWidth = measureWordWidth(renderer, fontId, text.substr(0, info.byteOffset), word.style,
+                                                  scratch, info.requiresInsertedHyphen);
+    search.hyphenBreaks.push_back({static_cast<uint32_t>(wordIndex), static_cast<uint16_t>(info.byteOffset),
+                                   prefixWidth, UNMEASURED, info.requiresInsertedHyphen});
+    search.nodes.push_back({NO_PATH, 0});
+  }
 }
 
-std::vector<size_t> ParsedText::computeLineBreaks(const GfxRenderer& renderer, const int fontId, const int pageWidth,
-                                                  const int spaceWidth, std::vector<uint16_t>& wordWidths) {
-  if (words.empty()) {
-    return {};
+// Width of the narrowest prefix, hyphen included, that a break in the word could leave: its first character before an
+// explicit hyphen, or the language's minimum prefix before a pattern break. INT_MAX if it cannot be broken at all.
+int ParsedText::narrowestBreakPrefix(const Word& word, const GfxRenderer& renderer, const int fontId) {
+  const size_t minPrefix = Hyphenator::minPrefix();
+  const auto* begin = reinterpret_cast<const unsigned char*>(wordText(word));
+  const auto* cursor = begin;
+  size_t firstEnd = 0;
+  size_t minPrefixEnd = 0;
+  size_t codepoints = 0;
+  bool explicitHyphen = false;
+  while (static_cast<size_t>(cursor - begin) < word.length) {
+    explicitHyphen |= isExplicitHyphen(utf8NextCodepoint(&cursor));
+    codepoints++;
+    if (codepoints == 1) firstEnd = cursor - begin;
+    if (codepoints == minPrefix) minPrefixEnd = cursor - begin;
   }
 
-  // Ensure any word that would overflow even as the first entry on a line is split using fallback hyphenation.
-  for (size_t i = 0; i < wordWidths.size(); ++i) {
-    while (wordWidths[i] > pageWidth) {
-      if (!hyphenateWordAtIndex(i, pageWidth, renderer, fontId, wordWidths, /*allowFallbackBreaks=*/true)) {
-        break;
-      }
-    }
+  const char* text = wordText(word);
+  if (explicitHyphen) {
+    return measureWordWidth(renderer, fontId, {text, firstEnd}, word.style, scratch, true);
   }
+  if (minPrefix == 0 || codepoints <= minPrefix) {
+    return std::numeric_limits<int>::max();
+  }
+  return measureWordWidth(renderer, fontId, {text, minPrefixEnd}, word.style, scratch, true);
+}
 
-  const size_t totalWordCount = words.size();
+// Fills search.lineEnds with the lines that can start at node
+void ParsedText::collectLineEnds(BreakSearch& search, const uint32_t node, const GfxRenderer& renderer,
+                                 const int fontId) {
+  auto& ends = search.lineEnds;
+  ends.clear();
+
+  size_t first = node;
+  int firstWidth;
+  if (search.isHyphenBreak(node)) {
+    HyphenBreak& start = search.hyphenBreak(node);
+    if (start.remainderWidth == UNMEASURED) {
+      const Word& word = words[start.word];
+      start.remainderWidth = measureWordWidth(
+          renderer, fontId, std::string_view(wordText(word), word.length).substr(start.offset), word.style, scratch);
+    }
+    first = start.word;
+    firstWidth = start.remainderWidth;
+  } else {
+    firstWidth = words[first].width;
+  }
+  if (firstWidth > search.pageWidth) {
+    // Even the first word does not fit, it gets a line of its own
+    ends.push_back({static_cast<uint32_t>(first + 1), 0});
+    return;
+  }
 
-  // DP table to store the minimum badness (cost) of lines starting at index i
-  std::vector<int> dp(totalWordCount);
-  // 'ans[i]' stores the index 'j' of the *last word* in the optimal line starting at 'i'
-  std::vector<size_t> ans(totalWordCount);
+  // Width of the line from first through last, from the running sums of word plus space widths
+  const auto lineWidth = [&](const size_t last) {
+    return firstWidth + static_cast<int>(search.prefixWidths[last + 1] - search.prefixWidths[first + 1]);
+  };
+  // The fullest line hardly ever ends before the fullest line from an earlier breakpoint, so start looking there
+  size_t last = std::max(search.fullestLast, first);
+  while (last > first && lineWidth(last) > search.pageWidth) {
+    last--;
+  }
+  while (last + 1 < search.wordCount && lineWidth(last + 1) <= search.pageWidth) {
+    last++;
+  }
+  search.fullestLast = last;
 
-  // Base Case
-  dp[totalWordCount - 1] = 0;
-  ans[totalWordCount - 1] = totalWordCount - 1;
+  // Lines ending on a word, back from the fullest, as long as they are within the bound
+  const int fullestSlack = search.pageWidth - lineWidth(last);
+  for (size_t end = last + 1; end > first; end--) {
+    const int slack = search.pageWidth - lineWidth(end - 1);
+    if (!search.withinBound(slack, end - first)) {
+      break;
+    }
+    ends.push_back({static_cast<uint32_t>(end), slack});
+  }
+  const bool fullestFollowed = !ends.empty() && ends.front().node == last + 1;
+
+  // The line may also end inside the word that overflows it, on a hyphen. Like TeX's pretolerance, a line already
+  // within the bound does not look for one, nor does one without room for the narrowest prefix a break could leave,
+  // which is far cheaper to check than running the Liang patterns.
+  const int room = fullestSlack - search.spaceWidth;
+  bool hyphenEnds = false;
+  if (hyphenationEnabled && last + 1 < search.wordCount && !fullestFollowed &&
+      (search.lookedUpWord == last + 1 || room >= narrowestBreakPrefix(words[last + 1], renderer, fontId))) {
+    findHyphenBreaks(search, last + 1, renderer, fontId);
+    // Within the bound again, plus the fullest, which is what greedy filling would pick
+    size_t fullest = 0;
+    bool fullestKept = true;
+    for (size_t i = search.lookedUpFirst; i < search.hyphenBreaks.size(); i++) {
+      const int slack = room - search.hyphenBreaks[i].prefixWidth;
+      if (slack < 0) {
+        continue;
+      }
+      fullest = i;
+      fullestKept = search.withinBound(slack, last + 2 - first);
+      if (fullestKept) {
+        ends.push_back({search.hyphenBreakNode(i), slack});
+      }
+      hyphenEnds = true;
+    }
+    if (!fullestKept) {
+      ends.push_back({search.hyphenBreakNode(fullest), room - search.hyphenBreaks[fullest].prefixWidth});
+    }
+  }
 
-  for (int i = totalWordCount - 2; i >= 0; --i) {
-    int currlen = -spaceWidth;
-    dp[i] = MAX_COST;
+  // Out of bound, the fullest line on a word is still followed when nothing else ends the line, or when it is not much
+  // looser than the bound. Avoiding a hyphen that way is often worth a slightly loose line, and a wider margin costs
+  // more hyphenation lookups than it gains.
+  if (!fullestFollowed && (!hyphenEnds || search.withinLooseBound(fullestSlack, last + 1 - first))) {
+    ends.push_back({static_cast<uint32_t>(last + 1), fullestSlack});
+  }
+}
 
-    for (size_t j = i; j < totalWordCount; ++j) {
-      // Current line length: previous width + space + current word width
-      currlen += wordWidths[j] + spaceWidth;
+// Total-fit line breaking: picks the breaks that minimise the sum over all lines but the last of the squared space
+// left over, plus demerits for ending lines on a hyphen. With hyphenation off this is the classic minimum-raggedness
+// DP. With it on, the hyphenation points of the word overflowing each line are breakpoints too, looked up only for
+// lines that can actually be reached.
+std::vector<size_t> ParsedText::computeLineBreaks(const GfxRenderer& renderer, const int fontId, const int pageWidth,
+                                                  const int spaceWidth) {
+  if (words.empty()) {
+    return {};
+  }
 
-      if (currlen > pageWidth) {
+  // Ensure any word that would overflow even as the first entry on a line is split using fallback hyphenation.
+  for (size_t i = 0; i < words.size(); ++i) {
+    while (words[i].width > pageWidth) {
+      if (!hyphenateWordAtIndex(i, pageWidth, renderer, fontId, /*allowFallbackBreaks=*/true)) {
         break;
       }
+    }
+  }
 
-      int cost;
-      if (j == totalWordCount - 1) {
-        cost = 0;  // Last line
-      } else {
-        const int remainingSpace = pageWidth - currlen;
-        // Use long long for the square to prevent overflow
-        const long long cost_ll = static_cast<long long>(remainingSpace) * remainingSpace + dp[j + 1];
-
-        if (cost_ll > MAX_COST) {
-          cost = MAX_COST;
-        } else {
-          cost = static_cast<int>(cost_ll);
+  const size_t wordCount = words.size();
+  BreakSearch search;
+  search.pageWidth = pageWidth;
+  search.spaceWidth = spaceWidth;
+  search.bounded = hyphenationEnabled;
+  search.wordCount = wordCount;
+  search.prefixWidths.resize(wordCount + 1);
+  search.prefixWidths[0] = 0;
+  for (size_t i = 0; i < wordCount; i++) {
+    search.prefixWidths[i + 1] = search.prefixWidths[i] + spaceWidth + words[i].width;
+  }
+  search.nodes.assign(wordCount + 1, {NO_PATH, 0});
+  search.nodes[0].cost = 0;
+
+  // One pass in paragraph order, relaxing every line from each reachable breakpoint. A word's hyphenation points sit
+  // between its own boundary and the next, and were all found by lines starting before it.
+  size_t nextHyphenBreak = 0;
+  for (size_t w = 0; w < wordCount; w++) {
+    uint32_t node = w;
+    while (true) {
+      const uint32_t cost = search.nodes[node].cost;
+      if (cost != NO_PATH) {
+        collectLineEnds(search, node, renderer, fontId);
+        for (const auto& end : search.lineEnds) {
+          uint64_t total = cost;
+          if (end.node != wordCount) {
+            total += static_cast<uint64_t>(end.slack) * end.slack;
+            if (search.isHyphenBreak(end.node)) {
+              total += search.isHyphenBreak(node) ? CONSECUTIVE_HYPHEN_DEMERITS : HYPHEN_DEMERITS;
+            }
+          }
+          // Ties go to the earliest start
+          if (total < search.nodes[end.node].cost) {
+            search.nodes[end.node] = {static_cast<uint32_t>(std::min<uint64_t>(total, NO_PATH - 1)), node};
+          }
         }
       }
-
-      if (cost < dp[i]) {
-        dp[i] = cost;
-        ans[i] = j;  // j is the index of the last word in this optimal line
+      if (nextHyphenBreak == search.hyphenBreaks.size() || search.hyphenBreaks[nextHyphenBreak].word != w) {
+        break;
       }
+      node = search.hyphenBreakNode(nextHyphenBreak++);
     }
+  }
 
-    // Handle oversized word: if no valid configuration found, force single-word line
-    // This prevents cascade failure where one oversized word breaks all preceding words
-    if (dp[i] == MAX_COST) {
-      ans[i] = i;  // Just this word on its own line
-      // Inherit cost from next word to allow subsequent words to find valid configurations
-      if (i + 1 < static_cast<int>(totalWordCount)) {
-        dp[i] = dp[i + 1];
-      } else {
-        dp[i] = 0;
-      }
+  // Walk the chosen breaks back from the end, splitting the words broken on a hyphen on the way (last first, so
+  // earlier indices stay put), then turn every break into the index of the word starting the next line
+  std::vector<uint32_t> path;
+  for (uint32_t node = search.nodes[wordCount].previous; node != 0; node = search.nodes[node].previous) {
+    path.push_back(node);
+    if (search.isHyphenBreak(node)) {
+      const HyphenBreak& hyphenBreak = search.hyphenBreak(node);
+      splitWord(hyphenBreak.word, hyphenBreak.offset, hyphenBreak.insertHyphen, hyphenBreak.prefixWidth,
+                hyphenBreak.remainderWidth);
     }
   }
 
-  // Stores the index of the word that starts the next line (last_word_index + 1)
   std::vector<size_t> lineBreakIndices;
-  size_t currentWordIndex = 0;
-
-  while (currentWordIndex < totalWordCount) {
-    size_t nextBreakIndex = ans[currentWordIndex] + 1;
-
-    // Safety check: prevent infinite loop if nextBreakIndex doesn't advance
-    if (nextBreakIndex <= currentWordIndex) {
-      // Force advance by at least one word to avoid infinite loop
-      nextBreakIndex = currentWordIndex + 1;
+  lineBreakIndices.reserve(path.size() + 1);
+  size_t splitsBefore = 0;
+  for (auto it = path.rbegin(); it != path.rend(); ++it) {
+    if (search.isHyphenBreak(*it)) {
+      lineBreakIndices.push_back(search.hyphenBreak(*it).word + splitsBefore + 1);
+      splitsBefore++;
+    } else {
+      lineBreakIndices.push_back(*it + splitsBefore);
     }
-
-    lineBreakIndices.push_back(nextBreakIndex);
-    currentWordIndex = nextBreakIndex;
   }
-
+  lineBreakIndices.push_back(words.size());
   return lineBreakIndices;
 }
 
@@ -201,81 +414,26 @@ void ParsedText::applyParagraphIndent() {
   }
 
   if (style == TextBlock::JUSTIFIED || style == TextBlock::LEFT_ALIGN) {
-    words.front().insert(0, "\xe2\x80\x83");
-  }
-}
-
-// Builds break indices while opportunistically splitting the word that would overflow the current line.
-std::vector<size_t> ParsedText::computeHyphenatedLineBreaks(const GfxRenderer& renderer, const int fontId,
-                                                            const int pageWidth, const int spaceWidth,
-                                                            std::vector<uint16_t>& wordWidths) {
-  std::vector<size_t> lineBreakIndices;
-  size_t currentIndex = 0;
-
-  while (currentIndex < wordWidths.size()) {
-    const size_t lineStart = currentIndex;
-    int lineWidth = 0;
-
-    // Consume as many words as possible for current line, splitting when prefixes fit
-    while (currentIndex < wordWidths.size()) {
-      const bool isFirstWord = currentIndex == lineStart;
-      const int spacing = isFirstWord ? 0 : spaceWidth;
-      const int candidateWidth = spacing + wordWidths[currentIndex];
-
-      // Word fits on current line
-      if (lineWidth + candidateWidth <= pageWidth) {
-        lineWidth += candidateWidth;
-        ++currentIndex;
-        continue;
-      }
-
-      // Word would overflow — try to split based on hyphenation points
-      const int availableWidth = pageWidth - lineWidth - spacing;
-      const bool allowFallbackBreaks = isFirstWord;  // Only for first word on line
-
-      if (availableWidth > 0 &&
-          hyphenateWordAtIndex(currentIndex, availableWidth, renderer, fontId, wordWidths, allowFallbackBreaks)) {
-        // Prefix now fits; append it to this line and move to next line
-        lineWidth += spacing + wordWidths[currentIndex];
-        ++currentIndex;
-        break;
-      }
-
-      // Could not split: force at least one word per line to avoid infinite loop
-      if (currentIndex == lineStart) {
-        lineWidth += candidateWidth;
-        ++currentIndex;
-      }
-      break;
-    }
-
-    lineBreakIndices.push_back(currentIndex);
+    Word& first = words.front();
+    first.offset = copyWordToArena(first, first.length, "\xe2\x80\x83");
+    first.length += 3;
   }
-
-  return lineBreakIndices;
 }
 
 // Splits words[wordIndex] into prefix (adding a hyphen only when needed) and remainder when a legal breakpoint fits the
 // available width.
 bool ParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availableWidth, const GfxRenderer& renderer,
-                                      const int fontId, std::vector<uint16_t>& wordWidths,
-                                      const bool allowFallbackBreaks) {
+                                      const int fontId, const bool allowFallbackBreaks) {
   // Guard against invalid indices or zero available width before attempting to split.
   if (availableWidth <= 0 || wordIndex >= words.size()) {
     return false;
   }
 
-  // Get iterators to target word and style.
-  auto wordIt = words.begin();
-  auto styleIt = wordStyles.begin();
-  std::advance(wordIt, wordIndex);
-  std::advance(styleIt, wordIndex);
-
-  const std::string& word = *wordIt;
-  const auto style = *styleIt;
+  const Word target = words[wordIndex];
+  const std::string_view word(wordText(target), target.length);
 
   // Collect candidate breakpoints (byte offsets and hyphen requirements).
-  auto breakInfos = Hyphenator::breakOffsets(word, allowFallbackBreaks);
+  const auto breakInfos = Hyphenator::breakOffsets(word, allowFallbackBreaks);
   if (breakInfos.empty()) {
     return false;
   }
@@ -292,7 +450,8 @@ bool ParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availabl
     }
 
     const bool needsHyphen = info.requiresInsertedHyphen;
-    const int prefixWidth = measureWordWidth(renderer, fontId, word.substr(0, offset), style, needsHyphen);
+    const int prefixWidth =
+        measureWordWidth(renderer, fontId, word.substr(0, offset), target.style, scratch, needsHyphen);
     if (prefixWidth > availableWidth || prefixWidth <= chosenWidth) {
       continue;  // Skip if too wide or not an improvement
     }
@@ -307,28 +466,32 @@ bool ParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availabl
     return false;
   }
 
-  // Split the word at the selected breakpoint and append a hyphen if required.
-  std::string remainder = word.substr(chosenOffset);
-  wordIt->resize(chosenOffset);
-  if (chosenNeedsHyphen) {
-    wordIt->push_back('-');
-  }
+  splitWord(wordIndex, chosenOffset, chosenNeedsHyphen, chosenWidth,
+            measureWordWidth(renderer, fontId, word.substr(chosenOffset), target.style, scratch));
+  return true;
+}
+
+// Splits a word into prefix (with an inserted hyphen if asked) and remainder. The remainder stays where it is in the
+// arena, the prefix needs its own terminator so it is copied to the end.
+void ParsedText::splitWord(const size_t wordIndex, const uint16_t offset, const bool insertHyphen,
+                           const uint16_t prefixWidth, const uint16_t remainderWidth) {
+  const Word target = words[wordIndex];
+  Word remainder = target;
+  remainder.offset += offset;
+  remainder.length -= offset;
+  remainder.width = remainderWidth;
+
+  Word& prefix = words[wordIndex];
+  prefix.offset = copyWordToArena(target, offset, "", insertHyphen);
+  prefix.length = offset + (insertHyphen ? 1 : 0);
+  prefix.width = prefixWidth;
 
   // Insert the remainder word (with matching style) directly after the prefix.
-  auto insertWordIt = std::next(wordIt);
-  auto insertStyleIt = std::next(styleIt);
-  words.insert(insertWordIt, remainder);
-  wordStyles.insert(insertStyleIt, style);
-
-  // Update cached widths to reflect the new prefix/remainder pairing.
-  wordWidths[wordIndex] = static_cast<uint16_t>(chosenWidth);
-  const uint16_t remainderWidth = measureWordWidth(renderer, fontId, remainder, style);
-  wordWidths.insert(wordWidths.begin() + wordIndex + 1, remainderWidth);
-  return true;
+  words.insert(words.begin() + wordIndex + 1, remainder);
 }
 
 void ParsedText::extractLine(const size_t breakIndex, const int pageWidth, const int spaceWidth,
-                             const std::vector<uint16_t>& wordWidths, const std::vector<size_t>& lineBreakIndices,
+                             const std::vector<size_t>& lineBreakIndices,
                              const std::function<void(std::shared_ptr<TextBlock>)>& processLine) {
   const size_t lineBreak = lineBreakIndices[breakIndex];
   const size_t lastBreakAt = breakIndex > 0 ? lineBreakIndices[breakIndex - 1] : 0;
@@ -336,8 +499,10 @@ void ParsedText::extractLine(const size_t breakIndex, const int pageWidth, const
 
   // Calculate total word width for this line
   int lineWordWidthSum = 0;
+  size_t lineTextSize = 0;
   for (size_t i = lastBreakAt; i < lineBreak; i++) {
-    lineWordWidthSum += wordWidths[i];
+    lineWordWidthSum += words[i].width;
+    lineTextSize += words[i].length + 1;
   }
 
   // Calculate spacing
@@ -358,31 +523,26 @@ void ParsedText::extractLine(const size_t breakIndex, const int pageWidth, const
     xpos = (spareSpace - (lineWordCount - 1) * spaceWidth) / 2;
   }
 
-  // Pre-calculate X positions for words
-  std::list<uint16_t> lineXPos;
+  // Copy the line's words into a text buffer of its own, dropping soft hyphens, and place them
+  std::string lineText;
+  lineText.reserve(lineTextSize);
+  std::vector<TextBlock::Word> lineWords;
+  lineWords.reserve(lineWordCount);
   for (size_t i = lastBreakAt; i < lineBreak; i++) {
-    const uint16_t currentWordWidth = wordWidths[i];
-    lineXPos.push_back(xpos);
-    xpos += currentWordWidth + spacing;
-  }
-
-  // Iterators always start at the beginning as we are moving content with splice below
-  auto wordEndIt = words.begin();
-  auto wordStyleEndIt = wordStyles.begin();
-  std::advance(wordEndIt, lineWordCount);
-  std::advance(wordStyleEndIt, lineWordCount);
-
-  // *** CRITICAL STEP: CONSUME DATA USING SPLICE ***
-  std::list<std::string> lineWords;
-  lineWords.splice(lineWords.begin(), words, words.begin(), wordEndIt);
-  std::list<EpdFontFamily::Style> lineWordStyles;
-  lineWordStyles.splice(lineWordStyles.begin(), wordStyles, wordStyles.begin(), wordStyleEndIt);
-
-  for (auto& word : lineWords) {
-    if (containsSoftHyphen(word)) {
-      stripSoftHyphensInPlace(word);
+    const Word& word = words[i];
+    const std::string_view bytes(wordText(word), word.length);
+    const auto offset = static_cast<uint16_t>(lineText.size());
+    size_t start = 0;
+    size_t pos;
+    while ((pos = bytes.find(SOFT_HYPHEN_UTF8, start)) != std::string_view::npos) {
+      lineText.append(bytes.substr(start, pos - start));
+      start = pos + SOFT_HYPHEN_BYTES;
     }
+    lineText.append(bytes.substr(start));
+    lineWords.push_back({offset, static_cast<uint16_t>(lineText.size() - offset), xpos, word.style});
+    lineText.push_back('\0');
+    xpos += word.width + spacing;
   }
 
-  processLine(std::make_shared<TextBlock>(std::move(lineWords), std::move(lineXPos), std::move(lineWordStyles), style));
-}
\ No newline at end of file
+  processLine(std::make_shared<TextBlock>(std::move(lineText), std::move(lineWords), style));
+}
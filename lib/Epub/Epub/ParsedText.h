@@ -3,9 +3,9 @@
 #include <EpdFontFamily.h>
 
 #include <functional>
-#include <list>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "blocks/TextBlock.h"
@@ -13,23 +13,53 @@
 class GfxRenderer;
 
 class ParsedText {
-  std::list<std::string> words;
-  std::list<EpdFontFamily::Style> wordStyles;
+  // A word of the paragraph. Its bytes live NUL-terminated in the arena at offset.
+  struct Word {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t width;
+    EpdFontFamily::Style style;
+  };
+
+  // A point inside a word where a line may end on a hyphen. The remainder is measured once a line starts with it.
+  struct HyphenBreak {
+    uint32_t word;
+    uint16_t offset;
+    uint16_t prefixWidth;     // Including the inserted hyphen, if any
+    uint16_t remainderWidth;  // UINT16_MAX until measured
+    bool insertHyphen;
+  };
+
+  // A line that can follow a breakpoint: the breakpoint it ends on and the space left over
+  struct LineEnd {
+    uint32_t node;
+    int slack;
+  };
+
+  struct BreakSearch;
+
+  // Every word of the paragraph in one buffer, so a word costs a Word entry instead of a list node and a string
+  std::string arena;
+  std::vector<Word> words;
+  std::string scratch;
   TextBlock::Style style;
   bool extraParagraphSpacing;
   bool hyphenationEnabled;
 
+  const char* wordText(const Word& word) const { return arena.c_str() + word.offset; }
+  uint32_t copyWordToArena(const Word& source, uint16_t length, const char* prefix, bool appendHyphen = false);
   void applyParagraphIndent();
-  std::vector<size_t> computeLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth, int spaceWidth,
-                                        std::vector<uint16_t>& wordWidths);
-  std::vector<size_t> computeHyphenatedLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth,
-                                                  int spaceWidth, std::vector<uint16_t>& wordWidths);
+  std::vector<size_t> computeLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth, int spaceWidth);
+  void findHyphenBreaks(BreakSearch& search, size_t wordIndex, const GfxRenderer& renderer, int fontId);
+  int narrowestBreakPrefix(const Word& word, const GfxRenderer& renderer, int fontId);
+  void collectLineEnds(BreakSearch& search, uint32_t node, const GfxRenderer& renderer, int fontId);
   bool hyphenateWordAtIndex(size_t wordIndex, int availableWidth, const GfxRenderer& renderer, int fontId,
-                            std::vector<uint16_t>& wordWidths, bool allowFallbackBreaks);
-  void extractLine(size_t breakIndex, int pageWidth, int spaceWidth, const std::vector<uint16_t>& wordWidths,
-                   const std::vector<size_t>& lineBreakIndices,
+                            bool allowFallbackBreaks);
+  void splitWord(size_t wordIndex, uint16_t offset, bool insertHyphen, uint16_t prefixWidth, uint16_t remainderWidth);
+  void extractLine(size_t breakIndex, int pageWidth, int spaceWidth, const std::vector<size_t>& lineBreakIndices,
                    const std::function<void(std::shared_ptr<TextBlock>)>& processLine);
-  std::vector<uint16_t> calculateWordWidths(const GfxRenderer& renderer, int fontId);
+  void dropWords(size_t count);
+  void calculateWordWidths(const GfxRenderer& renderer, int fontId);
 
  public:
   explicit ParsedText(const TextBlock::Style style, const bool extraParagraphSpacing,
@@ -37,7 +67,7 @@ class ParsedText {
       : style(style), extraParagraphSpacing(extraParagraphSpacing), hyphenationEnabled(hyphenationEnabled) {}
   ~ParsedText() = default;
 
-  void addWord(std::string word, EpdFontFamily::Style fontStyle);
+  void addWord(std::string_view word, EpdFontFamily::Style fontStyle);
   void setStyle(const TextBlock::Style style) { this->style = style; }
   TextBlock::Style getStyle() const { return style; }
   size_t size() const { return words.size(); }
@@ -1,19 +1,60 @@
 #include "Section.h"
 
+#include <FsHelpers.h>
+#include <HeapWatch.h>
 #include <SDCardManager.h>
 #include <Serialization.h>
+#include <Trace.h>
+#include <ZipFile.h>
 
 #include "Page.h"
+#include "SectionProfiles.h"
 #include "hyphenation/Hyphenator.h"
 #include "parsers/ChapterHtmlSlimParser.h"
 
 namespace {
-constexpr uint8_t SECTION_FILE_VERSION = 10;
+constexpr uint8_t SECTION_FILE_VERSION = 12;
 constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int) + sizeof(float) + sizeof(bool) + sizeof(uint8_t) +
                                  sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(bool) +
                                  sizeof(uint32_t);
+
+uint32_t fileSize(const std::string& path) {
+  FsFile file;
+  if (!SdMan.openFileForRead("SCT", path, file)) {
+    return 0;
+  }
+  const auto size = static_cast<uint32_t>(file.size());
+  file.close();
+  return size;
+}
 }  // namespace
 
+void Section::selectLayout(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
+                           const uint8_t paragraphAlignment, const uint16_t viewportWidth,
+                           const uint16_t viewportHeight, const bool hyphenationEnabled) {
+  // FNV-1a over the parameters as the header stores them, and the file version so a new format gets fresh files
+  uint32_t hash = 2166136261u;
+  const auto mix = [&hash](const auto& value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(value); i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+  };
+  mix(SECTION_FILE_VERSION);
+  mix(fontId);
+  mix(lineCompression);
+  mix(extraParagraphSpacing);
+  mix(paragraphAlignment);
+  mix(viewportWidth);
+  mix(viewportHeight);
+  mix(hyphenationEnabled);
+
+  layoutFingerprint = hash;
+  filePath = SectionProfiles::profileDir(sectionsDir, hash) + "/" + std::to_string(spineIndex) + ".bin";
+}
+
+std::string Section::getProfileDir() const { return SectionProfiles::profileDir(sectionsDir, layoutFingerprint); }
+
 uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
   if (!file) {
     Serial.printf("[%lu] [SCT] File not open for writing page %d\n", millis(), pageCount);
@@ -21,11 +62,15 @@ uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
   }
 
   const uint32_t position = file.position();
-  if (!page->serialize(file)) {
-    Serial.printf("[%lu] [SCT] Failed to serialize page %d\n", millis(), pageCount);
-    return 0;
+  {
+    trace::Scope span(trace::Span::SECTION_SERIALIZE, pageCount);
+    if (!page->serialize(file)) {
+      Serial.printf("[%lu] [SCT] Failed to serialize page %d\n", millis(), pageCount);
+      return 0;
+    }
   }
-  Serial.printf("[%lu] [SCT] Page %d processed\n", millis(), pageCount);
+  trace::add(trace::Counter::SERIALIZED_PAGES);
+  heapwatch::sample();
 
   pageCount++;
   return position;
@@ -43,29 +88,37 @@ void Section::writeSectionFileHeader(const int fontId, const float lineCompressi
                                    sizeof(viewportHeight) + sizeof(pageCount) + sizeof(hyphenationEnabled) +
                                    sizeof(uint32_t),
                 "Header size mismatch");
-  serialization::writePod(file, SECTION_FILE_VERSION);
-  serialization::writePod(file, fontId);
-  serialization::writePod(file, lineCompression);
-  serialization::writePod(file, extraParagraphSpacing);
-  serialization::writePod(file, paragraphAlignment);
-  serialization::writePod(file, viewportWidth);
-  serialization::writePod(file, viewportHeight);
-  serialization::writePod(file, hyphenationEnabled);
-  serialization::writePod(file, pageCount);  // Placeholder for page count (will be initially 0 when written)
-  serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for LUT offset
+  serialization::BufferedFileWriter header(file);
+  serialization::writePod(header, SECTION_FILE_VERSION);
+  serialization::writePod(header, fontId);
+  serialization::writePod(header, lineCompression);
+  serialization::writePod(header, extraParagraphSpacing);
+  serialization::writePod(header, paragraphAlignment);
+  serialization::writePod(header, viewportWidth);
+  serialization::writePod(header, viewportHeight);
+  serialization::writePod(header, hyphenationEnabled);
+  serialization::writePod(header, pageCount);  // Placeholder for page count (will be initially 0 when written)
+  serialization::writePod(header, static_cast<uint32_t>(0));  // Placeholder for LUT offset
 }
 
 bool Section::loadSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
                               const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                               const uint16_t viewportHeight, const bool hyphenationEnabled) {
+  if (file) {
+    file.close();
+  }
+  dropPageCache();
+  selectLayout(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth, viewportHeight,
+               hyphenationEnabled);
   if (!SdMan.openFileForRead("SCT", filePath, file)) {
     return false;
   }
 
   // Match parameters
+  serialization::BufferedFileReader header(file);
   {
     uint8_t version;
-    serialization::readPod(file, version);
+    serialization::readPod(header, version);
     if (version != SECTION_FILE_VERSION) {
       file.close();
       Serial.printf("[%lu] [SCT] Deserialization failed: Unknown version %u\n", millis(), version);
@@ -79,13 +132,13 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
     bool fileExtraParagraphSpacing;
     uint8_t fileParagraphAlignment;
     bool fileHyphenationEnabled;
-    serialization::readPod(file, fileFontId);
-    serialization::readPod(file, fileLineCompression);
-    serialization::readPod(file, fileExtraParagraphSpacing);
-    serialization::readPod(file, fileParagraphAlignment);
-    serialization::readPod(file, fileViewportWidth);
-    serialization::readPod(file, fileViewportHeight);
-    serialization::readPod(file, fileHyphenationEnabled);
+    serialization::readPod(header, fileFontId);
+    serialization::readPod(header, fileLineCompression);
+    serialization::readPod(header, fileExtraParagraphSpacing);
+    serialization::readPod(header, fileParagraphAlignment);
+    serialization::readPod(header, fileViewportWidth);
+    serialization::readPod(header, fileViewportHeight);
+    serialization::readPod(header, fileHyphenationEnabled);
 
     if (fontId != fileFontId || lineCompression != fileLineCompression ||
         extraParagraphSpacing != fileExtraParagraphSpacing || paragraphAlignment != fileParagraphAlignment ||
@@ -98,23 +151,43 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
     }
   }
 
-  serialization::readPod(file, pageCount);
-  file.close();
+  uint32_t lutOffset;
+  serialization::readPod(header, pageCount);
+  serialization::readPod(header, lutOffset);
+
+  // The LUT stays in RAM and the file stays open, so loading a page is a seek and a read
+  lut.resize(pageCount);
+  const int lutBytes = pageCount * sizeof(uint32_t);
+  if (!file.seek(lutOffset) || file.read(lut.data(), lutBytes) != lutBytes) {
+    file.close();
+    lut.clear();
+    Serial.printf("[%lu] [SCT] Deserialization failed: Could not read LUT\n", millis());
+    clearCache();
+    return false;
+  }
+  SectionProfiles(sectionsDir, epub->getSpineItemsCount()).touch(layoutFingerprint);
   Serial.printf("[%lu] [SCT] Deserialization succeeded: %d pages\n", millis(), pageCount);
   return true;
 }
 
 // Your updated class method (assuming you are using the 'SD' object, which is a wrapper for a specific filesystem)
-bool Section::clearCache() const {
+bool Section::clearCache() {
+  if (file) {
+    file.close();
+  }
+  dropPageCache();
+
   if (!SdMan.exists(filePath.c_str())) {
     Serial.printf("[%lu] [SCT] Cache does not exist, no action needed\n", millis());
     return true;
   }
 
+  const uint32_t removedBytes = fileSize(filePath);
   if (!SdMan.remove(filePath.c_str())) {
     Serial.printf("[%lu] [SCT] Failed to clear cache\n", millis());
     return false;
   }
+  SectionProfiles(sectionsDir, epub->getSpineItemsCount()).release(layoutFingerprint, removedBytes);
 
   Serial.printf("[%lu] [SCT] Cache cleared successfully\n", millis());
   return true;
@@ -124,96 +197,152 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
                                 const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                 const uint16_t viewportHeight, const bool hyphenationEnabled,
                                 const std::function<void()>& progressSetupFn,
-                                const std::function<void(int)>& progressFn) {
+                                const std::function<void(int)>& progressFn,
+                                const std::function<bool()>& abortFn) {
   constexpr uint32_t MIN_SIZE_FOR_PROGRESS = 50 * 1024;  // 50KB
-  const auto localPath = epub->getSpineItem(spineIndex).href;
-  const auto tmpHtmlPath = epub->getCachePath() + "/.tmp_" + std::to_string(spineIndex) + ".html";
+  const auto itemPath = FsHelpers::normalisePath(epub->getSpineItem(spineIndex).href);
+  heapwatch::Operation heapOperation("SectionBuild", epub->getPath() + " #" + std::to_string(spineIndex));
 
-  // Create cache directory if it doesn't exist
-  {
-    const auto sectionsDir = epub->getCachePath() + "/sections";
-    SdMan.mkdir(sectionsDir.c_str());
+  // Create cache directories if they don't exist
+  selectLayout(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth, viewportHeight,
+               hyphenationEnabled);
+  SdMan.mkdir(sectionsDir.c_str());
+  SdMan.mkdir(SectionProfiles::profileDir(sectionsDir, layoutFingerprint).c_str());
+
+  if (file) {
+    file.close();
   }
+  dropPageCache();
+  // The old file is replaced below, successful or not, so it no longer counts towards the profile's size
+  if (SdMan.exists(filePath.c_str())) {
+    SectionProfiles(sectionsDir, epub->getSpineItemsCount()).release(layoutFingerprint, fileSize(filePath));
+  }
+  const auto beginSectionFile = [&] {
+    if (!SdMan.openFileForWrite("SCT", filePath, file)) {
+      return false;
+    }
+    pageCount = 0;
+    lut.clear();
+    writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                           viewportHeight, hyphenationEnabled);
+    return true;
+  };
+  const auto onPage = [this](std::unique_ptr<Page> page) { lut.emplace_back(this->onPageComplete(std::move(page))); };
+  Hyphenator::setPreferredLanguage(epub->getLanguage());
 
-  // Retry logic for SD card timing issues
+  // The chapter's words and blocks don't depend on layout settings, so once recorded a settings change only has to
+  // lay them out again, without inflating and parsing the XHTML
   bool success = false;
-  uint32_t fileSize = 0;
+  bool progressShown = false;
+  FsFile tokens;
+  if (SdMan.exists(tokensPath.c_str()) && SdMan.openFileForRead("SCT", tokensPath, tokens)) {
+    const size_t tokensSize = tokens.size();
+    if (progressSetupFn && tokensSize >= MIN_SIZE_FOR_PROGRESS) {
+      progressSetupFn();
+      progressShown = true;
+    }
+    if (!beginSectionFile()) {
+      tokens.close();
+      return false;
+    }
+    ChapterHtmlSlimParser visitor(
+        [&tokens](uint8_t* buf, const size_t len) {
+          const int n = tokens.read(buf, len);
+          return n > 0 ? static_cast<size_t>(n) : 0;
+        },
+        tokensSize, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+        viewportHeight, hyphenationEnabled, onPage, progressFn, abortFn);
+    success = visitor.buildPagesFromTokens();
+    tokens.close();
+    if (!success) {
+      file.close();
+      SdMan.remove(filePath.c_str());
+      if (abortFn && abortFn()) {
+        return false;
+      }
+      Serial.printf("[%lu] [SCT] Could not lay out chapter tokens, parsing the chapter again\n", millis());
+      SdMan.remove(tokensPath.c_str());
+    }
+  }
+
+  // The chapter is inflated straight out of the EPUB into the XML parser, so there is no temp file to fall back on.
+  // A failed SD read mid-chapter restarts the whole pass; a parse error does not.
+  // Streams through the book's zip session; renderingMutex keeps the background builder and the reader task apart.
+  ZipFile::InflateReader reader(epub->getZip());
   for (int attempt = 0; attempt < 3 && !success; attempt++) {
     if (attempt > 0) {
       Serial.printf("[%lu] [SCT] Retrying stream (attempt %d)...\n", millis(), attempt + 1);
       delay(50);  // Brief delay before retry
     }
 
-    // Remove any incomplete file from previous attempt before retrying
-    if (SdMan.exists(tmpHtmlPath.c_str())) {
-      SdMan.remove(tmpHtmlPath.c_str());
-    }
-
-    FsFile tmpHtml;
-    if (!SdMan.openFileForWrite("SCT", tmpHtmlPath, tmpHtml)) {
+    if (!reader.begin(itemPath.c_str(), 1024)) {
       continue;
     }
-    success = epub->readItemContentsToStream(localPath, tmpHtml, 1024);
-    fileSize = tmpHtml.size();
-    tmpHtml.close();
+    const size_t contentSize = reader.getInflatedSize();
 
-    // If streaming failed, remove the incomplete file immediately
-    if (!success && SdMan.exists(tmpHtmlPath.c_str())) {
-      SdMan.remove(tmpHtmlPath.c_str());
-      Serial.printf("[%lu] [SCT] Removed incomplete temp file after failed attempt\n", millis());
+    // Only show progress bar for larger chapters where rendering overhead is worth it
+    if (progressSetupFn && !progressShown && contentSize >= MIN_SIZE_FOR_PROGRESS) {
+      progressSetupFn();
+      progressShown = true;
     }
-  }
 
-  if (!success) {
-    Serial.printf("[%lu] [SCT] Failed to stream item contents to temp file after retries\n", millis());
-    return false;
-  }
-
-  Serial.printf("[%lu] [SCT] Streamed temp HTML to %s (%d bytes)\n", millis(), tmpHtmlPath.c_str(), fileSize);
-
-  // Only show progress bar for larger chapters where rendering overhead is worth it
-  if (progressSetupFn && fileSize >= MIN_SIZE_FOR_PROGRESS) {
-    progressSetupFn();
-  }
+    if (!beginSectionFile()) {
+      reader.end();
+      return false;
+    }
 
-  if (!SdMan.openFileForWrite("SCT", filePath, file)) {
-    return false;
+    ChapterHtmlSlimParser visitor(
+        [&reader](uint8_t* buf, const size_t len) { return reader.read(buf, len); }, contentSize, renderer, fontId,
+        lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth, viewportHeight, hyphenationEnabled,
+        onPage, progressFn, abortFn);
+    // Without the tokens this chapter is simply parsed again next time
+    if (SdMan.openFileForWrite("SCT", tokensPath, tokens)) {
+      visitor.recordTokens([&tokens](const uint8_t* buf, const size_t len) { return tokens.write(buf, len) == len; });
+    }
+    success = visitor.parseAndBuildPages();
+
+    const bool streamFailed = reader.hasFailed();
+    reader.end();
+    if (tokens) {
+      tokens.close();
+      if (!success || visitor.hasTokenWriteFailed()) {
+        SdMan.remove(tokensPath.c_str());
+      }
+    }
+    if (!success) {
+      file.close();
+      SdMan.remove(filePath.c_str());
+      if (!streamFailed) {
+        break;
+      }
+    }
   }
-  writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
-                         viewportHeight, hyphenationEnabled);
-  std::vector<uint32_t> lut = {};
 
-  ChapterHtmlSlimParser visitor(
-      tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
-      viewportHeight, hyphenationEnabled,
-      [this, &lut](std::unique_ptr<Page> page) { lut.emplace_back(this->onPageComplete(std::move(page))); },
-      progressFn);
-  Hyphenator::setPreferredLanguage(epub->getLanguage());
-  success = visitor.parseAndBuildPages();
-
-  SdMan.remove(tmpHtmlPath.c_str());
   if (!success) {
     Serial.printf("[%lu] [SCT] Failed to parse XML and build pages\n", millis());
-    file.close();
-    SdMan.remove(filePath.c_str());
+    lut.clear();
     return false;
   }
 
   const uint32_t lutOffset = file.position();
   bool hasFailedLutRecords = false;
   // Write LUT
-  for (const uint32_t& pos : lut) {
-    if (pos == 0) {
-      hasFailedLutRecords = true;
-      break;
+  {
+    serialization::BufferedFileWriter lutWriter(file);
+    for (const uint32_t& pos : lut) {
+      if (pos == 0) {
+        hasFailedLutRecords = true;
+        break;
+      }
+      serialization::writePod(lutWriter, pos);
     }
-    serialization::writePod(file, pos);
   }
 
   if (hasFailedLutRecords) {
     Serial.printf("[%lu] [SCT] Failed to write LUT due to invalid page positions\n", millis());
     file.close();
     SdMan.remove(filePath.c_str());
+    lut.clear();
     return false;
   }
 
@@ -222,23 +351,60 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
   serialization::writePod(file, pageCount);
   serialization::writePod(file, lutOffset);
   file.close();
+  SectionProfiles(sectionsDir, epub->getSpineItemsCount())
+      .touch(layoutFingerprint, lutOffset + lut.size() * sizeof(uint32_t));
   return true;
 }
 
-std::unique_ptr<Page> Section::loadPageFromSectionFile() {
-  if (!SdMan.openFileForRead("SCT", filePath, file)) {
-    return nullptr;
+void Section::dropPageCache() {
+  for (auto& cached : pageCache) {
+    cached = CachedPage{};
   }
+  lastLoadedPage = -1;
+  readingBackwards = false;
+}
 
-  file.seek(HEADER_SIZE - sizeof(uint32_t));
-  uint32_t lutOffset;
-  serialization::readPod(file, lutOffset);
-  file.seek(lutOffset + sizeof(uint32_t) * currentPage);
-  uint32_t pagePos;
-  serialization::readPod(file, pagePos);
-  file.seek(pagePos);
+std::shared_ptr<Page> Section::loadPage(const int index) {
+  for (auto& cached : pageCache) {
+    if (cached.index == index) {
+      cached.lastUse = ++pageCacheClock;
+      return cached.page;
+    }
+  }
 
-  auto page = Page::deserialize(file);
-  file.close();
+  if (index < 0 || static_cast<size_t>(index) >= lut.size()) {
+    return nullptr;
+  }
+  if (!file && !SdMan.openFileForRead("SCT", filePath, file)) {
+    return nullptr;
+  }
+  if (!file.seek(lut[index])) {
+    return nullptr;
+  }
+  std::shared_ptr<Page> page = Page::deserialize(file);
+  if (!page) {
+    return nullptr;
+  }
+
+  auto* victim = &pageCache[0];
+  for (auto& cached : pageCache) {
+    if (cached.lastUse < victim->lastUse) {
+      victim = &cached;
+    }
+  }
+  *victim = CachedPage{index, ++pageCacheClock, page};
   return page;
 }
+
+std::shared_ptr<Page> Section::loadPageFromSectionFile() {
+  readingBackwards = lastLoadedPage >= 0 && currentPage < lastLoadedPage;
+  lastLoadedPage = currentPage;
+  return loadPage(currentPage);
+}
+
+void Section::readAhead() {
+  const int next = readingBackwards ? currentPage - 1 : currentPage + 1;
+  if (next >= 0 && next < pageCount) {
+    loadPage(next);
+  }
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "Epub.h"
 
@@ -8,15 +9,41 @@ class Page;
 class GfxRenderer;
 
 class Section {
+  // Deserialized pages kept in RAM: the current one and its neighbours either side
+  static constexpr size_t PAGE_CACHE_SIZE = 3;
+
+  struct CachedPage {
+    int index = -1;
+    uint32_t lastUse = 0;
+    std::shared_ptr<Page> page;
+  };
+
   std::shared_ptr<Epub> epub;
   const int spineIndex;
   GfxRenderer& renderer;
+  std::string sectionsDir;
+  // Set once the layout is known: section files for each layout live apart, so switching back to one used before
+  // finds its pages already built
   std::string filePath;
+  uint32_t layoutFingerprint = 0;
+  // The chapter's words and blocks independent of layout settings, kept across rebuilds of the section file
+  std::string tokensPath;
+  // Written while building; afterwards held open for reading pages until the section goes away
   FsFile file;
+  // Offset of every page record, so a page is one seek away
+  std::vector<uint32_t> lut;
+  CachedPage pageCache[PAGE_CACHE_SIZE];
+  uint32_t pageCacheClock = 0;
+  int lastLoadedPage = -1;
+  bool readingBackwards = false;
 
+  void selectLayout(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
+                    uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled);
   void writeSectionFileHeader(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                               uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled);
   uint32_t onPageComplete(std::unique_ptr<Page> page);
+  void dropPageCache();
+  std::shared_ptr<Page> loadPage(int index);
 
  public:
   uint16_t pageCount = 0;
@@ -26,14 +53,26 @@ class Section {
       : epub(epub),
         spineIndex(spineIndex),
         renderer(renderer),
-        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin") {}
-  ~Section() = default;
+        sectionsDir(epub->getCachePath() + "/sections"),
+        tokensPath(sectionsDir + "/" + std::to_string(spineIndex) + ".tok") {}
+  ~Section() {
+    if (file) {
+      file.close();
+    }
+  }
   bool loadSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                        uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled);
-  bool clearCache() const;
+  bool clearCache();
   bool createSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                          uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
                          const std::function<void()>& progressSetupFn = nullptr,
-                         const std::function<void(int)>& progressFn = nullptr);
-  std::unique_ptr<Page> loadPageFromSectionFile();
+                         const std::function<void(int)>& progressFn = nullptr,
+                         const std::function<bool()>& abortFn = nullptr);
+  // Directory of the section files for the layout last loaded or built
+  std::string getProfileDir() const;
+  // Returns currentPage, from RAM when it is cached
+  std::shared_ptr<Page> loadPageFromSectionFile();
+  // Loads the page the reader is likely to turn to next into the cache: the one after currentPage, or the one before
+  // when they are paging backwards. Meant for the time after a page is shown, so the next turn does no SD I/O.
+  void readAhead();
 };
@@ -0,0 +1,155 @@
+#include "SectionProfiles.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace {
+constexpr uint8_t PROFILES_FILE_VERSION = 1;
+constexpr char PROFILES_FILE[] = "/profiles.bin";
+
+// Names of the directories, or of the files with their sizes, directly in dir
+void listDir(const std::string& dir, const bool directories, std::vector<std::pair<std::string, uint32_t>>& out) {
+  auto root = SdMan.open(dir.c_str());
+  if (!root || !root.isDirectory()) {
+    if (root) root.close();
+    return;
+  }
+  char name[64];
+  for (auto entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+    if (entry.isDirectory() == directories) {
+      entry.getName(name, sizeof(name));
+      out.emplace_back(name, directories ? 0 : static_cast<uint32_t>(entry.size()));
+    }
+    entry.close();
+  }
+  root.close();
+}
+}  // namespace
+
+std::string SectionProfiles::profileDir(const std::string& sectionsDir, const uint32_t fingerprint) {
+  char name[10];
+  snprintf(name, sizeof(name), "/%08lx", static_cast<unsigned long>(fingerprint));
+  return sectionsDir + name;
+}
+
+bool SectionProfiles::load() {
+  profiles.clear();
+  FsFile file;
+  if (!SdMan.openFileForRead("SPR", sectionsDir + PROFILES_FILE, file)) {
+    return false;
+  }
+  uint8_t version = 0;
+  uint8_t count = 0;
+  serialization::readPod(file, version);
+  serialization::readPod(file, count);
+  if (version != PROFILES_FILE_VERSION) {
+    file.close();
+    return false;
+  }
+  profiles.resize(count);
+  const int bytes = count * sizeof(Profile);
+  const bool ok = file.read(reinterpret_cast<uint8_t*>(profiles.data()), bytes) == bytes;
+  file.close();
+  if (!ok) {
+    profiles.clear();
+  }
+  return ok;
+}
+
+bool SectionProfiles::save() const {
+  FsFile file;
+  if (!SdMan.openFileForWrite("SPR", sectionsDir + PROFILES_FILE, file)) {
+    return false;
+  }
+  serialization::writePod(file, PROFILES_FILE_VERSION);
+  serialization::writePod(file, static_cast<uint8_t>(profiles.size()));
+  const size_t bytes = profiles.size() * sizeof(Profile);
+  const bool ok = file.write(reinterpret_cast<const uint8_t*>(profiles.data()), bytes) == bytes;
+  file.close();
+  return ok;
+}
+
+// Section files from before profiles, and the profile directories of a lost or damaged list. Those are no longer
+// counted against the limits, so they would never be evicted. Returns the bytes of keptFingerprint's section files,
+// which is still in use and kept.
+uint32_t SectionProfiles::removeUnprofiledSections(const uint32_t keptFingerprint) const {
+  for (int i = 0; i < spineCount; i++) {
+    const auto path = sectionsDir + "/" + std::to_string(i) + ".bin";
+    if (SdMan.exists(path.c_str())) {
+      SdMan.remove(path.c_str());
+    }
+  }
+
+  const std::string keptDir = profileDir(sectionsDir, keptFingerprint);
+  std::vector<std::pair<std::string, uint32_t>> entries;
+  listDir(sectionsDir, true, entries);
+  for (const auto& [name, bytes] : entries) {
+    const std::string dir = sectionsDir + "/" + name;
+    if (dir != keptDir) {
+      Serial.printf("[%lu] [SPR] Removing unlisted layout profile %s\n", millis(), name.c_str());
+      SdMan.removeDir(dir.c_str());
+    }
+  }
+
+  uint32_t keptBytes = 0;
+  entries.clear();
+  listDir(keptDir, false, entries);
+  for (const auto& [name, bytes] : entries) {
+    keptBytes += bytes;
+  }
+  return keptBytes;
+}
+
+bool SectionProfiles::touch(const uint32_t fingerprint, uint32_t addedBytes) {
+  if (!load()) {
+    // The files already in fingerprint's directory are measured, which includes any addedBytes just written
+    profiles.push_back({fingerprint, 0});
+    addedBytes = removeUnprofiledSections(fingerprint);
+  }
+  if (!profiles.empty() && profiles.front().fingerprint == fingerprint && addedBytes == 0) {
+    return true;
+  }
+
+  Profile current = {fingerprint, 0};
+  for (auto it = profiles.begin(); it != profiles.end(); ++it) {
+    if (it->fingerprint == fingerprint) {
+      current = *it;
+      profiles.erase(it);
+      break;
+    }
+  }
+  current.bytes += addedBytes;
+  profiles.insert(profiles.begin(), current);
+
+  uint64_t totalBytes = 0;
+  for (const auto& profile : profiles) {
+    totalBytes += profile.bytes;
+  }
+  while (profiles.size() > 1 && (profiles.size() > static_cast<size_t>(maxProfiles) || totalBytes > maxBytes)) {
+    const Profile oldest = profiles.back();
+    Serial.printf("[%lu] [SPR] Evicting layout profile %08lx (%lu bytes)\n", millis(),
+                  static_cast<unsigned long>(oldest.fingerprint), static_cast<unsigned long>(oldest.bytes));
+    SdMan.removeDir(profileDir(sectionsDir, oldest.fingerprint).c_str());
+    totalBytes -= oldest.bytes;
+    profiles.pop_back();
+  }
+  return save();
+}
+
+bool SectionProfiles::release(const uint32_t fingerprint, const uint32_t removedBytes) {
+  if (removedBytes == 0 || !load()) {
+    return true;
+  }
+  for (auto& profile : profiles) {
+    if (profile.fingerprint == fingerprint) {
+      profile.bytes -= std::min(profile.bytes, removedBytes);
+      return save();
+    }
+  }
+  return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The layout profiles a book has section files for. Each profile is a directory under the book's sections directory
+// named by its layout fingerprint. The list is kept most recently used first along with the bytes each profile's
+// section files take, so the oldest profiles can be evicted once there are too many or they take too much space.
+class SectionProfiles {
+ public:
+  static constexpr int MAX_PROFILES = 4;
+  static constexpr uint32_t MAX_BYTES = 24 * 1024 * 1024;
+
+  struct Profile {
+    uint32_t fingerprint;
+    uint32_t bytes;
+  };
+
+  SectionProfiles(std::string sectionsDir, int spineCount, int maxProfiles = MAX_PROFILES,
+                  uint32_t maxBytes = MAX_BYTES)
+      : sectionsDir(std::move(sectionsDir)), spineCount(spineCount), maxProfiles(maxProfiles), maxBytes(maxBytes) {}
+
+  static std::string profileDir(const std::string& sectionsDir, uint32_t fingerprint);
+  // Makes fingerprint the most recently used profile, adding addedBytes to its size, then evicts the oldest other
+  // profiles beyond the count and size limits. Only writes the list when something changed. Without a readable list,
+  // the other profiles' directories are removed and fingerprint's is measured again.
+  bool touch(uint32_t fingerprint, uint32_t addedBytes = 0);
+  // Takes removedBytes off fingerprint's size once one of its section files is deleted or about to be rewritten
+  bool release(uint32_t fingerprint, uint32_t removedBytes);
+  const std::vector<Profile>& getProfiles() const { return profiles; }
+
+ private:
+  std::string sectionsDir;
+  int spineCount;
+  int maxProfiles;
+  uint32_t maxBytes;
+  std::vector<Profile> profiles;
+
+  bool load();
+  bool save() const;
+  uint32_t removeUnprofiledSections(uint32_t keptFingerprint) const;
+};
@@ -4,54 +4,58 @@
 #include <Serialization.h>
 
 void TextBlock::render(const GfxRenderer& renderer, const int fontId, const int x, const int y) const {
-  // Validate iterator bounds before rendering
-  if (words.size() != wordXpos.size() || words.size() != wordStyles.size()) {
-    Serial.printf("[%lu] [TXB] Render skipped: size mismatch (words=%u, xpos=%u, styles=%u)\n", millis(),
-                  (uint32_t)words.size(), (uint32_t)wordXpos.size(), (uint32_t)wordStyles.size());
+  const EpdFontFamily* font = renderer.getFont(fontId);
+  if (!font) {
     return;
   }
-
-  auto wordIt = words.begin();
-  auto wordStylesIt = wordStyles.begin();
-  auto wordXposIt = wordXpos.begin();
-
-  for (size_t i = 0; i < words.size(); i++) {
-    renderer.drawText(fontId, *wordXposIt + x, y, wordIt->c_str(), true, *wordStylesIt);
-
-    std::advance(wordIt, 1);
-    std::advance(wordStylesIt, 1);
-    std::advance(wordXposIt, 1);
+  for (const auto& word : words) {
+    renderer.drawText(*font, word.xPos + x, y, text.c_str() + word.offset, true, word.style);
   }
 }
 
-bool TextBlock::serialize(FsFile& file) const {
-  if (words.size() != wordXpos.size() || words.size() != wordStyles.size()) {
-    Serial.printf("[%lu] [TXB] Serialization failed: size mismatch (words=%u, xpos=%u, styles=%u)\n", millis(),
-                  words.size(), wordXpos.size(), wordStyles.size());
-    return false;
+bool TextBlock::serialize(std::vector<uint8_t>& record) const {
+  // Block style
+  record.push_back(style);
+
+  // Word lengths, then every word back to back in one blob
+  serialization::writeVarint(record, words.size());
+  uint32_t textLength = 0;
+  for (const auto& w : words) {
+    serialization::writeVarint(record, w.length);
+    textLength += w.length;
+  }
+  serialization::writeVarint(record, textLength);
+  for (const auto& w : words) {
+    record.insert(record.end(), text.begin() + w.offset, text.begin() + w.offset + w.length);
   }
 
-  // Word data
-  serialization::writePod(file, static_cast<uint16_t>(words.size()));
-  for (const auto& w : words) serialization::writeString(file, w);
-  for (auto x : wordXpos) serialization::writePod(file, x);
-  for (auto s : wordStyles) serialization::writePod(file, s);
+  // X positions as deltas from the previous word
+  int32_t previousX = 0;
+  for (const auto& w : words) {
+    serialization::writeSignedVarint(record, w.xPos - previousX);
+    previousX = w.xPos;
+  }
 
-  // Block style
-  serialization::writePod(file, style);
+  // Styles packed four to a byte, first word in the low bits
+  uint8_t packed = 0;
+  for (size_t i = 0; i < words.size(); i++) {
+    packed |= (words[i].style & 0x03) << (2 * (i % 4));
+    if (i % 4 == 3) {
+      record.push_back(packed);
+      packed = 0;
+    }
+  }
+  if (words.size() % 4 != 0) record.push_back(packed);
 
   return true;
 }
 
-std::unique_ptr<TextBlock> TextBlock::deserialize(FsFile& file) {
-  uint16_t wc;
-  std::list<std::string> words;
-  std::list<uint16_t> wordXpos;
-  std::list<EpdFontFamily::Style> wordStyles;
-  Style style;
+std::unique_ptr<TextBlock> TextBlock::deserialize(serialization::RecordReader& reader) {
+  // Block style
+  const auto style = static_cast<Style>(reader.readByte());
 
   // Word count
-  serialization::readPod(file, wc);
+  const uint32_t wc = reader.readVarint();
 
   // Sanity check: prevent allocation of unreasonably large lists (max 10000 words per block)
   if (wc > 10000) {
@@ -60,15 +64,42 @@ std::unique_ptr<TextBlock> TextBlock::deserialize(FsFile& file) {
   }
 
   // Word data
-  words.resize(wc);
-  wordXpos.resize(wc);
-  wordStyles.resize(wc);
-  for (auto& w : words) serialization::readString(file, w);
-  for (auto& x : wordXpos) serialization::readPod(file, x);
-  for (auto& s : wordStyles) serialization::readPod(file, s);
+  std::vector<Word> words(wc);
+  uint32_t lengthSum = 0;
+  for (auto& w : words) {
+    w.length = reader.readVarint();
+    lengthSum += w.length;
+  }
+  const uint32_t textLength = reader.readVarint();
+  const auto* blob = reinterpret_cast<const char*>(reader.readBytes(textLength));
+  // Offsets into the line text are 16 bits, including a NUL after each word
+  if (!blob || lengthSum != textLength || textLength + wc > UINT16_MAX) {
+    Serial.printf("[%lu] [TXB] Deserialization failed: corrupt word data\n", millis());
+    return nullptr;
+  }
+  std::string text;
+  text.reserve(textLength + wc);
+  for (auto& w : words) {
+    w.offset = text.size();
+    text.append(blob, w.length);
+    text.push_back('\0');
+    blob += w.length;
+  }
 
-  // Block style
-  serialization::readPod(file, style);
+  int32_t x = 0;
+  for (auto& w : words) {
+    x += reader.readSignedVarint();
+    w.xPos = static_cast<uint16_t>(x);
+  }
+
+  const uint8_t* packed = reader.readBytes((wc + 3) / 4);
+  if (!packed || reader.hasFailed()) {
+    Serial.printf("[%lu] [TXB] Deserialization failed: record truncated\n", millis());
+    return nullptr;
+  }
+  for (uint32_t i = 0; i < wc; i++) {
+    words[i].style = static_cast<EpdFontFamily::Style>((packed[i / 4] >> (2 * (i % 4))) & 0x03);
+  }
 
-  return std::unique_ptr<TextBlock>(new TextBlock(std::move(words), std::move(wordXpos), std::move(wordStyles), style));
+  return std::unique_ptr<TextBlock>(new TextBlock(std::move(text), std::move(words), style));
 }
@@ -2,12 +2,16 @@
 #include <EpdFontFamily.h>
 #include <SdFat.h>
 
-#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Block.h"
 
+namespace serialization {
+class RecordReader;
+}
+
 // Represents a line of text on a page
 class TextBlock final : public Block {
  public:
@@ -18,16 +22,22 @@ class TextBlock final : public Block {
     RIGHT_ALIGN = 3,
   };
 
+  // A word of the line, stored NUL-terminated in the line's text at offset
+  struct Word {
+    uint16_t offset;
+    uint16_t length;
+    uint16_t xPos;
+    EpdFontFamily::Style style;
+  };
+
  private:
-  std::list<std::string> words;
-  std::list<uint16_t> wordXpos;
-  std::list<EpdFontFamily::Style> wordStyles;
+  std::string text;
+  std::vector<Word> words;
   Style style;
 
  public:
-  explicit TextBlock(std::list<std::string> words, std::list<uint16_t> word_xpos,
-                     std::list<EpdFontFamily::Style> word_styles, const Style style)
-      : words(std::move(words)), wordXpos(std::move(word_xpos)), wordStyles(std::move(word_styles)), style(style) {}
+  explicit TextBlock(std::string text, std::vector<Word> words, const Style style)
+      : text(std::move(text)), words(std::move(words)), style(style) {}
   ~TextBlock() override = default;
   void setStyle(const Style style) { this->style = style; }
   Style getStyle() const { return style; }
@@ -36,6 +46,9 @@ class TextBlock final : public Block {
   // given a renderer works out where to break the words into lines
   void render(const GfxRenderer& renderer, int fontId, int x, int y) const;
   BlockType getType() override { return TEXT_BLOCK; }
-  bool serialize(FsFile& file) const;
-  static std::unique_ptr<TextBlock> deserialize(FsFile& file);
+  const std::vector<Word>& getWords() const { return words; }
+  const char* getWordText(const Word& word) const { return text.c_str() + word.offset; }
+  // Appends the block to a page record, see the section.bin layout in docs/file-formats.md
+  bool serialize(std::vector<uint8_t>& record) const;
+  static std::unique_ptr<TextBlock> deserialize(serialization::RecordReader& reader);
 };
@@ -38,6 +38,42 @@ uint32_t toLowerCyrillicImpl(const uint32_t cp) {
   return cp;
 }
 
+// Bytes in the UTF-8 sequence starting with lead, as utf8NextCodepoint consumes them
+size_t utf8SequenceLength(const unsigned char lead) {
+  if ((lead >> 5) == 0x6) return 2;
+  if ((lead >> 4) == 0xE) return 3;
+  if ((lead >> 3) == 0x1E) return 4;
+  return 1;
+}
+
+// Narrows [begin, end) to the word without surrounding punctuation or a trailing footnote reference
+template <typename ValueAt>
+void trimmedRange(const ValueAt& valueAt, size_t& begin, size_t& end) {
+  // Remove trailing footnote references like [12], even if punctuation trails after the closing bracket.
+  if (end - begin >= 3) {
+    size_t last = end;
+    while (last > begin && isPunctuation(valueAt(last - 1))) {
+      --last;
+    }
+    size_t pos = last;
+    if (pos > begin && isAsciiDigit(valueAt(pos - 1))) {
+      while (pos > begin && isAsciiDigit(valueAt(pos - 1))) {
+        --pos;
+      }
+      if (pos > begin && valueAt(pos - 1) == '[' && last - pos > 1) {
+        end = pos - 1;
+      }
+    }
+  }
+
+  while (begin < end && isPunctuation(valueAt(begin))) {
+    ++begin;
+  }
+  while (end > begin && isPunctuation(valueAt(end - 1))) {
+    --end;
+  }
+}
+
 }  // namespace
 
 uint32_t toLowerLatin(const uint32_t cp) { return toLowerLatinImpl(cp); }
@@ -136,33 +172,19 @@ bool isExplicitHyphen(const uint32_t cp) {
 bool isSoftHyphen(const uint32_t cp) { return cp == 0x00AD; }
 
 void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
-  if (cps.empty()) {
-    return;
-  }
-
-  // Remove trailing footnote references like [12], even if punctuation trails after the closing bracket.
-  if (cps.size() >= 3) {
-    int end = static_cast<int>(cps.size()) - 1;
-    while (end >= 0 && isPunctuation(cps[end].value)) {
-      --end;
-    }
-    int pos = end;
-    if (pos >= 0 && isAsciiDigit(cps[pos].value)) {
-      while (pos >= 0 && isAsciiDigit(cps[pos].value)) {
-        --pos;
-      }
-      if (pos >= 0 && cps[pos].value == '[' && end - pos > 1) {
-        cps.erase(cps.begin() + pos, cps.end());
-      }
-    }
-  }
+  size_t begin = 0;
+  size_t end = cps.size();
+  trimmedRange([&cps](const size_t i) { return cps[i].value; }, begin, end);
+  cps.erase(cps.begin() + end, cps.end());
+  cps.erase(cps.begin(), cps.begin() + begin);
+}
 
-  while (!cps.empty() && isPunctuation(cps.front().value)) {
-    cps.erase(cps.begin());
-  }
-  while (!cps.empty() && isPunctuation(cps.back().value)) {
-    cps.pop_back();
-  }
+void trimSurroundingPunctuationAndFootnote(WordCodepoints& cps) {
+  size_t begin = cps.first;
+  size_t end = cps.first + cps.count;
+  trimmedRange([&cps](const size_t i) { return cps.values[i]; }, begin, end);
+  cps.first = begin;
+  cps.count = end - begin;
 }
 
 std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
@@ -179,3 +201,24 @@ std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
 
   return cps;
 }
+
+bool collectCodepoints(const std::string_view word, WordCodepoints& out) {
+  out.first = 0;
+  out.count = 0;
+  if (word.size() > kMaxHyphenatedWordBytes) {
+    return false;
+  }
+
+  const auto* base = reinterpret_cast<const unsigned char*>(word.data());
+  const auto* ptr = base;
+  const auto* end = base + word.size();
+  while (ptr < end && *ptr != 0) {
+    // The word need not be null-terminated, so a sequence cut short at its end is dropped rather than read past it
+    if (ptr + utf8SequenceLength(*ptr) > end) {
+      break;
+    }
+    out.byteOffsets[out.count] = static_cast<uint8_t>(ptr - base);
+    out.values[out.count++] = utf8NextCodepoint(&ptr);
+  }
+  return true;
+}
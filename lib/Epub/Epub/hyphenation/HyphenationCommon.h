@@ -3,13 +3,26 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Longest word, in bytes, that gets hyphenated. Matches MAX_WORD_SIZE in ChapterHtmlSlimParser, the longest word it
+// hands to layout, and sizes the stack buffers of the allocation-free paths.
+constexpr size_t kMaxHyphenatedWordBytes = 200;
+
 struct CodepointInfo {
   uint32_t value;
   size_t byteOffset;
 };
 
+// Fixed-capacity codepoints of a word; [first, first + count) is what is left after trimming
+struct WordCodepoints {
+  uint32_t values[kMaxHyphenatedWordBytes];
+  uint8_t byteOffsets[kMaxHyphenatedWordBytes];
+  size_t first = 0;
+  size_t count = 0;
+};
+
 uint32_t toLowerLatin(uint32_t cp);
 uint32_t toLowerCyrillic(uint32_t cp);
 
@@ -23,3 +36,8 @@ bool isExplicitHyphen(uint32_t cp);
 bool isSoftHyphen(uint32_t cp);
 void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps);
 std::vector<CodepointInfo> collectCodepoints(const std::string& word);
+
+// Allocation-free counterparts of the two above. collectCodepoints returns false, leaving nothing collected, for words
+// longer than kMaxHyphenatedWordBytes.
+bool collectCodepoints(std::string_view word, WordCodepoints& out);
+void trimSurroundingPunctuationAndFootnote(WordCodepoints& cps);
@@ -1,6 +1,6 @@
 #include "Hyphenator.h"
 
-#include <vector>
+#include <cstdlib>
 
 #include "HyphenationCommon.h"
 #include "LanguageRegistry.h"
@@ -26,72 +26,161 @@ const LanguageHyphenator* hyphenatorForLanguage(const std::string& langTag) {
   return getLanguageHyphenatorForPrimaryTag(primary);
 }
 
-// Maps a codepoint index back to its byte offset inside the source word.
-size_t byteOffsetForIndex(const std::vector<CodepointInfo>& cps, const size_t index) {
-  return (index < cps.size()) ? cps[index].byteOffset : (cps.empty() ? 0 : cps.back().byteOffset);
+// Cache of the language breaks of recently hyphenated words, so the common long words of a book only run the Liang
+// patterns once. Words up to 64 bytes without explicit hyphens are kept as a 64-bit FNV-1a hash of their text plus a
+// bit per byte offset they may break at; all such breaks take an inserted hyphen. It is 4-way set associative, and a
+// set only takes a new word once a miss finds a way that has not been hit since the last misses aged it, so the
+// frequent words stay while the long tail passes through. Allocated on first use and tied to the active language, it
+// is dropped whenever that changes.
+constexpr size_t kCacheSets = 64;
+constexpr size_t kCacheWays = 4;
+constexpr size_t kCachedWordBytes = 64;
+constexpr uint8_t kMaxCacheHits = 3;
+
+struct WordCacheSet {
+  uint64_t keys[kCacheWays];  // 0 for an empty way
+  uint64_t breakMasks[kCacheWays];
+  uint8_t hits[kCacheWays];
+};
+
+WordCacheSet* wordCache = nullptr;
+
+void dropWordCache() {
+  free(wordCache);
+  wordCache = nullptr;
 }
 
-// Builds a vector of break information from explicit hyphen markers in the given codepoints.
-std::vector<Hyphenator::BreakInfo> buildExplicitBreakInfos(const std::vector<CodepointInfo>& cps) {
-  std::vector<Hyphenator::BreakInfo> breaks;
-
-  // Scan every codepoint looking for explicit/soft hyphen markers that are surrounded by letters.
-  for (size_t i = 1; i + 1 < cps.size(); ++i) {
-    const uint32_t cp = cps[i].value;
-    if (!isExplicitHyphen(cp) || !isAlphabetic(cps[i - 1].value) || !isAlphabetic(cps[i + 1].value)) {
-      continue;
+struct WordCacheSlot {
+  WordCacheSet* set = nullptr;
+  uint64_t key = 0;
+  int way = -1;  // The way holding the word, or -1
+};
+
+// The set a word maps to and its way there, if any. set stays nullptr when the word is not cacheable.
+WordCacheSlot findInWordCache(const std::string_view word) {
+  WordCacheSlot slot;
+  if (word.size() > kCachedWordBytes) {
+    return slot;
+  }
+  if (!wordCache) {
+    wordCache = static_cast<WordCacheSet*>(calloc(kCacheSets, sizeof(WordCacheSet)));
+    if (!wordCache) {
+      return slot;
+    }
+  }
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : word) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  slot.key = hash != 0 ? hash : 1;
+  slot.set = &wordCache[hash % kCacheSets];
+  for (size_t way = 0; way < kCacheWays; way++) {
+    if (slot.set->keys[way] == slot.key) {
+      slot.way = static_cast<int>(way);
+      if (slot.set->hits[way] < kMaxCacheHits) {
+        slot.set->hits[way]++;
+      }
+      break;
     }
-    // Offset points to the next codepoint so rendering starts after the hyphen marker.
-    breaks.push_back({cps[i + 1].byteOffset, isSoftHyphen(cp)});
   }
+  return slot;
+}
 
-  return breaks;
+// Stores a missed word in the way that has been hit least, or ages the set if every way has been hit since
+void storeInWordCache(const WordCacheSlot& slot, const uint64_t breakMask) {
+  size_t coldest = 0;
+  for (size_t way = 1; way < kCacheWays; way++) {
+    if (slot.set->hits[way] < slot.set->hits[coldest]) {
+      coldest = way;
+    }
+  }
+  if (slot.set->hits[coldest] > 0) {
+    for (auto& hits : slot.set->hits) {
+      hits = hits > 0 ? hits - 1 : 0;
+    }
+    return;
+  }
+  slot.set->keys[coldest] = slot.key;
+  slot.set->breakMasks[coldest] = breakMask;
 }
 
+// Working buffers for the word being hyphenated, kept off the stack of the task laying out text: the background section
+// build runs deep in the XML parser on an 8KB stack. Like the word cache they hold one word at a time, which holds as
+// layout only runs under the reader's rendering mutex.
+WordCodepoints scratchCodepoints;
+uint8_t scratchIndexes[kMaxHyphenatedWordBytes];
+
 }  // namespace
 
-std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& word, const bool includeFallback) {
+size_t Hyphenator::minPrefix() { return cachedHyphenator_ ? cachedHyphenator_->minPrefix() : 0; }
+
+Hyphenator::Breaks Hyphenator::breakOffsets(const std::string_view word, const bool includeFallback) {
+  Breaks breaks;
   if (word.empty()) {
-    return {};
+    return breaks;
   }
 
-  // Convert to codepoints and normalize word boundaries.
-  auto cps = collectCodepoints(word);
-  trimSurroundingPunctuationAndFootnote(cps);
   const auto* hyphenator = cachedHyphenator_;
+  const WordCacheSlot slot = hyphenator ? findInWordCache(word) : WordCacheSlot{};
+  const bool cached = slot.way >= 0;
+  if (cached) {
+    for (uint64_t mask = slot.set->breakMasks[slot.way]; mask != 0; mask &= mask - 1) {
+      breaks.push(__builtin_ctzll(mask), true);
+    }
+    if (!breaks.empty() || !includeFallback) {
+      return breaks;
+    }
+  }
 
-  // Explicit hyphen markers (soft or hard) take precedence over language breaks.
-  auto explicitBreakInfos = buildExplicitBreakInfos(cps);
-  if (!explicitBreakInfos.empty()) {
-    return explicitBreakInfos;
+  // Convert to codepoints and normalize word boundaries.
+  WordCodepoints& cps = scratchCodepoints;
+  if (!collectCodepoints(word, cps)) {
+    return breaks;
+  }
+  trimSurroundingPunctuationAndFootnote(cps);
+  const uint32_t* values = cps.values + cps.first;
+  const uint8_t* offsets = cps.byteOffsets + cps.first;
+
+  // Explicit hyphen markers (soft or hard) surrounded by letters take precedence over language breaks. The break
+  // offset points to the next codepoint so rendering starts after the hyphen marker.
+  for (size_t i = 1; i + 1 < cps.count; ++i) {
+    if (isExplicitHyphen(values[i]) && isAlphabetic(values[i - 1]) && isAlphabetic(values[i + 1])) {
+      breaks.push(offsets[i + 1], isSoftHyphen(values[i]));
+    }
+  }
+  if (!breaks.empty()) {
+    return breaks;
   }
 
-  // Ask language hyphenator for legal break points.
-  std::vector<size_t> indexes;
-  if (hyphenator) {
-    indexes = hyphenator->breakIndexes(cps);
+  // Ask language hyphenator for legal break points, unless the cache already said there are none.
+  if (hyphenator && !cached) {
+    const size_t found = hyphenator->breakIndexes(values, cps.count, scratchIndexes);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < found; ++i) {
+      breaks.push(offsets[scratchIndexes[i]], true);
+      mask |= uint64_t{1} << offsets[scratchIndexes[i]];
+    }
+    if (slot.set) {
+      storeInWordCache(slot, mask);
+    }
   }
 
   // Only add fallback breaks if needed
-  if (includeFallback && indexes.empty()) {
+  if (includeFallback && breaks.empty()) {
     const size_t minPrefix = hyphenator ? hyphenator->minPrefix() : LiangWordConfig::kDefaultMinPrefix;
     const size_t minSuffix = hyphenator ? hyphenator->minSuffix() : LiangWordConfig::kDefaultMinSuffix;
-    for (size_t idx = minPrefix; idx + minSuffix <= cps.size(); ++idx) {
-      indexes.push_back(idx);
+    for (size_t idx = minPrefix; idx + minSuffix <= cps.count; ++idx) {
+      breaks.push(offsets[idx], true);
     }
   }
 
-  if (indexes.empty()) {
-    return {};
-  }
-
-  std::vector<Hyphenator::BreakInfo> breaks;
-  breaks.reserve(indexes.size());
-  for (const size_t idx : indexes) {
-    breaks.push_back({byteOffsetForIndex(cps, idx), true});
-  }
-
   return breaks;
 }
 
-void Hyphenator::setPreferredLanguage(const std::string& lang) { cachedHyphenator_ = hyphenatorForLanguage(lang); }
+void Hyphenator::setPreferredLanguage(const std::string& lang) {
+  const auto* hyphenator = hyphenatorForLanguage(lang);
+  if (hyphenator != cachedHyphenator_) {
+    dropWordCache();
+  }
+  cachedHyphenator_ = hyphenator;
+}
@@ -1,24 +1,89 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
-#include <vector>
+#include <string_view>
+
+#include "HyphenationCommon.h"
 
 class LanguageHyphenator;
 
 class Hyphenator {
  public:
   struct BreakInfo {
-    size_t byteOffset;
+    uint8_t byteOffset;
     bool requiresInsertedHyphen;
   };
+
+  // Break points of one word in byte offset order, held inline as bit masks over the offsets so looking them up never
+  // touches the heap and takes little of the caller's stack
+  class Breaks {
+   public:
+    class Iterator {
+     public:
+      BreakInfo operator*() const {
+        return {static_cast<uint8_t>(offset_), Breaks::test(breaks_->hyphens_, offset_)};
+      }
+      Iterator& operator++() {
+        offset_ = breaks_->next(offset_ + 1);
+        return *this;
+      }
+      bool operator!=(const Iterator& other) const { return offset_ != other.offset_; }
+
+     private:
+      friend class Breaks;
+      Iterator(const Breaks* breaks, const size_t offset) : breaks_(breaks), offset_(offset) {}
+
+      const Breaks* breaks_;
+      size_t offset_;
+    };
+
+    Iterator begin() const { return {this, next(0)}; }
+    Iterator end() const { return {this, kMaxHyphenatedWordBytes}; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+   private:
+    friend class Hyphenator;
+    static constexpr size_t kMaskWords = (kMaxHyphenatedWordBytes + 63) / 64;
+
+    static bool test(const uint64_t* mask, const size_t offset) { return (mask[offset / 64] >> (offset % 64)) & 1; }
+    // The first break at or after from, or kMaxHyphenatedWordBytes when there is none
+    size_t next(const size_t from) const {
+      for (size_t word = from / 64; word < kMaskWords; word++) {
+        const uint64_t bits = word == from / 64 ? offsets_[word] & (~uint64_t{0} << (from % 64)) : offsets_[word];
+        if (bits != 0) {
+          return word * 64 + __builtin_ctzll(bits);
+        }
+      }
+      return kMaxHyphenatedWordBytes;
+    }
+    void push(const size_t byteOffset, const bool requiresInsertedHyphen) {
+      offsets_[byteOffset / 64] |= uint64_t{1} << (byteOffset % 64);
+      if (requiresInsertedHyphen) {
+        hyphens_[byteOffset / 64] |= uint64_t{1} << (byteOffset % 64);
+      }
+      count_++;
+    }
+
+    uint64_t offsets_[kMaskWords] = {};
+    uint64_t hyphens_[kMaskWords] = {};
+    size_t count_ = 0;
+  };
+
   // Returns byte offsets where the word may be hyphenated. When includeFallback is true, all positions obeying the
-  // minimum prefix/suffix constraints are returned even if no language-specific rule matches.
-  static std::vector<BreakInfo> breakOffsets(const std::string& word, bool includeFallback);
+  // minimum prefix/suffix constraints are returned even if no language-specific rule matches. Words longer than
+  // kMaxHyphenatedWordBytes get no breaks. Language breaks of recent words are cached, keyed by the word's text.
+  static Breaks breakOffsets(std::string_view word, bool includeFallback);
+
+  // Fewest codepoints a language rule leaves before a break, or 0 when no language rules apply. Breaks at explicit
+  // hyphens are not bound by it.
+  static size_t minPrefix();
 
   // Provide a publication-level language hint (e.g. "en", "en-US", "ru") used to select hyphenation rules.
   static void setPreferredLanguage(const std::string& lang);
 
  private:
   static const LanguageHyphenator* cachedHyphenator_;
-};
\ No newline at end of file
+};
@@ -13,6 +13,9 @@ class LanguageHyphenator {
   std::vector<size_t> breakIndexes(const std::vector<CodepointInfo>& cps) const {
     return liangBreakIndexes(cps, patterns_, config_);
   }
+  size_t breakIndexes(const uint32_t* codepoints, const size_t count, uint8_t* indexes) const {
+    return liangBreakIndexes(codepoints, count, patterns_, config_, indexes);
+  }
 
   size_t minPrefix() const { return config_.minPrefix; }
   size_t minSuffix() const { return config_.minSuffix; }
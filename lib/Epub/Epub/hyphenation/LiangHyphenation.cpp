@@ -1,13 +1,14 @@
 #include "LiangHyphenation.h"
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 /*
  * Liang hyphenation pipeline overview (Typst-style binary trie variant)
  * --------------------------------------------------------------------
  * 1.  Input normalization (buildAugmentedWord)
- *     - Accepts a vector of CodepointInfo structs emitted by the EPUB text
+ *     - Accepts the codepoints of a word emitted by the EPUB text
  *       parser. Each codepoint is validated with LiangWordConfig::isLetter so
  *       we abort early on digits, punctuation, etc. If the word is valid we
  *       build an "augmented" byte sequence: leading '.', lowercase UTF-8 bytes
@@ -47,80 +48,92 @@
  * Keeping the entire algorithm small and deterministic is critical on the
  * ESP32-C3: we avoid recursion, dynamic allocations per node, or copying the
  * trie. All lookups stay within the generated blob, which lives in flash, and
- * the working buffers (augmented bytes/scores) scale with the word length rather
- * than the pattern corpus.
+ * the working buffers (augmented bytes/scores) are fixed static arrays sized by
+ * kMaxHyphenatedWordBytes, so evaluating a word never touches the heap nor
+ * adds them to the stack of the layout task. Words are evaluated one at a
+ * time, as for Hyphenator's word cache.
  */
 
 namespace {
 
-struct AugmentedWord {
-  std::vector<uint8_t> bytes;
-  std::vector<size_t> charByteOffsets;
-  std::vector<int32_t> byteToCharIndex;
+// Augmented words never outgrow the source word: lowercasing keeps or shrinks UTF-8 sequences, and the sentinels take
+// the place of the longest word's final byte or two.
+constexpr size_t kMaxAugmentedBytes = kMaxHyphenatedWordBytes + 2;
+constexpr uint8_t kMidCodepoint = 0xFF;
 
-  bool empty() const { return bytes.empty(); }
-  size_t charCount() const { return charByteOffsets.size(); }
+struct AugmentedWord {
+  uint8_t bytes[kMaxAugmentedBytes];
+  uint8_t charByteOffsets[kMaxAugmentedBytes];
+  uint8_t byteToCharIndex[kMaxAugmentedBytes];
+  size_t byteCount = 0;
+  size_t charCount = 0;
 };
 
-// Encode a single Unicode codepoint into UTF-8 and append to the provided buffer.
-size_t encodeUtf8(uint32_t cp, std::vector<uint8_t>& out) {
+AugmentedWord scratchWord;
+// Liang scores: one entry per augmented char (leading/trailing dots included).
+uint8_t scores[kMaxAugmentedBytes];
+
+// Encode a single Unicode codepoint into UTF-8 at out, returning the bytes written or 0 when they do not fit.
+size_t encodeUtf8(const uint32_t cp, uint8_t* out, const size_t room) {
   if (cp <= 0x7Fu) {
-    out.push_back(static_cast<uint8_t>(cp));
+    if (room < 1) return 0;
+    out[0] = static_cast<uint8_t>(cp);
     return 1;
   }
   if (cp <= 0x7FFu) {
-    out.push_back(static_cast<uint8_t>(0xC0u | ((cp >> 6) & 0x1Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
+    if (room < 2) return 0;
+    out[0] = static_cast<uint8_t>(0xC0u | ((cp >> 6) & 0x1Fu));
+    out[1] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
     return 2;
   }
   if (cp <= 0xFFFFu) {
-    out.push_back(static_cast<uint8_t>(0xE0u | ((cp >> 12) & 0x0Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
+    if (room < 3) return 0;
+    out[0] = static_cast<uint8_t>(0xE0u | ((cp >> 12) & 0x0Fu));
+    out[1] = static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu));
+    out[2] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
     return 3;
   }
-  out.push_back(static_cast<uint8_t>(0xF0u | ((cp >> 18) & 0x07u)));
-  out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 12) & 0x3Fu)));
-  out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu)));
-  out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
+  if (room < 4) return 0;
+  out[0] = static_cast<uint8_t>(0xF0u | ((cp >> 18) & 0x07u));
+  out[1] = static_cast<uint8_t>(0x80u | ((cp >> 12) & 0x3Fu));
+  out[2] = static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu));
+  out[3] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
   return 4;
 }
 
-// Build the dotted, lowercase UTF-8 representation plus lookup tables.
-AugmentedWord buildAugmentedWord(const std::vector<CodepointInfo>& cps, const LiangWordConfig& config) {
-  AugmentedWord word;
-  if (cps.empty()) {
-    return word;
+// Build the dotted, lowercase UTF-8 representation plus lookup tables. Returns false for words with a non-letter or
+// too long to augment.
+bool buildAugmentedWord(const uint32_t* codepoints, const size_t count, const LiangWordConfig& config,
+                        AugmentedWord& word) {
+  if (count == 0 || count + 2 > kMaxAugmentedBytes) {
+    return false;
   }
 
-  word.bytes.reserve(cps.size() * 2 + 2);
-  word.charByteOffsets.reserve(cps.size() + 2);
-
-  word.charByteOffsets.push_back(0);
-  word.bytes.push_back('.');
-
-  for (const auto& info : cps) {
-    if (!config.isLetter(info.value)) {
-      word.bytes.clear();
-      word.charByteOffsets.clear();
-      word.byteToCharIndex.clear();
-      return word;
+  word.charByteOffsets[0] = 0;
+  word.bytes[0] = '.';
+  size_t bytes = 1;
+  for (size_t i = 0; i < count; ++i) {
+    if (!config.isLetter(codepoints[i])) {
+      return false;
     }
-    word.charByteOffsets.push_back(word.bytes.size());
-    encodeUtf8(config.toLower(info.value), word.bytes);
-  }
-
-  word.charByteOffsets.push_back(word.bytes.size());
-  word.bytes.push_back('.');
-
-  word.byteToCharIndex.assign(word.bytes.size(), -1);
-  for (size_t i = 0; i < word.charByteOffsets.size(); ++i) {
-    const size_t offset = word.charByteOffsets[i];
-    if (offset < word.byteToCharIndex.size()) {
-      word.byteToCharIndex[offset] = static_cast<int32_t>(i);
+    word.charByteOffsets[i + 1] = static_cast<uint8_t>(bytes);
+    const size_t room = kMaxAugmentedBytes - 1 - bytes;  // Keeping one for the trailing '.'
+    const size_t written = encodeUtf8(config.toLower(codepoints[i]), word.bytes + bytes, room);
+    if (written == 0) {
+      return false;
     }
+    bytes += written;
+  }
+  word.charByteOffsets[count + 1] = static_cast<uint8_t>(bytes);
+  word.bytes[bytes++] = '.';
+  word.byteCount = bytes;
+  word.charCount = count + 2;
+
+  memset(word.byteToCharIndex, kMidCodepoint, bytes);
+  for (size_t i = 0; i < word.charCount; ++i) {
+    word.byteToCharIndex[word.charByteOffsets[i]] = static_cast<uint8_t>(i);
   }
-  return word;
+  return true;
 }
 
 // Decoded view of a single trie node pulled straight out of the serialized blob.
@@ -302,67 +315,48 @@ bool transition(const EmbeddedAutomaton& automaton, const AutomatonState& state,
 
 // Converts odd score positions back into codepoint indexes, honoring min prefix/suffix constraints.
 // Each break corresponds to scores[breakIndex + 1] because of the leading '.' sentinel.
-// Convert odd score entries into hyphen positions while honoring prefix/suffix limits.
-std::vector<size_t> collectBreakIndexes(const std::vector<CodepointInfo>& cps, const std::vector<uint8_t>& scores,
-                                        const size_t minPrefix, const size_t minSuffix) {
-  std::vector<size_t> indexes;
-  const size_t cpCount = cps.size();
-  if (cpCount < 2) {
-    return indexes;
-  }
-
-  for (size_t breakIndex = 1; breakIndex < cpCount; ++breakIndex) {
-    if (breakIndex < minPrefix) {
-      continue;
-    }
-
-    const size_t suffixCount = cpCount - breakIndex;
-    if (suffixCount < minSuffix) {
-      continue;
-    }
-
-    const size_t scoreIdx = breakIndex + 1;
-    if (scoreIdx >= scores.size()) {
+size_t collectBreakIndexes(const size_t cpCount, const uint8_t* scores, const size_t minPrefix, const size_t minSuffix,
+                           uint8_t* indexes) {
+  size_t found = 0;
+  for (size_t breakIndex = std::max<size_t>(minPrefix, 1); breakIndex < cpCount; ++breakIndex) {
+    if (cpCount - breakIndex < minSuffix) {
       break;
     }
-    if ((scores[scoreIdx] & 1u) == 0) {
-      continue;
+    if ((scores[breakIndex + 1] & 1u) != 0) {
+      indexes[found++] = static_cast<uint8_t>(breakIndex);
     }
-    indexes.push_back(breakIndex);
   }
-
-  return indexes;
+  return found;
 }
 
 }  // namespace
 
 // Entry point that runs the full Liang pipeline for a single word.
-std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
-                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
-  const auto augmented = buildAugmentedWord(cps, config);
-  if (augmented.empty()) {
-    return {};
+size_t liangBreakIndexes(const uint32_t* codepoints, const size_t count, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, uint8_t* indexes) {
+  AugmentedWord& augmented = scratchWord;
+  if (!buildAugmentedWord(codepoints, count, config, augmented)) {
+    return 0;
   }
 
   const EmbeddedAutomaton& automaton = getAutomaton(patterns);
   if (!automaton.valid()) {
-    return {};
+    return 0;
   }
 
   const AutomatonState root = decodeState(automaton, automaton.rootOffset);
   if (!root.valid()) {
-    return {};
+    return 0;
   }
 
-  // Liang scores: one entry per augmented char (leading/trailing dots included).
-  std::vector<uint8_t> scores(augmented.charCount(), 0);
+  std::fill(scores, scores + augmented.charCount, 0);
 
   // Walk every starting character position and stream bytes through the trie.
-  for (size_t charStart = 0; charStart < augmented.charByteOffsets.size(); ++charStart) {
+  for (size_t charStart = 0; charStart < augmented.charCount; ++charStart) {
     const size_t byteStart = augmented.charByteOffsets[charStart];
     AutomatonState state = root;
 
-    for (size_t cursor = byteStart; cursor < augmented.bytes.size(); ++cursor) {
+    for (size_t cursor = byteStart; cursor < augmented.byteCount; ++cursor) {
       AutomatonState next;
       if (!transition(automaton, state, augmented.bytes[cursor], next)) {
         break;  // No more matches for this prefix.
@@ -379,27 +373,36 @@ std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
 
           offset += dist;
           const size_t splitByte = byteStart + offset;
-          if (splitByte >= augmented.byteToCharIndex.size()) {
+          if (splitByte >= augmented.byteCount) {
             continue;
           }
 
-          const int32_t boundary = augmented.byteToCharIndex[splitByte];
-          if (boundary < 0) {
+          const uint8_t boundary = augmented.byteToCharIndex[splitByte];
+          if (boundary == kMidCodepoint) {
             continue;  // Mid-codepoint byte, wait for the next one.
           }
-          if (boundary < 2 || boundary + 2 > static_cast<int32_t>(augmented.charCount())) {
+          if (boundary < 2 || boundary + 2u > augmented.charCount) {
             continue;  // Skip splits that land in the leading/trailing sentinels.
           }
-
-          const size_t idx = static_cast<size_t>(boundary);
-          if (idx >= scores.size()) {
-            continue;
-          }
-          scores[idx] = std::max(scores[idx], level);
+          scores[boundary] = std::max(scores[boundary], level);
         }
       }
     }
   }
 
-  return collectBreakIndexes(cps, scores, config.minPrefix, config.minSuffix);
+  return collectBreakIndexes(count, scores, config.minPrefix, config.minSuffix, indexes);
+}
+
+std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
+                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
+  if (cps.size() > kMaxHyphenatedWordBytes) {
+    return {};
+  }
+  uint32_t codepoints[kMaxHyphenatedWordBytes];
+  for (size_t i = 0; i < cps.size(); ++i) {
+    codepoints[i] = cps[i].value;
+  }
+  uint8_t indexes[kMaxHyphenatedWordBytes];
+  const size_t found = liangBreakIndexes(codepoints, cps.size(), patterns, config, indexes);
+  return std::vector<size_t>(indexes, indexes + found);
 }
@@ -33,6 +33,12 @@ struct LiangWordConfig {
       : isLetter(letterFn), toLower(lowerFn), minPrefix(prefix), minSuffix(suffix) {}
 };
 
-// Shared Liang pattern evaluator used by every language-specific hyphenator.
+// Shared Liang pattern evaluator used by every language-specific hyphenator. Writes the codepoint indexes the word may
+// break at to `indexes`, which must have room for `count` entries, and returns how many it wrote. Allocation-free;
+// words longer than kMaxHyphenatedWordBytes get no breaks.
+size_t liangBreakIndexes(const uint32_t* codepoints, size_t count, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, uint8_t* indexes);
+
+// Convenience form for tooling and tests.
 std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
                                       const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config);
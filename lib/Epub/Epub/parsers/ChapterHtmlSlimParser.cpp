@@ -2,7 +2,8 @@
 
 #include <GfxRenderer.h>
 #include <HardwareSerial.h>
-#include <SDCardManager.h>
+#include <Serialization.h>
+#include <Trace.h>
 #include <expat.h>
 
 #include "../Page.h"
@@ -13,6 +14,15 @@ constexpr int NUM_HEADER_TAGS = sizeof(HEADER_TAGS) / sizeof(HEADER_TAGS[0]);
 // Minimum file size (in bytes) to show progress bar - smaller chapters don't benefit from it
 constexpr size_t MIN_SIZE_FOR_PROGRESS = 50 * 1024;  // 50KB
 
+// Recorded tokens: a format version byte, then chunks of whole tokens each prefixed with their uint16 length, ending
+// with an empty chunk. A token's first byte holds its kind and a style: the block's alignment or the word's font style.
+constexpr uint8_t TOKEN_FORMAT_VERSION = 1;
+constexpr uint8_t TOKEN_KIND_MASK = 0xF0;
+constexpr uint8_t TOKEN_BLOCK = 0x10;  // New text block
+constexpr uint8_t TOKEN_WORD = 0x20;   // Followed by the word's length as a varint and its bytes
+constexpr uint8_t TOKEN_SPLIT = 0x30;  // A long block was laid out early here
+constexpr size_t TOKEN_CHUNK_SIZE = 1024;
+
 const char* BLOCK_TAGS[] = {"p", "li", "div", "br", "blockquote"};
 constexpr int NUM_BLOCK_TAGS = sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]);
 
@@ -52,13 +62,28 @@ void ChapterHtmlSlimParser::flushPartWordBuffer() {
     fontStyle = EpdFontFamily::ITALIC;
   }
   // flush the buffer
-  partWordBuffer[partWordBufferIndex] = '\0';
-  currentTextBlock->addWord(partWordBuffer, fontStyle);
+  addWord({partWordBuffer, static_cast<size_t>(partWordBufferIndex)}, fontStyle);
   partWordBufferIndex = 0;
 }
 
+void ChapterHtmlSlimParser::addWord(const std::string_view word, const EpdFontFamily::Style fontStyle) {
+  if (tokenWriteFn) {
+    tokenChunk.push_back(TOKEN_WORD | fontStyle);
+    serialization::writeVarint(tokenChunk, word.size());
+    tokenChunk.insert(tokenChunk.end(), word.begin(), word.end());
+    writeFullTokenChunk();
+  }
+  currentTextBlock->addWord(word, fontStyle);
+}
+
 // start a new text block if needed
-void ChapterHtmlSlimParser::startNewTextBlock(const TextBlock::Style style) {
+void ChapterHtmlSlimParser::startNewTextBlock(const uint8_t blockStyle) {
+  if (tokenWriteFn) {
+    tokenChunk.push_back(TOKEN_BLOCK | blockStyle);
+    writeFullTokenChunk();
+  }
+  currentBlockStyle = blockStyle;
+  const auto style = static_cast<TextBlock::Style>(blockStyle == PARAGRAPH_ALIGNMENT ? paragraphAlignment : blockStyle);
   if (currentTextBlock) {
     // already have a text block running and it is empty - just reuse it
     if (currentTextBlock->isEmpty()) {
@@ -71,6 +96,34 @@ void ChapterHtmlSlimParser::startNewTextBlock(const TextBlock::Style style) {
   currentTextBlock.reset(new ParsedText(style, extraParagraphSpacing, hyphenationEnabled));
 }
 
+// Lays out a long block so far, keeping its last line as it may continue
+void ChapterHtmlSlimParser::splitLongTextBlock() {
+  if (tokenWriteFn) {
+    tokenChunk.push_back(TOKEN_SPLIT);
+    writeFullTokenChunk();
+  }
+  Serial.printf("[%lu] [EHP] Text block too long, splitting into multiple pages\n", millis());
+  currentTextBlock->layoutAndExtractLines(
+      renderer, fontId, viewportWidth,
+      [this](const std::shared_ptr<TextBlock>& textBlock) { addLineToPage(textBlock); }, false);
+}
+
+void ChapterHtmlSlimParser::writeFullTokenChunk() {
+  if (tokenChunk.size() >= TOKEN_CHUNK_SIZE) {
+    writeTokenChunk();
+  }
+}
+
+void ChapterHtmlSlimParser::writeTokenChunk() {
+  const uint16_t length = tokenChunk.size();
+  const uint8_t prefix[2] = {static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8)};
+  if (!tokenWriteFailed && (!tokenWriteFn(prefix, sizeof(prefix)) || !tokenWriteFn(tokenChunk.data(), length))) {
+    Serial.printf("[%lu] [EHP] Could not write chapter tokens\n", millis());
+    tokenWriteFailed = true;
+  }
+  tokenChunk.clear();
+}
+
 void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char* name, const XML_Char** atts) {
   auto* self = static_cast<ChapterHtmlSlimParser*>(userData);
 
@@ -154,14 +207,14 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
         // flush word preceding <br/> to currentTextBlock before calling startNewTextBlock
         self->flushPartWordBuffer();
       }
-      self->startNewTextBlock(self->currentTextBlock->getStyle());
+      self->startNewTextBlock(self->currentBlockStyle);
       self->depth += 1;
       return;
     }
 
-    self->startNewTextBlock(static_cast<TextBlock::Style>(self->paragraphAlignment));
+    self->startNewTextBlock(PARAGRAPH_ALIGNMENT);
     if (strcmp(name, "li") == 0) {
-      self->currentTextBlock->addWord("\xe2\x80\xa2", EpdFontFamily::REGULAR);
+      self->addWord("\xe2\x80\xa2", EpdFontFamily::REGULAR);
     }
 
     self->depth += 1;
@@ -229,10 +282,7 @@ void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char
   // memory.
   // Spotted when reading Intermezzo, there are some really long text blocks in there.
   if (self->currentTextBlock->size() > 750) {
-    Serial.printf("[%lu] [EHP] Text block too long, splitting into multiple pages\n", millis());
-    self->currentTextBlock->layoutAndExtractLines(
-        self->renderer, self->fontId, self->viewportWidth,
-        [self](const std::shared_ptr<TextBlock>& textBlock) { self->addLineToPage(textBlock); }, false);
+    self->splitLongTextBlock();
   }
 }
 
@@ -273,7 +323,12 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
 }
 
 bool ChapterHtmlSlimParser::parseAndBuildPages() {
-  startNewTextBlock((TextBlock::Style)this->paragraphAlignment);
+  if (tokenWriteFn) {
+    tokenChunk.clear();
+    tokenChunk.reserve(TOKEN_CHUNK_SIZE + MAX_WORD_SIZE + 8);
+    tokenWriteFailed = !tokenWriteFn(&TOKEN_FORMAT_VERSION, 1);
+  }
+  startNewTextBlock(PARAGRAPH_ALIGNMENT);
 
   const XML_Parser parser = XML_ParserCreate(nullptr);
   int done;
@@ -283,22 +338,26 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
     return false;
   }
 
-  FsFile file;
-  if (!SdMan.openFileForRead("EHP", filepath, file)) {
-    XML_ParserFree(parser);
-    return false;
-  }
-
-  // Get file size for progress calculation
-  const size_t totalSize = file.size();
   size_t bytesRead = 0;
   int lastProgress = -1;
+  // Time in expat, including the layout its callbacks do, but not reading the content
+  const uint32_t parseStart = trace::nowUs();
+  uint32_t parseUs = 0;
 
   XML_SetUserData(parser, this);
   XML_SetElementHandler(parser, startElement, endElement);
   XML_SetCharacterDataHandler(parser, characterData);
 
   do {
+    if (abortFn && abortFn()) {
+      Serial.printf("[%lu] [EHP] Aborted after %zu of %zu bytes\n", millis(), bytesRead, contentSize);
+      XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
+      XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
+      XML_SetCharacterDataHandler(parser, nullptr);
+      XML_ParserFree(parser);
+      return false;
+    }
+
     void* const buf = XML_GetBuffer(parser, 1024);
     if (!buf) {
       Serial.printf("[%lu] [EHP] Couldn't allocate memory for buffer\n", millis());
@@ -306,43 +365,43 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
       XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
       XML_SetCharacterDataHandler(parser, nullptr);
       XML_ParserFree(parser);
-      file.close();
       return false;
     }
 
-    const size_t len = file.read(buf, 1024);
+    const size_t len = readFn(static_cast<uint8_t*>(buf), 1024);
 
-    if (len == 0 && file.available() > 0) {
-      Serial.printf("[%lu] [EHP] File read error\n", millis());
+    if (len == 0 && bytesRead < contentSize) {
+      Serial.printf("[%lu] [EHP] Content read error after %zu of %zu bytes\n", millis(), bytesRead, contentSize);
       XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
       XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
       XML_SetCharacterDataHandler(parser, nullptr);
       XML_ParserFree(parser);
-      file.close();
       return false;
     }
 
     // Update progress (call every 10% change to avoid too frequent updates)
     // Only show progress for larger chapters where rendering overhead is worth it
     bytesRead += len;
-    if (progressFn && totalSize >= MIN_SIZE_FOR_PROGRESS) {
-      const int progress = static_cast<int>((bytesRead * 100) / totalSize);
+    if (progressFn && contentSize >= MIN_SIZE_FOR_PROGRESS) {
+      const int progress = static_cast<int>((bytesRead * 100) / contentSize);
       if (lastProgress / 10 != progress / 10) {
         lastProgress = progress;
         progressFn(progress);
       }
     }
 
-    done = file.available() == 0;
+    done = len == 0 || bytesRead >= contentSize;
 
-    if (XML_ParseBuffer(parser, static_cast<int>(len), done) == XML_STATUS_ERROR) {
+    const uint32_t bufferStart = trace::nowUs();
+    const XML_Status status = XML_ParseBuffer(parser, static_cast<int>(len), done);
+    parseUs += trace::nowUs() - bufferStart;
+    if (status == XML_STATUS_ERROR) {
       Serial.printf("[%lu] [EHP] Parse error at line %lu:\n%s\n", millis(), XML_GetCurrentLineNumber(parser),
                     XML_ErrorString(XML_GetErrorCode(parser)));
       XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
       XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
       XML_SetCharacterDataHandler(parser, nullptr);
       XML_ParserFree(parser);
-      file.close();
       return false;
     }
   } while (!done);
@@ -351,16 +410,102 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
   XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
   XML_SetCharacterDataHandler(parser, nullptr);
   XML_ParserFree(parser);
-  file.close();
+  trace::record(trace::Span::XML_PARSE, parseStart, parseUs, bytesRead);
+  trace::add(trace::Counter::PARSED_BYTES, bytesRead);
+
+  finishPages();
+  if (tokenWriteFn) {
+    // The empty chunk marks the record complete
+    writeTokenChunk();
+    writeTokenChunk();
+  }
+  return true;
+}
 
-  // Process last page if there is still text
-  if (currentTextBlock) {
-    makePages();
-    completePageFn(std::move(currentPage));
-    currentPage.reset();
-    currentTextBlock.reset();
+bool ChapterHtmlSlimParser::buildPagesFromTokens() {
+  const auto readFully = [this](uint8_t* buf, const size_t len) {
+    size_t got = 0;
+    while (got < len) {
+      const size_t n = readFn(buf + got, len - got);
+      if (n == 0) return false;
+      got += n;
+    }
+    return true;
+  };
+
+  uint8_t version = 0;
+  if (!readFully(&version, 1) || version != TOKEN_FORMAT_VERSION) {
+    Serial.printf("[%lu] [EHP] Chapter tokens missing or from another version\n", millis());
+    return false;
   }
 
+  std::vector<uint8_t> chunk;
+  chunk.reserve(TOKEN_CHUNK_SIZE + MAX_WORD_SIZE + 8);
+  size_t bytesRead = 1;
+  int lastProgress = -1;
+  while (true) {
+    if (abortFn && abortFn()) {
+      Serial.printf("[%lu] [EHP] Aborted after %zu of %zu token bytes\n", millis(), bytesRead, contentSize);
+      return false;
+    }
+
+    uint8_t prefix[2];
+    if (!readFully(prefix, sizeof(prefix))) {
+      Serial.printf("[%lu] [EHP] Chapter tokens end early after %zu bytes\n", millis(), bytesRead);
+      return false;
+    }
+    const uint16_t length = prefix[0] | prefix[1] << 8;
+    if (length == 0) {
+      break;
+    }
+    chunk.resize(length);
+    if (!readFully(chunk.data(), length)) {
+      Serial.printf("[%lu] [EHP] Chapter tokens end early after %zu bytes\n", millis(), bytesRead);
+      return false;
+    }
+    bytesRead += sizeof(prefix) + length;
+
+    serialization::RecordReader reader(chunk.data(), length);
+    while (!reader.atEnd()) {
+      const uint8_t token = reader.readByte();
+      const uint8_t style = token & ~TOKEN_KIND_MASK;
+      switch (token & TOKEN_KIND_MASK) {
+        case TOKEN_BLOCK:
+          if (style > TextBlock::RIGHT_ALIGN && style != PARAGRAPH_ALIGNMENT) {
+            Serial.printf("[%lu] [EHP] Bad block style in chapter tokens\n", millis());
+            return false;
+          }
+          startNewTextBlock(style);
+          break;
+        case TOKEN_WORD: {
+          const uint32_t wordLength = reader.readVarint();
+          const uint8_t* word = reader.readBytes(wordLength);
+          if (!word || reader.hasFailed() || style > EpdFontFamily::BOLD_ITALIC || wordLength > MAX_WORD_SIZE) {
+            Serial.printf("[%lu] [EHP] Bad word in chapter tokens\n", millis());
+            return false;
+          }
+          addWord({reinterpret_cast<const char*>(word), wordLength}, static_cast<EpdFontFamily::Style>(style));
+          break;
+        }
+        case TOKEN_SPLIT:
+          splitLongTextBlock();
+          break;
+        default:
+          Serial.printf("[%lu] [EHP] Unknown chapter token %u\n", millis(), token);
+          return false;
+      }
+    }
+
+    if (progressFn && contentSize >= MIN_SIZE_FOR_PROGRESS) {
+      const int progress = static_cast<int>((bytesRead * 100) / contentSize);
+      if (lastProgress / 10 != progress / 10) {
+        lastProgress = progress;
+        progressFn(progress);
+      }
+    }
+  }
+
+  finishPages();
   return true;
 }
 
@@ -377,6 +522,16 @@ void ChapterHtmlSlimParser::addLineToPage(std::shared_ptr<TextBlock> line) {
   currentPageNextY += lineHeight;
 }
 
+// Process last page if there is still text
+void ChapterHtmlSlimParser::finishPages() {
+  if (currentTextBlock) {
+    makePages();
+    completePageFn(std::move(currentPage));
+    currentPage.reset();
+    currentTextBlock.reset();
+  }
+}
+
 void ChapterHtmlSlimParser::makePages() {
   if (!currentTextBlock) {
     Serial.printf("[%lu] [EHP] !! No text block to make pages for !!\n", millis());
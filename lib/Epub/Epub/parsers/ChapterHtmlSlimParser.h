@@ -5,6 +5,7 @@
 #include <climits>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "../ParsedText.h"
 #include "../blocks/TextBlock.h"
@@ -15,10 +16,22 @@ class GfxRenderer;
 #define MAX_WORD_SIZE 200
 
 class ChapterHtmlSlimParser {
-  const std::string& filepath;
+ public:
+  // Pulls up to len bytes of chapter XHTML into buf, returning 0 at end of content or on error
+  using ReadFn = std::function<size_t(uint8_t* buf, size_t len)>;
+  // Appends len bytes of recorded tokens, returning false if they could not all be written
+  using WriteFn = std::function<bool(const uint8_t* buf, size_t len)>;
+
+ private:
+  // Block style token standing for the reader's paragraph alignment setting rather than a fixed alignment
+  static constexpr uint8_t PARAGRAPH_ALIGNMENT = 0x0F;
+
+  ReadFn readFn;
+  size_t contentSize;
   GfxRenderer& renderer;
   std::function<void(std::unique_ptr<Page>)> completePageFn;
   std::function<void(int)> progressFn;  // Progress callback (0-100)
+  std::function<bool()> abortFn;        // Polled between chunks, parsing stops early when it returns true
   int depth = 0;
   int skipUntilDepth = INT_MAX;
   int boldUntilDepth = INT_MAX;
@@ -28,6 +41,8 @@ class ChapterHtmlSlimParser {
   char partWordBuffer[MAX_WORD_SIZE + 1] = {};
   int partWordBufferIndex = 0;
   std::unique_ptr<ParsedText> currentTextBlock = nullptr;
+  // TextBlock::Style of the current block, or PARAGRAPH_ALIGNMENT
+  uint8_t currentBlockStyle = PARAGRAPH_ALIGNMENT;
   std::unique_ptr<Page> currentPage = nullptr;
   int16_t currentPageNextY = 0;
   int fontId;
@@ -37,23 +52,34 @@ class ChapterHtmlSlimParser {
   uint16_t viewportWidth;
   uint16_t viewportHeight;
   bool hyphenationEnabled;
+  // Layout-independent record of the chapter (blocks, words and their styles), written in chunks while parsing
+  WriteFn tokenWriteFn;
+  std::vector<uint8_t> tokenChunk;
+  bool tokenWriteFailed = false;
 
-  void startNewTextBlock(TextBlock::Style style);
+  void startNewTextBlock(uint8_t blockStyle);
+  void addWord(std::string_view word, EpdFontFamily::Style fontStyle);
   void flushPartWordBuffer();
+  void splitLongTextBlock();
   void makePages();
+  void finishPages();
+  void writeFullTokenChunk();
+  void writeTokenChunk();
   // XML callbacks
   static void XMLCALL startElement(void* userData, const XML_Char* name, const XML_Char** atts);
   static void XMLCALL characterData(void* userData, const XML_Char* s, int len);
   static void XMLCALL endElement(void* userData, const XML_Char* name);
 
  public:
-  explicit ChapterHtmlSlimParser(const std::string& filepath, GfxRenderer& renderer, const int fontId,
+  explicit ChapterHtmlSlimParser(ReadFn readFn, const size_t contentSize, GfxRenderer& renderer, const int fontId,
                                  const float lineCompression, const bool extraParagraphSpacing,
                                  const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                  const uint16_t viewportHeight, const bool hyphenationEnabled,
                                  const std::function<void(std::unique_ptr<Page>)>& completePageFn,
-                                 const std::function<void(int)>& progressFn = nullptr)
-      : filepath(filepath),
+                                 const std::function<void(int)>& progressFn = nullptr,
+                                 const std::function<bool()>& abortFn = nullptr)
+      : readFn(std::move(readFn)),
+        contentSize(contentSize),
         renderer(renderer),
         fontId(fontId),
         lineCompression(lineCompression),
@@ -63,8 +89,15 @@ class ChapterHtmlSlimParser {
         viewportHeight(viewportHeight),
         hyphenationEnabled(hyphenationEnabled),
         completePageFn(completePageFn),
-        progressFn(progressFn) {}
+        progressFn(progressFn),
+        abortFn(abortFn) {}
   ~ChapterHtmlSlimParser() = default;
+  // Also record the chapter's tokens through writeFn while parsing, so buildPagesFromTokens can lay it out again
+  // under other layout settings without inflating and parsing the XHTML
+  void recordTokens(WriteFn writeFn) { tokenWriteFn = std::move(writeFn); }
+  bool hasTokenWriteFailed() const { return tokenWriteFailed; }
   bool parseAndBuildPages();
+  // Lays out pages from tokens recorded by an earlier parse, pulled through readFn instead of the XHTML
+  bool buildPagesFromTokens();
   void addLineToPage(std::shared_ptr<TextBlock> line);
 };
@@ -2,7 +2,282 @@
 
 #include <Utf8.h>
 
-void GfxRenderer::insertFont(const int fontId, EpdFontFamily font) { fontMap.insert({fontId, font}); }
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// How a pre-rendered page's bits turn into pixels to paint in the current render mode
+enum class PagePaint : uint8_t {
+  XtgBlack,     // 1-bit rows, 0 = black
+  XthBlack,     // 2-bit planes, any non-white value
+  XthDarkGray,  // 2-bit planes, value 1 only (LSB pass)
+  XthGrays,     // 2-bit planes, values 1 and 2 (MSB pass)
+};
+
+// Pre-rendered page stored as lines of MSB-first packed bits, split over one or two planes
+struct PageBitLines {
+  const uint8_t* plane1;
+  const uint8_t* plane2;
+  size_t lineBytes;
+  int lineCount;
+  int lineLength;  // Bits per line holding pixels, the rest of the last byte is padding
+  PagePaint paint;
+};
+
+// Panel position of bit k of line l: px = pxPerLine * l + pxPerBit * k + pxBase (same for py)
+struct PageBitMap {
+  int pxPerLine, pxPerBit, pxBase;
+  int pyPerLine, pyPerBit, pyBase;
+};
+
+template <typename T>
+T paintBits(const PagePaint paint, const T a, const T b) {
+  switch (paint) {
+    case PagePaint::XtgBlack:
+      return static_cast<T>(~a);
+    case PagePaint::XthBlack:
+      return a | b;
+    case PagePaint::XthDarkGray:
+      return static_cast<T>(~a & b);
+    case PagePaint::XthGrays:
+    default:
+      return a ^ b;
+  }
+}
+
+uint8_t reverseBits(uint8_t b) {
+  b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+  b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+  b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+  return b;
+}
+
+// Transposes an 8x8 bit matrix packed one row per byte (Hacker's Delight, transpose8rS64)
+uint64_t transpose8x8(uint64_t x) {
+  uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+  return x ^ t ^ (t << 28);
+}
+
+class PageBlitter {
+  uint8_t* frameBuffer;
+  const PageBitLines& lines;
+  const PageBitMap& map;
+  const bool clearBits;
+  const uint8_t lastByteMask;  // Pixel bits of the final byte of a line
+
+  void apply(uint8_t* dst, const uint8_t paint) const {
+    if (clearBits) {
+      *dst &= ~paint;
+    } else {
+      *dst |= paint;
+    }
+  }
+
+  uint8_t paintByte(const int line, const size_t byteIndex) const {
+    const size_t offset = line * lines.lineBytes + byteIndex;
+    const uint8_t second = lines.plane2 ? lines.plane2[offset] : 0;
+    const uint8_t paint = paintBits<uint8_t>(lines.paint, lines.plane1[offset], second);
+    return byteIndex == lines.lineBytes - 1 ? paint & lastByteMask : paint;
+  }
+
+  // Slow path for lines or edges that don't line up with framebuffer bytes
+  void blitPixels(const int line, const int firstBit, const int endBit) const {
+    for (int k = firstBit; k < endBit; k++) {
+      if (!((paintByte(line, k / 8) << (k % 8)) & 0x80)) {
+        continue;
+      }
+      const int px = map.pxPerLine * line + map.pxPerBit * k + map.pxBase;
+      const int py = map.pyPerLine * line + map.pyPerBit * k + map.pyBase;
+      if (px < 0 || px >= HalDisplay::DISPLAY_WIDTH || py < 0 || py >= HalDisplay::DISPLAY_HEIGHT) {
+        continue;
+      }
+      apply(&frameBuffer[py * HalDisplay::DISPLAY_WIDTH_BYTES + px / 8], 0x80 >> (px % 8));
+    }
+  }
+
+  // Line lands on a panel row: straight byte copy, or byte-and-bit reversed copy
+  void blitRow(const int line) const {
+    const int py = map.pyPerLine * line + map.pyBase;
+    if (py < 0 || py >= HalDisplay::DISPLAY_HEIGHT) {
+      return;
+    }
+    uint8_t* row = frameBuffer + py * HalDisplay::DISPLAY_WIDTH_BYTES;
+    const int firstPx = map.pxBase;
+    const size_t offset = line * lines.lineBytes;
+
+    // Panel rows are whole bytes, so clipping a byte-aligned line to the panel drops whole bytes
+    if (map.pxPerBit == 1 && firstPx % 8 == 0 && firstPx >= 0) {
+      const size_t count = std::min(lines.lineBytes, static_cast<size_t>(HalDisplay::DISPLAY_WIDTH - firstPx) / 8);
+      uint8_t* dst = row + firstPx / 8;
+      size_t j = 0;
+      // Four bytes at a time for everything but the (possibly padded) last byte
+      for (; j + 4 < count; j += 4) {
+        uint32_t a, b = 0, d;
+        memcpy(&a, lines.plane1 + offset + j, 4);
+        if (lines.plane2) {
+          memcpy(&b, lines.plane2 + offset + j, 4);
+        }
+        const uint32_t paint = paintBits<uint32_t>(lines.paint, a, b);
+        memcpy(&d, dst + j, 4);
+        d = clearBits ? d & ~paint : d | paint;
+        memcpy(dst + j, &d, 4);
+      }
+      for (; j < count; j++) {
+        apply(dst + j, paintByte(line, j));
+      }
+      return;
+    }
+
+    if (map.pxPerBit == -1 && firstPx % 8 == 7 && firstPx < HalDisplay::DISPLAY_WIDTH) {
+      const size_t count = std::min(lines.lineBytes, static_cast<size_t>(firstPx + 1) / 8);
+      for (size_t j = 0; j < count; j++) {
+        apply(row + (firstPx - 8 * static_cast<int>(j)) / 8, reverseBits(paintByte(line, j)));
+      }
+      return;
+    }
+
+    blitPixels(line, 0, lines.lineLength);
+  }
+
+  // Eight lines land on one panel byte column: transpose 8x8 blocks of bits into eight panel rows
+  void blitColumns(const int firstLine) const {
+    const int px = map.pxPerLine * firstLine + map.pxBase;
+    const int byteX = px / 8;
+    const bool reversed = map.pxPerLine == -1;
+
+    for (size_t j = 0; j < lines.lineBytes; j++) {
+      uint64_t block = 0;
+      for (int m = 0; m < 8; m++) {
+        block = block << 8 | paintByte(firstLine + m, j);
+      }
+      if (!block) {
+        continue;
+      }
+      block = transpose8x8(block);
+
+      for (int i = 0; i < 8; i++) {
+        const int k = static_cast<int>(j) * 8 + i;
+        if (k >= lines.lineLength) {
+          break;
+        }
+        const int py = map.pyPerBit * k + map.pyBase;
+        if (py < 0 || py >= HalDisplay::DISPLAY_HEIGHT) {
+          continue;
+        }
+        const uint8_t paint = static_cast<uint8_t>(block >> (56 - 8 * i));
+        if (paint) {
+          apply(&frameBuffer[py * HalDisplay::DISPLAY_WIDTH_BYTES + byteX], reversed ? reverseBits(paint) : paint);
+        }
+      }
+    }
+  }
+
+ public:
+  PageBlitter(uint8_t* frameBuffer, const PageBitLines& lines, const PageBitMap& map, const bool clearBits)
+      : frameBuffer(frameBuffer),
+        lines(lines),
+        map(map),
+        clearBits(clearBits),
+        lastByteMask(lines.lineLength % 8 ? static_cast<uint8_t>(0xFF << (8 - lines.lineLength % 8)) : 0xFF) {}
+
+  void blit() const {
+    if (map.pxPerLine == 0) {
+      for (int line = 0; line < lines.lineCount; line++) {
+        blitRow(line);
+      }
+      return;
+    }
+
+    // Lines are panel columns; group them into eight-line runs that fill whole framebuffer bytes
+    const bool rowsAligned = (map.pyPerBit == 1 || map.pyPerBit == -1) && map.pyPerLine == 0;
+    int line = 0;
+    while (line < lines.lineCount) {
+      const int px = map.pxPerLine * line + map.pxBase;
+      const bool groupStart = map.pxPerLine == 1 ? px % 8 == 0 : px % 8 == 7;
+      if (rowsAligned && groupStart && line + 8 <= lines.lineCount && px >= 0 &&
+          px < HalDisplay::DISPLAY_WIDTH && map.pxPerLine * 7 + px >= 0 &&
+          map.pxPerLine * 7 + px < HalDisplay::DISPLAY_WIDTH) {
+        blitColumns(line);
+        line += 8;
+      } else {
+        blitPixels(line, 0, lines.lineLength);
+        line++;
+      }
+    }
+  }
+};
+
+// Combines a page's (line, bit) -> logical (x, y) layout with the logical -> panel rotation of rotateCoordinates
+PageBitMap mapPageBits(const GfxRenderer::Orientation orientation, const int xPerLine, const int xPerBit,
+                       const int xBase, const int yPerLine, const int yPerBit, const int yBase) {
+  int pxPerX = 0, pxPerY = 0, pxBase = 0, pyPerX = 0, pyPerY = 0, pyBase = 0;
+  switch (orientation) {
+    case GfxRenderer::Portrait:
+      pxPerY = 1;
+      pyPerX = -1;
+      pyBase = HalDisplay::DISPLAY_HEIGHT - 1;
+      break;
+    case GfxRenderer::LandscapeClockwise:
+      pxPerX = -1;
+      pxBase = HalDisplay::DISPLAY_WIDTH - 1;
+      pyPerY = -1;
+      pyBase = HalDisplay::DISPLAY_HEIGHT - 1;
+      break;
+    case GfxRenderer::PortraitInverted:
+      pxPerY = -1;
+      pxBase = HalDisplay::DISPLAY_WIDTH - 1;
+      pyPerX = 1;
+      break;
+    case GfxRenderer::LandscapeCounterClockwise:
+    default:
+      pxPerX = 1;
+      pyPerY = 1;
+      break;
+  }
+  return {pxPerX * xPerLine + pxPerY * yPerLine, pxPerX * xPerBit + pxPerY * yPerBit,
+          pxPerX * xBase + pxPerY * yBase + pxBase,  pyPerX * xPerLine + pyPerY * yPerLine,
+          pyPerX * xPerBit + pyPerY * yPerBit,       pyPerX * xBase + pyPerY * yBase + pyBase};
+}
+}  // namespace
+
+void GfxRenderer::insertFont(const int fontId, EpdFontFamily font) {
+  std::lock_guard<std::mutex> guard(fontMapLock);
+  fontMap.insert({fontId, font});
+}
+
+const EpdFontFamily* GfxRenderer::getFont(const int fontId) const {
+  const auto* last = lastFont.load(std::memory_order_acquire);
+  if (last && last->first == fontId) {
+    return &last->second;
+  }
+
+  std::lock_guard<std::mutex> guard(fontMapLock);
+  auto entry = fontMap.find(fontId);
+  if (entry == fontMap.end()) {
+    const EpdFontFamily* loaded = fontLoader ? fontLoader(fontId) : nullptr;
+    if (!loaded) {
+      Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+      return nullptr;
+    }
+    entry = fontMap.insert({fontId, *loaded}).first;
+  }
+  lastFont.store(&*entry, std::memory_order_release);
+  return &entry->second;
+}
+
+std::vector<int> GfxRenderer::getFontIds() const {
+  std::lock_guard<std::mutex> guard(fontMapLock);
+  std::vector<int> ids;
+  ids.reserve(fontMap.size());
+  for (const auto& entry : fontMap) {
+    ids.push_back(entry.first);
+  }
+  return ids;
+}
 
 void GfxRenderer::rotateCoordinates(const int x, const int y, int* rotatedX, int* rotatedY) const {
   switch (orientation) {
@@ -44,6 +319,14 @@ void GfxRenderer::drawPixel(const int x, const int y, const bool state) const {
     return;
   }
 
+  // The grayscale passes would draw the same pixel into their cleared buffers
+  if (plotPixel(frameBuffer, x, y, state) && capturingGrayscale) {
+    plotPixel(grayLsbPlane, x, y, state);
+    plotPixel(grayMsbPlane, x, y, state);
+  }
+}
+
+bool GfxRenderer::plotPixel(uint8_t* buffer, const int x, const int y, const bool state) const {
   int rotatedX = 0;
   int rotatedY = 0;
   rotateCoordinates(x, y, &rotatedX, &rotatedY);
@@ -51,7 +334,7 @@ void GfxRenderer::drawPixel(const int x, const int y, const bool state) const {
   // Bounds checking against physical panel dimensions
   if (rotatedX < 0 || rotatedX >= HalDisplay::DISPLAY_WIDTH || rotatedY < 0 || rotatedY >= HalDisplay::DISPLAY_HEIGHT) {
     Serial.printf("[%lu] [GFX] !! Outside range (%d, %d) -> (%d, %d)\n", millis(), x, y, rotatedX, rotatedY);
-    return;
+    return false;
   }
 
   // Calculate byte position and bit position
@@ -59,21 +342,43 @@ void GfxRenderer::drawPixel(const int x, const int y, const bool state) const {
   const uint8_t bitPosition = 7 - (rotatedX % 8);  // MSB first
 
   if (state) {
-    frameBuffer[byteIndex] &= ~(1 << bitPosition);  // Clear bit
+    buffer[byteIndex] &= ~(1 << bitPosition);  // Clear bit
   } else {
-    frameBuffer[byteIndex] |= 1 << bitPosition;  // Set bit
+    buffer[byteIndex] |= 1 << bitPosition;  // Set bit
+  }
+  return true;
+}
+
+void GfxRenderer::drawGrayPixel(const int x, const int y, const uint8_t val, const bool black) const {
+  if (capturingGrayscale) {
+    if (val < 3) {
+      plotPixel(display.getFrameBuffer(), x, y, black);
+    }
+    if (val == 1) {
+      plotPixel(grayLsbPlane, x, y, false);
+    }
+    if (val == 1 || val == 2) {
+      plotPixel(grayMsbPlane, x, y, false);
+    }
+    return;
+  }
+
+  if (renderMode == BW && val < 3) {
+    drawPixel(x, y, black);
+  } else if (renderMode == GRAYSCALE_MSB && (val == 1 || val == 2)) {
+    drawPixel(x, y, false);
+  } else if (renderMode == GRAYSCALE_LSB && val == 1) {
+    drawPixel(x, y, false);
   }
 }
 
 int GfxRenderer::getTextWidth(const int fontId, const char* text, const EpdFontFamily::Style style) const {
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
     return 0;
   }
 
-  int w = 0, h = 0;
-  fontMap.at(fontId).getTextDimensions(text, &w, &h, style);
-  return w;
+  return textMeasureCache.getTextWidth(fontId, *font, text, style);
 }
 
 void GfxRenderer::drawCenteredText(const int fontId, const int y, const char* text, const bool black,
@@ -84,7 +389,16 @@ void GfxRenderer::drawCenteredText(const int fontId, const int y, const char* te
 
 void GfxRenderer::drawText(const int fontId, const int x, const int y, const char* text, const bool black,
                            const EpdFontFamily::Style style) const {
-  const int yPos = y + getFontAscenderSize(fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
+    return;
+  }
+  drawText(*font, x, y, text, black, style);
+}
+
+void GfxRenderer::drawText(const EpdFontFamily& font, const int x, const int y, const char* text, const bool black,
+                           const EpdFontFamily::Style style) const {
+  const int yPos = y + font.getData(EpdFontFamily::REGULAR)->ascender;
   int xpos = x;
 
   // cannot draw a NULL / empty string
@@ -92,12 +406,6 @@ void GfxRenderer::drawText(const int fontId, const int x, const int y, const cha
     return;
   }
 
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
-    return;
-  }
-  const auto font = fontMap.at(fontId);
-
   // no printable characters
   if (!font.hasPrintableChars(text, style)) {
     return;
@@ -247,13 +555,7 @@ void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, con
 
       const uint8_t val = outputRow[bmpX / 4] >> (6 - ((bmpX * 2) % 8)) & 0x3;
 
-      if (renderMode == BW && val < 3) {
-        drawPixel(screenX, screenY);
-      } else if (renderMode == GRAYSCALE_MSB && (val == 1 || val == 2)) {
-        drawPixel(screenX, screenY, false);
-      } else if (renderMode == GRAYSCALE_LSB && val == 1) {
-        drawPixel(screenX, screenY, false);
-      }
+      drawGrayPixel(screenX, screenY, val);
     }
   }
 
@@ -454,30 +756,30 @@ int GfxRenderer::getScreenHeight() const {
 }
 
 int GfxRenderer::getSpaceWidth(const int fontId) const {
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
     return 0;
   }
 
-  return fontMap.at(fontId).getGlyph(' ', EpdFontFamily::REGULAR)->advanceX;
+  return font->getGlyph(' ', EpdFontFamily::REGULAR)->advanceX;
 }
 
 int GfxRenderer::getFontAscenderSize(const int fontId) const {
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
     return 0;
   }
 
-  return fontMap.at(fontId).getData(EpdFontFamily::REGULAR)->ascender;
+  return font->getData(EpdFontFamily::REGULAR)->ascender;
 }
 
 int GfxRenderer::getLineHeight(const int fontId) const {
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
     return 0;
   }
 
-  return fontMap.at(fontId).getData(EpdFontFamily::REGULAR)->advanceY;
+  return font->getData(EpdFontFamily::REGULAR)->advanceY;
 }
 
 void GfxRenderer::drawButtonHints(const int fontId, const char* btn1, const char* btn2, const char* btn3,
@@ -560,11 +862,11 @@ void GfxRenderer::drawSideButtonHints(const int fontId, const char* topBtn, cons
 }
 
 int GfxRenderer::getTextHeight(const int fontId) const {
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* font = getFont(fontId);
+  if (!font) {
     return 0;
   }
-  return fontMap.at(fontId).getData(EpdFontFamily::REGULAR)->ascender;
+  return font->getData(EpdFontFamily::REGULAR)->ascender;
 }
 
 void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y, const char* text, const bool black,
@@ -574,11 +876,11 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
     return;
   }
 
-  if (fontMap.count(fontId) == 0) {
-    Serial.printf("[%lu] [GFX] Font %d not found\n", millis(), fontId);
+  const EpdFontFamily* fontPtr = getFont(fontId);
+  if (!fontPtr) {
     return;
   }
-  const auto font = fontMap.at(fontId);
+  const EpdFontFamily& font = *fontPtr;
 
   // No printable characters
   if (!font.hasPrintableChars(text, style)) {
@@ -626,13 +928,7 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
             const uint8_t bit_index = (3 - pixelPosition % 4) * 2;
             const uint8_t bmpVal = 3 - (byte >> bit_index) & 0x3;
 
-            if (renderMode == BW && bmpVal < 3) {
-              drawPixel(screenX, screenY, black);
-            } else if (renderMode == GRAYSCALE_MSB && (bmpVal == 1 || bmpVal == 2)) {
-              drawPixel(screenX, screenY, false);
-            } else if (renderMode == GRAYSCALE_LSB && bmpVal == 1) {
-              drawPixel(screenX, screenY, false);
-            }
+            drawGrayPixel(screenX, screenY, bmpVal, black);
           } else {
             const uint8_t byte = bitmap[pixelPosition / 8];
             const uint8_t bit_index = 7 - (pixelPosition % 8);
@@ -770,6 +1066,46 @@ void GfxRenderer::cleanupGrayscaleWithFrameBuffer() const {
   }
 }
 
+bool GfxRenderer::beginGrayscaleCapture() {
+  if (renderMode != BW) {
+    return false;
+  }
+  if (!grayLsbPlane) {
+    grayLsbPlane = static_cast<uint8_t*>(malloc(HalDisplay::BUFFER_SIZE));
+  }
+  if (!grayMsbPlane) {
+    grayMsbPlane = static_cast<uint8_t*>(malloc(HalDisplay::BUFFER_SIZE));
+  }
+  if (!grayLsbPlane || !grayMsbPlane) {
+    Serial.printf("[%lu] [GFX] !! Failed to allocate grayscale capture planes\n", millis());
+    freeGrayscaleCapture();
+    return false;
+  }
+
+  memset(grayLsbPlane, 0x00, HalDisplay::BUFFER_SIZE);
+  memset(grayMsbPlane, 0x00, HalDisplay::BUFFER_SIZE);
+  capturingGrayscale = true;
+  return true;
+}
+
+void GfxRenderer::displayGrayscaleCapture() const {
+  uint8_t* frameBuffer = display.getFrameBuffer();
+  if (!frameBuffer || !grayLsbPlane || !grayMsbPlane) {
+    return;
+  }
+  display.copyGrayscaleBuffers(grayLsbPlane, grayMsbPlane);
+  display.displayGrayBuffer();
+  display.cleanupGrayscaleBuffers(frameBuffer);
+}
+
+void GfxRenderer::freeGrayscaleCapture() {
+  capturingGrayscale = false;
+  free(grayLsbPlane);
+  free(grayMsbPlane);
+  grayLsbPlane = nullptr;
+  grayMsbPlane = nullptr;
+}
+
 void GfxRenderer::renderChar(const EpdFontFamily& fontFamily, const uint32_t cp, int* x, const int* y,
                              const bool pixelState, const EpdFontFamily::Style style) const {
   const EpdGlyph* glyph = fontFamily.getGlyph(cp, style);
@@ -783,54 +1119,190 @@ void GfxRenderer::renderChar(const EpdFontFamily& fontFamily, const uint32_t cp,
     return;
   }
 
-  const int is2Bit = fontFamily.getData(style)->is2Bit;
-  const uint32_t offset = glyph->dataOffset;
-  const uint8_t width = glyph->width;
-  const uint8_t height = glyph->height;
-  const int left = glyph->left;
-
-  const uint8_t* bitmap = nullptr;
-  bitmap = &fontFamily.getData(style)->bitmap[offset];
-
-  if (bitmap != nullptr) {
-    for (int glyphY = 0; glyphY < height; glyphY++) {
-      const int screenY = *y - glyph->top + glyphY;
-      for (int glyphX = 0; glyphX < width; glyphX++) {
-        const int pixelPosition = glyphY * width + glyphX;
-        const int screenX = *x + left + glyphX;
-
-        if (is2Bit) {
-          const uint8_t byte = bitmap[pixelPosition / 4];
-          const uint8_t bit_index = (3 - pixelPosition % 4) * 2;
-          // the direct bit from the font is 0 -> white, 1 -> light gray, 2 -> dark gray, 3 -> black
-          // we swap this to better match the way images and screen think about colors:
-          // 0 -> black, 1 -> dark grey, 2 -> light grey, 3 -> white
-          const uint8_t bmpVal = 3 - (byte >> bit_index) & 0x3;
-
-          if (renderMode == BW && bmpVal < 3) {
-            // Black (also paints over the grays in BW mode)
-            drawPixel(screenX, screenY, pixelState);
-          } else if (renderMode == GRAYSCALE_MSB && (bmpVal == 1 || bmpVal == 2)) {
-            // Light gray (also mark the MSB if it's going to be a dark gray too)
-            // We have to flag pixels in reverse for the gray buffers, as 0 leave alone, 1 update
-            drawPixel(screenX, screenY, false);
-          } else if (renderMode == GRAYSCALE_LSB && bmpVal == 1) {
-            // Dark gray
-            drawPixel(screenX, screenY, false);
-          }
-        } else {
-          const uint8_t byte = bitmap[pixelPosition / 8];
-          const uint8_t bit_index = 7 - (pixelPosition % 8);
+  const EpdFontData* fontData = fontFamily.getData(style);
+  const uint8_t* bitmap = &fontData->bitmap[glyph->dataOffset];
+  if (glyph->width > 0 && glyph->height > 0) {
+    blitGlyph(bitmap, fontData->is2Bit, glyph->width, glyph->height, *x + glyph->left, *y - glyph->top, pixelState);
+  }
 
-          if ((byte >> bit_index) & 1) {
-            drawPixel(screenX, screenY, pixelState);
+  *x += glyph->advanceX;
+}
+
+// Writes a glyph straight into the framebuffer without going through drawPixel. The glyph box is rotated and clipped
+// against the panel once, then every panel row it covers is walked left to right as a run, collecting the painted
+// pixels of each framebuffer byte into a mask that is applied with a single read-modify-write.
+void GfxRenderer::blitGlyph(const uint8_t* bitmap, const bool is2Bit, const int width, const int height,
+                            const int originX, const int originY, const bool pixelState) const {
+  uint8_t* frameBuffer = display.getFrameBuffer();
+  if (!frameBuffer) {
+    Serial.printf("[%lu] [GFX] !! No framebuffer\n", millis());
+    return;
+  }
+
+  // Raw glyph values that paint in this pass (bit n set = value n paints) and whether painting clears the bit.
+  // 2-bit values are 0 -> white, 1 -> light gray, 2 -> dark gray, 3 -> black.
+  // While capturing grayscale, the LSB and MSB planes get painted alongside the BW frame buffer.
+  struct Target {
+    uint8_t* buffer;
+    uint8_t paintValues;
+    bool clearBits;
+    uint8_t mask;
+  };
+  Target targets[3];
+  int targetCount = 0;
+  const auto addTarget = [&](uint8_t* buffer, const RenderMode mode) {
+    Target& target = targets[targetCount++];
+    target = {buffer, 0b0010, pixelState, 0};
+    if (is2Bit) {
+      switch (mode) {
+        case BW:
+          // Black (also paints over the grays in BW mode)
+          target.paintValues = 0b1110;
+          break;
+        case GRAYSCALE_MSB:
+          // Light and dark gray, gray buffers flag pixels to update by setting the bit
+          target.paintValues = 0b0110;
+          target.clearBits = false;
+          break;
+        case GRAYSCALE_LSB:
+          // Dark gray only
+          target.paintValues = 0b0100;
+          target.clearBits = false;
+          break;
+      }
+    }
+  };
+  addTarget(frameBuffer, renderMode);
+  if (capturingGrayscale) {
+    addTarget(grayLsbPlane, GRAYSCALE_LSB);
+    addTarget(grayMsbPlane, GRAYSCALE_MSB);
+  }
+
+  // Panel-space bounding box of the glyph, and the glyph coordinate of a panel pixel expressed as
+  // gx = gxBase + gxPerX * panelX + gxPerY * panelY (same for gy). Mirrors rotateCoordinates.
+  int x0, x1, y0, y1;
+  int gxBase = 0, gxPerX = 0, gxPerY = 0, gyBase = 0, gyPerX = 0, gyPerY = 0;
+  switch (orientation) {
+    case Portrait:
+      x0 = originY;
+      x1 = originY + height;
+      y0 = HalDisplay::DISPLAY_HEIGHT - originX - width;
+      y1 = HalDisplay::DISPLAY_HEIGHT - originX;
+      gxBase = HalDisplay::DISPLAY_HEIGHT - 1 - originX;
+      gxPerY = -1;
+      gyBase = -originY;
+      gyPerX = 1;
+      break;
+    case LandscapeClockwise:
+      x0 = HalDisplay::DISPLAY_WIDTH - originX - width;
+      x1 = HalDisplay::DISPLAY_WIDTH - originX;
+      y0 = HalDisplay::DISPLAY_HEIGHT - originY - height;
+      y1 = HalDisplay::DISPLAY_HEIGHT - originY;
+      gxBase = HalDisplay::DISPLAY_WIDTH - 1 - originX;
+      gxPerX = -1;
+      gyBase = HalDisplay::DISPLAY_HEIGHT - 1 - originY;
+      gyPerY = -1;
+      break;
+    case PortraitInverted:
+      x0 = HalDisplay::DISPLAY_WIDTH - originY - height;
+      x1 = HalDisplay::DISPLAY_WIDTH - originY;
+      y0 = originX;
+      y1 = originX + width;
+      gxBase = -originX;
+      gxPerY = 1;
+      gyBase = HalDisplay::DISPLAY_WIDTH - 1 - originY;
+      gyPerX = -1;
+      break;
+    case LandscapeCounterClockwise:
+    default:
+      x0 = originX;
+      x1 = originX + width;
+      y0 = originY;
+      y1 = originY + height;
+      gxBase = -originX;
+      gxPerX = 1;
+      gyBase = -originY;
+      gyPerY = 1;
+      break;
+  }
+
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, static_cast<int>(HalDisplay::DISPLAY_WIDTH));
+  y1 = std::min(y1, static_cast<int>(HalDisplay::DISPLAY_HEIGHT));
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  // Bitmap pixel index moves by a fixed amount per panel column
+  const int posStepX = gyPerX * width + gxPerX;
+
+  for (int panelY = y0; panelY < y1; panelY++) {
+    int pos = (gyBase + gyPerX * x0 + gyPerY * panelY) * width + gxBase + gxPerX * x0 + gxPerY * panelY;
+    const size_t rowOffset = panelY * HalDisplay::DISPLAY_WIDTH_BYTES;
+
+    for (int panelX = x0; panelX < x1; panelX++, pos += posStepX) {
+      const uint8_t value = is2Bit ? (bitmap[pos >> 2] >> ((3 - (pos & 3)) * 2)) & 0x3
+                                   : (bitmap[pos >> 3] >> (7 - (pos & 7))) & 0x1;
+      for (int t = 0; t < targetCount; t++) {
+        if ((targets[t].paintValues >> value) & 1) {
+          targets[t].mask |= 0x80 >> (panelX & 7);
+        }
+      }
+
+      if ((panelX & 7) == 7 || panelX == x1 - 1) {
+        for (int t = 0; t < targetCount; t++) {
+          Target& target = targets[t];
+          if (target.mask) {
+            if (target.clearBits) {
+              target.buffer[rowOffset + (panelX >> 3)] &= ~target.mask;
+            } else {
+              target.buffer[rowOffset + (panelX >> 3)] |= target.mask;
+            }
+            target.mask = 0;
           }
         }
       }
     }
   }
+}
 
-  *x += glyph->advanceX;
+void GfxRenderer::drawXtgPage(const uint8_t* rows, const int width, const int height) const {
+  // 1-bit pages have no gray levels, so only the BW pass paints anything
+  if (renderMode != BW || width <= 0 || height <= 0) {
+    return;
+  }
+  uint8_t* frameBuffer = display.getFrameBuffer();
+  if (!frameBuffer) {
+    Serial.printf("[%lu] [GFX] !! No framebuffer in drawXtgPage\n", millis());
+    return;
+  }
+
+  // Row y holds pixels x = 0..width-1
+  const PageBitLines lines = {rows, nullptr, static_cast<size_t>((width + 7) / 8), height, width, PagePaint::XtgBlack};
+  PageBlitter(frameBuffer, lines, mapPageBits(orientation, 0, 1, 0, 1, 0, 0), true).blit();
+}
+
+void GfxRenderer::drawXthPage(const uint8_t* plane1, const uint8_t* plane2, const int width, const int height) const {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  uint8_t* frameBuffer = display.getFrameBuffer();
+  if (!frameBuffer) {
+    Serial.printf("[%lu] [GFX] !! No framebuffer in drawXthPage\n", millis());
+    return;
+  }
+
+  PagePaint paint = PagePaint::XthBlack;
+  if (renderMode == GRAYSCALE_LSB) {
+    paint = PagePaint::XthDarkGray;
+  } else if (renderMode == GRAYSCALE_MSB) {
+    paint = PagePaint::XthGrays;
+  }
+
+  // Column c holds pixels y = 0..height-1 of x = width-1-c
+  const PageBitLines lines = {plane1, plane2, static_cast<size_t>((height + 7) / 8), width, height, paint};
+  PageBlitter(frameBuffer, lines, mapPageBits(orientation, -1, 0, width - 1, 0, 1, 0), renderMode == BW).blit();
 }
 
 void GfxRenderer::getOrientedViewableTRBL(int* outTop, int* outRight, int* outBottom, int* outLeft) const {
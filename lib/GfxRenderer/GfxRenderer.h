@@ -3,14 +3,21 @@
 #include <EpdFontFamily.h>
 #include <HalDisplay.h>
 
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include "Bitmap.h"
+#include "TextMeasureCache.h"
 
 class GfxRenderer {
  public:
   enum RenderMode { BW, GRAYSCALE_LSB, GRAYSCALE_MSB };
 
+  // Finds the family of a font id the renderer hasn't been given yet, or returns nullptr for an unknown id
+  using FontLoader = const EpdFontFamily* (*)(int fontId);
+
   // Logical screen orientation from the perspective of callers
   enum Orientation {
     Portrait,                  // 480x800 logical coordinates (current default)
@@ -29,15 +36,34 @@ class GfxRenderer {
   RenderMode renderMode;
   Orientation orientation;
   uint8_t* bwBufferChunks[BW_BUFFER_NUM_CHUNKS] = {nullptr};
-  std::map<int, EpdFontFamily> fontMap;
+  // Side buffers filled during a BW render while capturing grayscale, kept until freeGrayscaleCapture()
+  uint8_t* grayLsbPlane = nullptr;
+  uint8_t* grayMsbPlane = nullptr;
+  bool capturingGrayscale = false;
+  // Families by id, inserted up front or added by the loader on first use. Entries are never removed, so the
+  // pointers handed out by getFont() stay valid for the renderer's lifetime.
+  mutable std::map<int, EpdFontFamily> fontMap;
+  mutable std::mutex fontMapLock;
+  FontLoader fontLoader = nullptr;
+  // The entry last resolved, as text is mostly drawn and measured in one font at a time
+  mutable std::atomic<const std::pair<const int, EpdFontFamily>*> lastFont{nullptr};
+  mutable TextMeasureCache textMeasureCache;
   void renderChar(const EpdFontFamily& fontFamily, uint32_t cp, int* x, const int* y, bool pixelState,
                   EpdFontFamily::Style style) const;
+  void blitGlyph(const uint8_t* bitmap, bool is2Bit, int width, int height, int originX, int originY,
+                 bool pixelState) const;
   void freeBwBufferChunks();
   void rotateCoordinates(int x, int y, int* rotatedX, int* rotatedY) const;
+  bool plotPixel(uint8_t* buffer, int x, int y, bool state) const;
+  // Pixel with a 2-bit value (0 black .. 3 white) as the current render mode paints it
+  void drawGrayPixel(int x, int y, uint8_t val, bool black = true) const;
 
  public:
   explicit GfxRenderer(HalDisplay& halDisplay) : display(halDisplay), renderMode(BW), orientation(Portrait) {}
-  ~GfxRenderer() { freeBwBufferChunks(); }
+  ~GfxRenderer() {
+    freeBwBufferChunks();
+    freeGrayscaleCapture();
+  }
 
   static constexpr int VIEWABLE_MARGIN_TOP = 9;
   static constexpr int VIEWABLE_MARGIN_RIGHT = 3;
@@ -46,6 +72,11 @@ class GfxRenderer {
 
   // Setup
   void insertFont(int fontId, EpdFontFamily font);
+  void setFontLoader(const FontLoader loader) { fontLoader = loader; }
+  // The family of a font id, loading it on first use, or nullptr if there is none
+  const EpdFontFamily* getFont(int fontId) const;
+  // Ids of the fonts inserted or loaded so far
+  std::vector<int> getFontIds() const;
 
   // Orientation control (affects logical width/height and coordinate transforms)
   void setOrientation(const Orientation o) { orientation = o; }
@@ -70,6 +101,11 @@ class GfxRenderer {
                   float cropY = 0) const;
   void drawBitmap1Bit(const Bitmap& bitmap, int x, int y, int maxWidth, int maxHeight) const;
   void fillPolygon(const int* xPoints, const int* yPoints, int numPoints, bool state = true) const;
+  // Pre-rendered XTC pages, copied or transposed straight into the buffer of the current render mode.
+  // XTG: 1-bit rows, 0 = black. XTH: two column-major bit planes starting at the right edge, value = bit1 << 1 | bit2,
+  // painted as black (BW), value 1 (GRAYSCALE_LSB) or values 1 and 2 (GRAYSCALE_MSB).
+  void drawXtgPage(const uint8_t* rows, int width, int height) const;
+  void drawXthPage(const uint8_t* plane1, const uint8_t* plane2, int width, int height) const;
 
   // Text
   int getTextWidth(int fontId, const char* text, EpdFontFamily::Style style = EpdFontFamily::REGULAR) const;
@@ -77,6 +113,9 @@ class GfxRenderer {
                         EpdFontFamily::Style style = EpdFontFamily::REGULAR) const;
   void drawText(int fontId, int x, int y, const char* text, bool black = true,
                 EpdFontFamily::Style style = EpdFontFamily::REGULAR) const;
+  // For drawing many runs in one font, with the family from getFont() resolved once
+  void drawText(const EpdFontFamily& font, int x, int y, const char* text, bool black = true,
+                EpdFontFamily::Style style = EpdFontFamily::REGULAR) const;
   int getSpaceWidth(int fontId) const;
   int getFontAscenderSize(int fontId) const;
   int getLineHeight(int fontId) const;
@@ -102,6 +141,14 @@ class GfxRenderer {
   bool storeBwBuffer();    // Returns true if buffer was stored successfully
   void restoreBwBuffer();  // Restore and free the stored buffer
   void cleanupGrayscaleWithFrameBuffer() const;
+  // Single-pass alternative to the LSB/MSB re-renders: between begin and end, BW drawing also fills the LSB and MSB
+  // side buffers with what those passes would have drawn. Returns false (nothing captured) if the side buffers can't
+  // be allocated or the renderer isn't in BW mode, in which case the caller should fall back to the separate passes.
+  bool beginGrayscaleCapture();
+  void endGrayscaleCapture() { capturingGrayscale = false; }
+  // Sends the captured planes to the display and shows them, leaving the BW frame buffer as it was
+  void displayGrayscaleCapture() const;
+  void freeGrayscaleCapture();
 
   // Low level functions
   uint8_t* getFrameBuffer() const;
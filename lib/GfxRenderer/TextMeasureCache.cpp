@@ -0,0 +1,121 @@
+#include "TextMeasureCache.h"
+
+#include <HardwareSerial.h>
+#include <Utf8.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// FNV-1a 64 over font id, style and text. Stops hashing once the text is too long to be memoised.
+uint64_t memoKey(const int fontId, const EpdFontFamily::Style style, const char* text, const int maxBytes,
+                 int* textBytes) {
+  uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](const uint8_t byte) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  };
+  for (int i = 0; i < 4; i++) {
+    mix(static_cast<uint32_t>(fontId) >> (8 * i));
+  }
+  mix(style);
+
+  int length = 0;
+  for (; text[length] && length <= maxBytes; length++) {
+    mix(text[length]);
+  }
+  mix(length);
+  *textBytes = length;
+  return hash ? hash : 1;
+}
+}  // namespace
+
+const EpdAdvanceTable* TextMeasureCache::getAdvanceTable(const EpdFont* font) {
+  tableUseCounter++;
+  int slot = 0;
+  for (int i = 0; i < MAX_ADVANCE_TABLES; i++) {
+    if (tables[i].getFont() == font) {
+      tableLastUse[i] = tableUseCounter;
+      return &tables[i];
+    }
+    if (tableLastUse[i] < tableLastUse[slot]) {
+      slot = i;
+    }
+  }
+
+  // Not cached yet, replace the least recently used (or an empty) slot
+  if (!tables[slot].build(*font)) {
+    Serial.printf("[%lu] [GFX] Not enough memory for a %u byte advance table\n", millis(),
+                  static_cast<unsigned>(EpdAdvanceTable::memoryUsage()));
+    tableLastUse[slot] = 0;
+    return nullptr;
+  }
+  tableLastUse[slot] = tableUseCounter;
+  return &tables[slot];
+}
+
+// Same walk as EpdFont::getTextBounds, restricted to the horizontal extent. Stops at the first code point the advance
+// table can't answer when stopAtSlowGlyph is set, leaving text pointing at it.
+bool TextMeasureCache::Extent::advance(const EpdFont& font, const EpdAdvanceTable* table,
+                                       const unsigned char** text, const bool stopAtSlowGlyph) {
+  while (**text) {
+    const unsigned char* glyphStart = *text;
+    const uint32_t cp = **text < 0x80 ? *(*text)++ : utf8NextCodepoint(text);
+
+    const EpdAdvanceTable::Metrics* metrics = table ? table->lookup(cp) : nullptr;
+    if (metrics && metrics->left != EpdAdvanceTable::SLOW_PATH) {
+      add(metrics->left, metrics->width, metrics->advanceX);
+      continue;
+    }
+
+    if (stopAtSlowGlyph) {
+      *text = glyphStart;
+      return false;
+    }
+    const EpdGlyph* glyph = font.getGlyph(cp);
+    if (!glyph) {
+      glyph = font.getGlyph(REPLACEMENT_GLYPH);
+    }
+    if (glyph) {
+      add(glyph->left, glyph->width, glyph->advanceX);
+    }
+  }
+  return true;
+}
+
+int TextMeasureCache::getTextWidth(const int fontId, const EpdFontFamily& family, const char* text,
+                                   const EpdFontFamily::Style style) {
+  const EpdFont* font = family.getFont(style);
+  const EpdAdvanceTable* table = getAdvanceTable(font);
+
+  // Text the advance table covers entirely is cheaper to measure than to hash
+  Extent extent;
+  auto str = reinterpret_cast<const unsigned char*>(text);
+  if (extent.advance(*font, table, &str, true)) {
+    return extent.width();
+  }
+
+  int textBytes = 0;
+  const uint64_t key = memoKey(fontId, style, text, MAX_MEMO_TEXT_BYTES, &textBytes);
+  if (textBytes > MAX_MEMO_TEXT_BYTES) {
+    extent.advance(*font, table, &str, false);
+    return extent.width();
+  }
+
+  // Ways are kept in most-recently-used order
+  MemoEntry* set = &memo[(key % MEMO_SETS) * MEMO_WAYS];
+  for (int way = 0; way < MEMO_WAYS; way++) {
+    if (set[way].key == key) {
+      const MemoEntry hit = set[way];
+      memmove(&set[1], &set[0], way * sizeof(MemoEntry));
+      set[0] = hit;
+      return hit.width;
+    }
+  }
+
+  extent.advance(*font, table, &str, false);
+  const int width = extent.width();
+  memmove(&set[1], &set[0], (MEMO_WAYS - 1) * sizeof(MemoEntry));
+  set[0] = {key, static_cast<uint16_t>(width)};
+  return width;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <EpdAdvanceTable.h>
+#include <EpdFontFamily.h>
+
+#include <algorithm>
+
+// Fast path behind GfxRenderer::getTextWidth. Returns exactly what EpdFontFamily::getTextDimensions would, but:
+// - glyph metrics for common scripts come from a per-font EpdAdvanceTable, built the first time a font is measured
+//   and kept for the MAX_ADVANCE_TABLES most recently used fonts;
+// - short strings the table doesn't fully cover (CJK, Greek, symbols...) are memoised in a small set-associative LRU
+//   keyed by font id, style and text, since each of their glyphs costs a binary search over the font's intervals.
+// Not thread-safe, like the rest of the renderer; callers already serialise rendering.
+class TextMeasureCache {
+  static constexpr int MAX_ADVANCE_TABLES = 8;
+  static constexpr int MEMO_SETS = 32;
+  static constexpr int MEMO_WAYS = 4;
+  static constexpr int MAX_MEMO_TEXT_BYTES = 48;
+
+  struct MemoEntry {
+    uint64_t key;  // 0 = empty
+    uint16_t width;
+  };
+
+  EpdAdvanceTable tables[MAX_ADVANCE_TABLES];
+  uint32_t tableLastUse[MAX_ADVANCE_TABLES] = {};
+  uint32_t tableUseCounter = 0;
+  MemoEntry memo[MEMO_SETS * MEMO_WAYS] = {};
+
+  // Horizontal bounds of the glyphs measured so far, as EpdFont::getTextBounds tracks them
+  struct Extent {
+    int minX = 0;
+    int maxX = 0;
+    int cursorX = 0;
+
+    void add(const int left, const int width, const int advanceX) {
+      minX = std::min(minX, cursorX + left);
+      maxX = std::max(maxX, cursorX + left + width);
+      cursorX += advanceX;
+    }
+    int width() const { return maxX - minX; }
+    bool advance(const EpdFont& font, const EpdAdvanceTable* table, const unsigned char** text, bool stopAtSlowGlyph);
+  };
+
+  const EpdAdvanceTable* getAdvanceTable(const EpdFont* font);
+
+ public:
+  int getTextWidth(int fontId, const EpdFontFamily& family, const char* text, EpdFontFamily::Style style);
+};
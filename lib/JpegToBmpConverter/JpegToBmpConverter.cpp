@@ -1,6 +1,7 @@
 #include "JpegToBmpConverter.h"
 
 #include <HardwareSerial.h>
+#include <HeapWatch.h>
 #include <SdFat.h>
 #include <picojpeg.h>
 
@@ -336,6 +337,7 @@ bool JpegToBmpConverter::jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bm
     rowCount = new uint16_t[outWidth]();
     nextOutY_srcStart = scaleY_fp;  // First boundary is at scaleY_fp (source Y for outY=1)
   }
+  heapwatch::sample();  // Every buffer of the conversion is allocated by now
 
   // Process MCUs row-by-row and write to BMP as we go (top-down)
   const int mcuPixelWidth = imageInfo.m_MCUWidth;
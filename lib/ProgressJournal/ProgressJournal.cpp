@@ -0,0 +1,213 @@
+#include "ProgressJournal.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+
+#include <algorithm>
+#include <cstring>
+
+ProgressJournal ProgressJournal::instance;
+
+namespace {
+// A record is the progress size, the progress and the FNV-1a hash of both
+constexpr size_t RECORD_OVERHEAD = 1 + sizeof(uint32_t);
+
+uint32_t checksum(const uint8_t* data, const size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Leaves the last intact record in out and returns its size, with torn set if the file ends in a partial or corrupt one
+size_t readJournal(FsFile& file, uint8_t* out, bool& torn) {
+  size_t latestSize = 0;
+  uint8_t record[ProgressJournal::MAX_PROGRESS_SIZE + RECORD_OVERHEAD];
+  while (true) {
+    if (file.read(record, 1) != 1) {
+      break;
+    }
+    const size_t size = record[0];
+    if (size == 0 || size > ProgressJournal::MAX_PROGRESS_SIZE) {
+      torn = true;
+      break;
+    }
+    const int rest = static_cast<int>(size + sizeof(uint32_t));
+    uint32_t stored;
+    if (file.read(record + 1, rest) != rest) {
+      torn = true;
+      break;
+    }
+    memcpy(&stored, record + 1 + size, sizeof(stored));
+    if (stored != checksum(record, 1 + size)) {
+      torn = true;
+      break;
+    }
+    memcpy(out, record + 1, size);
+    latestSize = size;
+  }
+  return latestSize;
+}
+}  // namespace
+
+size_t ProgressJournal::load(const std::string& bookCachePath, uint8_t* out, const size_t capacity) {
+  bool otherBookUnsaved;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    otherBookUnsaved = dirty && cachePath != bookCachePath;
+  }
+  if (otherBookUnsaved) {
+    flush();
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (cachePath == bookCachePath && dirty) {
+    const size_t size = std::min(capacity, pendingSize);
+    memcpy(out, pending, size);
+    return size;
+  }
+
+  cachePath = bookCachePath;
+  dirty = false;
+  savedSize = 0;
+  journalTorn = false;
+
+  FsFile file;
+  const std::string journalPath = cachePath + "/" + JOURNAL_FILE;
+  if (SdMan.exists(journalPath.c_str()) && SdMan.openFileForRead("PRJ", journalPath, file)) {
+    savedSize = readJournal(file, saved, journalTorn);
+    file.close();
+    if (journalTorn) {
+      Serial.printf("[%lu] [PRJ] %s ends in a torn record, kept the last intact one\n", millis(), journalPath.c_str());
+    }
+  }
+  if (savedSize == 0 && SdMan.openFileForRead("PRJ", cachePath + "/" + CHECKPOINT_FILE, file)) {
+    const int bytes = file.read(saved, MAX_PROGRESS_SIZE);
+    savedSize = bytes > 0 ? bytes : 0;
+    file.close();
+  }
+
+  const size_t size = std::min(capacity, savedSize);
+  memcpy(out, saved, size);
+  return size;
+}
+
+void ProgressJournal::update(const std::string& bookCachePath, const uint8_t* data, size_t size) {
+  size = std::min(size, MAX_PROGRESS_SIZE);
+  if (size == 0) {
+    return;
+  }
+
+  bool otherBookUnsaved;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    otherBookUnsaved = dirty && cachePath != bookCachePath;
+  }
+  if (otherBookUnsaved) {
+    flush();
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (cachePath != bookCachePath) {
+    cachePath = bookCachePath;
+    savedSize = 0;
+    journalTorn = false;
+  }
+  memcpy(pending, data, size);
+  pendingSize = size;
+  if (pendingSize == savedSize && memcmp(pending, saved, size) == 0) {
+    dirty = false;
+  } else if (!dirty) {
+    dirty = true;
+    dirtySince = millis();
+  }
+}
+
+bool ProgressJournal::write(const std::string& path, const uint8_t* data, const size_t size, bool compact) {
+  const std::string journalPath = path + "/" + JOURNAL_FILE;
+  if (!compact) {
+    FsFile file = SdMan.open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND);
+    if (file) {
+      const size_t journalSize = file.size();
+      if (journalSize + size + RECORD_OVERHEAD <= COMPACT_SIZE) {
+        // One write per record, so a power loss tears at most the record being written
+        uint8_t record[MAX_PROGRESS_SIZE + RECORD_OVERHEAD];
+        record[0] = static_cast<uint8_t>(size);
+        memcpy(record + 1, data, size);
+        const uint32_t hash = checksum(record, 1 + size);
+        memcpy(record + 1 + size, &hash, sizeof(hash));
+        const bool written = file.write(record, size + RECORD_OVERHEAD) == size + RECORD_OVERHEAD;
+        file.close();
+        return written;
+      }
+      file.close();
+    }
+    compact = true;
+  }
+
+  // The journal keeps the position until the checkpoint holding it is complete
+  FsFile file;
+  if (!SdMan.openFileForWrite("PRJ", path + "/" + CHECKPOINT_FILE, file)) {
+    return false;
+  }
+  const bool written = file.write(data, size) == size;
+  file.close();
+  if (!written) {
+    return false;
+  }
+  if (SdMan.exists(journalPath.c_str())) {
+    SdMan.remove(journalPath.c_str());
+  }
+  Serial.printf("[%lu] [PRJ] Compacted progress of %s\n", millis(), path.c_str());
+  return true;
+}
+
+bool ProgressJournal::flush() {
+  std::lock_guard<std::mutex> flushGuard(flushLock);
+  std::string path;
+  uint8_t data[MAX_PROGRESS_SIZE];
+  size_t size;
+  bool compact;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!dirty) {
+      return true;
+    }
+    path = cachePath;
+    size = pendingSize;
+    memcpy(data, pending, size);
+    compact = journalTorn;
+    dirty = false;
+  }
+
+  const bool written = write(path, data, size, compact);
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (path != cachePath) {
+    return written;
+  }
+  if (written) {
+    memcpy(saved, data, size);
+    savedSize = size;
+    journalTorn = false;
+  } else {
+    Serial.printf("[%lu] [PRJ] Could not save progress of %s\n", millis(), path.c_str());
+    // Try again after another delay rather than on every loop
+    if (!dirty) {
+      dirty = true;
+      dirtySince = millis();
+    }
+  }
+  return written;
+}
+
+bool ProgressJournal::flushIfDue(const unsigned long now) {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!dirty || now - dirtySince < FLUSH_DELAY_MS) {
+      return true;
+    }
+  }
+  return flush();
+}
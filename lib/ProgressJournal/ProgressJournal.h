@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Reading progress of the open book, kept off the page turn path. The readers hand over their position after every
+// page; it stays in RAM until flush() appends it to progress.jnl in the book's cache directory as one record with a
+// checksum. The main loop flushes a few seconds after the first unsaved page turn and at once on low battery, the
+// readers when they exit and main before deep sleep.
+//
+// Loading takes the last record whose checksum matches, so a write cut short by a power loss only loses that record.
+// Once the journal outgrows COMPACT_SIZE the position is written to progress.bin, the file older versions read and
+// write directly, and the journal is removed; a book without a journal loads from progress.bin.
+class ProgressJournal {
+ public:
+  static constexpr size_t MAX_PROGRESS_SIZE = 16;
+  static constexpr unsigned long FLUSH_DELAY_MS = 5000;
+  static constexpr size_t COMPACT_SIZE = 512;
+  static constexpr char JOURNAL_FILE[] = "progress.jnl";
+  static constexpr char CHECKPOINT_FILE[] = "progress.bin";
+
+ private:
+  // Static instance
+  static ProgressJournal instance;
+
+  std::mutex lock;
+  // Held across a flush so two tasks never write the same journal at once
+  std::mutex flushLock;
+  std::string cachePath;
+  uint8_t pending[MAX_PROGRESS_SIZE] = {};
+  size_t pendingSize = 0;
+  bool dirty = false;
+  unsigned long dirtySince = 0;
+  // What the card holds for cachePath, so going back to a saved position writes nothing
+  uint8_t saved[MAX_PROGRESS_SIZE] = {};
+  size_t savedSize = 0;
+  // The journal ends in a torn record; appending after it would hide the new ones, so it is compacted instead
+  bool journalTorn = false;
+
+  bool write(const std::string& path, const uint8_t* data, size_t size, bool compact);
+
+ public:
+  // Get singleton instance
+  static ProgressJournal& getInstance() { return instance; }
+
+  // Reads the book's latest position into out, returning its size or 0 if there is none
+  size_t load(const std::string& bookCachePath, uint8_t* out, size_t capacity);
+
+  // Records the position without touching the card. Progress of another book still unsaved is flushed first.
+  void update(const std::string& bookCachePath, const uint8_t* data, size_t size);
+
+  // Writes unsaved progress, if any
+  bool flush();
+
+  // Flushes progress left unsaved for FLUSH_DELAY_MS as of now (a millis() value)
+  bool flushIfDue(unsigned long now);
+};
+
+// Helper macro to access the progress journal
+#define PROGRESS_JOURNAL ProgressJournal::getInstance()
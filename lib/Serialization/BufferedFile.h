@@ -0,0 +1,136 @@
+#pragma once
+#include <SdFat.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace serialization {
+// One SD card sector. The adapters below go to the card a block at a time, aligned to sector boundaries in the file.
+constexpr size_t FILE_BLOCK_SIZE = 512;
+
+// Collects small writes into a block before handing it to the file, so a run of writePod/writeString calls becomes
+// one SdFat write per sector. The bytes on the card are exactly what writing straight to the file gives. Call flush()
+// (the destructor does too) before seeking, writing to or closing the file directly.
+class BufferedFileWriter {
+  FsFile& file;
+  uint8_t block[FILE_BLOCK_SIZE];
+  // File offset of block[0], and how much of the block fits before the next sector boundary
+  uint32_t blockStart;
+  size_t limit;
+  size_t used = 0;
+  bool failed = false;
+
+ public:
+  explicit BufferedFileWriter(FsFile& file)
+      : file(file),
+        blockStart(static_cast<uint32_t>(file.position())),
+        limit(FILE_BLOCK_SIZE - blockStart % FILE_BLOCK_SIZE) {}
+  ~BufferedFileWriter() { flush(); }
+  BufferedFileWriter(const BufferedFileWriter&) = delete;
+  BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+  size_t write(const uint8_t* data, const size_t size) {
+    size_t done = 0;
+    while (done < size) {
+      // Whole sectors skip the copy once the block is empty
+      if (used == 0 && limit == FILE_BLOCK_SIZE && size - done >= FILE_BLOCK_SIZE) {
+        const size_t direct = (size - done) / FILE_BLOCK_SIZE * FILE_BLOCK_SIZE;
+        if (file.write(data + done, direct) != direct) {
+          failed = true;
+          return done;
+        }
+        blockStart += direct;
+        done += direct;
+        continue;
+      }
+      const size_t chunk = std::min(size - done, limit - used);
+      memcpy(block + used, data + done, chunk);
+      used += chunk;
+      done += chunk;
+      if (used == limit && !flush()) {
+        return done - chunk;
+      }
+    }
+    return done;
+  }
+
+  bool flush() {
+    if (used > 0) {
+      failed |= file.write(block, used) != used;
+      blockStart += used;
+      used = 0;
+    }
+    limit = FILE_BLOCK_SIZE - blockStart % FILE_BLOCK_SIZE;
+    return !failed;
+  }
+
+  uint32_t position() const { return blockStart + used; }
+  bool hasFailed() const { return failed; }
+};
+
+// Reads the file a block at a time and serves small reads from RAM, so a run of readPod/readString calls becomes one
+// SdFat read per sector. Leaves the file positioned past the last block read: while the reader is in use, seek and
+// ask for the position through it rather than the file.
+class BufferedFileReader {
+  FsFile& file;
+  uint8_t block[FILE_BLOCK_SIZE];
+  // File offset of block[0]
+  uint32_t blockStart;
+  size_t pos = 0;
+  size_t end = 0;
+
+  bool refill() {
+    blockStart += end;
+    pos = 0;
+    end = 0;
+    const int bytes = file.read(block, FILE_BLOCK_SIZE - blockStart % FILE_BLOCK_SIZE);
+    if (bytes <= 0) {
+      return false;
+    }
+    end = bytes;
+    return true;
+  }
+
+ public:
+  explicit BufferedFileReader(FsFile& file) : file(file), blockStart(static_cast<uint32_t>(file.position())) {}
+  BufferedFileReader(const BufferedFileReader&) = delete;
+  BufferedFileReader& operator=(const BufferedFileReader&) = delete;
+
+  int read(void* data, const size_t size) {
+    auto* out = static_cast<uint8_t*>(data);
+    size_t done = 0;
+    while (done < size) {
+      if (pos == end) {
+        // Whole sectors go straight to the caller
+        if (size - done >= FILE_BLOCK_SIZE && (blockStart + end) % FILE_BLOCK_SIZE == 0) {
+          const size_t direct = (size - done) / FILE_BLOCK_SIZE * FILE_BLOCK_SIZE;
+          const int bytes = file.read(out + done, direct);
+          if (bytes <= 0) break;
+          blockStart += end + bytes;
+          pos = end = 0;
+          done += bytes;
+          continue;
+        }
+        if (!refill()) break;
+      }
+      const size_t chunk = std::min(size - done, end - pos);
+      memcpy(out + done, block + pos, chunk);
+      pos += chunk;
+      done += chunk;
+    }
+    return static_cast<int>(done);
+  }
+
+  bool seek(const uint32_t offset) {
+    if (offset >= blockStart && offset <= blockStart + end) {
+      pos = offset - blockStart;
+      return true;
+    }
+    blockStart = offset;
+    pos = end = 0;
+    return file.seek(offset);
+  }
+
+  uint32_t position() const { return blockStart + pos; }
+};
+}  // namespace serialization
@@ -2,6 +2,9 @@
 #include <SdFat.h>
 
 #include <iostream>
+#include <vector>
+
+#include "BufferedFile.h"
 
 namespace serialization {
 template <typename T>
@@ -14,6 +17,11 @@ static void writePod(FsFile& file, const T& value) {
   file.write(reinterpret_cast<const uint8_t*>(&value), sizeof(T));
 }
 
+template <typename T>
+static void writePod(BufferedFileWriter& writer, const T& value) {
+  writer.write(reinterpret_cast<const uint8_t*>(&value), sizeof(T));
+}
+
 template <typename T>
 static void readPod(std::istream& is, T& value) {
   is.read(reinterpret_cast<char*>(&value), sizeof(T));
@@ -24,6 +32,11 @@ static void readPod(FsFile& file, T& value) {
   file.read(reinterpret_cast<uint8_t*>(&value), sizeof(T));
 }
 
+template <typename T>
+static void readPod(BufferedFileReader& reader, T& value) {
+  reader.read(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+}
+
 static void writeString(std::ostream& os, const std::string& s) {
   const uint32_t len = s.size();
   writePod(os, len);
@@ -36,6 +49,12 @@ static void writeString(FsFile& file, const std::string& s) {
   file.write(reinterpret_cast<const uint8_t*>(s.data()), len);
 }
 
+static void writeString(BufferedFileWriter& writer, const std::string& s) {
+  const uint32_t len = s.size();
+  writePod(writer, len);
+  writer.write(reinterpret_cast<const uint8_t*>(s.data()), len);
+}
+
 static void readString(std::istream& is, std::string& s) {
   uint32_t len;
   readPod(is, len);
@@ -49,4 +68,90 @@ static void readString(FsFile& file, std::string& s) {
   s.resize(len);
   file.read(&s[0], len);
 }
+
+static void readString(BufferedFileReader& reader, std::string& s) {
+  uint32_t len;
+  readPod(reader, len);
+  s.resize(len);
+  reader.read(&s[0], len);
+}
+
+// Variable-length integers for records assembled in RAM and written with a single call. Unsigned LEB128, and signed
+// LEB128 for values that can go negative such as deltas.
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+static void writeSignedVarint(std::vector<uint8_t>& out, int32_t value) {
+  while (true) {
+    const uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if ((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40))) {
+      out.push_back(byte);
+      return;
+    }
+    out.push_back(byte | 0x80);
+  }
+}
+
+// Bounds-checked cursor over a record read into RAM. Reading past the end sets failed and yields zeros.
+class RecordReader {
+  const uint8_t* pos;
+  const uint8_t* end;
+  bool failed = false;
+
+ public:
+  RecordReader(const uint8_t* data, const size_t size) : pos(data), end(data + size) {}
+  bool hasFailed() const { return failed; }
+  bool atEnd() const { return pos == end; }
+
+  uint8_t readByte() {
+    if (pos == end) {
+      failed = true;
+      return 0;
+    }
+    return *pos++;
+  }
+
+  uint32_t readVarint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      const uint8_t byte = readByte();
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+    failed = true;
+    return 0;
+  }
+
+  int32_t readSignedVarint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      const uint8_t byte = readByte();
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        if (shift + 7 < 32 && (byte & 0x40)) value |= ~0u << (shift + 7);
+        return static_cast<int32_t>(value);
+      }
+    }
+    failed = true;
+    return 0;
+  }
+
+  // Returns a pointer into the record, or nullptr if fewer than count bytes are left
+  const uint8_t* readBytes(const size_t count) {
+    if (static_cast<size_t>(end - pos) < count) {
+      failed = true;
+      pos = end;
+      return nullptr;
+    }
+    const uint8_t* bytes = pos;
+    pos += count;
+    return bytes;
+  }
+};
 }  // namespace serialization
@@ -0,0 +1,359 @@
+#include "HeapWatch.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace heapwatch {
+namespace {
+constexpr uint8_t FILE_VERSION = 1;
+
+struct HeapState {
+  uint32_t freeBytes;
+  uint32_t largestBlock;
+  uint32_t minFreeSinceBoot;
+};
+
+// An activity or operation in progress. Slot 0 is the current activity, the others operations, which can run on the
+// reader's background task while the main loop samples.
+struct Frame {
+  bool open = false;
+  char name[NAME_SIZE];
+  char detail[DETAIL_SIZE];
+  uint32_t minFree;
+  uint32_t minLargestBlock;
+  uint32_t freeAtMinLargestBlock;
+  uint32_t watermarkAtStart;
+};
+
+std::mutex lock;
+Frame frames[1 + MAX_OPERATIONS];
+Record records[MAX_RECORDS];
+size_t recordCount = 0;
+bool dirty = false;
+
+HeapState readHeap() {
+  return {static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT)),
+          static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)),
+          static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT))};
+}
+
+// Keeps the end of text that doesn't fit, the file name being more telling than the start of its path
+void copyTail(char* out, const size_t size, const char* text) {
+  const size_t length = strlen(text);
+  const char* from = length < size ? text : text + length - (size - 1);
+  snprintf(out, size, "%s", from);
+}
+
+void update(Frame& frame, const HeapState& heap) {
+  frame.minFree = std::min(frame.minFree, heap.freeBytes);
+  // A new low since boot happened while this frame was open, so the allocator's watermark is this frame's low
+  if (heap.minFreeSinceBoot < frame.watermarkAtStart) {
+    frame.minFree = std::min(frame.minFree, heap.minFreeSinceBoot);
+  }
+  if (heap.largestBlock < frame.minLargestBlock) {
+    frame.minLargestBlock = heap.largestBlock;
+    frame.freeAtMinLargestBlock = heap.freeBytes;
+  }
+}
+
+void open(Frame& frame, const char* name, const char* detail, const HeapState& heap) {
+  frame.open = true;
+  copyTail(frame.name, sizeof(frame.name), name);
+  copyTail(frame.detail, sizeof(frame.detail), detail);
+  frame.minFree = heap.freeBytes;
+  frame.minLargestBlock = heap.largestBlock;
+  frame.freeAtMinLargestBlock = heap.freeBytes;
+  frame.watermarkAtStart = heap.minFreeSinceBoot;
+}
+
+// Folds a worst case into the record of the same name. Call with the lock held.
+void merge(const Record& worst) {
+  Record* record = nullptr;
+  for (size_t i = 0; i < recordCount; i++) {
+    if (strcmp(records[i].name, worst.name) == 0) {
+      record = &records[i];
+      break;
+    }
+  }
+  if (!record) {
+    if (recordCount == MAX_RECORDS) {
+      Serial.printf("[%lu] [HEAP] No room to track %s\n", millis(), worst.name);
+      return;
+    }
+    record = &records[recordCount++];
+    *record = worst;
+    dirty = true;
+    return;
+  }
+
+  // The count alone changing doesn't call for a write
+  record->count += worst.count;
+  if (worst.minFree < record->minFree) {
+    record->minFree = worst.minFree;
+    memcpy(record->minFreeDetail, worst.minFreeDetail, DETAIL_SIZE);
+    dirty = true;
+  }
+  if (worst.minLargestBlock < record->minLargestBlock) {
+    record->minLargestBlock = worst.minLargestBlock;
+    record->freeAtMinLargestBlock = worst.freeAtMinLargestBlock;
+    memcpy(record->minLargestBlockDetail, worst.minLargestBlockDetail, DETAIL_SIZE);
+    dirty = true;
+  }
+}
+
+void close(Frame& frame, const HeapState& heap) {
+  if (!frame.open) {
+    return;
+  }
+  update(frame, heap);
+  frame.open = false;
+
+  Record worst{};
+  memcpy(worst.name, frame.name, NAME_SIZE);
+  worst.count = 1;
+  worst.minFree = frame.minFree;
+  memcpy(worst.minFreeDetail, frame.detail, DETAIL_SIZE);
+  worst.minLargestBlock = frame.minLargestBlock;
+  worst.freeAtMinLargestBlock = frame.freeAtMinLargestBlock;
+  memcpy(worst.minLargestBlockDetail, frame.detail, DETAIL_SIZE);
+  merge(worst);
+}
+
+void appendJsonString(std::string& out, const char* text) {
+  out += '"';
+  for (const char* c = text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      out += '\\';
+      out += *c;
+    } else if (static_cast<uint8_t>(*c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+      out += escaped;
+    } else {
+      out += *c;
+    }
+  }
+  out += '"';
+}
+
+// Reads like serialization::readPod but reports a short read
+template <typename T>
+bool readValue(serialization::BufferedFileReader& reader, T& value) {
+  return reader.read(&value, sizeof(T)) == static_cast<int>(sizeof(T));
+}
+
+// Saved strings are copyTail'ed into size, so a longer length or a short read means the file is damaged
+bool readFixedString(serialization::BufferedFileReader& reader, char* out, const size_t size) {
+  uint32_t length = 0;
+  if (!readValue(reader, length) || length >= size || reader.read(out, length) != static_cast<int>(length)) {
+    return false;
+  }
+  out[length] = '\0';
+  return true;
+}
+
+bool readRecord(serialization::BufferedFileReader& reader, Record& record) {
+  return readFixedString(reader, record.name, NAME_SIZE) && readValue(reader, record.count) &&
+         readValue(reader, record.minFree) && readFixedString(reader, record.minFreeDetail, DETAIL_SIZE) &&
+         readValue(reader, record.minLargestBlock) && readValue(reader, record.freeAtMinLargestBlock) &&
+         readFixedString(reader, record.minLargestBlockDetail, DETAIL_SIZE);
+}
+}  // namespace
+
+void enterActivity(const std::string& name) {
+  const HeapState heap = readHeap();
+  std::lock_guard<std::mutex> guard(lock);
+  close(frames[0], heap);
+  open(frames[0], name.c_str(), "", heap);
+}
+
+void exitActivity() {
+  const HeapState heap = readHeap();
+  std::lock_guard<std::mutex> guard(lock);
+  close(frames[0], heap);
+}
+
+void sample() {
+  const HeapState heap = readHeap();
+  std::lock_guard<std::mutex> guard(lock);
+  for (auto& frame : frames) {
+    if (frame.open) {
+      update(frame, heap);
+    }
+  }
+}
+
+Operation::Operation(const char* name, const std::string& detail) : slot(-1) {
+  const HeapState heap = readHeap();
+  std::lock_guard<std::mutex> guard(lock);
+  // Whatever the activity has been doing up to here counts for it too
+  if (frames[0].open) {
+    update(frames[0], heap);
+  }
+  for (size_t i = 1; i < sizeof(frames) / sizeof(frames[0]); i++) {
+    if (!frames[i].open) {
+      open(frames[i], name, detail.c_str(), heap);
+      slot = static_cast<int>(i);
+      return;
+    }
+  }
+}
+
+Operation::~Operation() {
+  const HeapState heap = readHeap();
+  std::lock_guard<std::mutex> guard(lock);
+  if (frames[0].open) {
+    update(frames[0], heap);
+  }
+  if (slot > 0) {
+    close(frames[slot], heap);
+  }
+}
+
+size_t getRecords(Record* out, const size_t capacity) {
+  std::lock_guard<std::mutex> guard(lock);
+  const size_t count = std::min(capacity, recordCount);
+  std::copy(records, records + count, out);
+  return count;
+}
+
+void reset() {
+  std::lock_guard<std::mutex> guard(lock);
+  recordCount = 0;
+  dirty = true;
+}
+
+std::string toJson() {
+  const HeapState heap = readHeap();
+  Record snapshot[MAX_RECORDS];
+  const size_t count = getRecords(snapshot, MAX_RECORDS);
+
+  std::string out;
+  out.reserve(128 + count * 256);
+  char number[160];
+  snprintf(number, sizeof(number), "{\"free\":%lu,\"largestBlock\":%lu,\"minFreeSinceBoot\":%lu,\"records\":[",
+           static_cast<unsigned long>(heap.freeBytes), static_cast<unsigned long>(heap.largestBlock),
+           static_cast<unsigned long>(heap.minFreeSinceBoot));
+  out += number;
+  for (size_t i = 0; i < count; i++) {
+    const Record& record = snapshot[i];
+    out += i ? ",{\"name\":" : "{\"name\":";
+    appendJsonString(out, record.name);
+    snprintf(number, sizeof(number), ",\"count\":%lu,\"minFree\":%lu,\"minFreeDetail\":",
+             static_cast<unsigned long>(record.count), static_cast<unsigned long>(record.minFree));
+    out += number;
+    appendJsonString(out, record.minFreeDetail);
+    // How much of the free heap was unusable for one allocation, in percent
+    const unsigned fragmentation =
+        record.freeAtMinLargestBlock ? 100 - record.minLargestBlock * 100ull / record.freeAtMinLargestBlock : 0;
+    snprintf(number, sizeof(number),
+             ",\"minLargestBlock\":%lu,\"freeAtMinLargestBlock\":%lu,\"fragmentation\":%u,\"minLargestBlockDetail\":",
+             static_cast<unsigned long>(record.minLargestBlock),
+             static_cast<unsigned long>(record.freeAtMinLargestBlock), fragmentation);
+    out += number;
+    appendJsonString(out, record.minLargestBlockDetail);
+    out += '}';
+  }
+  out += "]}";
+  return out;
+}
+
+bool loadFromFile(const char* path) {
+  FsFile file;
+  if (!SdMan.exists(path) || !SdMan.openFileForRead("HEAP", path, file)) {
+    return false;
+  }
+  Record loaded[MAX_RECORDS];
+  uint8_t version = 0;
+  uint8_t count = 0;
+  bool damaged;
+  {
+    serialization::BufferedFileReader reader(file);
+    if (!readValue(reader, version) || version != FILE_VERSION) {
+      Serial.printf("[%lu] [HEAP] Ignoring %s, unknown version %u\n", millis(), path, version);
+      file.close();
+      return false;
+    }
+    damaged = !readValue(reader, count);
+    if (!damaged && count > MAX_RECORDS) {
+      Serial.printf("[%lu] [HEAP] %s holds %u records, more than %u\n", millis(), path, count,
+                    static_cast<unsigned>(MAX_RECORDS));
+      damaged = true;
+    }
+    for (uint8_t i = 0; i < count && !damaged; i++) {
+      loaded[i] = Record{};
+      damaged = !readRecord(reader, loaded[i]);
+    }
+  }
+  file.close();
+  if (damaged) {
+    // Most likely cut short by a power loss during a save; the worst cases are collected again from here
+    Serial.printf("[%lu] [HEAP] Removing damaged %s\n", millis(), path);
+    SdMan.remove(path);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  for (uint8_t i = 0; i < count; i++) {
+    merge(loaded[i]);
+  }
+  dirty = false;
+  return true;
+}
+
+bool saveToFile(const char* path) {
+  Record snapshot[MAX_RECORDS];
+  size_t count;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!dirty) {
+      return true;
+    }
+    count = recordCount;
+    std::copy(records, records + count, snapshot);
+    dirty = false;
+  }
+
+  FsFile file;
+  if (!SdMan.openFileForWrite("HEAP", path, file)) {
+    std::lock_guard<std::mutex> guard(lock);
+    dirty = true;
+    return false;
+  }
+  bool written;
+  {
+    serialization::BufferedFileWriter writer(file);
+    serialization::writePod(writer, FILE_VERSION);
+    serialization::writePod(writer, static_cast<uint8_t>(count));
+    for (size_t i = 0; i < count; i++) {
+      const Record& record = snapshot[i];
+      serialization::writeString(writer, record.name);
+      serialization::writePod(writer, record.count);
+      serialization::writePod(writer, record.minFree);
+      serialization::writeString(writer, record.minFreeDetail);
+      serialization::writePod(writer, record.minLargestBlock);
+      serialization::writePod(writer, record.freeAtMinLargestBlock);
+      serialization::writeString(writer, record.minLargestBlockDetail);
+    }
+    written = writer.flush();
+  }
+  file.close();
+  if (!written) {
+    Serial.printf("[%lu] [HEAP] Could not write %s\n", millis(), path);
+    // A partial file would load as half-read records; keep them in RAM for the next save instead
+    SdMan.remove(path);
+    std::lock_guard<std::mutex> guard(lock);
+    dirty = true;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace heapwatch
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Heap low-water marks per activity and per tracked operation (a chapter build, a cover conversion, an OPDS fetch), to
+// find what brings the device close to running out of memory.
+//
+// For each name the worst case seen is kept, across boots in a small file on the card: the least free heap, and the
+// smallest largest free block with the free heap at that moment, which together show fragmentation. Each comes with
+// what was being worked on, such as the book. Free heap is exact whenever an activity or operation sets a new low since
+// boot, as the allocator keeps that watermark itself. Otherwise, and always for the largest block, it is sampled on
+// entry and exit and wherever sample() is called.
+namespace heapwatch {
+
+constexpr size_t MAX_RECORDS = 16;
+constexpr size_t MAX_OPERATIONS = 4;
+constexpr size_t NAME_SIZE = 24;
+constexpr size_t DETAIL_SIZE = 40;
+constexpr char DEFAULT_PATH[] = "/.crosspoint/heap.bin";
+
+struct Record {
+  char name[NAME_SIZE];
+  uint32_t count;
+  uint32_t minFree;
+  char minFreeDetail[DETAIL_SIZE];
+  uint32_t minLargestBlock;
+  uint32_t freeAtMinLargestBlock;
+  char minLargestBlockDetail[DETAIL_SIZE];
+};
+
+void enterActivity(const std::string& name);
+void exitActivity();
+
+// Updates the low-water marks of the current activity and open operations
+void sample();
+
+// Tracks the heap from construction to destruction under the given name. Detail is kept for a new worst case, its
+// end if it is too long.
+class Operation {
+  int slot;
+
+ public:
+  Operation(const char* name, const std::string& detail);
+  ~Operation();
+  Operation(const Operation&) = delete;
+  Operation& operator=(const Operation&) = delete;
+};
+
+// Worst cases so far, in the order the names were first seen
+size_t getRecords(Record* out, size_t capacity);
+void reset();
+std::string toJson();
+
+bool loadFromFile(const char* path = DEFAULT_PATH);
+// Writes the worst cases if any changed since the last load or save
+bool saveToFile(const char* path = DEFAULT_PATH);
+
+}  // namespace heapwatch
@@ -0,0 +1,130 @@
+#include "Trace.h"
+
+#include <Arduino.h>
+#include <SDCardManager.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace trace {
+namespace {
+constexpr size_t SPAN_COUNT = static_cast<size_t>(Span::COUNT);
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+
+constexpr const char* SPAN_NAMES[SPAN_COUNT] = {"zipInflate", "xmlParse", "layout", "sectionSerialize",
+                                                "pageRender", "displayRefresh", "sectionPrecompute", "pageIndex"};
+constexpr const char* COUNTER_NAMES[COUNTER_COUNT] = {"inflatedBytes", "parsedBytes", "laidOutLines",
+                                                      "serializedPages"};
+
+struct Event {
+  uint32_t startUs;
+  uint32_t durationUs;
+  uint32_t value;
+  Span span;
+};
+
+struct Totals {
+  std::atomic<uint32_t> count{0};
+  std::atomic<uint64_t> totalUs{0};
+  std::atomic<uint32_t> maxUs{0};
+};
+
+// Spans come from the main loop and the reader's background task, so slots are claimed atomically. An event being
+// written while the ring is read can come out torn, which is fine for diagnostics.
+Event events[EVENT_CAPACITY];
+std::atomic<uint32_t> eventHead{0};
+Totals totals[SPAN_COUNT];
+std::atomic<uint32_t> counters[COUNTER_COUNT];
+
+void appendf(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+void appendf(std::string& out, const char* format, ...) {
+  char buffer[96];
+  va_list args;
+  va_start(args, format);
+  const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0) {
+    out.append(buffer, length < static_cast<int>(sizeof(buffer)) ? length : sizeof(buffer) - 1);
+  }
+}
+}  // namespace
+
+uint32_t nowUs() { return micros(); }
+
+void record(const Span span, const uint32_t startUs, const uint32_t durationUs, const uint32_t value) {
+  Totals& spanTotals = totals[static_cast<size_t>(span)];
+  spanTotals.count.fetch_add(1, std::memory_order_relaxed);
+  spanTotals.totalUs.fetch_add(durationUs, std::memory_order_relaxed);
+  uint32_t longest = spanTotals.maxUs.load(std::memory_order_relaxed);
+  while (durationUs > longest && !spanTotals.maxUs.compare_exchange_weak(longest, durationUs)) {
+  }
+
+  Event& event = events[eventHead.fetch_add(1, std::memory_order_relaxed) % EVENT_CAPACITY];
+  event.startUs = startUs;
+  event.durationUs = durationUs;
+  event.value = value;
+  event.span = span;
+}
+
+void add(const Counter counter, const uint32_t amount) {
+  counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void reset() {
+  for (auto& spanTotals : totals) {
+    spanTotals.count = 0;
+    spanTotals.totalUs = 0;
+    spanTotals.maxUs = 0;
+  }
+  for (auto& counter : counters) {
+    counter = 0;
+  }
+  eventHead = 0;
+}
+
+std::string toJson() {
+  std::string out;
+  out.reserve(512 + EVENT_CAPACITY * 64);
+  appendf(out, "{\"uptimeMs\":%lu,\"spans\":{", static_cast<unsigned long>(millis()));
+  for (size_t i = 0; i < SPAN_COUNT; i++) {
+    appendf(out, "%s\"%s\":{\"count\":%lu,\"totalUs\":%llu,\"maxUs\":%lu}", i ? "," : "", SPAN_NAMES[i],
+            static_cast<unsigned long>(totals[i].count.load()),
+            static_cast<unsigned long long>(totals[i].totalUs.load()),
+            static_cast<unsigned long>(totals[i].maxUs.load()));
+  }
+  out += "},\"counters\":{";
+  for (size_t i = 0; i < COUNTER_COUNT; i++) {
+    appendf(out, "%s\"%s\":%lu", i ? "," : "", COUNTER_NAMES[i], static_cast<unsigned long>(counters[i].load()));
+  }
+
+  const uint32_t head = eventHead.load();
+  const uint32_t buffered = head < EVENT_CAPACITY ? head : EVENT_CAPACITY;
+  appendf(out, "},\"dropped\":%lu,\"events\":[", static_cast<unsigned long>(head - buffered));
+  for (uint32_t i = head - buffered; i < head; i++) {
+    const Event& event = events[i % EVENT_CAPACITY];
+    appendf(out, "%s{\"span\":\"%s\",\"startUs\":%lu,\"us\":%lu,\"value\":%lu}", i == head - buffered ? "" : ",",
+            SPAN_NAMES[static_cast<size_t>(event.span) % SPAN_COUNT], static_cast<unsigned long>(event.startUs),
+            static_cast<unsigned long>(event.durationUs), static_cast<unsigned long>(event.value));
+  }
+  out += "]}";
+  return out;
+}
+
+bool saveToFile(const char* path) {
+  FsFile file;
+  if (!SdMan.openFileForWrite("TRC", path, file)) {
+    return false;
+  }
+  const std::string json = toJson();
+  const bool written = file.write(reinterpret_cast<const uint8_t*>(json.data()), json.size()) == json.size();
+  file.close();
+  if (!written) {
+    Serial.printf("[%lu] [TRC] Failed to write %s\n", millis(), path);
+    return false;
+  }
+  Serial.printf("[%lu] [TRC] Saved trace to %s\n", millis(), path);
+  return true;
+}
+
+}  // namespace trace
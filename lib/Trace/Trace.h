@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Timing spans and counters for finding where time goes on the device without a serial cable attached.
+//
+// Every span is added to running totals (count, total and longest duration) and to a fixed ring of the most recent
+// events. Both live in RAM until reboot and can be read back as JSON through the web server or written to the SD card.
+// Spans nest: a chapter parse includes the inflating and layout it triggers, a page render its display refreshes.
+namespace trace {
+
+enum class Span : uint8_t {
+  ZIP_INFLATE,         // value: inflated bytes
+  XML_PARSE,           // value: parsed bytes
+  LAYOUT,              // value: lines laid out
+  SECTION_SERIALIZE,   // value: page index
+  PAGE_RENDER,         // value: page index
+  DISPLAY_REFRESH,     // value: HalDisplay::RefreshMode, or 3 for a grayscale refresh
+  SECTION_PRECOMPUTE,  // value: spine index, built ahead of the reader
+  PAGE_INDEX,          // value: spine index, built for the book's page index
+  COUNT
+};
+
+enum class Counter : uint8_t { INFLATED_BYTES, PARSED_BYTES, LAID_OUT_LINES, SERIALIZED_PAGES, COUNT };
+
+constexpr size_t EVENT_CAPACITY = 128;
+constexpr char DEFAULT_PATH[] = "/.crosspoint/trace.json";
+
+uint32_t nowUs();
+void record(Span span, uint32_t startUs, uint32_t durationUs, uint32_t value = 0);
+void add(Counter counter, uint32_t amount = 1);
+void reset();
+
+// Totals, counters and the buffered events oldest first
+std::string toJson();
+bool saveToFile(const char* path = DEFAULT_PATH);
+
+// Records a span from construction to destruction
+class Scope {
+  Span span;
+  uint32_t startUs;
+  uint32_t value;
+
+ public:
+  explicit Scope(const Span span, const uint32_t value = 0) : span(span), startUs(nowUs()), value(value) {}
+  ~Scope() { record(span, startUs, nowUs() - startUs, value); }
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  void setValue(const uint32_t newValue) { value = newValue; }
+};
+
+}  // namespace trace
@@ -1,6 +1,7 @@
 #include "Txt.h"
 
 #include <FsHelpers.h>
+#include <HeapWatch.h>
 #include <JpegToBmpConverter.h>
 
 Txt::Txt(std::string path, std::string cacheBasePath)
@@ -110,6 +111,7 @@ bool Txt::generateCoverBmp() const {
 
   // Setup cache directory
   setupCacheDir();
+  heapwatch::Operation heapOperation("CoverConvert", filepath);
 
   // Get file extension
   const size_t len = coverImagePath.length();
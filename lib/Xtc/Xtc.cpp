@@ -8,6 +8,7 @@
 #include "Xtc.h"
 
 #include <HardwareSerial.h>
+#include <HeapWatch.h>
 #include <SDCardManager.h>
 
 bool Xtc::load() {
@@ -127,6 +128,7 @@ bool Xtc::generateCoverBmp() const {
     Serial.printf("[%lu] [XTC] No pages in XTC file\n", millis());
     return false;
   }
+  heapwatch::Operation heapOperation("CoverConvert", filepath);
 
   // Setup cache directory
   setupCacheDir();
@@ -318,6 +320,7 @@ bool Xtc::generateThumbBmp() const {
     Serial.printf("[%lu] [XTC] No pages in XTC file\n", millis());
     return false;
   }
+  heapwatch::Operation heapOperation("CoverConvert", filepath);
 
   // Setup cache directory
   setupCacheDir();
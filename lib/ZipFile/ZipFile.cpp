@@ -2,9 +2,31 @@
 
 #include <HardwareSerial.h>
 #include <SDCardManager.h>
+#include <Trace.h>
 #include <miniz.h>
 
 #include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint32_t INDEX_MAGIC = 0x3158495A;  // "ZIX1", bump the digit when the index layout changes
+constexpr size_t INDEX_RUN_ENTRIES = 256;     // Entries sorted in RAM at a time while building the index (6KB)
+constexpr size_t INDEX_MERGE_BLOCK = 8;       // Entries read ahead per sorted run while merging
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t zipSize;
+  uint32_t centralDirOffset;
+  uint32_t totalEntries;
+  uint32_t entryCount;
+};
+
+bool indexEntryLess(const ZipFile::IndexEntry& a, const ZipFile::IndexEntry& b) {
+  return a.hash < b.hash || (a.hash == b.hash && a.len < b.len);
+}
+
+static_assert(sizeof(ZipFile::IndexEntry) == 24, "Index entries are stored as raw 24 byte records");
+}  // namespace
 
 bool inflateOneShot(const uint8_t* inputBuf, const size_t deflatedSize, uint8_t* outputBuf, const size_t inflatedSize) {
   // Setup inflator
@@ -18,8 +40,11 @@ bool inflateOneShot(const uint8_t* inputBuf, const size_t deflatedSize, uint8_t*
 
   size_t inBytes = deflatedSize;
   size_t outBytes = inflatedSize;
+  const uint32_t inflateStart = trace::nowUs();
   const tinfl_status status = tinfl_decompress(inflator, inputBuf, &inBytes, nullptr, outputBuf, &outBytes,
                                                TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+  trace::record(trace::Span::ZIP_INFLATE, inflateStart, trace::nowUs() - inflateStart, outBytes);
+  trace::add(trace::Counter::INFLATED_BYTES, outBytes);
   free(inflator);
 
   if (status != TINFL_STATUS_DONE) {
@@ -30,72 +55,237 @@ bool inflateOneShot(const uint8_t* inputBuf, const size_t deflatedSize, uint8_t*
   return true;
 }
 
-bool ZipFile::loadAllFileStatSlims() {
-  const bool wasOpen = isOpen();
-  if (!wasOpen && !open()) {
-    return false;
-  }
-
-  if (!loadZipDetails()) {
+bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
+  if (indexState == IndexState::UNKNOWN && !indexPath.empty()) {
+    const bool wasOpen = isOpen();
+    if (!wasOpen && !open()) {
+      return false;
+    }
+    indexState = openIndex() || buildIndex() ? IndexState::READY : IndexState::UNAVAILABLE;
     if (!wasOpen) {
       close();
     }
+  }
+
+  if (indexState == IndexState::READY) {
+    return findInIndex(filename, fileStat);
+  }
+  return scanFileStatSlim(filename, fileStat);
+}
+
+bool ZipFile::openIndex() {
+  if (!loadZipDetails() || !SdMan.exists(indexPath.c_str())) {
+    return false;
+  }
+  stats.opens++;
+  if (!SdMan.openFileForRead("ZIP", indexPath, indexFile)) {
     return false;
   }
 
-  file.seek(zipDetails.centralDirOffset);
+  IndexHeader header = {};
+  if (indexFile.read(&header, sizeof(header)) != sizeof(header) || header.magic != INDEX_MAGIC ||
+      header.zipSize != file.size() || header.centralDirOffset != zipDetails.centralDirOffset ||
+      header.totalEntries != zipDetails.totalEntries || header.entryCount != header.totalEntries ||
+      indexFile.size() != sizeof(IndexHeader) + static_cast<uint64_t>(header.entryCount) * sizeof(IndexEntry)) {
+    Serial.printf("[%lu] [ZIP] Central directory index is stale or damaged, rebuilding\n", millis());
+    indexFile.close();
+    return false;
+  }
 
-  uint32_t sig;
-  char itemName[256];
-  fileStatSlimCache.clear();
-  fileStatSlimCache.reserve(zipDetails.totalEntries);
+  indexEntryCount = header.entryCount;
+  return true;
+}
 
-  while (file.available()) {
-    file.read(&sig, 4);
-    if (sig != 0x02014b50) break;  // End of list
+// Writes the central directory as IndexEntry records sorted by (hash, len). Entries are sorted in runs of
+// INDEX_RUN_ENTRIES in RAM, spilled to a temp file, then merged, so RAM use doesn't grow with the entry count.
+bool ZipFile::buildIndex() {
+  if (!loadZipDetails()) {
+    return false;
+  }
+  const uint32_t buildStart = millis();
+  const std::string runsPath = indexPath + ".tmp";
 
-    FileStatSlim fileStat = {};
+  FsFile runsFile;
+  if (!SdMan.openFileForWrite("ZIP", runsPath, runsFile)) {
+    return false;
+  }
 
-    file.seekCur(6);
-    file.read(&fileStat.method, 2);
-    file.seekCur(8);
-    file.read(&fileStat.compressedSize, 4);
-    file.read(&fileStat.uncompressedSize, 4);
-    uint16_t nameLen, m, k;
-    file.read(&nameLen, 2);
-    file.read(&m, 2);
-    file.read(&k, 2);
-    file.seekCur(8);
-    file.read(&fileStat.localHeaderOffset, 4);
-    file.read(itemName, nameLen);
-    itemName[nameLen] = '\0';
+  std::vector<IndexEntry> buffer;
+  buffer.reserve(INDEX_RUN_ENTRIES);
+  uint32_t entryCount = 0;
+  uint32_t runCount = 0;
+  bool ok = true;
+  const auto flushRun = [&] {
+    std::sort(buffer.begin(), buffer.end(), indexEntryLess);
+    const size_t bytes = buffer.size() * sizeof(IndexEntry);
+    ok = ok && runsFile.write(reinterpret_cast<const uint8_t*>(buffer.data()), bytes) == bytes;
+    buffer.clear();
+    runCount++;
+  };
+
+  // Pass 1: one read for the fixed part of each central directory header, the name hashed in place
+  seek(file, zipDetails.centralDirOffset);
+  uint8_t header[46];
+  char name[64];
+  while (ok && file.read(header, sizeof(header)) == sizeof(header)) {
+    uint32_t sig;
+    memcpy(&sig, header, 4);
+    if (sig != 0x02014b50) break;  // End of list
 
-    fileStatSlimCache.emplace(itemName, fileStat);
+    IndexEntry entry = {};
+    uint16_t extraLength, commentLength;
+    memcpy(&entry.method, header + 10, 2);
+    memcpy(&entry.compressedSize, header + 20, 4);
+    memcpy(&entry.uncompressedSize, header + 24, 4);
+    memcpy(&entry.len, header + 28, 2);
+    memcpy(&extraLength, header + 30, 2);
+    memcpy(&commentLength, header + 32, 2);
+    memcpy(&entry.localHeaderOffset, header + 42, 4);
+
+    entry.hash = 14695981039346656037ull;
+    for (size_t remaining = entry.len; remaining > 0 && ok;) {
+      const size_t chunk = std::min(remaining, sizeof(name));
+      ok = file.read(name, chunk) == static_cast<int>(chunk);
+      entry.hash = fnvHash64(name, chunk, entry.hash);
+      remaining -= chunk;
+    }
+    skip(extraLength + commentLength);
 
-    // Skip the rest of this entry (extra field + comment)
-    file.seekCur(m + k);
+    buffer.push_back(entry);
+    entryCount++;
+    if (buffer.size() == INDEX_RUN_ENTRIES) {
+      flushRun();
+    }
+  }
+  if (ok && !buffer.empty()) {
+    flushRun();
+  }
+  runsFile.close();
+  // An index missing entries would hide those files from the book in every later session
+  if (ok && entryCount != zipDetails.totalEntries) {
+    Serial.printf("[%lu] [ZIP] Central directory lists %u of %u entries\n", millis(), entryCount,
+                  zipDetails.totalEntries);
+    ok = false;
   }
 
-  // Set cursor to start of central directory for sequential access
-  lastCentralDirPos = zipDetails.centralDirOffset;
-  lastCentralDirPosValid = true;
+  // Pass 2: k-way merge of the sorted runs, INDEX_MERGE_BLOCK entries read ahead per run
+  FsFile indexOut;
+  if (ok && !SdMan.openFileForWrite("ZIP", indexPath, indexOut)) {
+    ok = false;
+  }
+  if (ok && !SdMan.openFileForRead("ZIP", runsPath, runsFile)) {
+    ok = false;
+  }
+  if (ok) {
+    const IndexHeader indexHeader = {INDEX_MAGIC, static_cast<uint32_t>(file.size()), zipDetails.centralDirOffset,
+                                     zipDetails.totalEntries, entryCount};
+    ok = indexOut.write(reinterpret_cast<const uint8_t*>(&indexHeader), sizeof(indexHeader)) == sizeof(indexHeader);
+
+    struct RunCursor {
+      uint32_t next;  // Next entry of the run still on the SD card
+      uint32_t end;
+      uint8_t buffered;
+      uint8_t pos;
+    };
+    std::vector<RunCursor> runs(runCount);
+    std::vector<IndexEntry> blocks(runCount * INDEX_MERGE_BLOCK);
+    const auto refill = [&](const uint32_t i) {
+      RunCursor& run = runs[i];
+      const uint32_t count = std::min<uint32_t>(INDEX_MERGE_BLOCK, run.end - run.next);
+      runsFile.seek(static_cast<uint64_t>(run.next) * sizeof(IndexEntry));
+      const size_t bytes = count * sizeof(IndexEntry);
+      ok = ok && runsFile.read(&blocks[i * INDEX_MERGE_BLOCK], bytes) == static_cast<int>(bytes);
+      run.next += count;
+      run.buffered = count;
+      run.pos = 0;
+    };
+    for (uint32_t i = 0; i < runCount; i++) {
+      runs[i] = {i * static_cast<uint32_t>(INDEX_RUN_ENTRIES),
+                 std::min<uint32_t>((i + 1) * INDEX_RUN_ENTRIES, entryCount), 0, 0};
+      refill(i);
+    }
 
-  if (!wasOpen) {
-    close();
+    for (uint32_t written = 0; ok && written < entryCount; written++) {
+      int smallest = -1;
+      for (uint32_t i = 0; i < runCount; i++) {
+        if (runs[i].pos < runs[i].buffered &&
+            (smallest < 0 || indexEntryLess(blocks[i * INDEX_MERGE_BLOCK + runs[i].pos],
+                                            blocks[smallest * INDEX_MERGE_BLOCK + runs[smallest].pos]))) {
+          smallest = static_cast<int>(i);
+        }
+      }
+      if (smallest < 0) {
+        ok = false;
+        break;
+      }
+
+      buffer.push_back(blocks[smallest * INDEX_MERGE_BLOCK + runs[smallest].pos]);
+      RunCursor& run = runs[smallest];
+      if (++run.pos == run.buffered && run.next < run.end) {
+        refill(smallest);
+      }
+      if (buffer.size() == INDEX_RUN_ENTRIES || written + 1 == entryCount) {
+        const size_t bytes = buffer.size() * sizeof(IndexEntry);
+        ok = ok && indexOut.write(reinterpret_cast<const uint8_t*>(buffer.data()), bytes) == bytes;
+        buffer.clear();
+      }
+    }
   }
-  return true;
+  runsFile.close();
+  indexOut.close();
+  SdMan.remove(runsPath.c_str());
+
+  if (!ok) {
+    Serial.printf("[%lu] [ZIP] Failed to write central directory index\n", millis());
+    SdMan.remove(indexPath.c_str());
+    return false;
+  }
+
+  Serial.printf("[%lu] [ZIP] Indexed %u central directory entries in %lu ms\n", millis(), entryCount,
+                millis() - buildStart);
+  return openIndex();
 }
 
-bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
-  if (!fileStatSlimCache.empty()) {
-    const auto it = fileStatSlimCache.find(filename);
-    if (it != fileStatSlimCache.end()) {
-      *fileStat = it->second;
-      return true;
+bool ZipFile::findInIndex(const char* filename, FileStatSlim* fileStat) {
+  const size_t len = strlen(filename);
+  IndexEntry key = {};
+  key.hash = fnvHash64(filename, len);
+  key.len = static_cast<uint16_t>(len);
+
+  // Lower bound over the records, one small read per probe
+  uint32_t lo = 0;
+  uint32_t hi = indexEntryCount;
+  IndexEntry candidate = {};
+  bool haveCandidate = false;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    IndexEntry entry;
+    seek(indexFile, sizeof(IndexHeader) + static_cast<uint64_t>(mid) * sizeof(IndexEntry));
+    if (indexFile.read(&entry, sizeof(entry)) != sizeof(entry)) {
+      Serial.printf("[%lu] [ZIP] Failed to read central directory index\n", millis());
+      return false;
+    }
+    if (indexEntryLess(entry, key)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+      candidate = entry;
+      haveCandidate = true;
     }
+  }
+
+  if (!haveCandidate || candidate.hash != key.hash || candidate.len != key.len) {
     return false;
   }
+  fileStat->method = candidate.method;
+  fileStat->compressedSize = candidate.compressedSize;
+  fileStat->uncompressedSize = candidate.uncompressedSize;
+  fileStat->localHeaderOffset = candidate.localHeaderOffset;
+  return true;
+}
 
+// Linear central directory scan, used when there is no index
+bool ZipFile::scanFileStatSlim(const char* filename, FileStatSlim* fileStat) {
   const bool wasOpen = isOpen();
   if (!wasOpen && !open()) {
     return false;
@@ -114,7 +304,7 @@ bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
   bool wrapped = false;
   bool found = false;
 
-  file.seek(startPos);
+  seek(file, startPos);
 
   uint32_t sig;
   char itemName[256];
@@ -126,7 +316,7 @@ bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
       // End of central directory
       if (!wrapped && lastCentralDirPosValid && startPos != zipDetails.centralDirOffset) {
         // Wrap around to beginning
-        file.seek(zipDetails.centralDirOffset);
+        seek(file, zipDetails.centralDirOffset);
         wrapped = true;
         continue;
       }
@@ -138,16 +328,16 @@ bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
       break;
     }
 
-    file.seekCur(6);
+    skip(6);
     file.read(&fileStat->method, 2);
-    file.seekCur(8);
+    skip(8);
     file.read(&fileStat->compressedSize, 4);
     file.read(&fileStat->uncompressedSize, 4);
     uint16_t nameLen, m, k;
     file.read(&nameLen, 2);
     file.read(&m, 2);
     file.read(&k, 2);
-    file.seekCur(8);
+    skip(8);
     file.read(&fileStat->localHeaderOffset, 4);
 
     if (nameLen < 256) {
@@ -156,7 +346,7 @@ bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
 
       if (strcmp(itemName, filename) == 0) {
         // Found it! Update cursor to next entry
-        file.seekCur(m + k);
+        skip(m + k);
         lastCentralDirPos = file.position();
         lastCentralDirPosValid = true;
         found = true;
@@ -164,11 +354,11 @@ bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
       }
     } else {
       // Name too long, skip it
-      file.seekCur(nameLen);
+      skip(nameLen);
     }
 
     // Skip extra field + comment
-    file.seekCur(m + k);
+    skip(m + k);
   }
 
   if (!wasOpen) {
@@ -188,7 +378,7 @@ long ZipFile::getDataOffset(const FileStatSlim& fileStat) {
   uint8_t pLocalHeader[localHeaderSize];
   const uint64_t fileOffset = fileStat.localHeaderOffset;
 
-  file.seek(fileOffset);
+  seek(file, fileOffset);
   const size_t read = file.read(pLocalHeader, localHeaderSize);
   if (!wasOpen) {
     close();
@@ -228,6 +418,23 @@ bool ZipFile::loadZipDetails() {
     }
     return false;  // Minimum EOCD size is 22 bytes
   }
+  stats.eocdReads++;
+
+  // Almost every EPUB has no archive comment, so the EOCD is the last 22 bytes of the file
+  {
+    uint8_t tail[22];
+    seek(file, fileSize - sizeof(tail));
+    if (file.read(tail, sizeof(tail)) == sizeof(tail) && tail[0] == 0x50 && tail[1] == 0x4b && tail[2] == 0x05 &&
+        tail[3] == 0x06 && tail[20] == 0 && tail[21] == 0) {
+      zipDetails.totalEntries = *reinterpret_cast<uint16_t*>(&tail[10]);
+      zipDetails.centralDirOffset = *reinterpret_cast<uint32_t*>(&tail[16]);
+      zipDetails.isSet = true;
+      if (!wasOpen) {
+        close();
+      }
+      return true;
+    }
+  }
 
   // We scan the last 1KB (or the whole file if smaller) for the EOCD signature
   // 0x06054b50 is stored as 0x50, 0x4b, 0x05, 0x06 in little-endian
@@ -241,7 +448,7 @@ bool ZipFile::loadZipDetails() {
     return false;
   }
 
-  file.seek(fileSize - scanRange);
+  seek(file, fileSize - scanRange);
   file.read(buffer, scanRange);
 
   // Scan backwards for the signature
@@ -279,6 +486,7 @@ bool ZipFile::loadZipDetails() {
 }
 
 bool ZipFile::open() {
+  stats.opens++;
   if (!SdMan.openFileForRead("ZIP", filePath, file)) {
     return false;
   }
@@ -294,6 +502,16 @@ bool ZipFile::close() {
   return true;
 }
 
+bool ZipFile::seek(FsFile& f, const uint64_t pos) {
+  stats.seeks++;
+  return f.seek(pos);
+}
+
+bool ZipFile::skip(const int64_t offset) {
+  stats.seeks++;
+  return file.seekCur(offset);
+}
+
 bool ZipFile::getInflatedFileSize(const char* filename, size_t* size) {
   FileStatSlim fileStat = {};
   if (!loadFileStatSlim(filename, &fileStat)) {
@@ -321,7 +539,7 @@ int ZipFile::fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector
     return 0;
   }
 
-  file.seek(zipDetails.centralDirOffset);
+  seek(file, zipDetails.centralDirOffset);
 
   int matched = 0;
   uint32_t sig;
@@ -331,10 +549,10 @@ int ZipFile::fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector
     file.read(&sig, 4);
     if (sig != 0x02014b50) break;
 
-    file.seekCur(6);
+    skip(6);
     uint16_t method;
     file.read(&method, 2);
-    file.seekCur(8);
+    skip(8);
     uint32_t compressedSize, uncompressedSize;
     file.read(&compressedSize, 4);
     file.read(&uncompressedSize, 4);
@@ -342,7 +560,7 @@ int ZipFile::fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector
     file.read(&nameLen, 2);
     file.read(&m, 2);
     file.read(&k, 2);
-    file.seekCur(8);
+    skip(8);
     uint32_t localHeaderOffset;
     file.read(&localHeaderOffset, 4);
 
@@ -365,10 +583,10 @@ int ZipFile::fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector
         ++it;
       }
     } else {
-      file.seekCur(nameLen);
+      skip(nameLen);
     }
 
-    file.seekCur(m + k);
+    skip(m + k);
   }
 
   if (!wasOpen) {
@@ -400,7 +618,7 @@ uint8_t* ZipFile::readFileToMemory(const char* filename, size_t* size, const boo
     return nullptr;
   }
 
-  file.seek(fileOffset);
+  seek(file, fileOffset);
 
   const auto deflatedDataSize = fileStat.compressedSize;
   const auto inflatedDataSize = fileStat.uncompressedSize;
@@ -490,7 +708,7 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
     return false;
   }
 
-  file.seek(fileOffset);
+  seek(file, fileOffset);
   const auto deflatedDataSize = fileStat.compressedSize;
   const auto inflatedDataSize = fileStat.uncompressedSize;
 
@@ -569,6 +787,9 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
     size_t fileReadBufferFilledBytes = 0;
     size_t fileReadBufferCursor = 0;
     size_t outputCursor = 0;  // Current offset in the circular dictionary
+    // Only the decompression is timed, not the reads and the stream consuming the output
+    const uint32_t inflateStart = trace::nowUs();
+    uint32_t inflateUs = 0;
 
     while (true) {
       // Load more compressed bytes when needed
@@ -594,9 +815,11 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
       // Space remaining in outputBuffer
       size_t outBytes = TINFL_LZ_DICT_SIZE - outputCursor;
 
+      const uint32_t chunkStart = trace::nowUs();
       const tinfl_status status = tinfl_decompress(inflator, fileReadBuffer + fileReadBufferCursor, &inBytes,
                                                    outputBuffer, outputBuffer + outputCursor, &outBytes,
                                                    fileRemainingBytes > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+      inflateUs += trace::nowUs() - chunkStart;
 
       // Update input position
       fileReadBufferCursor += inBytes;
@@ -630,8 +853,8 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
       }
 
       if (status == TINFL_STATUS_DONE) {
-        Serial.printf("[%lu] [ZIP] Decompressed %d bytes into %d bytes\n", millis(), deflatedDataSize,
-                      inflatedDataSize);
+        trace::record(trace::Span::ZIP_INFLATE, inflateStart, inflateUs, processedOutputBytes);
+        trace::add(trace::Counter::INFLATED_BYTES, processedOutputBytes);
         if (!wasOpen) {
           close();
         }
@@ -660,3 +883,171 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
   Serial.printf("[%lu] [ZIP] Unsupported compression method\n", millis());
   return false;
 }
+
+bool ZipFile::InflateReader::begin(const char* filename, const size_t chunkSize) {
+  end();
+  failed = false;
+  finished = false;
+  fileReadBufferFilledBytes = 0;
+  fileReadBufferCursor = 0;
+  dictionaryCursor = 0;
+  pendingOffset = 0;
+  pendingBytes = 0;
+
+  wasOpen = zip.isOpen();
+  if (!wasOpen && !zip.open()) {
+    return false;
+  }
+  active = true;
+
+  FileStatSlim fileStat = {};
+  if (!zip.loadFileStatSlim(filename, &fileStat)) {
+    end();
+    return false;
+  }
+
+  const long fileOffset = zip.getDataOffset(fileStat);
+  if (fileOffset < 0) {
+    end();
+    return false;
+  }
+
+  if (fileStat.method != MZ_NO_COMPRESSION && fileStat.method != MZ_DEFLATED) {
+    Serial.printf("[%lu] [ZIP] Unsupported compression method\n", millis());
+    end();
+    return false;
+  }
+
+  zip.seek(zip.file, fileOffset);
+  method = fileStat.method;
+  inflatedSize = fileStat.uncompressedSize;
+  fileRemainingBytes = method == MZ_NO_COMPRESSION ? fileStat.uncompressedSize : fileStat.compressedSize;
+  this->chunkSize = chunkSize;
+
+  if (method == MZ_NO_COMPRESSION) {
+    return true;
+  }
+
+  inflator = malloc(sizeof(tinfl_decompressor));
+  fileReadBuffer = static_cast<uint8_t*>(malloc(chunkSize));
+  dictionary = static_cast<uint8_t*>(malloc(TINFL_LZ_DICT_SIZE));
+  if (!inflator || !fileReadBuffer || !dictionary) {
+    Serial.printf("[%lu] [ZIP] Failed to allocate memory for streaming inflate\n", millis());
+    end();
+    return false;
+  }
+  memset(inflator, 0, sizeof(tinfl_decompressor));
+  tinfl_init(static_cast<tinfl_decompressor*>(inflator));
+  return true;
+}
+
+void ZipFile::InflateReader::end() {
+  free(inflator);
+  free(fileReadBuffer);
+  free(dictionary);
+  inflator = nullptr;
+  fileReadBuffer = nullptr;
+  dictionary = nullptr;
+
+  if (active && !wasOpen) {
+    zip.close();
+  }
+  active = false;
+}
+
+void ZipFile::InflateReader::fail(const char* message) {
+  Serial.printf("[%lu] [ZIP] %s\n", millis(), message);
+  failed = true;
+}
+
+bool ZipFile::InflateReader::inflateMore() {
+  const auto decompressor = static_cast<tinfl_decompressor*>(inflator);
+
+  while (true) {
+    // Load more compressed bytes when needed
+    if (fileReadBufferCursor >= fileReadBufferFilledBytes && fileRemainingBytes > 0) {
+      const int dataRead = zip.file.read(fileReadBuffer, std::min(fileRemainingBytes, chunkSize));
+      if (dataRead <= 0) {
+        fail("Could not read more bytes");
+        return false;
+      }
+      fileReadBufferFilledBytes = dataRead;
+      fileRemainingBytes -= dataRead;
+      fileReadBufferCursor = 0;
+    }
+
+    size_t inBytes = fileReadBufferFilledBytes - fileReadBufferCursor;
+    size_t outBytes = TINFL_LZ_DICT_SIZE - dictionaryCursor;
+    const tinfl_status status = tinfl_decompress(decompressor, fileReadBuffer + fileReadBufferCursor, &inBytes,
+                                                 dictionary, dictionary + dictionaryCursor, &outBytes,
+                                                 fileRemainingBytes > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+    fileReadBufferCursor += inBytes;
+
+    if (status < 0) {
+      Serial.printf("[%lu] [ZIP] tinfl_decompress() failed with status %d\n", millis(), status);
+      failed = true;
+      return false;
+    }
+
+    if (status == TINFL_STATUS_DONE) {
+      finished = true;
+    }
+
+    if (outBytes > 0) {
+      // Hand the freshly inflated run to read() before the dictionary cursor moves on (with wraparound)
+      pendingOffset = dictionaryCursor;
+      pendingBytes = outBytes;
+      dictionaryCursor = (dictionaryCursor + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+      return true;
+    }
+
+    if (finished) {
+      return false;
+    }
+
+    if (fileRemainingBytes == 0 && fileReadBufferCursor >= fileReadBufferFilledBytes) {
+      fail("Unexpected EOF");
+      return false;
+    }
+  }
+}
+
+size_t ZipFile::InflateReader::read(uint8_t* buf, const size_t len) {
+  if (!active || failed) {
+    return 0;
+  }
+
+  if (method == MZ_NO_COMPRESSION) {
+    const size_t toRead = std::min(len, fileRemainingBytes);
+    if (toRead == 0) {
+      finished = true;
+      return 0;
+    }
+    const int dataRead = zip.file.read(buf, toRead);
+    if (dataRead <= 0) {
+      fail("Could not read more bytes");
+      return 0;
+    }
+    fileRemainingBytes -= dataRead;
+    finished = fileRemainingBytes == 0;
+    return dataRead;
+  }
+
+  size_t copied = 0;
+  while (copied < len) {
+    if (pendingBytes == 0) {
+      if (finished || !inflateMore()) {
+        break;
+      }
+      continue;
+    }
+
+    const size_t toCopy = std::min(len - copied, pendingBytes);
+    memcpy(buf + copied, dictionary + pendingOffset, toCopy);
+    copied += toCopy;
+    pendingOffset += toCopy;
+    pendingBytes -= toCopy;
+  }
+
+  return copied;
+}
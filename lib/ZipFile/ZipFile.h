@@ -2,7 +2,6 @@
 #include <SdFat.h>
 
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 class ZipFile {
@@ -27,9 +26,26 @@ class ZipFile {
     uint16_t index;  // Caller's index (e.g. spine index)
   };
 
+  // One record of the on-disk central directory index, sorted by (hash, len)
+  struct IndexEntry {
+    uint64_t hash;  // FNV-1a 64-bit hash of the entry name
+    uint16_t len;   // Length of the entry name
+    uint16_t method;
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+    uint32_t localHeaderOffset;
+  };
+
+  // Running totals of SD work done by this instance, so callers and tests can see what a lookup actually cost
+  struct Stats {
+    uint32_t opens;      // Zip or index file opens
+    uint32_t seeks;      // Absolute and relative seeks on either file
+    uint32_t eocdReads;  // End of central directory parses
+  };
+
   // FNV-1a 64-bit hash computed from char buffer (no std::string allocation)
-  static uint64_t fnvHash64(const char* s, size_t len) {
-    uint64_t hash = 14695981039346656037ull;
+  // Pass a previous result as hash to continue hashing a name read in pieces.
+  static uint64_t fnvHash64(const char* s, size_t len, uint64_t hash = 14695981039346656037ull) {
     for (size_t i = 0; i < len; i++) {
       hash ^= static_cast<uint8_t>(s[i]);
       hash *= 1099511628211ull;
@@ -38,35 +54,95 @@ class ZipFile {
   }
 
  private:
+  enum class IndexState : uint8_t { UNKNOWN, READY, UNAVAILABLE };
+
   const std::string& filePath;
   FsFile file;
   ZipDetails zipDetails = {0, 0, false};
-  std::unordered_map<std::string, FileStatSlim> fileStatSlimCache;
+
+  // Sorted central directory index on the SD card, built on first lookup if an index path was given
+  std::string indexPath;
+  FsFile indexFile;
+  uint32_t indexEntryCount = 0;
+  IndexState indexState = IndexState::UNKNOWN;
 
   // Cursor for sequential central-dir scanning optimization
   uint32_t lastCentralDirPos = 0;
   bool lastCentralDirPosValid = false;
 
+  Stats stats = {0, 0, 0};
+
   bool loadFileStatSlim(const char* filename, FileStatSlim* fileStat);
+  bool scanFileStatSlim(const char* filename, FileStatSlim* fileStat);
   long getDataOffset(const FileStatSlim& fileStat);
   bool loadZipDetails();
+  bool openIndex();
+  bool buildIndex();
+  bool findInIndex(const char* filename, FileStatSlim* fileStat);
+  bool seek(FsFile& f, uint64_t pos);
+  bool skip(int64_t offset);
 
  public:
-  explicit ZipFile(const std::string& filePath) : filePath(filePath) {}
-  ~ZipFile() = default;
-  // Zip file can be opened and closed by hand in order to allow for quick calculation of inflated file size
-  // It is NOT recommended to pre-open it for any kind of inflation due to memory constraints
+  // indexPath is where the sorted central directory index for this zip lives (e.g. in the book's cache directory).
+  // Without one, every lookup scans the central directory.
+  explicit ZipFile(const std::string& filePath, std::string indexPath = "")
+      : filePath(filePath), indexPath(std::move(indexPath)) {}
+  ~ZipFile() { indexFile.close(); }
+  // Zip file can be opened and closed by hand in order to allow for quick calculation of inflated file size, or kept
+  // open for a whole reading session so the EOCD and central directory cursor are not re-read on every lookup
   bool isOpen() const { return !!file; }
   bool open();
   bool close();
-  bool loadAllFileStatSlims();
   bool getInflatedFileSize(const char* filename, size_t* size);
   // Batch lookup: scan ZIP central dir once and fill sizes for matching targets.
   // targets must be sorted by (hash, len). sizes[target.index] receives uncompressedSize.
   // Returns number of targets matched.
   int fillUncompressedSizes(std::vector<SizeTarget>& targets, std::vector<uint32_t>& sizes);
+  const Stats& getStats() const { return stats; }
+  void resetStats() { stats = {0, 0, 0}; }
   // Due to the memory required to run each of these, it is recommended to not preopen the zip file for multiple
   // These functions will open and close the zip as needed
   uint8_t* readFileToMemory(const char* filename, size_t* size = nullptr, bool trailingNullByte = false);
   bool readFileToStream(const char* filename, Print& out, size_t chunkSize);
+
+  // Pull-based counterpart to readFileToStream: the caller asks for inflated bytes into its own buffer (e.g. an
+  // expat XML_GetBuffer) instead of having them pushed into a Print. The inflator, the compressed read buffer and the
+  // 32KB dictionary stay allocated between read() calls, so only one entry should be streamed at a time.
+  class InflateReader {
+    ZipFile& zip;
+    bool wasOpen = false;
+    bool active = false;
+    bool failed = false;
+    bool finished = false;
+    uint16_t method = 0;
+    size_t inflatedSize = 0;
+    size_t fileRemainingBytes = 0;
+    size_t chunkSize = 0;
+
+    void* inflator = nullptr;  // tinfl_decompressor, kept opaque so miniz.h stays out of this header
+    uint8_t* fileReadBuffer = nullptr;
+    size_t fileReadBufferFilledBytes = 0;
+    size_t fileReadBufferCursor = 0;
+    uint8_t* dictionary = nullptr;
+    size_t dictionaryCursor = 0;  // Next write offset in the circular dictionary
+    size_t pendingOffset = 0;     // Inflated bytes in the dictionary not yet handed to the caller
+    size_t pendingBytes = 0;
+
+    bool inflateMore();
+    void fail(const char* message);
+
+   public:
+    explicit InflateReader(ZipFile& zip) : zip(zip) {}
+    ~InflateReader() { end(); }
+    InflateReader(const InflateReader&) = delete;
+    InflateReader& operator=(const InflateReader&) = delete;
+
+    bool begin(const char* filename, size_t chunkSize);
+    // Copies up to len inflated bytes into buf. Returns 0 once the entry is exhausted or on error.
+    size_t read(uint8_t* buf, size_t len);
+    void end();
+    size_t getInflatedSize() const { return inflatedSize; }
+    bool isFinished() const { return finished && pendingBytes == 0; }
+    bool hasFailed() const { return failed; }
+  };
 };
@@ -1,4 +1,7 @@
 #include <HalGPIO.h>
+
+// Emulated builds bring their own buttons, see test/emulator
+#if CROSSPOINT_EMULATED == 0
 #include <SPI.h>
 #include <esp_sleep.h>
 
@@ -53,3 +56,4 @@ bool HalGPIO::isWakeupByPowerButton() const {
     return (wakeupCause == ESP_SLEEP_WAKEUP_UNDEFINED) && (resetReason == ESP_RST_POWERON);
   }
 }
+#endif  // CROSSPOINT_EMULATED == 0
@@ -0,0 +1,264 @@
+#include "CacheManager.h"
+
+#include <HardwareSerial.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+constexpr uint8_t INDEX_FILE_VERSION = 1;
+constexpr char INDEX_FILE[] = "/cache.bin";
+constexpr char SECTIONS_DIR[] = "sections";
+constexpr char PROGRESS_FILE[] = "progress.bin";
+constexpr char PROGRESS_JOURNAL_FILE[] = "progress.jnl";
+constexpr const char* BOOK_PREFIXES[] = {"epub_", "xtc_", "txt_"};
+
+template <typename T>
+void appendPod(std::vector<uint8_t>& data, const T& value) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool takePod(const std::vector<uint8_t>& data, size_t& offset, T& value) {
+  if (offset + sizeof(T) > data.size()) return false;
+  memcpy(&value, data.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+bool isBookDir(const std::string& name) {
+  return std::any_of(std::begin(BOOK_PREFIXES), std::end(BOOK_PREFIXES),
+                     [&name](const char* prefix) { return name.rfind(prefix, 0) == 0; });
+}
+}  // namespace
+
+std::string CacheManager::dirName(const std::string& bookCachePath) {
+  const auto slash = bookCachePath.find_last_of('/');
+  return slash == std::string::npos ? bookCachePath : bookCachePath.substr(slash + 1);
+}
+
+// Book cache directories are named by a hash of the book's path after the type prefix
+bool CacheManager::isRecent(const std::string& name, const std::vector<std::string>& recentBookPaths) {
+  const auto underscore = name.find('_');
+  if (underscore == std::string::npos) return false;
+  const auto hash = name.substr(underscore + 1);
+  return std::any_of(recentBookPaths.begin(), recentBookPaths.end(), [&hash](const std::string& path) {
+    return std::to_string(std::hash<std::string>{}(path)) == hash;
+  });
+}
+
+bool CacheManager::load() {
+  loaded = true;
+  books.clear();
+  clock = 0;
+  std::vector<uint8_t> data;
+  if (!storage.readFile(cacheDir + INDEX_FILE, data)) {
+    return false;
+  }
+
+  size_t offset = 0;
+  uint8_t version = 0;
+  uint16_t count = 0;
+  bool ok = takePod(data, offset, version) && version == INDEX_FILE_VERSION && takePod(data, offset, clock) &&
+            takePod(data, offset, count);
+  for (uint16_t i = 0; ok && i < count; i++) {
+    Book book;
+    uint8_t nameLength = 0;
+    uint8_t stale = 0;
+    ok = takePod(data, offset, nameLength) && offset + nameLength <= data.size();
+    if (!ok) break;
+    book.name.assign(reinterpret_cast<const char*>(data.data() + offset), nameLength);
+    offset += nameLength;
+    ok = takePod(data, offset, book.bytes) && takePod(data, offset, book.sectionBytes) &&
+         takePod(data, offset, book.lastAccess) && takePod(data, offset, stale);
+    book.stale = stale != 0;
+    books.push_back(std::move(book));
+  }
+  if (!ok) {
+    Serial.printf("[%lu] [CACHE] Index is damaged, measuring all book caches again\n", millis());
+    books.clear();
+    clock = 0;
+  }
+  return ok;
+}
+
+bool CacheManager::save() {
+  std::vector<uint8_t> data;
+  appendPod(data, INDEX_FILE_VERSION);
+  appendPod(data, clock);
+  appendPod(data, static_cast<uint16_t>(books.size()));
+  for (const auto& book : books) {
+    appendPod(data, static_cast<uint8_t>(book.name.size()));
+    data.insert(data.end(), book.name.begin(), book.name.end());
+    appendPod(data, book.bytes);
+    appendPod(data, book.sectionBytes);
+    appendPod(data, book.lastAccess);
+    appendPod(data, static_cast<uint8_t>(book.stale));
+  }
+  dirty = false;
+  return storage.writeFile(cacheDir + INDEX_FILE, data);
+}
+
+CacheManager::Book* CacheManager::find(const std::string& name) {
+  for (auto& book : books) {
+    if (book.name == name) return &book;
+  }
+  return nullptr;
+}
+
+// Adds book directories the index does not know about yet as the oldest, and drops those that are gone. False when the
+// cache directory could not be listed, leaving the index as it was rather than dropping every book.
+bool CacheManager::reconcile() {
+  std::vector<CacheStorage::Entry> entries;
+  if (!storage.list(cacheDir, entries)) {
+    return false;
+  }
+
+  const auto before = books.size();
+  books.erase(std::remove_if(books.begin(), books.end(),
+                             [&entries](const Book& book) {
+                               return std::none_of(entries.begin(), entries.end(), [&book](const auto& entry) {
+                                 return entry.isDirectory && entry.name == book.name;
+                               });
+                             }),
+              books.end());
+  dirty |= books.size() != before;
+
+  for (const auto& entry : entries) {
+    if (entry.isDirectory && isBookDir(entry.name) && entry.name.size() <= UINT8_MAX && !find(entry.name)) {
+      books.push_back({entry.name, 0, 0, 0, true});
+      dirty = true;
+    }
+  }
+  return true;
+}
+
+uint64_t CacheManager::measure(const std::string& path) {
+  std::vector<CacheStorage::Entry> entries;
+  storage.list(path, entries);
+  uint64_t bytes = 0;
+  for (const auto& entry : entries) {
+    bytes += entry.isDirectory ? measure(path + "/" + entry.name) : entry.size;
+  }
+  return bytes;
+}
+
+void CacheManager::measure(Book& book) {
+  const auto bookPath = cacheDir + "/" + book.name;
+  book.bytes = measure(bookPath);
+  book.sectionBytes = measure(bookPath + "/" + SECTIONS_DIR);
+  book.stale = false;
+  dirty = true;
+}
+
+// Removes everything in a book's cache directory except its reading progress
+void CacheManager::stripToProgress(Book& book) {
+  const auto bookPath = cacheDir + "/" + book.name;
+  std::vector<CacheStorage::Entry> entries;
+  storage.list(bookPath, entries);
+  for (const auto& entry : entries) {
+    if (entry.name == PROGRESS_FILE || entry.name == PROGRESS_JOURNAL_FILE) continue;
+    const auto path = bookPath + "/" + entry.name;
+    entry.isDirectory ? storage.removeDir(path) : storage.removeFile(path);
+  }
+  measure(book);
+}
+
+void CacheManager::touch(const std::string& bookCachePath) {
+  if (!loaded) {
+    load();
+  }
+  const auto name = dirName(bookCachePath);
+  Book* book = find(name);
+  if (!book) {
+    books.push_back({name, 0, 0, 0, true});
+    book = &books.back();
+  }
+  book->lastAccess = ++clock;
+  book->stale = true;
+  dirty = true;
+}
+
+uint64_t CacheManager::getTotalBytes() const {
+  uint64_t total = 0;
+  for (const auto& book : books) {
+    total += book.bytes;
+  }
+  return total;
+}
+
+bool CacheManager::enforceLimit(const uint64_t limitBytes, const std::string& openBookCachePath,
+                                const std::vector<std::string>& recentBookPaths) {
+  if (!loaded && !load()) {
+    dirty = true;
+  }
+  if (!reconcile()) {
+    Serial.printf("[%lu] [CACHE] Could not list %s, leaving the cache as it is\n", millis(), cacheDir.c_str());
+    return false;
+  }
+  const auto openName = dirName(openBookCachePath);
+  for (auto& book : books) {
+    if (book.stale) {
+      measure(book);
+      // The open book keeps growing while it is read, so it is measured again next time
+      book.stale = book.name == openName;
+    }
+  }
+
+  uint64_t total = getTotalBytes();
+  if (limitBytes != 0 && total > limitBytes) {
+    std::vector<Book*> oldestFirst;
+    for (auto& book : books) {
+      if (book.name != openName) oldestFirst.push_back(&book);
+    }
+    std::sort(oldestFirst.begin(), oldestFirst.end(),
+              [](const Book* a, const Book* b) { return a->lastAccess < b->lastAccess; });
+
+    for (auto it = oldestFirst.begin(); it != oldestFirst.end() && total > limitBytes; ++it) {
+      Book& book = **it;
+      if (book.sectionBytes == 0) continue;
+      Serial.printf("[%lu] [CACHE] Evicting section files of %s (%llu bytes)\n", millis(), book.name.c_str(),
+                    static_cast<unsigned long long>(book.sectionBytes));
+      storage.removeDir(cacheDir + "/" + book.name + "/" + SECTIONS_DIR);
+      total -= book.sectionBytes;
+      book.bytes -= book.sectionBytes;
+      book.sectionBytes = 0;
+      dirty = true;
+    }
+
+    std::vector<std::string> removed;
+    for (auto it = oldestFirst.begin(); it != oldestFirst.end() && total > limitBytes; ++it) {
+      Book& book = **it;
+      if (isRecent(book.name, recentBookPaths)) {
+        const auto bytesBefore = book.bytes;
+        stripToProgress(book);
+        if (book.bytes < bytesBefore) {
+          Serial.printf("[%lu] [CACHE] Evicted %s except its progress (%llu bytes)\n", millis(), book.name.c_str(),
+                        static_cast<unsigned long long>(bytesBefore - book.bytes));
+          total -= bytesBefore - book.bytes;
+        }
+        continue;
+      }
+      Serial.printf("[%lu] [CACHE] Evicting %s (%llu bytes)\n", millis(), book.name.c_str(),
+                    static_cast<unsigned long long>(book.bytes));
+      storage.removeDir(cacheDir + "/" + book.name);
+      total -= book.bytes;
+      removed.push_back(book.name);
+    }
+    if (!removed.empty()) {
+      books.erase(std::remove_if(books.begin(), books.end(),
+                                 [&removed](const Book& book) {
+                                   return std::find(removed.begin(), removed.end(), book.name) != removed.end();
+                                 }),
+                  books.end());
+      dirty = true;
+    }
+    if (total > limitBytes) {
+      Serial.printf("[%lu] [CACHE] Still %llu bytes over the limit after eviction\n", millis(),
+                    static_cast<unsigned long long>(total - limitBytes));
+    }
+  }
+  return !dirty || save();
+}
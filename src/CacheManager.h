@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The file operations the cache manager needs. The firmware uses the SD card, host tests a fake filesystem.
+class CacheStorage {
+ public:
+  struct Entry {
+    std::string name;
+    bool isDirectory;
+    uint64_t size;
+  };
+
+  virtual ~CacheStorage() = default;
+  virtual bool list(const std::string& dir, std::vector<Entry>& entries) = 0;
+  virtual bool readFile(const std::string& path, std::vector<uint8_t>& data) = 0;
+  virtual bool writeFile(const std::string& path, const std::vector<uint8_t>& data) = 0;
+  virtual bool removeFile(const std::string& path) = 0;
+  // Removes a directory and everything in it
+  virtual bool removeDir(const std::string& path) = 0;
+};
+
+// Keeps the book caches under the cache directory (epub_*, xtc_* and txt_*) within a size limit. An index file records
+// each book directory's size, the part of it taken by section files, and when the book was last opened, so only
+// books opened since the last check have to be measured again. Above the limit the least recently read books lose
+// their section files first, since those are rebuilt on the next open, then their whole cache directory. The book
+// being read is never touched, and recently read books always keep their progress.bin and progress.jnl.
+class CacheManager {
+ public:
+  struct Book {
+    std::string name;
+    uint64_t bytes;
+    uint64_t sectionBytes;
+    uint32_t lastAccess;
+    // Changed since it was last measured
+    bool stale;
+  };
+
+  explicit CacheManager(CacheStorage& storage, std::string cacheDir = "/.crosspoint")
+      : storage(storage), cacheDir(std::move(cacheDir)) {}
+
+  // Marks the book cache at bookCachePath as the most recently read
+  void touch(const std::string& bookCachePath);
+  // Brings the index up to date with the cache directory, then evicts until the caches take at most limitBytes.
+  // recentBookPaths are the paths of the books themselves, as kept in the recent books list. Returns false without
+  // changing the saved index when the cache directory cannot be listed.
+  bool enforceLimit(uint64_t limitBytes, const std::string& openBookCachePath,
+                    const std::vector<std::string>& recentBookPaths);
+  uint64_t getTotalBytes() const;
+  const std::vector<Book>& getBooks() const { return books; }
+
+ private:
+  CacheStorage& storage;
+  std::string cacheDir;
+  std::vector<Book> books;
+  uint32_t clock = 0;
+  bool loaded = false;
+  bool dirty = false;
+
+  bool load();
+  bool save();
+  bool reconcile();
+  Book* find(const std::string& name);
+  uint64_t measure(const std::string& path);
+  void measure(Book& book);
+  void stripToProgress(Book& book);
+  static std::string dirName(const std::string& bookCachePath);
+  static bool isRecent(const std::string& name, const std::vector<std::string>& recentBookPaths);
+};
@@ -97,6 +97,9 @@ class CrossPointSettings {
   // Hide battery percentage
   enum HIDE_BATTERY_PERCENTAGE { HIDE_NEVER = 0, HIDE_READER = 1, HIDE_ALWAYS = 2, HIDE_BATTERY_PERCENTAGE_COUNT };
 
+  // Space book caches under /.crosspoint may take before the least recently read are evicted
+  enum CACHE_LIMIT { CACHE_64_MB = 0, CACHE_256_MB = 1, CACHE_1_GB = 2, CACHE_NO_LIMIT = 3, CACHE_LIMIT_COUNT };
+
   // Sleep screen settings
   uint8_t sleepScreen = DARK;
   // Sleep screen cover mode settings
@@ -137,6 +140,8 @@ class CrossPointSettings {
   uint8_t hideBatteryPercentage = HIDE_NEVER;
   // Long-press chapter skip on side buttons
   uint8_t longPressChapterSkip = 1;
+  // Book cache size limit (default 256 MB)
+  uint8_t cacheLimit = CACHE_256_MB;
 
   ~CrossPointSettings() = default;
 
@@ -154,6 +159,8 @@ class CrossPointSettings {
   float getReaderLineCompression() const;
   unsigned long getSleepTimeoutMs() const;
   int getRefreshFrequency() const;
+  // 0 when there is no limit
+  uint64_t getCacheLimitBytes() const;
 };
 
 // Helper macro to access settings
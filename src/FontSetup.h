@@ -0,0 +1,10 @@
+#pragma once
+
+class GfxRenderer;
+
+// Lets the renderer register the built-in reader and UI font families under their ids from fontIds.h as each is first
+// drawn or measured, so a session only sets up the fonts it uses
+void setupFonts(GfxRenderer& renderer);
+
+// Logs the built-in fonts the renderer has registered so far, i.e. the ones this session used
+void logUsedFonts(const GfxRenderer& renderer);
@@ -0,0 +1,146 @@
+#include "ResumeSnapshot.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <cstring>
+
+namespace resume {
+namespace {
+constexpr uint8_t SNAPSHOT_FILE_VERSION = 1;
+constexpr size_t MAX_PACKET = 128;
+
+uint32_t checksum(const uint8_t* data, const size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+bool startsRun(const uint8_t* data, const size_t size, const size_t i) {
+  return i + 2 < size && data[i] == data[i + 1] && data[i] == data[i + 2];
+}
+
+// PackBits: a header n below 128 is followed by n + 1 bytes to copy, one above 128 by a byte to repeat 257 - n times
+void pack(serialization::BufferedFileWriter& writer, const uint8_t* data, const size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    if (startsRun(data, size, i)) {
+      size_t run = 3;
+      while (run < MAX_PACKET && i + run < size && data[i + run] == data[i]) {
+        run++;
+      }
+      const uint8_t packet[2] = {static_cast<uint8_t>(257 - run), data[i]};
+      writer.write(packet, sizeof(packet));
+      i += run;
+      continue;
+    }
+    // Literal bytes up to where the next run starts
+    const size_t start = i;
+    do {
+      i++;
+    } while (i < size && i - start < MAX_PACKET && !startsRun(data, size, i));
+    const auto header = static_cast<uint8_t>(i - start - 1);
+    writer.write(&header, 1);
+    writer.write(data + start, i - start);
+  }
+}
+
+bool unpack(serialization::BufferedFileReader& reader, uint8_t* out, const size_t size) {
+  size_t filled = 0;
+  while (filled < size) {
+    uint8_t header;
+    if (reader.read(&header, 1) != 1) {
+      return false;
+    }
+    if (header < 128) {
+      const size_t count = header + 1;
+      if (filled + count > size || reader.read(out + filled, count) != static_cast<int>(count)) {
+        return false;
+      }
+      filled += count;
+    } else if (header > 128) {
+      const size_t count = 257 - header;
+      uint8_t value;
+      if (filled + count > size || reader.read(&value, 1) != 1) {
+        return false;
+      }
+      memset(out + filled, value, count);
+      filled += count;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+bool saveSnapshot(const uint8_t* frameBuffer, const size_t size, const std::string& bookPath, const char* path) {
+  FsFile file;
+  if (!SdMan.openFileForWrite("RES", path, file)) {
+    return false;
+  }
+  bool written;
+  {
+    serialization::BufferedFileWriter writer(file);
+    serialization::writePod(writer, SNAPSHOT_FILE_VERSION);
+    serialization::writeString(writer, bookPath);
+    serialization::writePod(writer, static_cast<uint32_t>(size));
+    pack(writer, frameBuffer, size);
+    serialization::writePod(writer, checksum(frameBuffer, size));
+    written = writer.flush();
+  }
+  const size_t fileSize = file.size();
+  file.close();
+  if (!written) {
+    Serial.printf("[%lu] [RES] Could not write snapshot\n", millis());
+    SdMan.remove(path);
+    return false;
+  }
+  Serial.printf("[%lu] [RES] Saved snapshot of %s, %u bytes\n", millis(), bookPath.c_str(),
+                static_cast<unsigned>(fileSize));
+  return true;
+}
+
+bool loadSnapshot(uint8_t* frameBuffer, const size_t size, const std::string& bookPath, const char* path) {
+  FsFile file;
+  if (!SdMan.exists(path) || !SdMan.openFileForRead("RES", path, file)) {
+    return false;
+  }
+  serialization::BufferedFileReader reader(file);
+  uint8_t version = 0;
+  std::string snapshotBookPath;
+  uint32_t snapshotSize = 0;
+  uint32_t storedChecksum = 0;
+  serialization::readPod(reader, version);
+  if (version != SNAPSHOT_FILE_VERSION) {
+    file.close();
+    return false;
+  }
+  // The length is checked before reading the path, so a damaged one can't ask for all the heap
+  uint32_t pathLength = 0;
+  serialization::readPod(reader, pathLength);
+  if (pathLength != bookPath.size()) {
+    file.close();
+    return false;
+  }
+  snapshotBookPath.resize(pathLength);
+  reader.read(&snapshotBookPath[0], pathLength);
+  serialization::readPod(reader, snapshotSize);
+  const bool loaded = snapshotBookPath == bookPath && snapshotSize == size && unpack(reader, frameBuffer, size) &&
+                      reader.read(&storedChecksum, sizeof(storedChecksum)) == sizeof(storedChecksum) &&
+                      storedChecksum == checksum(frameBuffer, size);
+  file.close();
+  if (!loaded) {
+    Serial.printf("[%lu] [RES] No usable snapshot for %s\n", millis(), bookPath.c_str());
+  }
+  return loaded;
+}
+
+void discardSnapshot(const char* path) {
+  if (SdMan.exists(path)) {
+    SdMan.remove(path);
+  }
+}
+
+}  // namespace resume
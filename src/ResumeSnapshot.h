@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The reader's page as it was on the panel when the device went to sleep, so waking up can show it again straight
+// after the display is up, before the fonts are set up and the book is opened. The reader then opens as usual and
+// draws the same page over it. The frame buffer is stored PackBits compressed, which takes a page from 48KB to around
+// 10-16KB, with a checksum so a snapshot cut short is never shown.
+namespace resume {
+
+constexpr char DEFAULT_SNAPSHOT_PATH[] = "/.crosspoint/resume.bin";
+
+// Saves the frame buffer as the page showing in the given book
+bool saveSnapshot(const uint8_t* frameBuffer, size_t size, const std::string& bookPath,
+                  const char* path = DEFAULT_SNAPSHOT_PATH);
+
+// Fills the frame buffer with the snapshot, if there is an intact one of the given book. On failure the frame buffer
+// may have been written to.
+bool loadSnapshot(uint8_t* frameBuffer, size_t size, const std::string& bookPath,
+                  const char* path = DEFAULT_SNAPSHOT_PATH);
+
+void discardSnapshot(const char* path = DEFAULT_SNAPSHOT_PATH);
+
+}  // namespace resume
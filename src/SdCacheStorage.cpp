@@ -0,0 +1,46 @@
+#include "SdCacheStorage.h"
+
+#include <SDCardManager.h>
+
+bool SdCacheStorage::list(const std::string& dir, std::vector<Entry>& entries) {
+  entries.clear();
+  auto root = SdMan.open(dir.c_str());
+  if (!root || !root.isDirectory()) {
+    if (root) root.close();
+    return false;
+  }
+  char name[128];
+  for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
+    file.getName(name, sizeof(name));
+    const bool isDirectory = file.isDirectory();
+    entries.push_back({name, isDirectory, isDirectory ? 0 : static_cast<uint64_t>(file.size())});
+    file.close();
+  }
+  root.close();
+  return true;
+}
+
+bool SdCacheStorage::readFile(const std::string& path, std::vector<uint8_t>& data) {
+  FsFile file;
+  if (!SdMan.openFileForRead("CACHE", path, file)) {
+    return false;
+  }
+  data.resize(file.size());
+  const bool ok = file.read(data.data(), data.size()) == static_cast<int>(data.size());
+  file.close();
+  return ok;
+}
+
+bool SdCacheStorage::writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+  FsFile file;
+  if (!SdMan.openFileForWrite("CACHE", path, file)) {
+    return false;
+  }
+  const bool ok = file.write(data.data(), data.size()) == data.size();
+  file.close();
+  return ok;
+}
+
+bool SdCacheStorage::removeFile(const std::string& path) { return SdMan.remove(path.c_str()); }
+
+bool SdCacheStorage::removeDir(const std::string& path) { return SdMan.removeDir(path.c_str()); }
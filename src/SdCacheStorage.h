@@ -0,0 +1,13 @@
+#pragma once
+
+#include "CacheManager.h"
+
+// CacheStorage on the SD card
+class SdCacheStorage final : public CacheStorage {
+ public:
+  bool list(const std::string& dir, std::vector<Entry>& entries) override;
+  bool readFile(const std::string& path, std::vector<uint8_t>& data) override;
+  bool writeFile(const std::string& path, const std::vector<uint8_t>& data) override;
+  bool removeFile(const std::string& path) override;
+  bool removeDir(const std::string& path) override;
+};
@@ -3,6 +3,7 @@
 #include <Epub.h>
 #include <GfxRenderer.h>
 #include <HardwareSerial.h>
+#include <HeapWatch.h>
 #include <OpdsStream.h>
 #include <WiFi.h>
 
@@ -264,6 +265,7 @@ void OpdsBookBrowserActivity::fetchFeed(const std::string& path) {
 
   std::string url = UrlUtils::buildUrl(serverUrl, path);
   Serial.printf("[%lu] [OPDS] Fetching: %s\n", millis(), url.c_str());
+  heapwatch::Operation heapOperation("OpdsFetch", url);
 
   OpdsParser parser;
 
@@ -3,7 +3,8 @@
 #include <Epub/Page.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
-#include <SDCardManager.h>
+#include <ProgressJournal.h>
+#include <Trace.h>
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
@@ -19,6 +20,8 @@ constexpr unsigned long skipChapterMs = 700;
 constexpr unsigned long goHomeMs = 1000;
 constexpr int statusBarMargin = 19;
 constexpr int progressBarMarginTop = 1;
+// How long the reader must sit on a page before the next chapter is built in the background
+constexpr unsigned long precomputeIdleMs = 1500;
 
 }  // namespace
 
@@ -27,6 +30,11 @@ void EpubReaderActivity::taskTrampoline(void* param) {
   self->displayTaskLoop();
 }
 
+void EpubReaderActivity::precomputeTaskTrampoline(void* param) {
+  auto* self = static_cast<EpubReaderActivity*>(param);
+  self->precomputeTaskLoop();
+}
+
 void EpubReaderActivity::onEnter() {
   ActivityWithSubactivity::onEnter();
 
@@ -56,20 +64,16 @@ void EpubReaderActivity::onEnter() {
 
   epub->setupCacheDir();
 
-  FsFile f;
-  if (SdMan.openFileForRead("ERS", epub->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[6];
-    int dataSize = f.read(data, 6);
-    if (dataSize == 4 || dataSize == 6) {
-      currentSpineIndex = data[0] + (data[1] << 8);
-      nextPageNumber = data[2] + (data[3] << 8);
-      cachedSpineIndex = currentSpineIndex;
-      Serial.printf("[%lu] [ERS] Loaded cache: %d, %d\n", millis(), currentSpineIndex, nextPageNumber);
-    }
-    if (dataSize == 6) {
-      cachedChapterTotalPageCount = data[4] + (data[5] << 8);
-    }
-    f.close();
+  uint8_t data[6];
+  const size_t dataSize = PROGRESS_JOURNAL.load(epub->getCachePath(), data, sizeof(data));
+  if (dataSize == 4 || dataSize == 6) {
+    currentSpineIndex = data[0] + (data[1] << 8);
+    nextPageNumber = data[2] + (data[3] << 8);
+    cachedSpineIndex = currentSpineIndex;
+    Serial.printf("[%lu] [ERS] Loaded cache: %d, %d\n", millis(), currentSpineIndex, nextPageNumber);
+  }
+  if (dataSize == 6) {
+    cachedChapterTotalPageCount = data[4] + (data[5] << 8);
   }
   // We may want a better condition to detect if we are opening for the first time.
   // This will trigger if the book is re-opened at Chapter 0.
@@ -96,6 +100,14 @@ void EpubReaderActivity::onEnter() {
               1,                  // Priority
               &displayTaskHandle  // Task handle
   );
+
+  // Below the display task so a page turn always wins the CPU; the SD bus is shared through renderingMutex
+  xTaskCreate(&EpubReaderActivity::precomputeTaskTrampoline, "EpubPrecomputeTask",
+              8192,                  // Stack size
+              this,                  // Parameters
+              tskIDLE_PRIORITY,      // Priority
+              &precomputeTaskHandle  // Task handle
+  );
 }
 
 void EpubReaderActivity::onExit() {
@@ -105,18 +117,31 @@ void EpubReaderActivity::onExit() {
   renderer.setOrientation(GfxRenderer::Orientation::Portrait);
 
   // Wait until not rendering to delete task to avoid killing mid-instruction to EPD
+  // A background section build holds the mutex too, ask it to bail out first
+  precomputeCancelled = true;
   xSemaphoreTake(renderingMutex, portMAX_DELAY);
   if (displayTaskHandle) {
     vTaskDelete(displayTaskHandle);
     displayTaskHandle = nullptr;
   }
+  if (precomputeTaskHandle) {
+    vTaskDelete(precomputeTaskHandle);
+    precomputeTaskHandle = nullptr;
+  }
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
+  PROGRESS_JOURNAL.flush();
   section.reset();
   epub.reset();
+  renderer.freeGrayscaleCapture();
 }
 
 void EpubReaderActivity::loop() {
+  // Any input stops a background section build so the page turn doesn't queue behind it
+  if (mappedInput.wasAnyPressed() || mappedInput.wasAnyReleased()) {
+    precomputeCancelled = true;
+  }
+
   // Pass input responsibility to sub activity if exists
   if (subActivity) {
     subActivity->loop();
@@ -129,9 +154,18 @@ void EpubReaderActivity::loop() {
     xSemaphoreTake(renderingMutex, portMAX_DELAY);
     const int currentPage = section ? section->currentPage : 0;
     const int totalPages = section ? section->pageCount : 0;
+    std::vector<uint32_t> spineStartPages;
+    if (pageIndex && pageIndex->isComplete()) {
+      for (int i = 0; i < epub->getSpineItemsCount(); i++) {
+        spineStartPages.push_back(pageIndex->pagesBefore(i) + 1);
+      }
+    }
     exitActivity();
+    // Hand the grayscale planes back while the menus (and possibly sync over WiFi) run, the next page reallocates them
+    renderer.freeGrayscaleCapture();
     enterNewActivity(new EpubReaderChapterSelectionActivity(
         this->renderer, this->mappedInput, epub, epub->getPath(), currentSpineIndex, currentPage, totalPages,
+        std::move(spineStartPages),
         [this] {
           exitActivity();
           updateRequired = true;
@@ -247,13 +281,95 @@ void EpubReaderActivity::displayTaskLoop() {
     if (updateRequired) {
       updateRequired = false;
       xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      pageOnScreen = false;
       renderScreen();
       xSemaphoreGive(renderingMutex);
+      if (precomputeTaskHandle) {
+        xTaskNotifyGive(precomputeTaskHandle);
+      }
     }
     vTaskDelay(10 / portTICK_PERIOD_MS);
   }
 }
 
+void EpubReaderActivity::precomputeTaskLoop() {
+  while (true) {
+    // Woken by the display task each time a page has been shown
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    precomputeCancelled = false;
+
+    // Let a burst of page turns settle before touching the SD card
+    vTaskDelay(precomputeIdleMs / portTICK_PERIOD_MS);
+    if (precomputeCancelled || updateRequired) {
+      continue;
+    }
+
+    xSemaphoreTake(renderingMutex, portMAX_DELAY);
+    if (!precomputeCancelled && !updateRequired && !subActivity) {
+      precomputeNextSection();
+    }
+    xSemaphoreGive(renderingMutex);
+
+    // Then page through the rest of the book, releasing the mutex between chapters
+    bool indexing = true;
+    while (indexing && !precomputeCancelled && !updateRequired) {
+      xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      indexing = !precomputeCancelled && !updateRequired && !subActivity && indexNextChapter();
+      xSemaphoreGive(renderingMutex);
+    }
+  }
+}
+
+// Builds the section file for the chapter after the current one with the layout of the page on screen, so crossing
+// the chapter boundary only has to load it. Must be called with renderingMutex held.
+void EpubReaderActivity::precomputeNextSection() {
+  if (!epub || !section || viewportWidth == 0 || viewportHeight == 0) {
+    return;
+  }
+
+  const int nextSpineIndex = currentSpineIndex + 1;
+  if (nextSpineIndex >= epub->getSpineItemsCount() || nextSpineIndex == precomputedSpineIndex) {
+    return;
+  }
+
+  Section nextSection(epub, nextSpineIndex, renderer);
+  if (nextSection.loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                  SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
+                                  viewportHeight, SETTINGS.hyphenationEnabled)) {
+    precomputedSpineIndex = nextSpineIndex;
+    return;
+  }
+
+  Serial.printf("[%lu] [ERS] Precomputing section for spine index %d\n", millis(), nextSpineIndex);
+  trace::Scope span(trace::Span::SECTION_PRECOMPUTE, nextSpineIndex);
+  if (nextSection.createSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                    SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
+                                    viewportHeight, SETTINGS.hyphenationEnabled, nullptr, nullptr,
+                                    [this] { return precomputeCancelled.load(); })) {
+    precomputedSpineIndex = nextSpineIndex;
+    if (pageIndex && pageIndex->getProfileDir() == nextSection.getProfileDir()) {
+      pageIndex->record(nextSpineIndex, nextSection.pageCount);
+    }
+  } else if (precomputeCancelled) {
+    Serial.printf("[%lu] [ERS] Precompute cancelled by input\n", millis());
+  } else {
+    // Don't keep retrying a chapter that won't build, the foreground path reports the failure when it gets there
+    precomputedSpineIndex = nextSpineIndex;
+  }
+}
+
+// Records the page count of the first chapter the page index is missing, building its section file if need be. Returns
+// false once there is nothing left to do. Must be called with renderingMutex held.
+bool EpubReaderActivity::indexNextChapter() {
+  if (!pageIndex || pageIndex->isComplete() || viewportWidth == 0 || viewportHeight == 0) {
+    return false;
+  }
+  return pageIndex->indexNextChapter(renderer, SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                     SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
+                                     viewportHeight, SETTINGS.hyphenationEnabled,
+                                     [this] { return precomputeCancelled.load(); });
+}
+
 // TODO: Failure handling
 void EpubReaderActivity::renderScreen() {
   if (!epub) {
@@ -295,14 +411,14 @@ void EpubReaderActivity::renderScreen() {
                             (showProgressBar ? (ScreenComponents::BOOK_PROGRESS_BAR_HEIGHT + progressBarMarginTop) : 0);
   }
 
+  viewportWidth = renderer.getScreenWidth() - orientedMarginLeft - orientedMarginRight;
+  viewportHeight = renderer.getScreenHeight() - orientedMarginTop - orientedMarginBottom;
+
   if (!section) {
     const auto filepath = epub->getSpineItem(currentSpineIndex).href;
     Serial.printf("[%lu] [ERS] Loading file: %s, index: %d\n", millis(), filepath.c_str(), currentSpineIndex);
     section = std::unique_ptr<Section>(new Section(epub, currentSpineIndex, renderer));
 
-    const uint16_t viewportWidth = renderer.getScreenWidth() - orientedMarginLeft - orientedMarginRight;
-    const uint16_t viewportHeight = renderer.getScreenHeight() - orientedMarginTop - orientedMarginBottom;
-
     if (!section->loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
                                   SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
                                   viewportHeight, SETTINGS.hyphenationEnabled)) {
@@ -359,6 +475,13 @@ void EpubReaderActivity::renderScreen() {
       Serial.printf("[%lu] [ERS] Cache found, skipping build...\n", millis());
     }
 
+    // A new layout gets its own page index
+    if (!pageIndex || pageIndex->getProfileDir() != section->getProfileDir()) {
+      pageIndex.reset(new BookPageIndex(epub, section->getProfileDir()));
+      pageIndex->load();
+    }
+    pageIndex->record(currentSpineIndex, section->pageCount);
+
     if (nextPageNumber == UINT16_MAX) {
       section->currentPage = section->pageCount - 1;
     } else {
@@ -403,29 +526,32 @@ void EpubReaderActivity::renderScreen() {
       section.reset();
       return renderScreen();
     }
-    const auto start = millis();
-    renderContents(std::move(p), orientedMarginTop, orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
-    Serial.printf("[%lu] [ERS] Rendered page in %dms\n", millis(), millis() - start);
-  }
-
-  FsFile f;
-  if (SdMan.openFileForWrite("ERS", epub->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[6];
-    data[0] = currentSpineIndex & 0xFF;
-    data[1] = (currentSpineIndex >> 8) & 0xFF;
-    data[2] = section->currentPage & 0xFF;
-    data[3] = (section->currentPage >> 8) & 0xFF;
-    data[4] = section->pageCount & 0xFF;
-    data[5] = (section->pageCount >> 8) & 0xFF;
-    f.write(data, 6);
-    f.close();
+    trace::Scope span(trace::Span::PAGE_RENDER, section->currentPage);
+    renderContents(p, orientedMarginTop, orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
+    pageOnScreen = true;
   }
+
+  // Kept in RAM, the main loop writes it to the card once the reader settles
+  uint8_t data[6];
+  data[0] = currentSpineIndex & 0xFF;
+  data[1] = (currentSpineIndex >> 8) & 0xFF;
+  data[2] = section->currentPage & 0xFF;
+  data[3] = (section->currentPage >> 8) & 0xFF;
+  data[4] = section->pageCount & 0xFF;
+  data[5] = (section->pageCount >> 8) & 0xFF;
+  PROGRESS_JOURNAL.update(epub->getCachePath(), data, sizeof(data));
+
+  // The page is on the panel; fetch the one the reader will most likely turn to while they read this one
+  section->readAhead();
 }
 
-void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int orientedMarginTop,
+void EpubReaderActivity::renderContents(const std::shared_ptr<Page>& page, const int orientedMarginTop,
                                         const int orientedMarginRight, const int orientedMarginBottom,
                                         const int orientedMarginLeft) {
+  // With anti-aliasing, the BW render also fills the grayscale planes so the page is only rasterized once
+  const bool grayscaleCaptured = SETTINGS.textAntiAliasing && renderer.beginGrayscaleCapture();
   page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+  renderer.endGrayscaleCapture();
   renderStatusBar(orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
   if (pagesUntilFullRefresh <= 1) {
     renderer.displayBuffer(HalDisplay::HALF_REFRESH);
@@ -435,10 +561,15 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
     pagesUntilFullRefresh--;
   }
 
+  if (grayscaleCaptured) {
+    renderer.displayGrayscaleCapture();
+    return;
+  }
+
   // Save bw buffer to reset buffer state after grayscale data sync
   renderer.storeBwBuffer();
 
-  // grayscale rendering
+  // grayscale rendering, re-rendering the page per plane if the capture planes couldn't be allocated
   // TODO: Only do this if font supports it
   if (SETTINGS.textAntiAliasing) {
     renderer.clearScreen(0x00);
@@ -483,16 +614,28 @@ void EpubReaderActivity::renderStatusBar(const int orientedMarginRight, const in
   const auto textY = screenHeight - orientedMarginBottom - 4;
   int progressTextWidth = 0;
 
-  // Calculate progress in book
-  const float sectionChapterProg = static_cast<float>(section->currentPage) / section->pageCount;
-  const float bookProgress = epub->calculateProgress(currentSpineIndex, sectionChapterProg) * 100;
+  // Calculate progress in book: exact once every chapter's pages are counted, estimated from chapter sizes until then
+  uint32_t bookPage = 0;
+  uint32_t bookPages = 0;
+  float bookProgress;
+  if (pageIndex && pageIndex->isComplete() && pageIndex->totalPages() > 0) {
+    bookPage = pageIndex->pagesBefore(currentSpineIndex) + section->currentPage + 1;
+    bookPages = pageIndex->totalPages();
+    bookProgress = static_cast<float>(bookPage) * 100 / bookPages;
+  } else {
+    const float sectionChapterProg = static_cast<float>(section->currentPage) / section->pageCount;
+    bookProgress = epub->calculateProgress(currentSpineIndex, sectionChapterProg) * 100;
+  }
 
   if (showProgressText || showProgressPercentage) {
     // Right aligned text for progress counter
-    char progressStr[32];
+    char progressStr[64];
 
     // Hide percentage when progress bar is shown to reduce clutter
-    if (showProgressPercentage) {
+    if (showProgressPercentage && bookPages > 0) {
+      snprintf(progressStr, sizeof(progressStr), "%d/%d  %lu of %lu", section->currentPage + 1, section->pageCount,
+               static_cast<unsigned long>(bookPage), static_cast<unsigned long>(bookPages));
+    } else if (showProgressPercentage) {
       snprintf(progressStr, sizeof(progressStr), "%d/%d  %.0f%%", section->currentPage + 1, section->pageCount,
                bookProgress);
     } else {
@@ -534,8 +677,7 @@ void EpubReaderActivity::renderStatusBar(const int orientedMarginRight, const in
       title = "Unnamed";
       titleWidth = renderer.getTextWidth(SMALL_FONT_ID, "Unnamed");
     } else {
-      const auto tocItem = epub->getTocItem(tocIndex);
-      title = tocItem.title;
+      title = epub->getTocTitle(tocIndex);
       titleWidth = renderer.getTextWidth(SMALL_FONT_ID, title.c_str());
       if (titleWidth > availableTitleSpace) {
         // Not enough space to center on the screen, center it within the remaining space instead
@@ -1,16 +1,23 @@
 #pragma once
 #include <Epub.h>
+#include <Epub/BookPageIndex.h>
 #include <Epub/Section.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <atomic>
+#include <functional>
+
 #include "activities/ActivityWithSubactivity.h"
 
 class EpubReaderActivity final : public ActivityWithSubactivity {
   std::shared_ptr<Epub> epub;
   std::unique_ptr<Section> section = nullptr;
+  // Page counts of every chapter for the current layout, filled in by the background worker
+  std::unique_ptr<BookPageIndex> pageIndex = nullptr;
   TaskHandle_t displayTaskHandle = nullptr;
+  TaskHandle_t precomputeTaskHandle = nullptr;
   SemaphoreHandle_t renderingMutex = nullptr;
   int currentSpineIndex = 0;
   int nextPageNumber = 0;
@@ -18,13 +25,25 @@ class EpubReaderActivity final : public ActivityWithSubactivity {
   int cachedSpineIndex = 0;
   int cachedChapterTotalPageCount = 0;
   bool updateRequired = false;
+  // The last render ended with a page on the panel rather than a message
+  bool pageOnScreen = false;
+  // Viewport of the last rendered page, reused by the background section build
+  uint16_t viewportWidth = 0;
+  uint16_t viewportHeight = 0;
+  // Spine index the background worker last built (or gave up on), so each chapter is only attempted once
+  int precomputedSpineIndex = -1;
+  std::atomic<bool> precomputeCancelled{false};
   const std::function<void()> onGoBack;
   const std::function<void()> onGoHome;
 
   static void taskTrampoline(void* param);
   [[noreturn]] void displayTaskLoop();
+  static void precomputeTaskTrampoline(void* param);
+  [[noreturn]] void precomputeTaskLoop();
+  void precomputeNextSection();
+  bool indexNextChapter();
   void renderScreen();
-  void renderContents(std::unique_ptr<Page> page, int orientedMarginTop, int orientedMarginRight,
+  void renderContents(const std::shared_ptr<Page>& page, int orientedMarginTop, int orientedMarginRight,
                       int orientedMarginBottom, int orientedMarginLeft);
   void renderStatusBar(int orientedMarginRight, int orientedMarginBottom, int orientedMarginLeft) const;
 
@@ -38,4 +57,5 @@ class EpubReaderActivity final : public ActivityWithSubactivity {
   void onEnter() override;
   void onExit() override;
   void loop() override;
+  bool showsResumablePage() const override { return pageOnScreen && !updateRequired && !subActivity; }
 };
@@ -2,17 +2,27 @@
 
 #include <GfxRenderer.h>
 
-#include "KOReaderCredentialStore.h"
-#include "KOReaderSyncActivity.h"
 #include "MappedInputManager.h"
 #include "fontIds.h"
 
+// The emulator has no network to sync over
+#if CROSSPOINT_EMULATED == 0
+#include "KOReaderCredentialStore.h"
+#include "KOReaderSyncActivity.h"
+#endif
+
 namespace {
 // Time threshold for treating a long press as a page-up/page-down
 constexpr int SKIP_PAGE_MS = 700;
 }  // namespace
 
-bool EpubReaderChapterSelectionActivity::hasSyncOption() const { return KOREADER_STORE.hasCredentials(); }
+bool EpubReaderChapterSelectionActivity::hasSyncOption() const {
+#if CROSSPOINT_EMULATED == 0
+  return KOREADER_STORE.hasCredentials();
+#else
+  return false;
+#endif
+}
 
 int EpubReaderChapterSelectionActivity::getTotalItems() const {
   // Add 2 for sync options (top and bottom) if credentials are configured
@@ -96,6 +106,7 @@ void EpubReaderChapterSelectionActivity::onExit() {
 }
 
 void EpubReaderChapterSelectionActivity::launchSyncActivity() {
+#if CROSSPOINT_EMULATED == 0
   xSemaphoreTake(renderingMutex, portMAX_DELAY);
   exitActivity();
   enterNewActivity(new KOReaderSyncActivity(
@@ -111,6 +122,7 @@ void EpubReaderChapterSelectionActivity::launchSyncActivity() {
         onSyncPosition(newSpineIndex, newPage);
       }));
   xSemaphoreGive(renderingMutex);
+#endif
 }
 
 void EpubReaderChapterSelectionActivity::loop() {
@@ -201,8 +213,16 @@ void EpubReaderChapterSelectionActivity::renderScreen() {
       auto item = epub->getTocItem(tocIndex);
 
       const int indentSize = 20 + (item.level - 1) * 15;
+      const int spineIndex = epub->getSpineIndexForTocIndex(tocIndex);
+      int pageNumberWidth = 0;
+      if (spineIndex >= 0 && spineIndex < static_cast<int>(spineStartPages.size())) {
+        const std::string pageNumber = std::to_string(spineStartPages[spineIndex]);
+        const int textWidth = renderer.getTextWidth(UI_10_FONT_ID, pageNumber.c_str());
+        renderer.drawText(UI_10_FONT_ID, pageWidth - 20 - textWidth, displayY, pageNumber.c_str(), !isSelected);
+        pageNumberWidth = textWidth + 10;
+      }
       const std::string chapterName =
-          renderer.truncatedText(UI_10_FONT_ID, item.title.c_str(), pageWidth - 40 - indentSize);
+          renderer.truncatedText(UI_10_FONT_ID, item.title.c_str(), pageWidth - 40 - indentSize - pageNumberWidth);
 
       renderer.drawText(UI_10_FONT_ID, indentSize, displayY, chapterName.c_str(), !isSelected);
     }
@@ -4,7 +4,9 @@
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "../ActivityWithSubactivity.h"
 
@@ -16,6 +18,8 @@ class EpubReaderChapterSelectionActivity final : public ActivityWithSubactivity
   int currentSpineIndex = 0;
   int currentPage = 0;
   int totalPagesInSpine = 0;
+  // First page of each spine item counted across the whole book, empty until the book's page index is complete
+  std::vector<uint32_t> spineStartPages;
   int selectorIndex = 0;
   bool updateRequired = false;
   const std::function<void()> onGoBack;
@@ -47,7 +51,8 @@ class EpubReaderChapterSelectionActivity final : public ActivityWithSubactivity
   explicit EpubReaderChapterSelectionActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
                                               const std::shared_ptr<Epub>& epub, const std::string& epubPath,
                                               const int currentSpineIndex, const int currentPage,
-                                              const int totalPagesInSpine, const std::function<void()>& onGoBack,
+                                              const int totalPagesInSpine, std::vector<uint32_t> spineStartPages,
+                                              const std::function<void()>& onGoBack,
                                               const std::function<void(int newSpineIndex)>& onSelectSpineIndex,
                                               const std::function<void(int newSpineIndex, int newPage)>& onSyncPosition)
       : ActivityWithSubactivity("EpubReaderChapterSelection", renderer, mappedInput),
@@ -56,6 +61,7 @@ class EpubReaderChapterSelectionActivity final : public ActivityWithSubactivity
         currentSpineIndex(currentSpineIndex),
         currentPage(currentPage),
         totalPagesInSpine(totalPagesInSpine),
+        spineStartPages(std::move(spineStartPages)),
         onGoBack(onGoBack),
         onSelectSpineIndex(onSelectSpineIndex),
         onSyncPosition(onSyncPosition) {}
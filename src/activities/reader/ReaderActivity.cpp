@@ -1,7 +1,10 @@
 #include "ReaderActivity.h"
 
+#include "CrossPointSettings.h"
 #include "Epub.h"
 #include "EpubReaderActivity.h"
+#include "RecentBooksStore.h"
+#include "SdCacheStorage.h"
 #include "Txt.h"
 #include "TxtReaderActivity.h"
 #include "Xtc.h"
@@ -77,9 +80,22 @@ void ReaderActivity::goToLibrary(const std::string& fromBookPath) {
   onGoToLibrary(initialPath, libraryTab);
 }
 
+// Marks the book being opened as the most recently read and evicts old book caches past the limit
+void ReaderActivity::enforceCacheLimit(const std::string& bookCachePath) {
+  SdCacheStorage storage;
+  CacheManager cache(storage);
+  cache.touch(bookCachePath);
+  std::vector<std::string> recentBookPaths;
+  for (const auto& book : RECENT_BOOKS.getBooks()) {
+    recentBookPaths.push_back(book.path);
+  }
+  cache.enforceLimit(SETTINGS.getCacheLimitBytes(), bookCachePath, recentBookPaths);
+}
+
 void ReaderActivity::onGoToEpubReader(std::unique_ptr<Epub> epub) {
   const auto epubPath = epub->getPath();
   currentBookPath = epubPath;
+  enforceCacheLimit(epub->getCachePath());
   exitActivity();
   enterNewActivity(new EpubReaderActivity(
       renderer, mappedInput, std::move(epub), [this, epubPath] { goToLibrary(epubPath); }, [this] { onGoBack(); }));
@@ -88,6 +104,7 @@ void ReaderActivity::onGoToEpubReader(std::unique_ptr<Epub> epub) {
 void ReaderActivity::onGoToXtcReader(std::unique_ptr<Xtc> xtc) {
   const auto xtcPath = xtc->getPath();
   currentBookPath = xtcPath;
+  enforceCacheLimit(xtc->getCachePath());
   exitActivity();
   enterNewActivity(new XtcReaderActivity(
       renderer, mappedInput, std::move(xtc), [this, xtcPath] { goToLibrary(xtcPath); }, [this] { onGoBack(); }));
@@ -96,6 +113,7 @@ void ReaderActivity::onGoToXtcReader(std::unique_ptr<Xtc> xtc) {
 void ReaderActivity::onGoToTxtReader(std::unique_ptr<Txt> txt) {
   const auto txtPath = txt->getPath();
   currentBookPath = txtPath;
+  enforceCacheLimit(txt->getCachePath());
   exitActivity();
   enterNewActivity(new TxtReaderActivity(
       renderer, mappedInput, std::move(txt), [this, txtPath] { goToLibrary(txtPath); }, [this] { onGoBack(); }));
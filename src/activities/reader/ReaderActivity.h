@@ -21,6 +21,7 @@ class ReaderActivity final : public ActivityWithSubactivity {
   static bool isTxtFile(const std::string& path);
 
   static std::string extractFolderPath(const std::string& filePath);
+  static void enforceCacheLimit(const std::string& bookCachePath);
   void goToLibrary(const std::string& fromBookPath = "");
   void onGoToEpubReader(std::unique_ptr<Epub> epub);
   void onGoToXtcReader(std::unique_ptr<Xtc> xtc);
@@ -36,4 +37,5 @@ class ReaderActivity final : public ActivityWithSubactivity {
         onGoBack(onGoBack),
         onGoToLibrary(onGoToLibrary) {}
   void onEnter() override;
+  bool showsResumablePage() const override { return subActivity && subActivity->showsResumablePage(); }
 };
@@ -1,8 +1,10 @@
 #include "TxtReaderActivity.h"
 
 #include <GfxRenderer.h>
+#include <ProgressJournal.h>
 #include <SDCardManager.h>
 #include <Serialization.h>
+#include <Trace.h>
 #include <Utf8.h>
 
 #include "CrossPointSettings.h"
@@ -87,9 +89,11 @@ void TxtReaderActivity::onExit() {
   }
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
+  PROGRESS_JOURNAL.flush();
   pageOffsets.clear();
   currentPageLines.clear();
   txt.reset();
+  renderer.freeGrayscaleCapture();
 }
 
 void TxtReaderActivity::loop() {
@@ -142,6 +146,7 @@ void TxtReaderActivity::displayTaskLoop() {
     if (updateRequired) {
       updateRequired = false;
       xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      pageOnScreen = false;
       renderScreen();
       xSemaphoreGive(renderingMutex);
     }
@@ -427,12 +432,14 @@ void TxtReaderActivity::renderScreen() {
 
   renderer.clearScreen();
   renderPage();
+  pageOnScreen = true;
 
   // Save progress
   saveProgress();
 }
 
 void TxtReaderActivity::renderPage() {
+  trace::Scope span(trace::Span::PAGE_RENDER, currentPage);
   int orientedMarginTop, orientedMarginRight, orientedMarginBottom, orientedMarginLeft;
   renderer.getOrientedViewableTRBL(&orientedMarginTop, &orientedMarginRight, &orientedMarginBottom,
                                    &orientedMarginLeft);
@@ -479,8 +486,10 @@ void TxtReaderActivity::renderPage() {
     }
   };
 
-  // First pass: BW rendering
+  // BW rendering, also filling the grayscale planes when anti-aliasing so the page is only laid out once
+  const bool grayscaleCaptured = SETTINGS.textAntiAliasing && renderer.beginGrayscaleCapture();
   renderLines();
+  renderer.endGrayscaleCapture();
   renderStatusBar(orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
 
   if (pagesUntilFullRefresh <= 1) {
@@ -491,8 +500,10 @@ void TxtReaderActivity::renderPage() {
     pagesUntilFullRefresh--;
   }
 
-  // Grayscale rendering pass (for anti-aliased fonts)
-  if (SETTINGS.textAntiAliasing) {
+  if (grayscaleCaptured) {
+    renderer.displayGrayscaleCapture();
+  } else if (SETTINGS.textAntiAliasing) {
+    // Grayscale rendering passes, for when the capture planes couldn't be allocated
     // Save BW buffer for restoration after grayscale pass
     renderer.storeBwBuffer();
 
@@ -575,33 +586,26 @@ void TxtReaderActivity::renderStatusBar(const int orientedMarginRight, const int
 }
 
 void TxtReaderActivity::saveProgress() const {
-  FsFile f;
-  if (SdMan.openFileForWrite("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
-    data[0] = currentPage & 0xFF;
-    data[1] = (currentPage >> 8) & 0xFF;
-    data[2] = 0;
-    data[3] = 0;
-    f.write(data, 4);
-    f.close();
-  }
+  // Kept in RAM, the main loop writes it to the card once the reader settles
+  uint8_t data[4];
+  data[0] = currentPage & 0xFF;
+  data[1] = (currentPage >> 8) & 0xFF;
+  data[2] = 0;
+  data[3] = 0;
+  PROGRESS_JOURNAL.update(txt->getCachePath(), data, sizeof(data));
 }
 
 void TxtReaderActivity::loadProgress() {
-  FsFile f;
-  if (SdMan.openFileForRead("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
-    if (f.read(data, 4) == 4) {
-      currentPage = data[0] + (data[1] << 8);
-      if (currentPage >= totalPages) {
-        currentPage = totalPages - 1;
-      }
-      if (currentPage < 0) {
-        currentPage = 0;
-      }
-      Serial.printf("[%lu] [TRS] Loaded progress: page %d/%d\n", millis(), currentPage, totalPages);
+  uint8_t data[4];
+  if (PROGRESS_JOURNAL.load(txt->getCachePath(), data, sizeof(data)) == 4) {
+    currentPage = data[0] + (data[1] << 8);
+    if (currentPage >= totalPages) {
+      currentPage = totalPages - 1;
     }
-    f.close();
+    if (currentPage < 0) {
+      currentPage = 0;
+    }
+    Serial.printf("[%lu] [TRS] Loaded progress: page %d/%d\n", millis(), currentPage, totalPages);
   }
 }
 
@@ -626,8 +630,9 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   // Read and validate header using serialization module
+  serialization::BufferedFileReader reader(f);
   uint32_t magic;
-  serialization::readPod(f, magic);
+  serialization::readPod(reader, magic);
   if (magic != CACHE_MAGIC) {
     Serial.printf("[%lu] [TRS] Cache magic mismatch, rebuilding\n", millis());
     f.close();
@@ -635,7 +640,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint8_t version;
-  serialization::readPod(f, version);
+  serialization::readPod(reader, version);
   if (version != CACHE_VERSION) {
     Serial.printf("[%lu] [TRS] Cache version mismatch (%d != %d), rebuilding\n", millis(), version, CACHE_VERSION);
     f.close();
@@ -643,7 +648,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint32_t fileSize;
-  serialization::readPod(f, fileSize);
+  serialization::readPod(reader, fileSize);
   if (fileSize != txt->getFileSize()) {
     Serial.printf("[%lu] [TRS] Cache file size mismatch, rebuilding\n", millis());
     f.close();
@@ -651,7 +656,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t cachedWidth;
-  serialization::readPod(f, cachedWidth);
+  serialization::readPod(reader, cachedWidth);
   if (cachedWidth != viewportWidth) {
     Serial.printf("[%lu] [TRS] Cache viewport width mismatch, rebuilding\n", millis());
     f.close();
@@ -659,7 +664,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t cachedLines;
-  serialization::readPod(f, cachedLines);
+  serialization::readPod(reader, cachedLines);
   if (cachedLines != linesPerPage) {
     Serial.printf("[%lu] [TRS] Cache lines per page mismatch, rebuilding\n", millis());
     f.close();
@@ -667,7 +672,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t fontId;
-  serialization::readPod(f, fontId);
+  serialization::readPod(reader, fontId);
   if (fontId != cachedFontId) {
     Serial.printf("[%lu] [TRS] Cache font ID mismatch (%d != %d), rebuilding\n", millis(), fontId, cachedFontId);
     f.close();
@@ -675,7 +680,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t margin;
-  serialization::readPod(f, margin);
+  serialization::readPod(reader, margin);
   if (margin != cachedScreenMargin) {
     Serial.printf("[%lu] [TRS] Cache screen margin mismatch, rebuilding\n", millis());
     f.close();
@@ -683,7 +688,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint8_t alignment;
-  serialization::readPod(f, alignment);
+  serialization::readPod(reader, alignment);
   if (alignment != cachedParagraphAlignment) {
     Serial.printf("[%lu] [TRS] Cache paragraph alignment mismatch, rebuilding\n", millis());
     f.close();
@@ -691,7 +696,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint32_t numPages;
-  serialization::readPod(f, numPages);
+  serialization::readPod(reader, numPages);
 
   // Read page offsets
   pageOffsets.clear();
@@ -699,7 +704,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
 
   for (uint32_t i = 0; i < numPages; i++) {
     uint32_t offset;
-    serialization::readPod(f, offset);
+    serialization::readPod(reader, offset);
     pageOffsets.push_back(offset);
   }
 
@@ -718,21 +723,23 @@ void TxtReaderActivity::savePageIndexCache() const {
   }
 
   // Write header using serialization module
-  serialization::writePod(f, CACHE_MAGIC);
-  serialization::writePod(f, CACHE_VERSION);
-  serialization::writePod(f, static_cast<uint32_t>(txt->getFileSize()));
-  serialization::writePod(f, static_cast<int32_t>(viewportWidth));
-  serialization::writePod(f, static_cast<int32_t>(linesPerPage));
-  serialization::writePod(f, static_cast<int32_t>(cachedFontId));
-  serialization::writePod(f, static_cast<int32_t>(cachedScreenMargin));
-  serialization::writePod(f, cachedParagraphAlignment);
-  serialization::writePod(f, static_cast<uint32_t>(pageOffsets.size()));
+  serialization::BufferedFileWriter writer(f);
+  serialization::writePod(writer, CACHE_MAGIC);
+  serialization::writePod(writer, CACHE_VERSION);
+  serialization::writePod(writer, static_cast<uint32_t>(txt->getFileSize()));
+  serialization::writePod(writer, static_cast<int32_t>(viewportWidth));
+  serialization::writePod(writer, static_cast<int32_t>(linesPerPage));
+  serialization::writePod(writer, static_cast<int32_t>(cachedFontId));
+  serialization::writePod(writer, static_cast<int32_t>(cachedScreenMargin));
+  serialization::writePod(writer, cachedParagraphAlignment);
+  serialization::writePod(writer, static_cast<uint32_t>(pageOffsets.size()));
 
   // Write page offsets
   for (size_t offset : pageOffsets) {
-    serialization::writePod(f, static_cast<uint32_t>(offset));
+    serialization::writePod(writer, static_cast<uint32_t>(offset));
   }
 
+  writer.flush();
   f.close();
   Serial.printf("[%lu] [TRS] Saved page index cache: %d pages\n", millis(), totalPages);
 }
@@ -5,6 +5,7 @@
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <functional>
 #include <vector>
 
 #include "CrossPointSettings.h"
@@ -18,6 +19,8 @@ class TxtReaderActivity final : public ActivityWithSubactivity {
   int totalPages = 1;
   int pagesUntilFullRefresh = 0;
   bool updateRequired = false;
+  // The last render ended with a page on the panel rather than a message
+  bool pageOnScreen = false;
   const std::function<void()> onGoBack;
   const std::function<void()> onGoHome;
 
@@ -57,4 +60,5 @@ class TxtReaderActivity final : public ActivityWithSubactivity {
   void onEnter() override;
   void onExit() override;
   void loop() override;
+  bool showsResumablePage() const override { return pageOnScreen && !updateRequired && !subActivity; }
 };
@@ -9,7 +9,8 @@
 
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
-#include <SDCardManager.h>
+#include <ProgressJournal.h>
+#include <Trace.h>
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
@@ -70,6 +71,7 @@ void XtcReaderActivity::onExit() {
   }
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
+  PROGRESS_JOURNAL.flush();
   xtc.reset();
 }
 
@@ -162,6 +164,7 @@ void XtcReaderActivity::displayTaskLoop() {
     if (updateRequired) {
       updateRequired = false;
       xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      pageOnScreen = false;
       renderScreen();
       xSemaphoreGive(renderingMutex);
     }
@@ -188,6 +191,7 @@ void XtcReaderActivity::renderScreen() {
 }
 
 void XtcReaderActivity::renderPage() {
+  trace::Scope span(trace::Span::PAGE_RENDER, currentPage);
   const uint16_t pageWidth = xtc->getPageWidth();
   const uint16_t pageHeight = xtc->getPageHeight();
   const uint8_t bitDepth = xtc->getBitDepth();
@@ -218,31 +222,14 @@ void XtcReaderActivity::renderPage() {
 
   // keep
   renderer.clearScreen();
-  const uint16_t maxSrcY = pageHeight;
 
   if (bitDepth == 2) {
     const size_t planeSize = (static_cast<size_t>(pageWidth) * pageHeight + 7) / 8;
     const uint8_t* plane1 = pageBuffer;
     const uint8_t* plane2 = pageBuffer + planeSize;
-    const size_t colBytes = (pageHeight + 7) / 8;
-
-    auto getPixelValue = [&](uint16_t x, uint16_t y) -> uint8_t {
-      const size_t colIndex = pageWidth - 1 - x;
-      const size_t byteInCol = y / 8;
-      const size_t bitInByte = 7 - (y % 8);
-      const size_t byteOffset = colIndex * colBytes + byteInCol;
-      const uint8_t bit1 = (plane1[byteOffset] >> bitInByte) & 1;
-      const uint8_t bit2 = (plane2[byteOffset] >> bitInByte) & 1;
-      return (bit1 << 1) | bit2;
-    };
-
-    for (uint16_t y = 0; y < pageHeight; y++) {
-      for (uint16_t x = 0; x < pageWidth; x++) {
-        if (getPixelValue(x, y) >= 1) {
-          renderer.drawPixel(x, y, true);
-        }
-      }
-    }
+
+    // The planes are copied straight into the frame buffer, one pass per render mode
+    renderer.drawXthPage(plane1, plane2, pageWidth, pageHeight);
 
     if (pagesUntilFullRefresh <= 1) {
       renderer.displayBuffer(HalDisplay::HALF_REFRESH);
@@ -253,49 +240,22 @@ void XtcReaderActivity::renderPage() {
     }
 
     renderer.clearScreen(0x00);
-    for (uint16_t y = 0; y < pageHeight; y++) {
-      for (uint16_t x = 0; x < pageWidth; x++) {
-        if (getPixelValue(x, y) == 1) {
-          renderer.drawPixel(x, y, false);
-        }
-      }
-    }
+    renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
+    renderer.drawXthPage(plane1, plane2, pageWidth, pageHeight);
     renderer.copyGrayscaleLsbBuffers();
 
     renderer.clearScreen(0x00);
-    for (uint16_t y = 0; y < pageHeight; y++) {
-      for (uint16_t x = 0; x < pageWidth; x++) {
-        const uint8_t pv = getPixelValue(x, y);
-        if (pv == 1 || pv == 2) {
-          renderer.drawPixel(x, y, false);
-        }
-      }
-    }
+    renderer.setRenderMode(GfxRenderer::GRAYSCALE_MSB);
+    renderer.drawXthPage(plane1, plane2, pageWidth, pageHeight);
     renderer.copyGrayscaleMsbBuffers();
 
     renderer.displayGrayBuffer();
+    renderer.setRenderMode(GfxRenderer::BW);
     renderer.clearScreen();
-    for (uint16_t y = 0; y < pageHeight; y++) {
-      for (uint16_t x = 0; x < pageWidth; x++) {
-        if (getPixelValue(x, y) >= 1) {
-          renderer.drawPixel(x, y, true);
-        }
-      }
-    }
+    renderer.drawXthPage(plane1, plane2, pageWidth, pageHeight);
     renderer.cleanupGrayscaleWithFrameBuffer();
   } else {
-    const size_t srcRowBytes = (pageWidth + 7) / 8;
-    for (uint16_t srcY = 0; srcY < maxSrcY; srcY++) {
-      const size_t srcRowStart = srcY * srcRowBytes;
-      for (uint16_t srcX = 0; srcX < pageWidth; srcX++) {
-        const size_t srcByte = srcRowStart + srcX / 8;
-        const size_t srcBit = 7 - (srcX % 8);
-        const bool isBlack = !((pageBuffer[srcByte] >> srcBit) & 1);
-        if (isBlack) {
-          renderer.drawPixel(srcX, srcY, true);
-        }
-      }
-    }
+    renderer.drawXtgPage(pageBuffer, pageWidth, pageHeight);
     if (pagesUntilFullRefresh <= 1) {
       renderer.displayBuffer(HalDisplay::HALF_REFRESH);
       pagesUntilFullRefresh = SETTINGS.getRefreshFrequency();
@@ -305,6 +265,7 @@ void XtcReaderActivity::renderPage() {
     }
   }
 
+  pageOnScreen = true;
   Serial.printf("[%lu] [成功] 显示页码: %lu/%lu\n", millis(), currentPage+1, xtc->getPageCount());
 }
 
@@ -330,57 +291,45 @@ void XtcReaderActivity::gotoPage(uint32_t targetPage) {
 
 
 void XtcReaderActivity::saveProgress() const {
-  FsFile f;
-  if (SdMan.openFileForWrite("XTR", xtc->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[8]; // for 2 data:currentPage and m_loadedMax
-    // currentPage
-    data[0] = currentPage & 0xFF;
-    data[1] = (currentPage >> 8) & 0xFF;
-    data[2] = (currentPage >> 16) & 0xFF;
-    data[3] = (currentPage >> 24) & 0xFF;
-    // m_loadedMax
-    data[4] = m_loadedMax & 0xFF;
-    data[5] = (m_loadedMax >> 8) & 0xFF;
-    data[6] = (m_loadedMax >> 16) & 0xFF;
-    data[7] = (m_loadedMax >> 24) & 0xFF;
-    
-    f.write(data, 8);
-    f.close();
-    Serial.printf("[%lu] [进度] 保存成功 → 页码: %lu | 页表上限: %lu\n", millis(), currentPage, m_loadedMax);
-  }
+  uint8_t data[8]; // for 2 data:currentPage and m_loadedMax
+  // currentPage
+  data[0] = currentPage & 0xFF;
+  data[1] = (currentPage >> 8) & 0xFF;
+  data[2] = (currentPage >> 16) & 0xFF;
+  data[3] = (currentPage >> 24) & 0xFF;
+  // m_loadedMax
+  data[4] = m_loadedMax & 0xFF;
+  data[5] = (m_loadedMax >> 8) & 0xFF;
+  data[6] = (m_loadedMax >> 16) & 0xFF;
+  data[7] = (m_loadedMax >> 24) & 0xFF;
+
+  // Kept in RAM, the main loop writes it to the card once the reader settles
+  PROGRESS_JOURNAL.update(xtc->getCachePath(), data, sizeof(data));
 }
 
 //2data to load
 
 void XtcReaderActivity::loadProgress() {
-  FsFile f;
-  if (SdMan.openFileForRead("XTR", xtc->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[8];
-    if (f.read(data, 8) == 8) {
-    
-      currentPage = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
-      uint32_t savedLoadedMax = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
-
-      Serial.printf("[%lu] [进度] 恢复成功 → 页码: %lu | 保存的页表上限: %lu\n", millis(), currentPage, savedLoadedMax);
-
-    
-      const uint32_t totalPages = xtc->getPageCount();
-      if (currentPage >= totalPages) currentPage = totalPages - 1;
-      if (currentPage < 0) currentPage = 0;
-
-      // Determine whether loading is required and which batch of tables to load.
-      uint32_t targetBatchStart = (currentPage / loadedMaxPage_per) * loadedMaxPage_per;
-      xtc->loadPageBatchByStart(targetBatchStart); 
-      
-     
-      m_loadedMax = targetBatchStart + loadedMaxPage_per - 1;
-      if(m_loadedMax >= totalPages) m_loadedMax = totalPages - 1;
-
-      Serial.printf("[进度] 恢复进度后加载批次 → 页码%lu → 批次[%lu~%lu]\n", currentPage, targetBatchStart, m_loadedMax);
-    }
-    f.close();
+  uint8_t data[8];
+  if (PROGRESS_JOURNAL.load(xtc->getCachePath(), data, sizeof(data)) == 8) {
+    currentPage = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+    uint32_t savedLoadedMax = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+
+    Serial.printf("[%lu] [进度] 恢复成功 → 页码: %lu | 保存的页表上限: %lu\n", millis(), currentPage, savedLoadedMax);
+
+    const uint32_t totalPages = xtc->getPageCount();
+    if (currentPage >= totalPages) currentPage = totalPages - 1;
+    if (currentPage < 0) currentPage = 0;
+
+    // Determine whether loading is required and which batch of tables to load.
+    uint32_t targetBatchStart = (currentPage / loadedMaxPage_per) * loadedMaxPage_per;
+    xtc->loadPageBatchByStart(targetBatchStart);
+
+    m_loadedMax = targetBatchStart + loadedMaxPage_per - 1;
+    if(m_loadedMax >= totalPages) m_loadedMax = totalPages - 1;
+
+    Serial.printf("[进度] 恢复进度后加载批次 → 页码%lu → 批次[%lu~%lu]\n", currentPage, targetBatchStart, m_loadedMax);
   } else {
- 
     const uint32_t totalPages = xtc->getPageCount();
     currentPage = 0;
     m_loadedMax = loadedMaxPage_per - 1;
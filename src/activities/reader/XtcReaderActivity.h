@@ -12,6 +12,8 @@
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <functional>
+
 #include "activities/ActivityWithSubactivity.h"
 namespace {
 constexpr size_t MAX_PAGE_BUFFER_SIZE = (480 * 800 + 7) / 8 * 2;
@@ -25,6 +27,8 @@ class XtcReaderActivity final : public ActivityWithSubactivity {
   uint32_t currentPage = 0;
   int pagesUntilFullRefresh = 0;
   bool updateRequired = false;
+  // The last render ended with a page on the panel rather than a message
+  bool pageOnScreen = false;
   const std::function<void()> onGoBack;
   const std::function<void()> onGoHome;
     //pages once load
@@ -49,4 +53,5 @@ void gotoPage(uint32_t targetPage);
   void onEnter() override;
   void onExit() override;
   void loop() override;
+  bool showsResumablePage() const override { return pageOnScreen && !updateRequired && !subActivity; }
 };
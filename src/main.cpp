@@ -3,18 +3,23 @@
 #include <GfxRenderer.h>
 #include <HalDisplay.h>
 #include <HalGPIO.h>
+#include <HeapWatch.h>
+#include <ProgressJournal.h>
 #include <SDCardManager.h>
 #include <SPI.h>
-#include <builtinFonts/all.h>
+#include <Trace.h>
+#include <esp_heap_caps.h>
 
 #include <cstring>
 
 #include "Battery.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "FontSetup.h"
 #include "KOReaderCredentialStore.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
+#include "ResumeSnapshot.h"
 #include "activities/boot_sleep/BootActivity.h"
 #include "activities/boot_sleep/SleepActivity.h"
 #include "activities/browser/OpdsBookBrowserActivity.h"
@@ -32,94 +37,8 @@ MappedInputManager mappedInputManager(gpio);
 GfxRenderer renderer(display);
 Activity* currentActivity;
 
-// Fonts
-EpdFont bookerly14RegularFont(&bookerly_14_regular);
-EpdFont bookerly14BoldFont(&bookerly_14_bold);
-EpdFont bookerly14ItalicFont(&bookerly_14_italic);
-EpdFont bookerly14BoldItalicFont(&bookerly_14_bolditalic);
-EpdFontFamily bookerly14FontFamily(&bookerly14RegularFont, &bookerly14BoldFont, &bookerly14ItalicFont,
-                                   &bookerly14BoldItalicFont);
-#ifndef OMIT_FONTS
-EpdFont bookerly12RegularFont(&bookerly_12_regular);
-EpdFont bookerly12BoldFont(&bookerly_12_bold);
-EpdFont bookerly12ItalicFont(&bookerly_12_italic);
-EpdFont bookerly12BoldItalicFont(&bookerly_12_bolditalic);
-EpdFontFamily bookerly12FontFamily(&bookerly12RegularFont, &bookerly12BoldFont, &bookerly12ItalicFont,
-                                   &bookerly12BoldItalicFont);
-EpdFont bookerly16RegularFont(&bookerly_16_regular);
-EpdFont bookerly16BoldFont(&bookerly_16_bold);
-EpdFont bookerly16ItalicFont(&bookerly_16_italic);
-EpdFont bookerly16BoldItalicFont(&bookerly_16_bolditalic);
-EpdFontFamily bookerly16FontFamily(&bookerly16RegularFont, &bookerly16BoldFont, &bookerly16ItalicFont,
-                                   &bookerly16BoldItalicFont);
-EpdFont bookerly18RegularFont(&bookerly_18_regular);
-EpdFont bookerly18BoldFont(&bookerly_18_bold);
-EpdFont bookerly18ItalicFont(&bookerly_18_italic);
-EpdFont bookerly18BoldItalicFont(&bookerly_18_bolditalic);
-EpdFontFamily bookerly18FontFamily(&bookerly18RegularFont, &bookerly18BoldFont, &bookerly18ItalicFont,
-                                   &bookerly18BoldItalicFont);
-
-EpdFont notosans12RegularFont(&notosans_12_regular);
-EpdFont notosans12BoldFont(&notosans_12_bold);
-EpdFont notosans12ItalicFont(&notosans_12_italic);
-EpdFont notosans12BoldItalicFont(&notosans_12_bolditalic);
-EpdFontFamily notosans12FontFamily(&notosans12RegularFont, &notosans12BoldFont, &notosans12ItalicFont,
-                                   &notosans12BoldItalicFont);
-EpdFont notosans14RegularFont(&notosans_14_regular);
-EpdFont notosans14BoldFont(&notosans_14_bold);
-EpdFont notosans14ItalicFont(&notosans_14_italic);
-EpdFont notosans14BoldItalicFont(&notosans_14_bolditalic);
-EpdFontFamily notosans14FontFamily(&notosans14RegularFont, &notosans14BoldFont, &notosans14ItalicFont,
-                                   &notosans14BoldItalicFont);
-EpdFont notosans16RegularFont(&notosans_16_regular);
-EpdFont notosans16BoldFont(&notosans_16_bold);
-EpdFont notosans16ItalicFont(&notosans_16_italic);
-EpdFont notosans16BoldItalicFont(&notosans_16_bolditalic);
-EpdFontFamily notosans16FontFamily(&notosans16RegularFont, &notosans16BoldFont, &notosans16ItalicFont,
-                                   &notosans16BoldItalicFont);
-EpdFont notosans18RegularFont(&notosans_18_regular);
-EpdFont notosans18BoldFont(&notosans_18_bold);
-EpdFont notosans18ItalicFont(&notosans_18_italic);
-EpdFont notosans18BoldItalicFont(&notosans_18_bolditalic);
-EpdFontFamily notosans18FontFamily(&notosans18RegularFont, &notosans18BoldFont, &notosans18ItalicFont,
-                                   &notosans18BoldItalicFont);
-
-EpdFont opendyslexic8RegularFont(&opendyslexic_8_regular);
-EpdFont opendyslexic8BoldFont(&opendyslexic_8_bold);
-EpdFont opendyslexic8ItalicFont(&opendyslexic_8_italic);
-EpdFont opendyslexic8BoldItalicFont(&opendyslexic_8_bolditalic);
-EpdFontFamily opendyslexic8FontFamily(&opendyslexic8RegularFont, &opendyslexic8BoldFont, &opendyslexic8ItalicFont,
-                                      &opendyslexic8BoldItalicFont);
-EpdFont opendyslexic10RegularFont(&opendyslexic_10_regular);
-EpdFont opendyslexic10BoldFont(&opendyslexic_10_bold);
-EpdFont opendyslexic10ItalicFont(&opendyslexic_10_italic);
-EpdFont opendyslexic10BoldItalicFont(&opendyslexic_10_bolditalic);
-EpdFontFamily opendyslexic10FontFamily(&opendyslexic10RegularFont, &opendyslexic10BoldFont, &opendyslexic10ItalicFont,
-                                       &opendyslexic10BoldItalicFont);
-EpdFont opendyslexic12RegularFont(&opendyslexic_12_regular);
-EpdFont opendyslexic12BoldFont(&opendyslexic_12_bold);
-EpdFont opendyslexic12ItalicFont(&opendyslexic_12_italic);
-EpdFont opendyslexic12BoldItalicFont(&opendyslexic_12_bolditalic);
-EpdFontFamily opendyslexic12FontFamily(&opendyslexic12RegularFont, &opendyslexic12BoldFont, &opendyslexic12ItalicFont,
-                                       &opendyslexic12BoldItalicFont);
-EpdFont opendyslexic14RegularFont(&opendyslexic_14_regular);
-EpdFont opendyslexic14BoldFont(&opendyslexic_14_bold);
-EpdFont opendyslexic14ItalicFont(&opendyslexic_14_italic);
-EpdFont opendyslexic14BoldItalicFont(&opendyslexic_14_bolditalic);
-EpdFontFamily opendyslexic14FontFamily(&opendyslexic14RegularFont, &opendyslexic14BoldFont, &opendyslexic14ItalicFont,
-                                       &opendyslexic14BoldItalicFont);
-#endif  // OMIT_FONTS
-
-EpdFont smallFont(&notosans_8_regular);
-EpdFontFamily smallFontFamily(&smallFont);
-
-EpdFont ui10RegularFont(&ubuntu_10_regular);
-EpdFont ui10BoldFont(&ubuntu_10_bold);
-EpdFontFamily ui10FontFamily(&ui10RegularFont, &ui10BoldFont);
-
-EpdFont ui12RegularFont(&ubuntu_12_regular);
-EpdFont ui12BoldFont(&ubuntu_12_bold);
-EpdFontFamily ui12FontFamily(&ui12RegularFont, &ui12BoldFont);
+// Below this charge reading progress is written right after every page turn
+constexpr uint16_t LOW_BATTERY_PERCENT = 5;
 
 // measurement of power button press duration calibration value
 unsigned long t1 = 0;
@@ -130,11 +49,14 @@ void exitActivity() {
     currentActivity->onExit();
     delete currentActivity;
     currentActivity = nullptr;
+    heapwatch::exitActivity();
+    heapwatch::saveToFile();
   }
 }
 
 void enterNewActivity(Activity* activity) {
   currentActivity = activity;
+  heapwatch::enterActivity(activity->getName());
   currentActivity->onEnter();
 }
 
@@ -192,8 +114,22 @@ void waitForPowerRelease() {
 
 // Enter deep sleep mode
 void enterDeepSleep() {
+  // Asked before the reader exits; its page stays in the frame buffer until the sleep screen is drawn
+  const bool pageOnScreen = currentActivity && currentActivity->showsResumablePage();
   exitActivity();
+  // The reader flushes its progress as it exits, this catches any other writer
+  PROGRESS_JOURNAL.flush();
+  if (pageOnScreen) {
+    resume::saveSnapshot(display.getFrameBuffer(), HalDisplay::BUFFER_SIZE, APP_STATE.openEpubPath);
+  } else {
+    resume::discardSnapshot();
+  }
   enterNewActivity(new SleepActivity(renderer, mappedInputManager));
+  // RAM is lost in deep sleep, keep the session's timings and the sleep screen's heap use on the card
+  trace::saveToFile();
+  heapwatch::exitActivity();
+  heapwatch::saveToFile();
+  logUsedFonts(renderer);
 
   display.deepSleep();
   Serial.printf("[%lu] [   ] Power button press calibration value: %lu ms\n", millis(), t2 - t1);
@@ -242,30 +178,28 @@ void onGoHome() {
                                     onGoToFileTransfer, onGoToBrowser));
 }
 
-void setupDisplayAndFonts() {
+void setupDisplay() {
   display.begin();
   Serial.printf("[%lu] [   ] Display initialized\n", millis());
-  renderer.insertFont(BOOKERLY_14_FONT_ID, bookerly14FontFamily);
-#ifndef OMIT_FONTS
-  renderer.insertFont(BOOKERLY_12_FONT_ID, bookerly12FontFamily);
-  renderer.insertFont(BOOKERLY_16_FONT_ID, bookerly16FontFamily);
-  renderer.insertFont(BOOKERLY_18_FONT_ID, bookerly18FontFamily);
-
-  renderer.insertFont(NOTOSANS_12_FONT_ID, notosans12FontFamily);
-  renderer.insertFont(NOTOSANS_14_FONT_ID, notosans14FontFamily);
-  renderer.insertFont(NOTOSANS_16_FONT_ID, notosans16FontFamily);
-  renderer.insertFont(NOTOSANS_18_FONT_ID, notosans18FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_8_FONT_ID, opendyslexic8FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_10_FONT_ID, opendyslexic10FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_12_FONT_ID, opendyslexic12FontFamily);
-  renderer.insertFont(OPENDYSLEXIC_14_FONT_ID, opendyslexic14FontFamily);
-#endif  // OMIT_FONTS
-  renderer.insertFont(UI_10_FONT_ID, ui10FontFamily);
-  renderer.insertFont(UI_12_FONT_ID, ui12FontFamily);
-  renderer.insertFont(SMALL_FONT_ID, smallFontFamily);
+}
+
+void setupRendererFonts() {
+  setupFonts(renderer);
   Serial.printf("[%lu] [   ] Fonts setup\n", millis());
 }
 
+// Puts the page the reader showed before sleep back on the panel, ahead of the fonts and the book. Returns whether it
+// did, in which case the boot screen is skipped and the reader draws the same page over it once it has opened.
+bool showResumeSnapshot() {
+  if (APP_STATE.openEpubPath.empty() ||
+      !resume::loadSnapshot(display.getFrameBuffer(), HalDisplay::BUFFER_SIZE, APP_STATE.openEpubPath)) {
+    return false;
+  }
+  display.displayBuffer(HalDisplay::HALF_REFRESH);
+  Serial.printf("[%lu] [   ] Showing the page from before sleep\n", millis());
+  return true;
+}
+
 void setup() {
   t1 = millis();
 
@@ -285,14 +219,14 @@ void setup() {
   // We need 6 open files concurrently when parsing a new chapter
   if (!SdMan.begin()) {
     Serial.printf("[%lu] [   ] SD card initialization failed\n", millis());
-    setupDisplayAndFonts();
+    setupDisplay();
+    setupRendererFonts();
     exitActivity();
     enterNewActivity(new FullScreenMessageActivity(renderer, mappedInputManager, "SD card error", EpdFontFamily::BOLD));
     return;
   }
 
   SETTINGS.loadFromFile();
-  KOREADER_STORE.loadFromFile();
 
   if (gpio.isWakeupByPowerButton()) {
     // For normal wakeups, verify power button press duration
@@ -303,12 +237,19 @@ void setup() {
   // First serial output only here to avoid timing inconsistencies for power button press duration verification
   Serial.printf("[%lu] [   ] Starting CrossPoint version " CROSSPOINT_VERSION "\n", millis());
 
-  setupDisplayAndFonts();
+  APP_STATE.loadFromFile();
+  setupDisplay();
+  const bool resumed = showResumeSnapshot();
+  // Everything not needed for the snapshot comes after it
+  KOREADER_STORE.loadFromFile();
+  heapwatch::loadFromFile();
+  setupRendererFonts();
 
   exitActivity();
-  enterNewActivity(new BootActivity(renderer, mappedInputManager));
+  if (!resumed) {
+    enterNewActivity(new BootActivity(renderer, mappedInputManager));
+  }
 
-  APP_STATE.loadFromFile();
   RECENT_BOOKS.loadFromFile();
 
   if (APP_STATE.openEpubPath.empty()) {
@@ -321,6 +262,10 @@ void setup() {
     APP_STATE.saveToFile();
     onGoToReader(path, MyLibraryActivity::Tab::Recent);
   }
+  // Only good for this wake, the next sleep saves a new one
+  if (resumed) {
+    resume::discardSnapshot();
+  }
 
   // Ensure we're not still holding the power button before leaving setup
   waitForPowerRelease();
@@ -330,12 +275,32 @@ void loop() {
   static unsigned long maxLoopDuration = 0;
   const unsigned long loopStartTime = millis();
   static unsigned long lastMemPrint = 0;
+  static unsigned long lastHeapSample = 0;
 
   gpio.update();
 
+  if (millis() - lastHeapSample >= 1000) {
+    heapwatch::sample();
+    lastHeapSample = millis();
+  }
+
+  // Reading progress waits in RAM after a page turn; on a low battery it goes to the card at once
+  static unsigned long lastBatteryCheck = 0;
+  static bool lowBattery = false;
+  if (millis() - lastBatteryCheck >= 10000) {
+    lowBattery = battery.readPercentage() <= LOW_BATTERY_PERCENT;
+    lastBatteryCheck = millis();
+  }
+  if (lowBattery) {
+    PROGRESS_JOURNAL.flush();
+  } else {
+    PROGRESS_JOURNAL.flushIfDue(millis());
+  }
+
   if (Serial && millis() - lastMemPrint >= 10000) {
-    Serial.printf("[%lu] [MEM] Free: %d bytes, Total: %d bytes, Min Free: %d bytes\n", millis(), ESP.getFreeHeap(),
-                  ESP.getHeapSize(), ESP.getMinFreeHeap());
+    Serial.printf("[%lu] [MEM] Free: %d bytes, Total: %d bytes, Min Free: %d bytes, Largest block: %d bytes\n",
+                  millis(), ESP.getFreeHeap(), ESP.getHeapSize(), ESP.getMinFreeHeap(),
+                  heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
     lastMemPrint = millis();
   }
 
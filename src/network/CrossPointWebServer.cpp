@@ -3,7 +3,9 @@
 #include <ArduinoJson.h>
 #include <Epub.h>
 #include <FsHelpers.h>
+#include <HeapWatch.h>
 #include <SDCardManager.h>
+#include <Trace.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
 
@@ -101,6 +103,11 @@ void CrossPointWebServer::begin() {
 
   server->on("/api/status", HTTP_GET, [this] { handleStatus(); });
   server->on("/api/files", HTTP_GET, [this] { handleFileListData(); });
+  server->on("/api/trace", HTTP_GET, [this] { handleTrace(); });
+  server->on("/api/trace/save", HTTP_POST, [this] { handleTraceSave(); });
+  server->on("/api/trace/reset", HTTP_POST, [this] { handleTraceReset(); });
+  server->on("/api/heap", HTTP_GET, [this] { handleHeap(); });
+  server->on("/api/heap/reset", HTTP_POST, [this] { handleHeapReset(); });
   server->on("/download", HTTP_GET, [this] { handleDownload(); });
 
   // Upload endpoint with special handling for multipart form data
@@ -279,6 +286,32 @@ void CrossPointWebServer::handleStatus() const {
   server->send(200, "application/json", json);
 }
 
+void CrossPointWebServer::handleTrace() const { server->send(200, "application/json", trace::toJson().c_str()); }
+
+void CrossPointWebServer::handleTraceSave() const {
+  if (!trace::saveToFile()) {
+    server->send(500, "text/plain", "Failed to save trace");
+    return;
+  }
+  server->send(200, "text/plain", trace::DEFAULT_PATH);
+}
+
+void CrossPointWebServer::handleTraceReset() const {
+  trace::reset();
+  server->send(200, "text/plain", "Trace cleared");
+}
+
+void CrossPointWebServer::handleHeap() const { server->send(200, "application/json", heapwatch::toJson().c_str()); }
+
+void CrossPointWebServer::handleHeapReset() const {
+  heapwatch::reset();
+  if (!heapwatch::saveToFile()) {
+    server->send(500, "text/plain", "Failed to clear heap records");
+    return;
+  }
+  server->send(200, "text/plain", "Heap records cleared");
+}
+
 void CrossPointWebServer::scanFiles(const char* path, const std::function<void(FileInfo)>& callback) const {
   FsFile root = SdMan.open(path);
   if (!root) {
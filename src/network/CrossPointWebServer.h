@@ -71,6 +71,11 @@ class CrossPointWebServer {
   void handleRoot() const;
   void handleNotFound() const;
   void handleStatus() const;
+  void handleTrace() const;
+  void handleTraceSave() const;
+  void handleTraceReset() const;
+  void handleHeap() const;
+  void handleHeapReset() const;
   void handleFileList() const;
   void handleFileListData() const;
   void handleDownload() const;
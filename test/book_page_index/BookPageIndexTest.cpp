@@ -0,0 +1,192 @@
+// Indexes the pages of a book a chapter at a time the way the reader's background worker does, stopping part way as if
+// the device slept and picking up again from a fresh index. Checks every chapter's page count matches its section
+// file, that a cancelled build records nothing, that a finished index answers without any SD I/O, and that an index
+// for another layout or a different spine starts over.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <TestEpub.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub.h"
+#include "lib/Epub/Epub/BookPageIndex.h"
+#include "lib/Epub/Epub/Section.h"
+#include "lib/Epub/Epub/blocks/TextBlock.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* CACHE_DIR = "/cache";
+constexpr int CHAPTERS = 6;
+constexpr uint16_t VIEWPORT_WIDTH = 464;
+constexpr uint16_t VIEWPORT_HEIGHT = 740;
+
+bool indexNext(BookPageIndex& index, GfxRenderer& renderer, const uint16_t viewportWidth,
+               const std::function<bool()>& abortFn = nullptr) {
+  return index.indexNextChapter(renderer, FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, viewportWidth, VIEWPORT_HEIGHT,
+                                true, abortFn);
+}
+
+// The profile directory the reader would get for a layout, from the section it opens
+std::string profileDirFor(const std::shared_ptr<Epub>& epub, GfxRenderer& renderer, const uint16_t viewportWidth) {
+  Section section(epub, 0, renderer);
+  section.loadSectionFile(FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, viewportWidth, VIEWPORT_HEIGHT, true);
+  return section.getProfileDir();
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/book_page_index_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir(CACHE_DIR);
+  if (!test_epub::writeEpub(std::string(dir) + EPUB_PATH,
+                            {.title = "Page Index", .chapters = CHAPTERS, .paragraphs = 20, .paragraphsStep = 30})) {
+    std::cerr << "Could not write test book\n";
+    return 1;
+  }
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+
+  auto epub = std::make_shared<Epub>(EPUB_PATH, CACHE_DIR);
+  if (!epub->load()) {
+    std::cerr << "Could not load test book\n";
+    return 1;
+  }
+  int failures = 0;
+  const std::string profileDir = profileDirFor(epub, renderer, VIEWPORT_WIDTH);
+
+  // A cancelled build records nothing
+  {
+    BookPageIndex index(epub, profileDir);
+    index.load();
+    if (indexNext(index, renderer, VIEWPORT_WIDTH, [] { return true; }) || index.firstMissing() != 0) {
+      std::cerr << "FAIL cancelled build recorded a page count\n";
+      failures++;
+    }
+  }
+
+  // Two chapters, then the session ends
+  const auto start = std::chrono::steady_clock::now();
+  {
+    BookPageIndex index(epub, profileDir);
+    index.load();
+    for (int i = 0; i < 2; i++) {
+      if (!indexNext(index, renderer, VIEWPORT_WIDTH)) {
+        std::cerr << "FAIL chapter " << i << " was not indexed\n";
+        failures++;
+      }
+    }
+  }
+
+  // The next session carries on where the last stopped
+  BookPageIndex index(epub, profileDir);
+  index.load();
+  if (index.firstMissing() != 2 || index.isComplete()) {
+    std::cerr << "FAIL index resumed at chapter " << index.firstMissing() << ", expected 2\n";
+    failures++;
+  }
+  int rounds = 0;
+  while (indexNext(index, renderer, VIEWPORT_WIDTH)) rounds++;
+  const double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (rounds != CHAPTERS - 2 || !index.isComplete()) {
+    std::cerr << "FAIL resumed index took " << rounds << " rounds, expected " << CHAPTERS - 2 << "\n";
+    failures++;
+  }
+
+  uint32_t expectedTotal = 0;
+  for (int spine = 0; spine < CHAPTERS; spine++) {
+    Section section(epub, spine, renderer);
+    if (!section.loadSectionFile(FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, true)) {
+      std::cerr << "FAIL chapter " << spine << " has no section file after indexing\n";
+      failures++;
+      continue;
+    }
+    if (index.pagesBefore(spine) != expectedTotal) {
+      std::cerr << "FAIL chapter " << spine << " starts after " << index.pagesBefore(spine) << " pages, expected "
+                << expectedTotal << "\n";
+      failures++;
+    }
+    expectedTotal += section.pageCount;
+  }
+  if (index.totalPages() != expectedTotal) {
+    std::cerr << "FAIL " << index.totalPages() << " pages in total, expected " << expectedTotal << "\n";
+    failures++;
+  }
+
+  // Page numbers come from RAM once the index is complete
+  const uint32_t ioBefore = FsFile::ioCount;
+  uint32_t sum = 0;
+  for (int spine = 0; spine <= CHAPTERS; spine++) sum += index.pagesBefore(spine);
+  if (indexNext(index, renderer, VIEWPORT_WIDTH) || FsFile::ioCount != ioBefore || sum == 0) {
+    std::cerr << "FAIL complete index touched the SD card\n";
+    failures++;
+  }
+  {
+    BookPageIndex reloaded(epub, profileDir);
+    if (!reloaded.load() || !reloaded.isComplete() || reloaded.totalPages() != expectedTotal) {
+      std::cerr << "FAIL complete index did not survive a reload\n";
+      failures++;
+    }
+  }
+
+  // Another layout has its own index
+  const std::string wideDir = profileDirFor(epub, renderer, 600);
+  {
+    BookPageIndex wide(epub, wideDir);
+    wide.load();
+    if (wideDir == profileDir || wide.firstMissing() != 0) {
+      std::cerr << "FAIL another layout shared the page index\n";
+      failures++;
+    }
+    // Indexing with a layout other than the index's own records nothing
+    if (indexNext(wide, renderer, VIEWPORT_WIDTH) || wide.firstMissing() != 0) {
+      std::cerr << "FAIL page counts of another layout were recorded\n";
+      failures++;
+    }
+  }
+
+  // An index for a spine of a different length starts over
+  {
+    FsFile file;
+    SdMan.openFileForWrite("TST", profileDir + "/pages.bin", file);
+    const uint8_t damaged[] = {1, 3, 0, 1, 0, 2, 0, 3, 0};
+    file.write(damaged, sizeof(damaged));
+    file.close();
+    BookPageIndex stale(epub, profileDir);
+    if (stale.load() || stale.firstMissing() != 0) {
+      std::cerr << "FAIL index for another spine was used\n";
+      failures++;
+    }
+  }
+
+  printf("%d chapters, %lu pages indexed in %.2f ms\n", CHAPTERS, static_cast<unsigned long>(expectedTotal), indexMs);
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All book page index checks passed\n";
+  return 0;
+}
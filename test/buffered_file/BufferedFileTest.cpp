@@ -0,0 +1,227 @@
+// Writes the same run of pods and strings through the std::ostream, FsFile and buffered FsFile serializers and checks
+// the files are byte-identical, including a writer that starts part way into a sector and strings longer than a
+// sector. Then reads them back through the buffered reader next to std::ifstream, seeking about, and checks every value
+// and position matches. Reports how many SdFat calls each path makes.
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+struct Op {
+  enum Kind { U8, U16, U32, U64, STRING } kind;
+  uint64_t value;
+  std::string text;
+};
+
+std::vector<Op> buildOps(uint32_t seed, const int count) {
+  std::vector<Op> ops;
+  for (int i = 0; i < count; i++) {
+    seed = seed * 1103515245u + 12345u;
+    const auto kind = static_cast<Op::Kind>((seed >> 16) % 5);
+    Op op{kind, (static_cast<uint64_t>(seed) << 29) ^ seed, ""};
+    if (kind == Op::STRING) {
+      // Mostly short, now and then longer than a sector or two
+      const size_t length = (seed >> 8) % 17 == 0 ? 300 + (seed >> 4) % 1500 : (seed >> 4) % 40;
+      for (size_t c = 0; c < length; c++) op.text += static_cast<char>('a' + (c * 7 + seed) % 26);
+    }
+    ops.push_back(op);
+  }
+  return ops;
+}
+
+template <typename Out>
+void writeOps(Out& out, const std::vector<Op>& ops) {
+  for (const auto& op : ops) {
+    switch (op.kind) {
+      case Op::U8:
+        serialization::writePod(out, static_cast<uint8_t>(op.value));
+        break;
+      case Op::U16:
+        serialization::writePod(out, static_cast<uint16_t>(op.value));
+        break;
+      case Op::U32:
+        serialization::writePod(out, static_cast<uint32_t>(op.value));
+        break;
+      case Op::U64:
+        serialization::writePod(out, op.value);
+        break;
+      case Op::STRING:
+        serialization::writeString(out, op.text);
+        break;
+    }
+  }
+}
+
+template <typename In>
+bool readOp(In& in, const Op& op) {
+  switch (op.kind) {
+    case Op::U8: {
+      uint8_t v = 0;
+      serialization::readPod(in, v);
+      return v == static_cast<uint8_t>(op.value);
+    }
+    case Op::U16: {
+      uint16_t v = 0;
+      serialization::readPod(in, v);
+      return v == static_cast<uint16_t>(op.value);
+    }
+    case Op::U32: {
+      uint32_t v = 0;
+      serialization::readPod(in, v);
+      return v == static_cast<uint32_t>(op.value);
+    }
+    case Op::U64: {
+      uint64_t v = 0;
+      serialization::readPod(in, v);
+      return v == op.value;
+    }
+    case Op::STRING: {
+      std::string s;
+      serialization::readString(in, s);
+      return s == op.text;
+    }
+  }
+  return false;
+}
+
+std::vector<char> fileBytes(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/buffered_file_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  const std::string root = dir;
+  const auto ops = buildOps(7, 5000);
+  int failures = 0;
+
+  // Reference through std::ofstream
+  {
+    std::ofstream out(root + "/stream.bin", std::ios::binary);
+    writeOps(out, ops);
+  }
+
+  FsFile file;
+  SdMan.openFileForWrite("TST", "/direct.bin", file);
+  uint32_t before = FsFile::writeCount;
+  writeOps(file, ops);
+  const uint32_t directWrites = FsFile::writeCount - before;
+  file.close();
+
+  SdMan.openFileForWrite("TST", "/buffered.bin", file);
+  before = FsFile::writeCount;
+  {
+    serialization::BufferedFileWriter writer(file);
+    writeOps(writer, ops);
+    if (!writer.flush() || writer.position() != file.position()) {
+      std::cerr << "FAIL buffered writer position does not match the file\n";
+      failures++;
+    }
+  }
+  const uint32_t bufferedWrites = FsFile::writeCount - before;
+  file.close();
+
+  // A writer taking over part way into a sector, as the section LUT does after the pages
+  SdMan.openFileForWrite("TST", "/offset.bin", file);
+  const uint8_t lead[5] = {1, 2, 3, 4, 5};
+  file.write(lead, sizeof(lead));
+  {
+    serialization::BufferedFileWriter writer(file);
+    writeOps(writer, ops);
+  }
+  file.close();
+
+  const auto reference = fileBytes(root + "/stream.bin");
+  if (fileBytes(root + "/direct.bin") != reference) {
+    std::cerr << "FAIL direct FsFile output differs from std::ofstream\n";
+    failures++;
+  }
+  if (fileBytes(root + "/buffered.bin") != reference) {
+    std::cerr << "FAIL buffered FsFile output differs from std::ofstream\n";
+    failures++;
+  }
+  auto offset = fileBytes(root + "/offset.bin");
+  if (offset.size() != reference.size() + sizeof(lead) ||
+      !std::equal(reference.begin(), reference.end(), offset.begin() + sizeof(lead))) {
+    std::cerr << "FAIL buffered output after an unaligned start differs from std::ofstream\n";
+    failures++;
+  }
+
+  // Read back in order, recording where each value starts
+  std::vector<uint32_t> starts;
+  SdMan.openFileForRead("TST", "/buffered.bin", file);
+  before = FsFile::ioCount;
+  {
+    serialization::BufferedFileReader reader(file);
+    std::ifstream in(root + "/stream.bin", std::ios::binary);
+    for (size_t i = 0; i < ops.size(); i++) {
+      starts.push_back(reader.position());
+      if (reader.position() != static_cast<uint32_t>(in.tellg()) || !readOp(reader, ops[i]) || !readOp(in, ops[i])) {
+        std::cerr << "FAIL sequential read of value " << i << " does not match\n";
+        failures++;
+        break;
+      }
+    }
+  }
+  const uint32_t bufferedReads = FsFile::ioCount - before;
+  file.close();
+
+  SdMan.openFileForRead("TST", "/direct.bin", file);
+  before = FsFile::ioCount;
+  for (const auto& op : ops) readOp(file, op);
+  const uint32_t directReads = FsFile::ioCount - before;
+  file.close();
+
+  // Jump about, backwards, within the block and far away, the way the book.bin passes do
+  SdMan.openFileForRead("TST", "/buffered.bin", file);
+  {
+    serialization::BufferedFileReader reader(file);
+    uint32_t seed = 3;
+    for (int i = 0; i < 2000; i++) {
+      seed = seed * 1103515245u + 12345u;
+      const size_t index = i % 3 == 0 ? (seed >> 8) % ops.size() : (seed >> 8) % 8;
+      const int run = 1 + seed % 5;
+      reader.seek(starts[index]);
+      for (int r = 0; r < run && index + r < ops.size(); r++) {
+        if (reader.position() != starts[index + r] || !readOp(reader, ops[index + r])) {
+          std::cerr << "FAIL read after seeking to value " << index << " does not match\n";
+          failures++;
+          i = 2000;
+          break;
+        }
+      }
+    }
+  }
+  file.close();
+
+  printf("%zu values, %zu bytes: %u writes and %u reads/seeks direct, %u writes and %u reads buffered\n", ops.size(),
+         reference.size(), directWrites, directReads, bufferedWrites, bufferedReads);
+  const uint32_t sectors = (reference.size() + serialization::FILE_BLOCK_SIZE - 1) / serialization::FILE_BLOCK_SIZE;
+  if (bufferedWrites > sectors || bufferedReads > sectors + 1) {
+    std::cerr << "FAIL buffered I/O is not a call per sector\n";
+    failures++;
+  }
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All buffered file checks passed\n";
+  return 0;
+}
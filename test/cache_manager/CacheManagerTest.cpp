@@ -0,0 +1,214 @@
+// Runs the cache manager against a fake filesystem holding a few book caches, opening books the way ReaderActivity
+// does. Checks section files of the least recently read books are evicted before whole books, that the open book is
+// never touched and recent books keep their progress.bin, and that only books opened since the last check are
+// measured again, and that a failed listing of the cache directory leaves the index as it was.
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CacheManager.h"
+
+namespace {
+constexpr const char* CACHE_DIR = "/.crosspoint";
+constexpr uint64_t BOOK_BYTES = 100000;
+constexpr uint64_t COVER_BYTES = 20000;
+constexpr uint64_t PROGRESS_BYTES = 16;
+constexpr uint64_t SECTION_BYTES = 200000;
+constexpr uint64_t PROFILES_BYTES = 10;
+constexpr uint64_t SECTIONS_BYTES = SECTION_BYTES + PROFILES_BYTES;
+constexpr uint64_t EPUB_BYTES = BOOK_BYTES + COVER_BYTES + PROGRESS_BYTES + SECTIONS_BYTES;
+
+class FakeStorage final : public CacheStorage {
+ public:
+  struct Node {
+    bool isDirectory;
+    std::vector<uint8_t> data;
+    uint64_t size;
+  };
+  std::map<std::string, Node> nodes;
+  std::vector<std::string> listed;
+  std::vector<std::string> removed;
+  // Makes every listing fail, as on an SD hiccup
+  bool failLists = false;
+
+  void addDir(const std::string& path) { nodes[path] = {true, {}, 0}; }
+  void addFile(const std::string& path, const uint64_t size) { nodes[path] = {false, {}, size}; }
+  bool exists(const std::string& path) const { return nodes.count(path) != 0; }
+
+  bool list(const std::string& dir, std::vector<Entry>& entries) override {
+    listed.push_back(dir);
+    entries.clear();
+    if (failLists || !exists(dir) || !nodes[dir].isDirectory) return false;
+    const auto prefix = dir + "/";
+    for (const auto& [path, node] : nodes) {
+      if (path.rfind(prefix, 0) == 0 && path.find('/', prefix.size()) == std::string::npos) {
+        entries.push_back({path.substr(prefix.size()), node.isDirectory, node.size});
+      }
+    }
+    return true;
+  }
+
+  bool readFile(const std::string& path, std::vector<uint8_t>& data) override {
+    if (!exists(path)) return false;
+    data = nodes[path].data;
+    return true;
+  }
+
+  bool writeFile(const std::string& path, const std::vector<uint8_t>& data) override {
+    nodes[path] = {false, data, data.size()};
+    return true;
+  }
+
+  bool removeFile(const std::string& path) override {
+    removed.push_back(path);
+    return nodes.erase(path) != 0;
+  }
+
+  bool removeDir(const std::string& path) override {
+    const auto prefix = path + "/";
+    for (auto it = nodes.begin(); it != nodes.end();) {
+      if (it->first == path || it->first.rfind(prefix, 0) == 0) {
+        removed.push_back(it->first);
+        it = nodes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return true;
+  }
+};
+
+std::string cachePath(const std::string& bookPath) {
+  return std::string(CACHE_DIR) + "/epub_" + std::to_string(std::hash<std::string>{}(bookPath));
+}
+
+void addEpubCache(FakeStorage& storage, const std::string& path) {
+  storage.addDir(path);
+  storage.addFile(path + "/book.bin", BOOK_BYTES);
+  storage.addFile(path + "/cover.bmp", COVER_BYTES);
+  storage.addFile(path + "/progress.bin", PROGRESS_BYTES);
+  storage.addDir(path + "/sections");
+  storage.addFile(path + "/sections/profiles.bin", PROFILES_BYTES);
+  storage.addDir(path + "/sections/0badf00d");
+  storage.addFile(path + "/sections/0badf00d/0.bin", SECTION_BYTES);
+}
+
+// Opens a book the way ReaderActivity does
+void openBook(FakeStorage& storage, const std::string& bookPath, const uint64_t limit,
+              const std::vector<std::string>& recent) {
+  CacheManager cache(storage, CACHE_DIR);
+  cache.touch(cachePath(bookPath));
+  cache.enforceLimit(limit, cachePath(bookPath), recent);
+}
+
+uint64_t storedBytes(const FakeStorage& storage, const std::string& dir) {
+  uint64_t bytes = 0;
+  for (const auto& [path, node] : storage.nodes) {
+    if (path.rfind(dir + "/", 0) == 0) bytes += node.size;
+  }
+  return bytes;
+}
+}  // namespace
+
+int main() {
+  FakeStorage storage;
+  int failures = 0;
+  auto check = [&failures](const bool ok, const char* what) {
+    if (!ok) {
+      std::cerr << "FAIL " << what << "\n";
+      failures++;
+    }
+  };
+
+  storage.addDir(CACHE_DIR);
+  storage.addFile(std::string(CACHE_DIR) + "/settings.bin", 300);
+  storage.addDir(std::string(CACHE_DIR) + "/fonts");
+  storage.addFile(std::string(CACHE_DIR) + "/fonts/custom.bin", 5000000);
+  // A book cache from before the index
+  const std::string orphan = std::string(CACHE_DIR) + "/epub_1234";
+  addEpubCache(storage, orphan);
+
+  const std::vector<std::string> books = {"/Books/a.epub", "/Books/b.epub", "/Books/c.epub", "/Books/d.epub",
+                                          "/Books/e.epub"};
+  for (const auto& book : books) {
+    addEpubCache(storage, cachePath(book));
+    openBook(storage, book, 0, {});
+  }
+  const std::string& open = books[4];
+  const std::vector<std::string> recent = {books[4], books[0], books[1]};
+
+  // Just over the limit: the oldest books lose their section files, the caches from before the index first
+  storage.removed.clear();
+  openBook(storage, open, 6 * EPUB_BYTES - SECTIONS_BYTES - 1, recent);
+  check(!storage.exists(orphan + "/sections"), "section files of the oldest cache were kept");
+  check(!storage.exists(cachePath(books[0]) + "/sections"), "section files of the oldest book were kept");
+  check(storage.exists(cachePath(books[1]) + "/sections"), "section files evicted beyond the limit");
+  check(storage.exists(orphan + "/book.bin"), "whole book evicted before other books' section files");
+
+  // Well over the limit: whole books go oldest first, recent books keep their progress
+  storage.removed.clear();
+  const uint64_t limit = EPUB_BYTES + 2 * PROGRESS_BYTES + (EPUB_BYTES - SECTIONS_BYTES);
+  openBook(storage, open, limit, recent);
+  check(!storage.exists(orphan), "oldest book cache was kept");
+  check(!storage.exists(cachePath(books[2])), "least recently read book was kept");
+  check(storage.exists(cachePath(books[3]) + "/book.bin"), "evicted more books than needed");
+  check(!storage.exists(cachePath(books[3]) + "/sections"), "whole books evicted before section files");
+  for (const int i : {0, 1}) {
+    check(storage.exists(cachePath(books[i]) + "/progress.bin"), "recent book lost its progress");
+    check(storedBytes(storage, cachePath(books[i])) == PROGRESS_BYTES, "recent book kept more than its progress");
+  }
+  for (const auto& path : storage.removed) {
+    check(path.rfind(cachePath(open), 0) != 0, "open book was touched");
+    check(path.find("progress.bin") == std::string::npos || path.rfind(orphan, 0) == 0 ||
+              path.rfind(cachePath(books[2]), 0) == 0,
+          "progress of a recent book was removed");
+  }
+  check(storedBytes(storage, cachePath(open)) == EPUB_BYTES, "open book lost files");
+  check(storage.exists(std::string(CACHE_DIR) + "/settings.bin") &&
+            storage.exists(std::string(CACHE_DIR) + "/fonts/custom.bin"),
+        "files that are not book caches were removed");
+
+  CacheManager index(storage, CACHE_DIR);
+  index.enforceLimit(0, cachePath(open), recent);
+  uint64_t booksBytes = 0;
+  for (const auto& book : books) booksBytes += storedBytes(storage, cachePath(book));
+  check(index.getBooks().size() == 4, "index does not match the book caches left");
+  check(index.getTotalBytes() == booksBytes && booksBytes <= limit, "index sizes do not match the book caches");
+
+  // Only the book opened now and the one open last time are measured again
+  storage.listed.clear();
+  openBook(storage, books[3], 0, recent);
+  for (const auto& dir : storage.listed) {
+    check(dir == CACHE_DIR || dir.rfind(cachePath(books[3]), 0) == 0 || dir.rfind(cachePath(open), 0) == 0,
+          "book cache measured again without being opened");
+  }
+
+  // A damaged index is rebuilt from the cache directory
+  storage.writeFile(std::string(CACHE_DIR) + "/cache.bin", {1, 2, 3});
+  CacheManager rebuilt(storage, CACHE_DIR);
+  rebuilt.enforceLimit(0, cachePath(open), recent);
+  check(rebuilt.getBooks().size() == 4 && rebuilt.getTotalBytes() == booksBytes, "damaged index was not rebuilt");
+
+  // A listing that fails once must not empty the saved index
+  const auto savedIndex = storage.nodes[std::string(CACHE_DIR) + "/cache.bin"].data;
+  storage.failLists = true;
+  CacheManager unlisted(storage, CACHE_DIR);
+  unlisted.touch(cachePath(open));
+  check(!unlisted.enforceLimit(0, cachePath(open), recent), "failed listing not reported");
+  storage.failLists = false;
+  check(storage.nodes[std::string(CACHE_DIR) + "/cache.bin"].data == savedIndex, "failed listing changed the index");
+  CacheManager relisted(storage, CACHE_DIR);
+  relisted.enforceLimit(0, cachePath(open), recent);
+  check(relisted.getBooks().size() == 4, "books dropped after a failed listing");
+
+  printf("%zu book caches, %llu bytes after eviction with a %llu byte limit\n", index.getBooks().size(),
+         static_cast<unsigned long long>(booksBytes), static_cast<unsigned long long>(limit));
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All cache manager checks passed\n";
+  return 0;
+}
@@ -0,0 +1,220 @@
+// Checks that parsing a chapter straight out of the EPUB zip produces exactly the same serialized pages as the old
+// path that first inflated the chapter into a temp file on the SD card and parsed that file.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <ZipFile.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <miniz.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+#include "lib/Epub/Epub/parsers/ChapterHtmlSlimParser.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* DEFLATED_ENTRY = "OEBPS/chapter.xhtml";
+constexpr const char* STORED_ENTRY = "OEBPS/stored.xhtml";
+
+struct LayoutParams {
+  const char* name;
+  uint8_t paragraphAlignment;
+  bool extraParagraphSpacing;
+  bool hyphenationEnabled;
+};
+
+// Deterministic chapter large enough to wrap the 32KB inflate dictionary several times
+std::string buildChapter(const size_t paragraphs) {
+  static const char* const kWords[] = {
+      "the",         "reader",      "turned",     "another",       "page",       "and",        "found",
+      "nothing",     "but",         "footnotes",  "extraordinary", "characters", "wandering",  "through",
+      "hyphenation", "considerable", "distance",  "between",       "lighthouse", "morning",    "a",
+      "of",          "was",         "remarkable", "straightforward", "notwithstanding", "it",  "quietly"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>T</title>"
+      "</head><body>\n";
+  uint32_t seed = 12345;
+  for (size_t p = 0; p < paragraphs; p++) {
+    if (p % 25 == 0) {
+      html += "<h2>Chapter " + std::to_string(p / 25 + 1) + "</h2>\n";
+    }
+    html += "<p>";
+    const size_t words = 20 + (seed % 80);
+    for (size_t w = 0; w < words; w++) {
+      seed = seed * 1103515245u + 12345u;
+      const char* word = kWords[(seed >> 16) % kWordCount];
+      if (w > 0) html += ' ';
+      if ((seed >> 8) % 17 == 0) {
+        html += std::string("<b>") + word + "</b>";
+      } else if ((seed >> 8) % 19 == 0) {
+        html += std::string("<i>") + word + "</i>,";
+      } else {
+        html += word;
+      }
+    }
+    html += ".</p>\n";
+  }
+  html += "</body></html>\n";
+  return html;
+}
+
+bool writeEpub(const std::string& path, const std::string& chapter) {
+  mz_zip_archive archive = {};
+  if (!mz_zip_writer_init_file(&archive, path.c_str(), 0)) return false;
+  const bool ok =
+      mz_zip_writer_add_mem(&archive, "mimetype", "application/epub+zip", 20, MZ_NO_COMPRESSION) &&
+      mz_zip_writer_add_mem(&archive, DEFLATED_ENTRY, chapter.data(), chapter.size(), MZ_DEFAULT_LEVEL) &&
+      mz_zip_writer_add_mem(&archive, STORED_ENTRY, chapter.data(), chapter.size(), MZ_NO_COMPRESSION) &&
+      mz_zip_writer_finalize_archive(&archive);
+  mz_zip_writer_end(&archive);
+  return ok;
+}
+
+std::vector<uint8_t> readAll(const char* path) {
+  FsFile file;
+  std::vector<uint8_t> bytes;
+  if (!SdMan.openFileForRead("TST", path, file)) return bytes;
+  bytes.resize(file.size());
+  if (!bytes.empty()) file.read(bytes.data(), bytes.size());
+  return bytes;
+}
+
+// Runs the parser the same way Section::createSectionFile does and returns the serialized pages
+std::vector<uint8_t> layoutPages(GfxRenderer& renderer, const LayoutParams& params,
+                                 const ChapterHtmlSlimParser::ReadFn& readFn, const size_t contentSize,
+                                 const char* outPath) {
+  FsFile out;
+  if (!SdMan.openFileForWrite("TST", outPath, out)) return {};
+  ChapterHtmlSlimParser parser(
+      readFn, contentSize, renderer, FONT_ID, 1.0f, params.extraParagraphSpacing, params.paragraphAlignment, 464, 760,
+      params.hyphenationEnabled, [&out](std::unique_ptr<Page> page) { page->serialize(out); });
+  const bool ok = parser.parseAndBuildPages();
+  out.close();
+  return ok ? readAll(outPath) : std::vector<uint8_t>{};
+}
+
+std::vector<uint8_t> viaTempFile(GfxRenderer& renderer, const LayoutParams& params, const char* entry) {
+  const std::string epubPath = EPUB_PATH;
+  {
+    FsFile tmpHtml;
+    if (!SdMan.openFileForWrite("TST", "/.tmp_0.html", tmpHtml)) return {};
+    if (!ZipFile(epubPath).readFileToStream(entry, tmpHtml, 1024)) return {};
+  }
+
+  FsFile tmpHtml;
+  if (!SdMan.openFileForRead("TST", "/.tmp_0.html", tmpHtml)) return {};
+  const size_t size = tmpHtml.size();
+  auto pages = layoutPages(
+      renderer, params,
+      [&tmpHtml](uint8_t* buf, const size_t len) {
+        const int read = tmpHtml.read(buf, len);
+        return read > 0 ? static_cast<size_t>(read) : 0;
+      },
+      size, "/pages_tmp.bin");
+  SdMan.remove("/.tmp_0.html");
+  return pages;
+}
+
+std::vector<uint8_t> viaInflateReader(GfxRenderer& renderer, const LayoutParams& params, const char* entry) {
+  const std::string epubPath = EPUB_PATH;
+  ZipFile zip(epubPath);
+  ZipFile::InflateReader reader(zip);
+  if (!reader.begin(entry, 1024)) return {};
+  auto pages = layoutPages(
+      renderer, params, [&reader](uint8_t* buf, const size_t len) { return reader.read(buf, len); },
+      reader.getInflatedSize(), "/pages_stream.bin");
+  if (reader.hasFailed() || !reader.isFinished()) return {};
+  return pages;
+}
+
+// Odd read sizes must reassemble to exactly the inflated entry
+bool checkRawStream(const char* entry, const std::string& expected, const size_t readSize) {
+  const std::string epubPath = EPUB_PATH;
+  ZipFile zip(epubPath);
+  ZipFile::InflateReader reader(zip);
+  if (!reader.begin(entry, 1024)) return false;
+  std::string actual;
+  std::vector<uint8_t> buf(readSize);
+  size_t len;
+  while ((len = reader.read(buf.data(), buf.size())) > 0) {
+    actual.append(reinterpret_cast<const char*>(buf.data()), len);
+  }
+  return !reader.hasFailed() && reader.isFinished() && actual == expected;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/chapter_stream_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+
+  const std::string chapter = buildChapter(1200);
+  if (!writeEpub(std::string(dir) + EPUB_PATH, chapter)) {
+    std::cerr << "Could not write test epub\n";
+    return 1;
+  }
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+  Hyphenator::setPreferredLanguage("en");
+
+  int failures = 0;
+  for (const size_t readSize : {1, 7, 1024, 4096, 70000}) {
+    for (const char* entry : {DEFLATED_ENTRY, STORED_ENTRY}) {
+      if (!checkRawStream(entry, chapter, readSize)) {
+        std::cerr << "FAIL raw stream " << entry << " read size " << readSize << "\n";
+        failures++;
+      }
+    }
+  }
+
+  const LayoutParams layouts[] = {
+      {"justified", 0, true, false},
+      {"left+hyphenation", 1, false, true},
+  };
+  for (const auto& params : layouts) {
+    for (const char* entry : {DEFLATED_ENTRY, STORED_ENTRY}) {
+      const auto expected = viaTempFile(renderer, params, entry);
+      const auto actual = viaInflateReader(renderer, params, entry);
+      if (expected.empty() || expected != actual) {
+        std::cerr << "FAIL pages " << params.name << " " << entry << ": temp-file " << expected.size()
+                  << " bytes, streamed " << actual.size() << " bytes\n";
+        failures++;
+      } else {
+        std::cout << "OK   " << params.name << " " << entry << ": " << actual.size() << " bytes of pages from "
+                  << chapter.size() << " bytes of XHTML\n";
+      }
+    }
+  }
+
+  for (const char* file : {EPUB_PATH, "/pages_tmp.bin", "/pages_stream.bin"}) {
+    SdMan.remove(file);
+  }
+  rmdir(dir);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All chapter stream checks passed\n";
+  return 0;
+}
@@ -0,0 +1,228 @@
+// Builds a chapter's section file under several layout settings, once from the recorded chapter tokens and once by
+// inflating and parsing the XHTML, and checks both section files are byte-identical. Also checks damaged token files
+// are rejected and replaced by a fresh parse. Reports the time to rebuild a section each way.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <TestEpub.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <builtinFonts/notosans_16_bold.h>
+#include <builtinFonts/notosans_16_bolditalic.h>
+#include <builtinFonts/notosans_16_italic.h>
+#include <builtinFonts/notosans_16_regular.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub.h"
+#include "lib/Epub/Epub/Section.h"
+#include "lib/Epub/Epub/SectionProfiles.h"
+#include "lib/Epub/Epub/blocks/TextBlock.h"
+
+namespace {
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* CACHE_DIR = "/cache";
+constexpr int ROUNDS = 3;
+
+struct LayoutParams {
+  const char* name;
+  int fontId;
+  float lineCompression;
+  bool extraParagraphSpacing;
+  uint8_t paragraphAlignment;
+  uint16_t viewportWidth;
+  uint16_t viewportHeight;
+  bool hyphenationEnabled;
+};
+
+// Headings, lists, line breaks, placeholders for tables and images, styled words, markup between words and one
+// paragraph long enough to be laid out early
+std::string buildChapter() {
+  static const char* const kWords[] = {
+      "the",     "reader",     "turned",      "another",  "page",            "and",     "found",   "nothing",
+      "but",     "footnotes",  "Übergrößen",  "характер", "lighthouse",      "morning", "a",       "of",
+      "was",     "remarkable", "hyphenation", "it",       "straightforward", "quietly", "déjà-vu", "“quoted”"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>T</title>"
+      "</head><body>\n";
+  uint32_t seed = 1234;
+  const auto next = [&seed] { return seed = seed * 1103515245u + 12345u; };
+  for (int p = 0; p < 500; p++) {
+    if (p % 40 == 0) {
+      html += "<h2>Part " + std::to_string(p / 40 + 1) + "</h2>\n";
+    }
+    if (p % 53 == 7) {
+      html += "<table><tr><td>cell</td></tr></table>\n";
+    }
+    if (p % 61 == 9) {
+      html += p % 2 ? "<img src=\"x.png\" alt=\"A lighthouse\"/>\n" : "<img src=\"y.png\"/>\n";
+    }
+    const bool list = p % 17 == 5;
+    html += list ? "<ul><li>" : "<p>";
+    const size_t words = p == 250 ? 1600 : 10 + next() % 90;
+    for (size_t w = 0; w < words; w++) {
+      const uint32_t r = next();
+      const char* word = kWords[(r >> 16) % kWordCount];
+      if (w > 0) html += (r >> 4) % 41 == 0 ? (list ? "</li><li>" : "<br/>") : " ";
+      if ((r >> 8) % 13 == 0) {
+        html += std::string("<b>") + word + "</b>";
+      } else if ((r >> 8) % 11 == 0) {
+        html += std::string("<i>") + word + "</i>";
+      } else if ((r >> 8) % 29 == 0) {
+        html += std::string("<span>wo</span>") + word;
+      } else {
+        html += word;
+      }
+    }
+    html += list ? ".</li></ul>\n" : ".</p>\n";
+  }
+  return html + "</body></html>\n";
+}
+
+std::vector<char> readFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// The section file of the layout built last, which SectionProfiles lists first
+std::vector<char> readSection(const std::string& root, const std::string& sectionsDir) {
+  const auto list = readFile(root + sectionsDir + "/profiles.bin");
+  if (list.size() < 2 + sizeof(SectionProfiles::Profile)) return {};
+  SectionProfiles::Profile current;
+  memcpy(&current, list.data() + 2, sizeof(current));
+  return readFile(root + SectionProfiles::profileDir(sectionsDir, current.fingerprint) + "/0.bin");
+}
+
+bool buildSection(const std::shared_ptr<Epub>& epub, GfxRenderer& renderer, const LayoutParams& params,
+                  double* ms = nullptr) {
+  Section section(epub, 0, renderer);
+  const auto start = std::chrono::steady_clock::now();
+  const bool ok = section.createSectionFile(params.fontId, params.lineCompression, params.extraParagraphSpacing,
+                                            params.paragraphAlignment, params.viewportWidth, params.viewportHeight,
+                                            params.hyphenationEnabled);
+  if (ms) *ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return ok;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/chapter_tokens_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir(CACHE_DIR);
+  if (!test_epub::writeEpub(std::string(dir) + EPUB_PATH, "Chapter Tokens", {buildChapter()})) {
+    std::cerr << "Could not write test book\n";
+    return 1;
+  }
+
+  EpdFont bookerly(&bookerly_14_regular);
+  EpdFont bookerlyBold(&bookerly_14_bold);
+  EpdFont bookerlyItalic(&bookerly_14_italic);
+  EpdFont bookerlyBoldItalic(&bookerly_14_bolditalic);
+  EpdFont noto(&notosans_16_regular);
+  EpdFont notoBold(&notosans_16_bold);
+  EpdFont notoItalic(&notosans_16_italic);
+  EpdFont notoBoldItalic(&notosans_16_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(1, EpdFontFamily(&bookerly, &bookerlyBold, &bookerlyItalic, &bookerlyBoldItalic));
+  renderer.insertFont(2, EpdFontFamily(&noto, &notoBold, &notoItalic, &notoBoldItalic));
+
+  auto epub = std::make_shared<Epub>(EPUB_PATH, CACHE_DIR);
+  if (!epub->load()) {
+    std::cerr << "Could not load test book\n";
+    return 1;
+  }
+  const std::string sectionsDir = epub->getCachePath() + "/sections";
+  const std::string tokensPath = epub->getCachePath() + "/sections/0.tok";
+  const std::string tokensFile = std::string(dir) + tokensPath;
+
+  const LayoutParams layouts[] = {
+      {"justified", 1, 1.0f, true, TextBlock::JUSTIFIED, 464, 740, true},
+      {"left", 1, 0.95f, false, TextBlock::LEFT_ALIGN, 464, 740, false},
+      {"large font", 2, 1.0f, true, TextBlock::JUSTIFIED, 464, 740, true},
+      {"narrow", 2, 1.2f, false, TextBlock::RIGHT_ALIGN, 300, 500, true},
+      {"centered", 1, 1.0f, true, TextBlock::CENTER_ALIGN, 740, 464, false},
+  };
+
+  // The first build parses the XHTML and records the tokens every other build starts from
+  int failures = 0;
+  if (!buildSection(epub, renderer, layouts[0]) || !SdMan.exists(tokensPath.c_str())) {
+    std::cerr << "FAIL first build did not record chapter tokens\n";
+    return 1;
+  }
+  const auto tokens = readFile(tokensFile);
+
+  for (const auto& params : layouts) {
+    double tokenMs = 0;
+    double parseMs = 0;
+    std::vector<char> fromTokens;
+    std::vector<char> fromXml;
+    for (int round = 0; round < ROUNDS; round++) {
+      if (!buildSection(epub, renderer, params, &tokenMs)) {
+        std::cerr << "FAIL " << params.name << " did not build from tokens\n";
+        failures++;
+      }
+      fromTokens = readSection(dir, sectionsDir);
+
+      SdMan.remove(tokensPath.c_str());
+      if (!buildSection(epub, renderer, params, &parseMs)) {
+        std::cerr << "FAIL " << params.name << " did not build from the XHTML\n";
+        failures++;
+      }
+      fromXml = readSection(dir, sectionsDir);
+    }
+
+    const bool same = !fromXml.empty() && fromTokens == fromXml && readFile(tokensFile) == tokens;
+    if (!same) {
+      failures++;
+    }
+    printf("%-4s %-10s %7zu byte section: parse %7.2f ms, from tokens %7.2f ms (%.1fx)\n", same ? "OK" : "FAIL",
+           params.name, fromXml.size(), parseMs / ROUNDS, tokenMs / ROUNDS, tokenMs > 0 ? parseMs / tokenMs : 0.0);
+  }
+  const auto expected = readSection(dir, sectionsDir);
+  const auto& lastLayout = layouts[sizeof(layouts) / sizeof(layouts[0]) - 1];
+  printf("%zu bytes of tokens\n", tokens.size());
+
+  // Damaged token files are dropped and the chapter parsed again, recording them afresh
+  const auto damage = [&](const char* name, std::vector<char> bytes) {
+    std::ofstream(tokensFile, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+    const bool built = buildSection(epub, renderer, lastLayout);
+    if (!built || readSection(dir, sectionsDir) != expected || readFile(tokensFile) != tokens) {
+      std::cerr << "FAIL " << name << " token file was not replaced by a fresh parse\n";
+      failures++;
+    }
+  };
+  damage("truncated", std::vector<char>(tokens.begin(), tokens.begin() + tokens.size() / 2));
+  damage("unterminated", std::vector<char>(tokens.begin(), tokens.end() - 2));
+  auto versioned = tokens;
+  versioned[0]++;
+  damage("other version", versioned);
+  auto garbled = tokens;
+  garbled[3] = static_cast<char>(0xF7);  // The first token, after the version byte and the chunk length
+  damage("unknown token", garbled);
+  damage("empty", {});
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All chapter token checks passed\n";
+  return 0;
+}
@@ -0,0 +1,143 @@
+# Sourced by the test/run_*.sh scripts: the library sources, include paths and flags every host build shares, so a
+# library file added, moved or split is listed here once. Sources come in layers that each bring the ones they depend
+# on; a script picks the layer its test needs and adds its own files.
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+
+TRACE_SOURCES=(
+  "$ROOT_DIR/lib/Trace/HeapWatch.cpp"
+  "$ROOT_DIR/lib/Trace/Trace.cpp"
+)
+
+ZIP_FILES=(
+  "$ROOT_DIR/lib/ZipFile/ZipFile.cpp"
+)
+ZIP_SOURCES=("${ZIP_FILES[@]}" "${TRACE_SOURCES[@]}")
+
+METADATA_FILES=(
+  "$ROOT_DIR/lib/Epub/Epub/BookMetadataCache.cpp"
+  "$ROOT_DIR/lib/FsHelpers/FsHelpers.cpp"
+)
+METADATA_SOURCES=("${METADATA_FILES[@]}" "${ZIP_SOURCES[@]}")
+
+RENDER_FILES=(
+  "$ROOT_DIR/lib/GfxRenderer/GfxRenderer.cpp"
+  "$ROOT_DIR/lib/GfxRenderer/TextMeasureCache.cpp"
+  "$ROOT_DIR/lib/GfxRenderer/Bitmap.cpp"
+  "$ROOT_DIR/lib/GfxRenderer/BitmapHelpers.cpp"
+  "$ROOT_DIR/lib/EpdFont/EpdAdvanceTable.cpp"
+  "$ROOT_DIR/lib/EpdFont/EpdFont.cpp"
+  "$ROOT_DIR/lib/EpdFont/EpdFontFamily.cpp"
+  "$ROOT_DIR/lib/hal/HalDisplay.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+RENDER_SOURCES=("${RENDER_FILES[@]}" "${TRACE_SOURCES[@]}")
+
+# Laying out words into lines
+TEXT_FILES=(
+  "$ROOT_DIR/lib/Epub/Epub/ParsedText.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/blocks/TextBlock.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+)
+TEXT_SOURCES=("${TEXT_FILES[@]}" "${RENDER_SOURCES[@]}")
+
+# Parsing a chapter's XHTML into pages
+CHAPTER_FILES=(
+  "$ROOT_DIR/lib/Epub/Epub/Page.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/ChapterHtmlSlimParser.cpp"
+)
+CHAPTER_SOURCES=("${CHAPTER_FILES[@]}" "${TEXT_SOURCES[@]}")
+
+EPUB_FILES=(
+  "$ROOT_DIR/lib/Epub/Epub.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/BookPageIndex.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/Section.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/SectionProfiles.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/ContainerParser.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/ContentOpfParser.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/TocNavParser.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/TocNcxParser.cpp"
+  "$ROOT_DIR/lib/JpegToBmpConverter/JpegToBmpConverter.cpp"
+)
+EPUB_SOURCES=("${EPUB_FILES[@]}" "${METADATA_FILES[@]}" "${ZIP_FILES[@]}" "${CHAPTER_SOURCES[@]}")
+
+# The other book formats and what the reader activities need besides the books
+READER_FILES=(
+  "$ROOT_DIR/lib/ProgressJournal/ProgressJournal.cpp"
+  "$ROOT_DIR/lib/Txt/Txt.cpp"
+  "$ROOT_DIR/lib/Xtc/Xtc.cpp"
+  "$ROOT_DIR/lib/Xtc/Xtc/XtcParser.cpp"
+  "$ROOT_DIR/lib/hal/HalGPIO.cpp"
+)
+READER_SOURCES=("${READER_FILES[@]}" "${EPUB_SOURCES[@]}")
+
+# C libraries, compiled once per build directory by compile_c_objects
+ZIP_C_SOURCES=(
+  "$ROOT_DIR/lib/miniz/miniz.c"
+)
+CHAPTER_C_SOURCES=(
+  "$ROOT_DIR/lib/expat/xmlparse.c"
+  "$ROOT_DIR/lib/expat/xmlrole.c"
+  "$ROOT_DIR/lib/expat/xmltok.c"
+)
+EPUB_C_SOURCES=("$ROOT_DIR/lib/picojpeg/picojpeg.c" "${ZIP_C_SOURCES[@]}" "${CHAPTER_C_SOURCES[@]}")
+
+# Mirrors the library-relevant build_flags from platformio.ini
+COMMON_DEFINES=(
+  -DMINIZ_NO_ZLIB_COMPATIBLE_NAMES=1
+  -DXML_GE=0
+  -DXML_CONTEXT_BYTES=1024
+)
+
+# test/host_stubs stands in for the Arduino core and SdFat
+COMMON_INCLUDES=(
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/src"
+  -I"$ROOT_DIR/test/host_stubs"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/Epub"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/FsHelpers"
+  -I"$ROOT_DIR/lib/GfxRenderer"
+  -I"$ROOT_DIR/lib/JpegToBmpConverter"
+  -I"$ROOT_DIR/lib/ProgressJournal"
+  -I"$ROOT_DIR/lib/Serialization"
+  -I"$ROOT_DIR/lib/Trace"
+  -I"$ROOT_DIR/lib/Txt"
+  -I"$ROOT_DIR/lib/Utf8"
+  -I"$ROOT_DIR/lib/Xtc"
+  -I"$ROOT_DIR/lib/ZipFile"
+  -I"$ROOT_DIR/lib/expat"
+  -I"$ROOT_DIR/lib/hal"
+  -I"$ROOT_DIR/lib/miniz"
+  -I"$ROOT_DIR/lib/picojpeg"
+)
+
+# The parsers rely on Arduino.h pulling in <cstdint> and <cstring> on the device
+COMMON_CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -include cstdint
+  -include cstring
+  "${COMMON_DEFINES[@]}"
+  "${COMMON_INCLUDES[@]}"
+)
+
+# Compiles the given C sources into BUILD_DIR, skipping those whose object is up to date, and lists them in OBJECTS.
+# These are the vendored libraries, built as they come, so their warnings are silenced.
+OBJECTS=()
+compile_c_objects() {
+  local src obj
+  for src in "$@"; do
+    obj="$BUILD_DIR/$(basename "$src" .c).o"
+    if [[ ! -f "$obj" || "$src" -nt "$obj" ]]; then
+      cc -O2 -w "${COMMON_DEFINES[@]}" "${COMMON_INCLUDES[@]}" -c "$src" -o "$obj"
+    fi
+    OBJECTS+=("$obj")
+  done
+}
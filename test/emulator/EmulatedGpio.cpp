@@ -0,0 +1,62 @@
+// HalGPIO for the emulator: the buttons are whatever the script last pressed, sampled on each update() as the input
+// manager samples the pins on the device.
+#include <HalGPIO.h>
+
+#include "Emulator.h"
+
+namespace {
+uint8_t requested = 0;
+uint8_t currentState = 0;
+uint8_t previousState = 0;
+unsigned long pressStart = 0;
+unsigned long lastHeldTime = 0;
+}  // namespace
+
+void emulator::setButton(const uint8_t buttonIndex, const bool pressed) {
+  if (pressed) {
+    requested |= 1 << buttonIndex;
+  } else {
+    requested &= ~(1 << buttonIndex);
+  }
+}
+
+void HalGPIO::begin() {}
+
+void HalGPIO::update() {
+  previousState = currentState;
+  currentState = requested;
+  if (currentState && !previousState) {
+    pressStart = millis();
+  }
+  if (!currentState && previousState) {
+    lastHeldTime = millis() - pressStart;
+  }
+}
+
+bool HalGPIO::isPressed(const uint8_t buttonIndex) const { return currentState & (1 << buttonIndex); }
+
+bool HalGPIO::wasPressed(const uint8_t buttonIndex) const {
+  return (currentState & ~previousState) & (1 << buttonIndex);
+}
+
+bool HalGPIO::wasAnyPressed() const { return currentState & ~previousState; }
+
+bool HalGPIO::wasReleased(const uint8_t buttonIndex) const {
+  return (previousState & ~currentState) & (1 << buttonIndex);
+}
+
+bool HalGPIO::wasAnyReleased() const { return previousState & ~currentState; }
+
+// While held, how long so far; once released, how long the last press lasted
+unsigned long HalGPIO::getHeldTime() const { return currentState ? millis() - pressStart : lastHeldTime; }
+
+void HalGPIO::startDeepSleep() {
+  Serial.printf("[%lu] [EMU] Deep sleep requested, stopping\n", millis());
+  exit(0);
+}
+
+int HalGPIO::getBatteryPercentage() const { return 100; }
+
+bool HalGPIO::isUsbConnected() const { return false; }
+
+bool HalGPIO::isWakeupByPowerButton() const { return false; }
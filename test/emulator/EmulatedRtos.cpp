@@ -0,0 +1,241 @@
+// FreeRTOS tasks, mutexes and notifications for the emulator, plus the Arduino clock they run on.
+//
+// Every task is a coroutine on the host's one thread, switched only where the firmware would block: vTaskDelay, a
+// contended mutex or a notification wait. Time only moves when every task is blocked, and then straight to the next
+// wake-up, so a scripted session takes as long as its CPU work and renders the same frames every run. The highest
+// priority task that can run goes first, round robin among equals, as on the device. The only preemption is handing a
+// mutex to a higher priority task waiting for it.
+#include <Arduino.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <ucontext.h>
+
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct EmulatedMutex {
+  EmulatedTask* owner = nullptr;
+};
+
+struct EmulatedTask {
+  enum Wait { NONE, DELAY, NOTIFY, MUTEX };
+
+  std::string name;
+  UBaseType_t priority = 0;
+  TaskFunction_t code = nullptr;
+  void* parameters = nullptr;
+  ucontext_t context{};
+  std::vector<uint8_t> stack;
+  Wait wait = NONE;
+  unsigned long deadline = 0;
+  EmulatedMutex* mutex = nullptr;
+  uint32_t notifications = 0;
+  bool deleted = false;
+};
+
+namespace {
+// Host code needs far more stack than the 8 KB the firmware asks for
+constexpr size_t TASK_STACK_SIZE = 1024 * 1024;
+constexpr unsigned long FOREVER = ULONG_MAX;
+
+unsigned long now = 0;
+std::vector<std::unique_ptr<EmulatedTask>> tasks;
+EmulatedTask* current = nullptr;
+
+EmulatedTask* mainTask() {
+  if (tasks.empty()) {
+    auto task = std::make_unique<EmulatedTask>();
+    task->name = "loopTask";
+    task->priority = 1;
+    current = task.get();
+    tasks.push_back(std::move(task));
+  }
+  return tasks.front().get();
+}
+
+unsigned long deadlineAfter(const TickType_t ticks) {
+  return ticks == portMAX_DELAY ? FOREVER : now + ticks * portTICK_PERIOD_MS;
+}
+
+bool canRun(const EmulatedTask& task) {
+  if (task.deleted) return false;
+  switch (task.wait) {
+    case EmulatedTask::NONE:
+      return true;
+    case EmulatedTask::DELAY:
+      return now >= task.deadline;
+    case EmulatedTask::NOTIFY:
+      return task.notifications > 0 || now >= task.deadline;
+    case EmulatedTask::MUTEX:
+      return task.mutex->owner == nullptr || now >= task.deadline;
+  }
+  return false;
+}
+
+// Highest priority runnable task, starting the search after the current one so equals take turns
+EmulatedTask* pickNext() {
+  const size_t count = tasks.size();
+  size_t start = 0;
+  while (start < count && tasks[start].get() != current) start++;
+  EmulatedTask* best = nullptr;
+  for (size_t i = 1; i <= count; i++) {
+    EmulatedTask* task = tasks[(start + i) % count].get();
+    if (canRun(*task) && (!best || task->priority > best->priority)) {
+      best = task;
+    }
+  }
+  return best;
+}
+
+void removeDeletedTasks() {
+  for (auto it = tasks.begin(); it != tasks.end();) {
+    if ((*it)->deleted && it->get() != current) {
+      it = tasks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Blocks the current task as it has set itself up to wait and runs others until it can carry on
+void reschedule() {
+  mainTask();
+  EmulatedTask* next = pickNext();
+  while (!next) {
+    unsigned long wakeAt = FOREVER;
+    for (const auto& task : tasks) {
+      if (!task->deleted && task->wait != EmulatedTask::NONE && task->deadline < wakeAt) {
+        wakeAt = task->deadline;
+      }
+    }
+    if (wakeAt == FOREVER) {
+      fprintf(stderr, "[EMU] Deadlock at %lu ms: every task is waiting forever\n", now);
+      for (const auto& task : tasks) {
+        if (!task->deleted) fprintf(stderr, "[EMU]   %s waits (%d)\n", task->name.c_str(), task->wait);
+      }
+      abort();
+    }
+    now = wakeAt;
+    next = pickNext();
+  }
+
+  EmulatedTask* previous = current;
+  current = next;
+  if (next != previous) {
+    swapcontext(&previous->context, &next->context);
+  }
+  // Back on this task's stack; tasks deleted meanwhile can go now
+  removeDeletedTasks();
+  current->wait = EmulatedTask::NONE;
+}
+
+void runTask() {
+  current->code(current->parameters);
+  // A FreeRTOS task must not return, treat it as deleting itself
+  vTaskDelete(nullptr);
+}
+}  // namespace
+
+unsigned long millis() { return now; }
+
+void delay(const unsigned long ms) { vTaskDelay(ms / portTICK_PERIOD_MS); }
+
+void yield() { vTaskDelay(0); }
+
+BaseType_t xTaskCreate(const TaskFunction_t taskCode, const char* name, uint32_t, void* parameters,
+                       const UBaseType_t priority, TaskHandle_t* createdTask) {
+  mainTask();
+  auto task = std::make_unique<EmulatedTask>();
+  task->name = name;
+  task->priority = priority;
+  task->code = taskCode;
+  task->parameters = parameters;
+  task->stack.resize(TASK_STACK_SIZE);
+  getcontext(&task->context);
+  task->context.uc_stack.ss_sp = task->stack.data();
+  task->context.uc_stack.ss_size = task->stack.size();
+  task->context.uc_link = nullptr;
+  makecontext(&task->context, runTask, 0);
+  if (createdTask) {
+    *createdTask = task.get();
+  }
+  tasks.push_back(std::move(task));
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  mainTask();
+  if (!task) {
+    task = current;
+  }
+  task->deleted = true;
+  if (task == current) {
+    reschedule();
+    // Never resumed
+  }
+  removeDeletedTasks();
+}
+
+void vTaskDelay(const TickType_t ticks) {
+  mainTask();
+  current->wait = EmulatedTask::DELAY;
+  current->deadline = now + ticks * portTICK_PERIOD_MS;
+  reschedule();
+}
+
+BaseType_t xTaskNotifyGive(const TaskHandle_t task) {
+  task->notifications++;
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(const BaseType_t clearCountOnExit, const TickType_t ticksToWait) {
+  mainTask();
+  if (current->notifications == 0 && ticksToWait > 0) {
+    current->wait = EmulatedTask::NOTIFY;
+    current->deadline = deadlineAfter(ticksToWait);
+    reschedule();
+  }
+  const uint32_t count = current->notifications;
+  if (count > 0) {
+    current->notifications = clearCountOnExit ? 0 : count - 1;
+  }
+  return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new EmulatedMutex(); }
+
+void vSemaphoreDelete(const SemaphoreHandle_t mutex) { delete mutex; }
+
+BaseType_t xSemaphoreTake(const SemaphoreHandle_t mutex, const TickType_t ticksToWait) {
+  mainTask();
+  if (mutex->owner && ticksToWait > 0) {
+    current->wait = EmulatedTask::MUTEX;
+    current->mutex = mutex;
+    current->deadline = deadlineAfter(ticksToWait);
+    reschedule();
+  }
+  if (mutex->owner) {
+    return pdFALSE;
+  }
+  mutex->owner = current;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(const SemaphoreHandle_t mutex) {
+  if (mutex->owner != current) {
+    return pdFALSE;
+  }
+  mutex->owner = nullptr;
+  // A higher priority task waiting for the mutex takes over straight away
+  for (const auto& task : tasks) {
+    if (!task->deleted && task->wait == EmulatedTask::MUTEX && task->mutex == mutex &&
+        task->priority > current->priority) {
+      reschedule();
+      break;
+    }
+  }
+  return pdTRUE;
+}
@@ -0,0 +1,311 @@
+// Runs the EPUB, TXT and XTC reader activities on the host against a directory standing in for the SD card, pressing
+// buttons from a script and dumping the panel as PBM (black and white) or PGM (grayscale) images.
+//
+//   CrossPointEmulator [--sd DIR] [--out DIR] [--frames] [--update] BOOK SCRIPT
+//
+// BOOK is a path on the card, as the library would open it. Settings, reading progress and book caches live under
+// DIR/.crosspoint like on the device. Each SCRIPT line is one of
+//
+//   press|release BUTTON     hold a button down or let it go, then run one main loop iteration
+//   tap BUTTON [MS]          press, hold for MS (default 50) and release
+//   wait MS                  run the main loop for MS of emulated time
+//   screen NAME [HASH]       dump what the panel shows as NAME.pbm/.pgm and check it against HASH
+//
+// with BUTTON one of back, confirm, left, right, up, down, power, and # starting a comment. Emulated time only moves
+// while every task is waiting, so a script produces the same screens every run. --update writes the hash of every
+// screen back into the script instead of checking it; --frames also dumps each refresh as it happens. With --out the
+// session's trace spans are written there as trace.json too.
+#include <Epub.h>
+#include <GfxRenderer.h>
+#include <HalDisplay.h>
+#include <HalGPIO.h>
+#include <SDCardManager.h>
+#include <Trace.h>
+#include <Txt.h>
+#include <Xtc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CrossPointSettings.h"
+#include "CrossPointState.h"
+#include "Emulator.h"
+#include "FontSetup.h"
+#include "MappedInputManager.h"
+#include "RecentBooksStore.h"
+#include "activities/reader/EpubReaderActivity.h"
+#include "activities/reader/TxtReaderActivity.h"
+#include "activities/reader/XtcReaderActivity.h"
+
+namespace {
+constexpr int WIDTH = HalDisplay::DISPLAY_WIDTH;
+constexpr int HEIGHT = HalDisplay::DISPLAY_HEIGHT;
+constexpr unsigned long LOOP_DELAY_MS = 10;
+constexpr unsigned long TAP_MS = 50;
+
+// What the panel shows: the last black and white refresh, and over it the planes of a grayscale refresh since
+struct Screen {
+  std::vector<uint8_t> bw = std::vector<uint8_t>(HalDisplay::BUFFER_SIZE, 0xFF);
+  std::vector<uint8_t> lsb = std::vector<uint8_t>(HalDisplay::BUFFER_SIZE, 0);
+  std::vector<uint8_t> msb = std::vector<uint8_t>(HalDisplay::BUFFER_SIZE, 0);
+  bool gray = false;
+
+  static bool bit(const std::vector<uint8_t>& plane, const int x, const int y) {
+    return plane[y * HalDisplay::DISPLAY_WIDTH_BYTES + x / 8] & (0x80 >> (x % 8));
+  }
+
+  // Both gray planes mark dark gray, the MSB plane alone light gray
+  uint8_t pixel(const int x, const int y) const {
+    if (gray && bit(msb, x, y)) {
+      return bit(lsb, x, y) ? 0x55 : 0xAA;
+    }
+    return bit(bw, x, y) ? 0xFF : 0x00;
+  }
+
+  uint64_t hash() const {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int y = 0; y < HEIGHT; y++) {
+      for (int x = 0; x < WIDTH; x++) {
+        h = (h ^ pixel(x, y)) * 0x100000001b3ull;
+      }
+    }
+    return h;
+  }
+
+  bool write(const std::string& pathWithoutExtension) const {
+    std::ofstream out(pathWithoutExtension + (gray ? ".pgm" : ".pbm"), std::ios::binary);
+    if (gray) {
+      out << "P5\n" << WIDTH << " " << HEIGHT << "\n255\n";
+      for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) out.put(static_cast<char>(pixel(x, y)));
+      }
+    } else {
+      // PBM has 1 for black, the panel 0
+      out << "P4\n" << WIDTH << " " << HEIGHT << "\n";
+      for (const uint8_t byte : bw) out.put(static_cast<char>(~byte));
+    }
+    return static_cast<bool>(out);
+  }
+};
+
+Screen screen;
+int refreshCount = 0;
+std::string framesDir;
+
+void onRefresh(const EInkDisplay& panel, const bool grayscale) {
+  if (grayscale) {
+    screen.lsb.assign(panel.lsbBuffer, panel.lsbBuffer + HalDisplay::BUFFER_SIZE);
+    screen.msb.assign(panel.msbBuffer, panel.msbBuffer + HalDisplay::BUFFER_SIZE);
+  } else {
+    screen.bw.assign(panel.getFrameBuffer(), panel.getFrameBuffer() + HalDisplay::BUFFER_SIZE);
+  }
+  screen.gray = grayscale;
+  refreshCount++;
+  if (!framesDir.empty()) {
+    char name[16];
+    snprintf(name, sizeof(name), "/%04d", refreshCount);
+    screen.write(framesDir + name);
+  }
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int buttonIndex(const std::string& name) {
+  static const char* const kNames[] = {"back", "confirm", "left", "right", "up", "down", "power"};
+  static_assert(HalGPIO::BTN_POWER == 6, "button names follow the HalGPIO indices");
+  for (int i = 0; i < 7; i++) {
+    if (name == kNames[i]) return i;
+  }
+  return -1;
+}
+
+// Opens the book the way ReaderActivity does and wraps it in its reader
+Activity* openReader(const std::string& path, GfxRenderer& renderer, MappedInputManager& input,
+                     const std::function<void()>& onDone) {
+  if (!SdMan.exists(path.c_str())) {
+    std::cerr << "No such book on the card: " << path << "\n";
+    return nullptr;
+  }
+  if (endsWith(path, ".xtc") || endsWith(path, ".xtch")) {
+    auto xtc = std::unique_ptr<Xtc>(new Xtc(path, "/.crosspoint"));
+    return xtc->load() ? new XtcReaderActivity(renderer, input, std::move(xtc), onDone, onDone) : nullptr;
+  }
+  if (endsWith(path, ".txt") || endsWith(path, ".md")) {
+    auto txt = std::unique_ptr<Txt>(new Txt(path, "/.crosspoint"));
+    return txt->load() ? new TxtReaderActivity(renderer, input, std::move(txt), onDone, onDone) : nullptr;
+  }
+  auto epub = std::unique_ptr<Epub>(new Epub(path, "/.crosspoint"));
+  return epub->load() ? new EpubReaderActivity(renderer, input, std::move(epub), onDone, onDone) : nullptr;
+}
+
+void usage() {
+  std::cerr << "Usage: CrossPointEmulator [--sd DIR] [--out DIR] [--frames] [--update] BOOK SCRIPT\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string sdDir = ".";
+  std::string outDir;
+  bool dumpFrames = false;
+  bool update = false;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--sd" && i + 1 < argc) {
+      sdDir = argv[++i];
+    } else if (arg == "--out" && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (arg == "--frames") {
+      dumpFrames = true;
+    } else if (arg == "--update") {
+      update = true;
+    } else if (arg.rfind("--", 0) == 0) {
+      usage();
+      return 2;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() != 2 || (dumpFrames && outDir.empty())) {
+    usage();
+    return 2;
+  }
+  const std::string bookPath = positional[0];
+  const std::string scriptPath = positional[1];
+
+  std::vector<std::string> script;
+  {
+    std::ifstream in(scriptPath);
+    if (!in) {
+      std::cerr << "Could not read " << scriptPath << "\n";
+      return 2;
+    }
+    for (std::string line; std::getline(in, line);) script.push_back(line);
+  }
+
+  SdMan.setRoot(sdDir);
+  SdMan.mkdir("/.crosspoint");
+  SETTINGS.loadFromFile();
+  APP_STATE.loadFromFile();
+  RECENT_BOOKS.loadFromFile();
+
+  HalDisplay display;
+  HalGPIO gpio;
+  MappedInputManager input(gpio);
+  GfxRenderer renderer(display);
+  display.begin();
+  setupFonts(renderer);
+  EInkDisplay::onRefresh = onRefresh;
+  if (dumpFrames) {
+    framesDir = outDir;
+  }
+
+  bool finished = false;
+  Activity* activity = openReader(bookPath, renderer, input, [&finished] { finished = true; });
+  if (!activity) {
+    std::cerr << "Could not open " << bookPath << "\n";
+    return 1;
+  }
+  activity->onEnter();
+
+  // One pass of the firmware's main loop
+  const auto step = [&] {
+    gpio.update();
+    activity->loop();
+    delay(LOOP_DELAY_MS);
+  };
+  const auto runFor = [&](const unsigned long ms) {
+    const unsigned long until = millis() + ms;
+    do {
+      step();
+    } while (millis() < until && !finished);
+  };
+
+  int mismatches = 0;
+  bool scriptChanged = false;
+  auto lastScreen = std::chrono::steady_clock::now();
+  int lastScreenRefreshes = 0;
+  for (size_t lineNumber = 0; lineNumber < script.size() && !finished; lineNumber++) {
+    std::string& line = script[lineNumber];
+    std::istringstream words(line.substr(0, line.find('#')));
+    std::string command;
+    if (!(words >> command)) continue;
+
+    std::string argument;
+    words >> argument;
+    if (command == "press" || command == "release" || command == "tap") {
+      const int button = buttonIndex(argument);
+      if (button < 0) {
+        std::cerr << scriptPath << ":" << lineNumber + 1 << ": unknown button '" << argument << "'\n";
+        return 2;
+      }
+      if (command == "tap") {
+        unsigned long holdMs = TAP_MS;
+        words >> holdMs;
+        emulator::setButton(button, true);
+        runFor(holdMs);
+        emulator::setButton(button, false);
+        step();
+      } else {
+        emulator::setButton(button, command == "press");
+        step();
+      }
+    } else if (command == "wait") {
+      runFor(std::stoul(argument));
+    } else if (command == "screen") {
+      char hash[17];
+      snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(screen.hash()));
+      const double ms =
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lastScreen).count();
+      printf("%-28s %s  %d refreshes, %.1f ms since the last screen\n", argument.c_str(), hash,
+             refreshCount - lastScreenRefreshes, ms);
+      lastScreen = std::chrono::steady_clock::now();
+      lastScreenRefreshes = refreshCount;
+      if (!outDir.empty() && !screen.write(outDir + "/" + argument)) {
+        std::cerr << "Could not write " << outDir << "/" << argument << "\n";
+      }
+
+      std::string expected;
+      words >> expected;
+      if (update) {
+        if (expected != hash) {
+          line = "screen " + argument + " " + hash;
+          scriptChanged = true;
+        }
+      } else if (!expected.empty() && expected != hash) {
+        std::cerr << "MISMATCH " << argument << ": expected " << expected << ", got " << hash << "\n";
+        mismatches++;
+      }
+    } else {
+      std::cerr << scriptPath << ":" << lineNumber + 1 << ": unknown command '" << command << "'\n";
+      return 2;
+    }
+  }
+  if (finished) {
+    printf("Reader closed at %lu ms\n", millis());
+  }
+
+  activity->onExit();
+  delete activity;
+  if (!outDir.empty()) {
+    std::ofstream(outDir + "/trace.json") << trace::toJson();
+  }
+
+  if (scriptChanged) {
+    std::ofstream out(scriptPath);
+    for (const auto& line : script) out << line << "\n";
+    printf("Updated screen hashes in %s\n", scriptPath.c_str());
+  }
+  if (mismatches) {
+    std::cerr << mismatches << " screen(s) differ\n";
+    return 1;
+  }
+  return 0;
+}
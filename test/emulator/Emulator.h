@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+// Hooks between the emulator's driver and its stand-ins for the device
+namespace emulator {
+// Holds a HalGPIO button down, or lets it go, as of the next update()
+void setButton(uint8_t buttonIndex, bool pressed);
+}  // namespace emulator
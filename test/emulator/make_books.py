@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Writes the emulator's sample books into a directory: an EPUB, a TXT and an XTC.
+
+The text comes from a fixed word list and seed, so the books, and the screens rendered from them, are the same on
+every run.
+"""
+
+import random
+import struct
+import sys
+import zipfile
+from pathlib import Path
+
+WORDS = (
+    "the reader turned another page and found a remarkable lighthouse standing over the quiet harbour where "
+    "morning light fell across weathered stones while gulls circled patiently above fishing boats returning "
+    "with their nets full of silver"
+).split()
+
+
+def paragraph(rng, words):
+    text = " ".join(rng.choice(WORDS) for _ in range(words))
+    return text[0].upper() + text[1:] + "."
+
+
+def write_epub(path, chapters=5):
+    rng = random.Random(20)
+    manifest = []
+    spine = []
+    nav_points = []
+    files = {}
+    for i in range(chapters):
+        body = [f"<h1>Chapter {i + 1}</h1>"]
+        for p in range(12 + i * 6):
+            text = paragraph(rng, rng.randint(25, 90))
+            if p % 5 == 1:
+                # Some styled runs, to exercise the bold and italic faces
+                first, _, rest = text.partition(" ")
+                text = f"<i>{first}</i> {rest}" if p % 2 else f"<b>{first}</b> {rest}"
+            body.append(f"<p>{text}</p>")
+        files[f"OEBPS/c{i}.xhtml"] = (
+            '<?xml version="1.0" encoding="utf-8"?>\n<html xmlns="http://www.w3.org/1999/xhtml"><head>'
+            f"<title>Chapter {i + 1}</title></head><body>\n" + "\n".join(body) + "\n</body></html>\n"
+        )
+        manifest.append(f'<item id="c{i}" href="c{i}.xhtml" media-type="application/xhtml+xml"/>')
+        spine.append(f'<itemref idref="c{i}"/>')
+        nav_points.append(
+            f'<navPoint id="n{i}" playOrder="{i + 1}"><navLabel><text>Chapter {i + 1}</text></navLabel>'
+            f'<content src="c{i}.xhtml"/></navPoint>'
+        )
+
+    files["OEBPS/content.opf"] = (
+        '<?xml version="1.0" encoding="utf-8"?>\n<package xmlns="http://www.idpf.org/2007/opf" version="2.0">'
+        '<metadata xmlns:dc="http://purl.org/dc/elements/1.1/"><dc:title>The Lighthouse</dc:title>'
+        "<dc:creator>Sample Author</dc:creator><dc:language>en</dc:language></metadata><manifest>"
+        '<item id="ncx" href="toc.ncx" media-type="application/x-dtbncx+xml"/>'
+        + "".join(manifest)
+        + '</manifest><spine toc="ncx">'
+        + "".join(spine)
+        + "</spine></package>\n"
+    )
+    files["OEBPS/toc.ncx"] = (
+        '<?xml version="1.0" encoding="utf-8"?>\n<ncx xmlns="http://www.daisy.org/z3986/2005/ncx/" version="2005-1">'
+        "<head/><docTitle><text>The Lighthouse</text></docTitle><navMap>" + "".join(nav_points) + "</navMap></ncx>\n"
+    )
+    container = (
+        '<?xml version="1.0"?>\n<container version="1.0" xmlns="urn:oasis:names:tc:opendocument:xmlns:container">'
+        '<rootfiles><rootfile full-path="OEBPS/content.opf" media-type="application/oebps-package+xml"/>'
+        "</rootfiles></container>\n"
+    )
+
+    with zipfile.ZipFile(path, "w") as archive:
+        # Fixed timestamps keep the archive, and so its cache key, identical between runs
+        def add(name, data, compression):
+            info = zipfile.ZipInfo(name, date_time=(2024, 1, 1, 0, 0, 0))
+            info.compress_type = compression
+            archive.writestr(info, data)
+
+        add("mimetype", "application/epub+zip", zipfile.ZIP_STORED)
+        add("META-INF/container.xml", container, zipfile.ZIP_DEFLATED)
+        for name, data in files.items():
+            add(name, data, zipfile.ZIP_DEFLATED)
+
+
+def write_txt(path):
+    rng = random.Random(30)
+    paragraphs = [paragraph(rng, rng.randint(20, 120)) for _ in range(60)]
+    path.write_text("The Harbour\n\n" + "\n\n".join(paragraphs) + "\n", encoding="utf-8")
+
+
+def write_xtc(path, pages=4):
+    """1-bit XTC: header, title, page table, then one XTG image of stripes and a frame per page."""
+    width, height = 480, 800
+    row_bytes = width // 8
+    title = b"Stripes".ljust(128, b"\0")
+    header_size = 56
+    table_offset = header_size + len(title)
+    data_offset = table_offset + 16 * pages
+    page_size = 22 + row_bytes * height
+
+    out = bytearray()
+    out += struct.pack(
+        "<IBBHBBBBIQQQQII",
+        0x00435458,  # "XTC\0"
+        1,
+        0,
+        pages,
+        0,  # read direction
+        1,  # has metadata
+        0,  # has thumbnails
+        0,  # has chapters
+        1,  # current page
+        0,
+        table_offset,
+        data_offset,
+        0,
+        table_offset,  # no chapter table of its own
+        0,
+    )
+    out += title
+    for page in range(pages):
+        out += struct.pack("<QIHH", data_offset + page * page_size, page_size, width, height)
+    for page in range(pages):
+        bitmap = bytearray(b"\xff" * (row_bytes * height))
+        for y in range(height):
+            for x in range(width):
+                border = x < 8 or x >= width - 8 or y < 8 or y >= height - 8
+                stripe = (y // 40) % (page + 2) == 0 and 40 <= x < 440
+                if border or stripe:
+                    bitmap[y * row_bytes + x // 8] &= ~(0x80 >> (x % 8))
+        out += struct.pack("<IHHBBIQ", 0x00475458, width, height, 0, 0, len(bitmap), 0)  # "XTG\0"
+        out += bitmap
+    path.write_bytes(bytes(out))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"Usage: {sys.argv[0]} OUTPUT_DIR")
+    out = Path(sys.argv[1])
+    out.mkdir(parents=True, exist_ok=True)
+    write_epub(out / "lighthouse.epub")
+    write_txt(out / "harbour.txt")
+    write_xtc(out / "stripes.xtc")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+// Registers fonts through a loader and checks each id is loaded once, on first use, that inserted fonts skip the
+// loader, that unknown ids draw and measure nothing, and that drawing with a resolved family matches drawing by id.
+#include <GfxRenderer.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <builtinFonts/ubuntu_10_bold.h>
+#include <builtinFonts/ubuntu_10_regular.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int BOOKERLY_ID = 1;
+constexpr int UI_ID = 2;
+constexpr int INSERTED_ID = 3;
+constexpr int UNKNOWN_ID = 4;
+
+int failures = 0;
+
+void expect(const bool condition, const std::string& what) {
+  if (!condition) {
+    std::cerr << "FAIL " << what << "\n";
+    failures++;
+  }
+}
+
+EpdFont regular(&bookerly_14_regular);
+EpdFont bold(&bookerly_14_bold);
+EpdFont italic(&bookerly_14_italic);
+EpdFont boldItalic(&bookerly_14_bolditalic);
+EpdFont uiRegular(&ubuntu_10_regular);
+EpdFont uiBold(&ubuntu_10_bold);
+const EpdFontFamily bookerly(&regular, &bold, &italic, &boldItalic);
+const EpdFontFamily ui(&uiRegular, &uiBold);
+
+std::vector<int> loads;
+
+const EpdFontFamily* loadFont(const int fontId) {
+  loads.push_back(fontId);
+  switch (fontId) {
+    case BOOKERLY_ID:
+      return &bookerly;
+    case UI_ID:
+    case INSERTED_ID:
+      return &ui;
+    default:
+      return nullptr;
+  }
+}
+}  // namespace
+
+int main() {
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(INSERTED_ID, ui);
+  renderer.setFontLoader(loadFont);
+
+  expect(loads.empty() && renderer.getFontIds() == std::vector<int>{INSERTED_ID}, "nothing loaded up front");
+
+  // Measuring, drawing and the metrics all go through the same registration
+  const int width = renderer.getTextWidth(BOOKERLY_ID, "Lighthouse");
+  expect(width > 0, "measured with a loaded font");
+  expect(renderer.getLineHeight(BOOKERLY_ID) == bookerly_14_regular.advanceY, "line height of the loaded font");
+  renderer.drawText(BOOKERLY_ID, 10, 10, "Lighthouse");
+  renderer.getSpaceWidth(UI_ID);
+  renderer.getTextWidth(BOOKERLY_ID, "keeper", EpdFontFamily::BOLD);
+  expect(loads == std::vector<int>({BOOKERLY_ID, UI_ID}), "each font loaded once");
+
+  const EpdFontFamily* font = renderer.getFont(BOOKERLY_ID);
+  expect(font && font->getData(EpdFontFamily::BOLD) == bookerly.getData(EpdFontFamily::BOLD), "resolved family");
+  renderer.getFont(UI_ID);
+  expect(renderer.getFont(BOOKERLY_ID) == font, "resolved family stays put");
+  expect(renderer.getFont(INSERTED_ID) && loads.size() == 2, "inserted font skips the loader");
+
+  // Unknown ids are asked for again, in case the loader learns them, and draw nothing
+  expect(!renderer.getFont(UNKNOWN_ID) && !renderer.getFont(UNKNOWN_ID) && loads.size() == 4, "unknown font");
+  expect(renderer.getTextWidth(UNKNOWN_ID, "Lighthouse") == 0 && renderer.getLineHeight(UNKNOWN_ID) == 0,
+         "unknown font measures nothing");
+  renderer.clearScreen();
+  renderer.drawText(UNKNOWN_ID, 10, 10, "Lighthouse");
+  std::vector<uint8_t> blank(HalDisplay::BUFFER_SIZE, 0xFF);
+  expect(memcmp(renderer.getFrameBuffer(), blank.data(), blank.size()) == 0, "unknown font draws nothing");
+
+  expect(renderer.getFontIds() == std::vector<int>({BOOKERLY_ID, UI_ID, INSERTED_ID}), "fonts used");
+
+  // A resolved family draws the same bits as its id
+  const char* words[] = {"The", "lamp", "was", "lit", "at", "dusk,", "as", "always."};
+  renderer.clearScreen();
+  int x = 20;
+  for (const char* word : words) {
+    renderer.drawText(BOOKERLY_ID, x, 40, word, true, EpdFontFamily::ITALIC);
+    x += renderer.getTextWidth(BOOKERLY_ID, word, EpdFontFamily::ITALIC) + renderer.getSpaceWidth(BOOKERLY_ID);
+  }
+  const std::vector<uint8_t> byId(renderer.getFrameBuffer(), renderer.getFrameBuffer() + HalDisplay::BUFFER_SIZE);
+  renderer.clearScreen();
+  x = 20;
+  for (const char* word : words) {
+    renderer.drawText(*font, x, 40, word, true, EpdFontFamily::ITALIC);
+    x += renderer.getTextWidth(BOOKERLY_ID, word, EpdFontFamily::ITALIC) + renderer.getSpaceWidth(BOOKERLY_ID);
+  }
+  expect(byId != blank, "words drawn");
+  expect(memcmp(renderer.getFrameBuffer(), byId.data(), byId.size()) == 0, "resolved family draws the same bits");
+
+  if (failures) {
+    std::cerr << failures << " font registry check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All font registry checks passed\n";
+  return 0;
+}
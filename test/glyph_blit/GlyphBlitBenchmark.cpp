@@ -0,0 +1,189 @@
+// Renders full pages of text through GfxRenderer::drawText and through a copy of the old per-pixel renderChar
+// (drawPixel for every glyph bit) into the same 48000-byte framebuffer, checks both produce identical bits for every
+// orientation and render mode, and reports the per-page render time of each.
+#include <GfxRenderer.h>
+#include <Utf8.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <builtinFonts/ubuntu_10_bold.h>
+#include <builtinFonts/ubuntu_10_regular.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int BOOKERLY_ID = 1;
+constexpr int UI_ID = 2;
+
+struct Line {
+  int x;
+  int y;
+  std::string text;
+  EpdFontFamily::Style style;
+};
+
+// The renderChar/drawText pair as it was before the span blitter, kept as the reference for bit-exactness
+void referenceRenderChar(const GfxRenderer& renderer, const GfxRenderer::RenderMode renderMode,
+                         const EpdFontFamily& fontFamily, const uint32_t cp, int* x, const int* y,
+                         const bool pixelState, const EpdFontFamily::Style style) {
+  const EpdGlyph* glyph = fontFamily.getGlyph(cp, style);
+  if (!glyph) {
+    glyph = fontFamily.getGlyph(REPLACEMENT_GLYPH, style);
+  }
+  if (!glyph) {
+    return;
+  }
+
+  const int is2Bit = fontFamily.getData(style)->is2Bit;
+  const uint8_t* bitmap = &fontFamily.getData(style)->bitmap[glyph->dataOffset];
+  for (int glyphY = 0; glyphY < glyph->height; glyphY++) {
+    const int screenY = *y - glyph->top + glyphY;
+    for (int glyphX = 0; glyphX < glyph->width; glyphX++) {
+      const int pixelPosition = glyphY * glyph->width + glyphX;
+      const int screenX = *x + glyph->left + glyphX;
+      if (is2Bit) {
+        const uint8_t byte = bitmap[pixelPosition / 4];
+        const uint8_t bit_index = (3 - pixelPosition % 4) * 2;
+        const uint8_t bmpVal = (3 - (byte >> bit_index)) & 0x3;
+        if (renderMode == GfxRenderer::BW && bmpVal < 3) {
+          renderer.drawPixel(screenX, screenY, pixelState);
+        } else if (renderMode == GfxRenderer::GRAYSCALE_MSB && (bmpVal == 1 || bmpVal == 2)) {
+          renderer.drawPixel(screenX, screenY, false);
+        } else if (renderMode == GfxRenderer::GRAYSCALE_LSB && bmpVal == 1) {
+          renderer.drawPixel(screenX, screenY, false);
+        }
+      } else {
+        const uint8_t byte = bitmap[pixelPosition / 8];
+        const uint8_t bit_index = 7 - (pixelPosition % 8);
+        if ((byte >> bit_index) & 1) {
+          renderer.drawPixel(screenX, screenY, pixelState);
+        }
+      }
+    }
+  }
+  *x += glyph->advanceX;
+}
+
+void referenceDrawText(const GfxRenderer& renderer, const GfxRenderer::RenderMode renderMode,
+                       const EpdFontFamily& font, const int fontId, const int x, const int y, const char* text,
+                       const bool black, const EpdFontFamily::Style style) {
+  const int yPos = y + renderer.getFontAscenderSize(fontId);
+  int xpos = x;
+  if (!font.hasPrintableChars(text, style)) {
+    return;
+  }
+  uint32_t cp;
+  while ((cp = utf8NextCodepoint(reinterpret_cast<const uint8_t**>(&text)))) {
+    referenceRenderChar(renderer, renderMode, font, cp, &xpos, &yPos, black, style);
+  }
+}
+
+std::vector<Line> buildPage(const GfxRenderer& renderer, const int fontId) {
+  static const char* const kText[] = {
+      "It was the best of times, it was the worst of times, it was the age of wisdom,",
+      "Съешь же ещё этих мягких французских булок, да выпей чаю.",
+      "Falsches Üben von Xylophonmusik quält jeden größeren Zwerg — «ça va» déjà vu?",
+      "The quick brown fox jumps over the lazy dog 0123456789 (!?) “quoted” text…",
+  };
+  std::vector<Line> lines;
+  const int lineHeight = renderer.getLineHeight(fontId);
+  int index = 0;
+  // Starts a little above and left of the screen and runs past the bottom and right edge to exercise clipping
+  for (int y = -lineHeight / 2; y < renderer.getScreenHeight() + lineHeight; y += lineHeight, index++) {
+    const int x = index % 7 == 0 ? -13 : 12;
+    lines.push_back({x, y, kText[index % 4], static_cast<EpdFontFamily::Style>(index % 4)});
+  }
+  return lines;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  EpdFont uiRegular(&ubuntu_10_regular);
+  EpdFont uiBold(&ubuntu_10_bold);
+  const EpdFontFamily bookerly(&regular, &bold, &italic, &boldItalic);
+  const EpdFontFamily ui(&uiRegular, &uiBold);
+
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(BOOKERLY_ID, bookerly);
+  renderer.insertFont(UI_ID, ui);
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  std::vector<uint8_t> expected(HalDisplay::BUFFER_SIZE);
+
+  struct FontCase {
+    const char* name;
+    int id;
+    const EpdFontFamily* family;
+  };
+  const FontCase fonts[] = {{"bookerly_14 (2-bit)", BOOKERLY_ID, &bookerly}, {"ubuntu_10 (1-bit)", UI_ID, &ui}};
+  const std::pair<GfxRenderer::Orientation, const char*> orientations[] = {
+      {GfxRenderer::Portrait, "Portrait"},
+      {GfxRenderer::LandscapeClockwise, "LandscapeCW"},
+      {GfxRenderer::PortraitInverted, "PortraitInverted"},
+      {GfxRenderer::LandscapeCounterClockwise, "LandscapeCCW"}};
+  const std::pair<GfxRenderer::RenderMode, const char*> modes[] = {
+      {GfxRenderer::BW, "BW"}, {GfxRenderer::GRAYSCALE_LSB, "LSB"}, {GfxRenderer::GRAYSCALE_MSB, "MSB"}};
+
+  int failures = 0;
+  for (const auto& font : fonts) {
+    for (const auto& [orientation, orientationName] : orientations) {
+      renderer.setOrientation(orientation);
+      const auto page = buildPage(renderer, font.id);
+
+      for (const auto& [mode, modeName] : modes) {
+        renderer.setRenderMode(mode);
+        const uint8_t background = mode == GfxRenderer::BW ? 0xFF : 0x00;
+        // White text on black lines too, so both the clear and the set path of BW are covered
+        const auto black = [&](const Line& line) { return mode != GfxRenderer::BW || line.y % 3 != 0; };
+
+        double referenceMs = 0;
+        double blitMs = 0;
+        for (int i = 0; i < iterations; i++) {
+          memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+          auto start = Clock::now();
+          for (const auto& line : page) {
+            referenceDrawText(renderer, mode, *font.family, font.id, line.x, line.y, line.text.c_str(), black(line),
+                              line.style);
+          }
+          referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+          memcpy(expected.data(), frameBuffer, HalDisplay::BUFFER_SIZE);
+
+          memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+          start = Clock::now();
+          for (const auto& line : page) {
+            renderer.drawText(font.id, line.x, line.y, line.text.c_str(), black(line), line.style);
+          }
+          blitMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        const bool exact = memcmp(expected.data(), frameBuffer, HalDisplay::BUFFER_SIZE) == 0;
+        if (!exact) {
+          failures++;
+        }
+        printf("%-4s %-20s %-17s %-4s per page: drawPixel %7.3f ms, span blit %7.3f ms (%.1fx)\n",
+               exact ? "OK" : "FAIL", font.name, orientationName, modeName, referenceMs / iterations,
+               blitMs / iterations, blitMs > 0 ? referenceMs / blitMs : 0.0);
+      }
+    }
+  }
+
+  if (failures) {
+    std::cerr << failures << " configuration(s) differ from the drawPixel reference\n";
+    return 1;
+  }
+  std::cout << "Span blitter output is bit-exact in every configuration\n";
+  return 0;
+}
@@ -0,0 +1,169 @@
+// Renders full pages of text the way the readers do with anti-aliasing on, once with the old BW, LSB and MSB passes
+// (storing and restoring the BW buffer around them) and once as a single BW pass capturing the grayscale planes.
+// Checks the BW frame buffer and both planes handed to the panel are identical for every orientation, and reports the
+// per-page time of each.
+#include <EInkDisplay.h>
+#include <GfxRenderer.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <builtinFonts/ubuntu_10_bold.h>
+#include <builtinFonts/ubuntu_10_regular.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int BOOKERLY_ID = 1;
+constexpr int UI_ID = 2;
+
+struct Line {
+  int x;
+  int y;
+  std::string text;
+  EpdFontFamily::Style style;
+};
+
+std::vector<Line> buildPage(const GfxRenderer& renderer, const int fontId) {
+  static const char* const kText[] = {
+      "It was the best of times, it was the worst of times, it was the age of wisdom,",
+      "Съешь же ещё этих мягких французских булок, да выпей чаю.",
+      "Falsches Üben von Xylophonmusik quält jeden größeren Zwerg — «ça va» déjà vu?",
+      "The quick brown fox jumps over the lazy dog 0123456789 (!?) “quoted” text…",
+  };
+  std::vector<Line> lines;
+  const int lineHeight = renderer.getLineHeight(fontId);
+  int index = 0;
+  for (int y = 10; y + lineHeight < renderer.getScreenHeight(); y += lineHeight, index++) {
+    lines.push_back({12, y, kText[index % 4], static_cast<EpdFontFamily::Style>(index % 4)});
+  }
+  return lines;
+}
+
+// Stands in for Page::render: text, plus a rule and a white line of text over a black bar so the drawPixel mirror and
+// the white text path take part too
+void renderPage(const GfxRenderer& renderer, const int fontId, const std::vector<Line>& page) {
+  for (const auto& line : page) {
+    renderer.drawText(fontId, line.x, line.y, line.text.c_str(), true, line.style);
+  }
+  const int barY = page.back().y;
+  renderer.fillRect(0, barY, renderer.getScreenWidth(), renderer.getLineHeight(fontId));
+  renderer.drawText(fontId, 12, barY, page.front().text.c_str(), false, EpdFontFamily::BOLD);
+  renderer.drawLine(12, page.front().y - 2, renderer.getScreenWidth() - 12, page.front().y - 2);
+}
+
+void renderThreePasses(GfxRenderer& renderer, const int fontId, const std::vector<Line>& page) {
+  renderer.clearScreen();
+  renderPage(renderer, fontId, page);
+  renderer.displayBuffer();
+  renderer.storeBwBuffer();
+
+  renderer.clearScreen(0x00);
+  renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
+  renderPage(renderer, fontId, page);
+  renderer.copyGrayscaleLsbBuffers();
+
+  renderer.clearScreen(0x00);
+  renderer.setRenderMode(GfxRenderer::GRAYSCALE_MSB);
+  renderPage(renderer, fontId, page);
+  renderer.copyGrayscaleMsbBuffers();
+
+  renderer.displayGrayBuffer();
+  renderer.setRenderMode(GfxRenderer::BW);
+  renderer.restoreBwBuffer();
+}
+
+bool renderSinglePass(GfxRenderer& renderer, const int fontId, const std::vector<Line>& page) {
+  renderer.clearScreen();
+  const bool captured = renderer.beginGrayscaleCapture();
+  renderPage(renderer, fontId, page);
+  renderer.endGrayscaleCapture();
+  renderer.displayBuffer();
+  if (captured) {
+    renderer.displayGrayscaleCapture();
+  }
+  return captured;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  EpdFont uiRegular(&ubuntu_10_regular);
+  EpdFont uiBold(&ubuntu_10_bold);
+  const EpdFontFamily bookerly(&regular, &bold, &italic, &boldItalic);
+  const EpdFontFamily ui(&uiRegular, &uiBold);
+
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(BOOKERLY_ID, bookerly);
+  renderer.insertFont(UI_ID, ui);
+  const EInkDisplay& panel = *EInkDisplay::instance;
+  std::vector<uint8_t> expectedBw(HalDisplay::BUFFER_SIZE);
+  std::vector<uint8_t> expectedLsb(HalDisplay::BUFFER_SIZE);
+  std::vector<uint8_t> expectedMsb(HalDisplay::BUFFER_SIZE);
+
+  struct FontCase {
+    const char* name;
+    int id;
+  };
+  const FontCase fonts[] = {{"bookerly_14 (2-bit)", BOOKERLY_ID}, {"ubuntu_10 (1-bit)", UI_ID}};
+  const std::pair<GfxRenderer::Orientation, const char*> orientations[] = {
+      {GfxRenderer::Portrait, "Portrait"},
+      {GfxRenderer::LandscapeClockwise, "LandscapeCW"},
+      {GfxRenderer::PortraitInverted, "PortraitInverted"},
+      {GfxRenderer::LandscapeCounterClockwise, "LandscapeCCW"}};
+
+  int failures = 0;
+  for (const auto& font : fonts) {
+    for (const auto& [orientation, orientationName] : orientations) {
+      renderer.setOrientation(orientation);
+      const auto page = buildPage(renderer, font.id);
+
+      double threePassMs = 0;
+      double singlePassMs = 0;
+      bool exact = true;
+      for (int i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        renderThreePasses(renderer, font.id, page);
+        threePassMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        memcpy(expectedBw.data(), renderer.getFrameBuffer(), HalDisplay::BUFFER_SIZE);
+        memcpy(expectedLsb.data(), panel.lsbBuffer, HalDisplay::BUFFER_SIZE);
+        memcpy(expectedMsb.data(), panel.msbBuffer, HalDisplay::BUFFER_SIZE);
+
+        start = Clock::now();
+        const bool captured = renderSinglePass(renderer, font.id, page);
+        singlePassMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        exact = exact && captured &&
+                memcmp(expectedBw.data(), renderer.getFrameBuffer(), HalDisplay::BUFFER_SIZE) == 0 &&
+                memcmp(expectedLsb.data(), panel.lsbBuffer, HalDisplay::BUFFER_SIZE) == 0 &&
+                memcmp(expectedMsb.data(), panel.msbBuffer, HalDisplay::BUFFER_SIZE) == 0;
+      }
+
+      if (!exact) {
+        failures++;
+      }
+      printf("%-4s %-20s %-17s per page: three passes %7.3f ms, single pass %7.3f ms (%.1fx)\n",
+             exact ? "OK" : "FAIL", font.name, orientationName, threePassMs / iterations, singlePassMs / iterations,
+             singlePassMs > 0 ? threePassMs / singlePassMs : 0.0);
+    }
+  }
+  renderer.freeGrayscaleCapture();
+
+  if (failures) {
+    std::cerr << failures << " configuration(s) differ from the three-pass render\n";
+    return 1;
+  }
+  std::cout << "Single-pass grayscale capture matches the three-pass render in every configuration\n";
+  return 0;
+}
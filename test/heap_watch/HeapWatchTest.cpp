@@ -0,0 +1,168 @@
+// Moves the pretend host heap through activities and operations and checks the worst cases recorded for each: lows
+// caught by sampling, lows between samples caught through the allocator's watermark, the largest block with the free
+// heap at that moment, details cut to their end, the records surviving a save and load with only real changes
+// written, and a damaged record file being dropped rather than read.
+#include <HeapWatch.h>
+#include <SDCardManager.h>
+#include <esp_heap_caps.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+int failures = 0;
+
+void expect(const bool condition, const std::string& what) {
+  if (!condition) {
+    std::cerr << "FAIL " << what << "\n";
+    failures++;
+  }
+}
+
+heapwatch::Record find(const char* name) {
+  heapwatch::Record records[heapwatch::MAX_RECORDS];
+  const size_t count = heapwatch::getRecords(records, heapwatch::MAX_RECORDS);
+  for (size_t i = 0; i < count; i++) {
+    if (strcmp(records[i].name, name) == 0) return records[i];
+  }
+  return heapwatch::Record{};
+}
+void writeFile(const std::string& path, const std::string& bytes) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/heap_watch_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir("/.crosspoint");
+  expect(!heapwatch::loadFromFile(), "nothing to load at first");
+
+  // A low the main loop samples, then a deeper one between samples that is a new low since boot
+  host_heap::set(150000, 90000);
+  heapwatch::enterActivity("Home");
+  host_heap::set(120000, 60000);
+  heapwatch::sample();
+  host_heap::set(150000, 90000);
+  {
+    heapwatch::Operation operation("CoverConvert", "/Books/Short.epub");
+    host_heap::set(70000, 20000);
+    host_heap::set(140000, 80000);
+  }
+  heapwatch::exitActivity();
+
+  heapwatch::Record record = find("Home");
+  expect(record.count == 1 && record.minFree == 70000, "activity low through the watermark");
+  expect(record.minLargestBlock == 60000 && record.freeAtMinLargestBlock == 120000, "activity largest block sampled");
+  record = find("CoverConvert");
+  expect(record.count == 1 && record.minFree == 70000, "operation low through the watermark");
+  expect(strcmp(record.minFreeDetail, "/Books/Short.epub") == 0, "operation detail");
+  // The largest block isn't watermarked, only what was sampled on the way in and out
+  expect(record.minLargestBlock == 80000 && record.freeAtMinLargestBlock == 140000, "operation largest block sampled");
+
+  // Concurrent operations, more than there are slots, and a detail longer than a record holds
+  const std::string longPath = "/Books/A Very Long Folder Name/Another Level/The Book With The Longest Title.epub #12";
+  heapwatch::enterActivity("Reader");
+  {
+    heapwatch::Operation build("SectionBuild", longPath);
+    heapwatch::Operation a("Extra", "a");
+    heapwatch::Operation b("Extra", "b");
+    heapwatch::Operation c("Extra", "c");
+    heapwatch::Operation untracked("Untracked", "d");
+    host_heap::set(100000, 30000);
+    heapwatch::sample();
+  }
+  record = find("SectionBuild");
+  expect(record.minFree == 100000 && record.minLargestBlock == 30000, "section build sampled");
+  expect(strlen(record.minFreeDetail) == heapwatch::DETAIL_SIZE - 1 &&
+             longPath.compare(longPath.size() - strlen(record.minFreeDetail), std::string::npos,
+                              record.minFreeDetail) == 0,
+         "long detail keeps its end: " + std::string(record.minFreeDetail));
+  expect(find("Extra").count == 3, "operations in every free slot");
+  expect(find("Untracked").count == 0, "no slot left, not tracked");
+
+  const std::string json = heapwatch::toJson();
+  expect(json.find("\"name\":\"SectionBuild\",\"count\":1,\"minFree\":100000,") != std::string::npos &&
+             json.find("\"fragmentation\":70,") != std::string::npos,
+         "JSON: " + json.substr(0, 200));
+
+  // Written once, reloaded intact, and a run that is no worse doesn't rewrite the file
+  heapwatch::exitActivity();
+  expect(heapwatch::saveToFile(), "save");
+  uint32_t writes = FsFile::writeCount;
+  expect(heapwatch::saveToFile() && FsFile::writeCount == writes, "unchanged records not rewritten");
+
+  heapwatch::enterActivity("Reader");
+  host_heap::set(150000, 90000);
+  {
+    heapwatch::Operation build("SectionBuild", "/Books/Easy.epub #1");
+  }
+  heapwatch::exitActivity();
+  expect(find("SectionBuild").count == 2 && find("SectionBuild").minFree == 100000, "better run keeps the worst");
+  expect(heapwatch::saveToFile() && FsFile::writeCount == writes, "better run not written");
+
+  host_heap::set(50000, 10000);
+  {
+    heapwatch::Operation build("SectionBuild", "/Books/Huge.epub #3");
+  }
+  record = find("SectionBuild");
+  expect(record.minFree == 50000 && strcmp(record.minFreeDetail, "/Books/Huge.epub #3") == 0, "worse run replaces");
+  writes = FsFile::writeCount;
+  expect(heapwatch::saveToFile() && FsFile::writeCount > writes, "worse run written");
+
+  // A failed write reports it and keeps the records to save again
+  host_heap::set(40000, 8000);
+  {
+    heapwatch::Operation build("SectionBuild", "/Books/Huger.epub #4");
+  }
+  FsFile::failWrites = true;
+  expect(!heapwatch::saveToFile(), "failed write reported");
+  FsFile::failWrites = false;
+  writes = FsFile::writeCount;
+  expect(heapwatch::saveToFile() && FsFile::writeCount > writes, "records written again after a failed write");
+
+  const heapwatch::Record before = find("SectionBuild");
+  heapwatch::reset();
+  expect(find("SectionBuild").count == 0, "reset");
+  expect(heapwatch::loadFromFile(), "load");
+  const heapwatch::Record after = find("SectionBuild");
+  expect(after.count == before.count && after.minFree == before.minFree &&
+             strcmp(after.minFreeDetail, before.minFreeDetail) == 0 &&
+             after.minLargestBlock == before.minLargestBlock &&
+             after.freeAtMinLargestBlock == before.freeAtMinLargestBlock &&
+             strcmp(after.minLargestBlockDetail, before.minLargestBlockDetail) == 0,
+         "section build record survives a reload");
+  expect(find("Home").minFree == 70000 && find("CoverConvert").count == 1, "other records survive a reload");
+
+  // Cut short by a power loss during a save
+  const std::string heapFile = std::string(dir) + heapwatch::DEFAULT_PATH;
+  std::filesystem::resize_file(heapFile, std::filesystem::file_size(heapFile) - 5);
+  heapwatch::reset();
+  expect(!heapwatch::loadFromFile(), "truncated file not loaded");
+  expect(!SdMan.exists(heapwatch::DEFAULT_PATH) && find("SectionBuild").count == 0, "truncated file removed");
+  // Version 1, one record whose name claims 4 GB
+  writeFile(heapFile, std::string("\x01\x01\xff\xff\xff\xff", 6));
+  expect(!heapwatch::loadFromFile() && !SdMan.exists(heapwatch::DEFAULT_PATH), "oversized string length rejected");
+  writeFile(heapFile, std::string("\x01\xc8", 2));
+  expect(!heapwatch::loadFromFile() && !SdMan.exists(heapwatch::DEFAULT_PATH), "too many records rejected");
+
+  std::string cleanup = "rm -rf ";
+  cleanup += dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " heap watch check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All heap watch checks passed\n";
+  return 0;
+}
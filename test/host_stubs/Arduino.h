@@ -0,0 +1,26 @@
+#pragma once
+// Host-side stand-in for the Arduino core, just enough to compile the reader libraries off-device.
+#include <HardwareSerial.h>
+#include <Print.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+
+#if CROSSPOINT_EMULATED == 0
+inline void delay(const unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+#else
+// Lets the emulator's other tasks run
+void delay(unsigned long ms);
+void yield();
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+// Always full, so the battery icon is the same in every emulator frame
+class BatteryMonitor {
+ public:
+  BatteryMonitor() = default;
+  explicit BatteryMonitor(uint8_t) {}
+  uint16_t readPercentage() const { return 100; }
+};
@@ -0,0 +1,57 @@
+#pragma once
+// Host-side panel: a plain 800x480 1bpp framebuffer plus the grayscale planes handed over by GfxRenderer.
+#include <cstdint>
+#include <cstring>
+
+class EInkDisplay {
+ public:
+  static constexpr uint16_t DISPLAY_WIDTH = 800;
+  static constexpr uint16_t DISPLAY_HEIGHT = 480;
+  static constexpr uint32_t BUFFER_SIZE = DISPLAY_WIDTH / 8 * DISPLAY_HEIGHT;
+
+  enum RefreshMode { FULL_REFRESH, HALF_REFRESH, FAST_REFRESH };
+
+  mutable uint8_t frameBuffer[BUFFER_SIZE];
+  uint8_t lsbBuffer[BUFFER_SIZE];
+  uint8_t msbBuffer[BUFFER_SIZE];
+
+  // Most recently constructed panel, so tests can inspect the planes behind a HalDisplay
+  static inline EInkDisplay* instance = nullptr;
+  // Called after every refresh with what the panel would now show, for the emulator to dump
+  static inline void (*onRefresh)(const EInkDisplay& panel, bool grayscale) = nullptr;
+
+  EInkDisplay(int8_t, int8_t, int8_t, int8_t, int8_t, int8_t) {
+    instance = this;
+    memset(frameBuffer, 0xFF, BUFFER_SIZE);
+    memset(lsbBuffer, 0, BUFFER_SIZE);
+    memset(msbBuffer, 0, BUFFER_SIZE);
+  }
+
+  void begin() {}
+  void clearScreen(const uint8_t color) const { memset(frameBuffer, color, BUFFER_SIZE); }
+  void drawImage(const uint8_t* imageData, const uint16_t x, const uint16_t y, const uint16_t w, const uint16_t h,
+                 bool) const {
+    const uint16_t wBytes = w / 8;
+    for (uint16_t row = 0; row < h && y + row < DISPLAY_HEIGHT; row++) {
+      memcpy(frameBuffer + (y + row) * (DISPLAY_WIDTH / 8) + x / 8, imageData + row * wBytes, wBytes);
+    }
+  }
+  void displayBuffer(RefreshMode) {
+    if (onRefresh) onRefresh(*this, false);
+  }
+  void refreshDisplay(RefreshMode, bool) {
+    if (onRefresh) onRefresh(*this, false);
+  }
+  void deepSleep() {}
+  uint8_t* getFrameBuffer() const { return frameBuffer; }
+  void copyGrayscaleBuffers(const uint8_t* lsb, const uint8_t* msb) {
+    copyGrayscaleLsbBuffers(lsb);
+    copyGrayscaleMsbBuffers(msb);
+  }
+  void copyGrayscaleLsbBuffers(const uint8_t* lsb) { memcpy(lsbBuffer, lsb, BUFFER_SIZE); }
+  void copyGrayscaleMsbBuffers(const uint8_t* msb) { memcpy(msbBuffer, msb, BUFFER_SIZE); }
+  void cleanupGrayscaleBuffers(const uint8_t* bw) { memcpy(frameBuffer, bw, BUFFER_SIZE); }
+  void displayGrayBuffer() {
+    if (onRefresh) onRefresh(*this, true);
+  }
+};
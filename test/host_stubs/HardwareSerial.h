@@ -0,0 +1,48 @@
+#pragma once
+// Host-side Serial: log lines are dropped unless CROSSPOINT_HOST_LOG is set in the environment.
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#if CROSSPOINT_EMULATED == 0
+inline unsigned long millis() {
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+#else
+// The emulator keeps its own clock, see test/emulator/EmulatedRtos.cpp
+unsigned long millis();
+#endif
+
+// Always host time, even in the emulator, so trace spans measure the work done rather than the emulated clock
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+class HardwareSerial {
+  bool enabled = std::getenv("CROSSPOINT_HOST_LOG") != nullptr;
+
+ public:
+  void begin(unsigned long) {}
+  __attribute__((format(printf, 2, 3))) int printf(const char* format, ...) {
+    if (!enabled) {
+      return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    const int written = vfprintf(stderr, format, args);
+    va_end(args);
+    return written;
+  }
+  void println(const char* s = "") {
+    if (enabled) {
+      fprintf(stderr, "%s\n", s);
+    }
+  }
+};
+
+inline HardwareSerial Serial;
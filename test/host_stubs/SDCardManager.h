@@ -0,0 +1,72 @@
+#pragma once
+// Host-side SdMan rooted at a directory on the host file system (defaults to the working directory).
+#include <Arduino.h>
+#include <SdFat.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+class SDCardManager {
+  std::string root = ".";
+
+  std::string resolve(const char* path) const { return root + (path[0] == '/' ? "" : "/") + path; }
+
+ public:
+  void setRoot(const std::string& dir) { root = dir; }
+  bool begin() { return true; }
+  bool ready() const { return true; }
+
+  bool openFileForRead(const char*, const std::string& path, FsFile& file) {
+    file = FsFile(fopen(resolve(path.c_str()).c_str(), "rb"));
+    return static_cast<bool>(file);
+  }
+  bool openFileForRead(const char* tag, const char* path, FsFile& file) {
+    return openFileForRead(tag, std::string(path), file);
+  }
+  bool openFileForWrite(const char*, const std::string& path, FsFile& file) {
+    file = FsFile(fopen(resolve(path.c_str()).c_str(), "w+b"));
+    return static_cast<bool>(file);
+  }
+  bool openFileForWrite(const char* tag, const char* path, FsFile& file) {
+    return openFileForWrite(tag, std::string(path), file);
+  }
+  // Directories for listing, and files with the open flags mapped onto the stdio mode closest to them
+  FsFile open(const char* path, const int oflag = O_RDONLY) {
+    struct stat st{};
+    if (stat(resolve(path).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      return FsFile(opendir(resolve(path).c_str()), resolve(path));
+    }
+    const char* mode = "rb";
+    if (oflag & O_APPEND) {
+      mode = "ab";
+    } else if (oflag & O_TRUNC) {
+      mode = "w+b";
+    } else if (oflag & (O_WRONLY | O_RDWR)) {
+      mode = exists(path) ? "r+b" : "w+b";
+    }
+    return FsFile(fopen(resolve(path).c_str(), mode));
+  }
+  bool exists(const char* path) const {
+    struct stat st{};
+    return stat(resolve(path).c_str(), &st) == 0;
+  }
+  bool remove(const char* path) const { return ::remove(resolve(path).c_str()) == 0; }
+  bool mkdir(const char* path, bool = true) const {
+    return ::mkdir(resolve(path).c_str(), 0755) == 0 || exists(path);
+  }
+  bool rmdir(const char* path) const { return ::rmdir(resolve(path).c_str()) == 0; }
+  bool removeDir(const char* path) const {
+    std::error_code error;
+    return std::filesystem::remove_all(resolve(path), error) != static_cast<std::uintmax_t>(-1) && !error;
+  }
+
+  static SDCardManager& getInstance() {
+    static SDCardManager instance;
+    return instance;
+  }
+};
+
+#define SdMan SDCardManager::getInstance()
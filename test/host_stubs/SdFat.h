@@ -0,0 +1,135 @@
+#pragma once
+// Host-side FsFile backed by stdio, covering the subset of the SdFat API the reader libraries use.
+// SdFat pulls in the Arduino core on the device
+#include <Arduino.h>
+#include <Print.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class FsFile : public Print {
+  FILE* fp = nullptr;
+  // Set instead of fp for a directory, along with its host path for openNextFile
+  DIR* dir = nullptr;
+  std::string path;
+  std::string name;
+
+ public:
+  // Reads and seeks across all files, so tests can check a code path stays off the card
+  static inline uint32_t ioCount = 0;
+  // Write calls across all files, to compare how chatty serializers are
+  static inline uint32_t writeCount = 0;
+  // Makes every write fail, as on a full or pulled card
+  static inline bool failWrites = false;
+
+  FsFile() = default;
+  explicit FsFile(FILE* fp) : fp(fp) {}
+  FsFile(DIR* dir, std::string path) : dir(dir), path(std::move(path)) {}
+  FsFile(const FsFile&) = delete;
+  FsFile& operator=(const FsFile&) = delete;
+  FsFile(FsFile&& other) noexcept
+      : fp(other.fp), dir(other.dir), path(std::move(other.path)), name(std::move(other.name)) {
+    other.fp = nullptr;
+    other.dir = nullptr;
+  }
+  FsFile& operator=(FsFile&& other) noexcept {
+    if (this != &other) {
+      close();
+      fp = other.fp;
+      dir = other.dir;
+      path = std::move(other.path);
+      name = std::move(other.name);
+      other.fp = nullptr;
+      other.dir = nullptr;
+    }
+    return *this;
+  }
+  ~FsFile() override { close(); }
+
+  explicit operator bool() const { return fp != nullptr || dir != nullptr; }
+  bool isOpen() const { return fp != nullptr || dir != nullptr; }
+  bool close() {
+    if (fp) {
+      fclose(fp);
+      fp = nullptr;
+    }
+    if (dir) {
+      closedir(dir);
+      dir = nullptr;
+    }
+    return true;
+  }
+
+  bool isDirectory() const { return dir != nullptr; }
+  // The next entry of a directory, skipping . and .., or a closed FsFile after the last one
+  FsFile openNextFile() {
+    for (dirent* entry = dir ? readdir(dir) : nullptr; entry; entry = readdir(dir)) {
+      const std::string entryName = entry->d_name;
+      if (entryName == "." || entryName == "..") continue;
+      const std::string entryPath = path + "/" + entryName;
+      struct stat st{};
+      if (stat(entryPath.c_str(), &st) != 0) continue;
+      FsFile next = S_ISDIR(st.st_mode) ? FsFile(opendir(entryPath.c_str()), entryPath)
+                                        : FsFile(fopen(entryPath.c_str(), "rb"));
+      next.name = entryName;
+      return next;
+    }
+    return FsFile();
+  }
+  size_t getName(char* out, const size_t size) const {
+    snprintf(out, size, "%s", name.c_str());
+    return name.size();
+  }
+
+  int read(void* buf, const size_t count) {
+    ioCount++;
+    if (!fp) return -1;
+    return static_cast<int>(fread(buf, 1, count, fp));
+  }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t write(const uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, const size_t count) override {
+    writeCount++;
+    return fp && !failWrites ? fwrite(buf, 1, count, fp) : 0;
+  }
+  using Print::write;
+
+  bool seek(const uint64_t pos) {
+    ioCount++;
+    return fp && fseek(fp, static_cast<long>(pos), SEEK_SET) == 0;
+  }
+  bool seekSet(const uint64_t pos) { return seek(pos); }
+  bool seekCur(const int64_t offset) {
+    ioCount++;
+    return fp && fseek(fp, static_cast<long>(offset), SEEK_CUR) == 0;
+  }
+  bool seekEnd(const int64_t offset = 0) { return fp && fseek(fp, static_cast<long>(offset), SEEK_END) == 0; }
+  uint64_t position() const { return fp ? static_cast<uint64_t>(ftell(fp)) : 0; }
+  uint64_t curPosition() const { return position(); }
+  uint64_t size() const {
+    if (!fp) return 0;
+    const long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    const long end = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+    return static_cast<uint64_t>(end);
+  }
+  uint64_t fileSize() const { return size(); }
+  int available() const {
+    const uint64_t remaining = size() - position();
+    return remaining > 0x7FFFFFFF ? 0x7FFFFFFF : static_cast<int>(remaining);
+  }
+  void flush() override {
+    if (fp) fflush(fp);
+  }
+  bool sync() {
+    flush();
+    return true;
+  }
+};
@@ -0,0 +1,87 @@
+#pragma once
+// Small generated EPUB 2 books for the host tests that open a book through Epub and Section. Each spine item is
+// OEBPS/c<i>.xhtml; chapters are either passed in or paragraphs of words picked from a fixed list by a seeded
+// generator, so a test gets the same book on every run.
+#include <miniz.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace test_epub {
+
+struct Book {
+  const char* title = "Test Book";
+  int chapters = 1;
+  uint32_t seed = 1;       // Chapter i is generated from seed + i
+  int paragraphs = 120;    // Paragraphs in the first chapter
+  int paragraphsStep = 0;  // Added for each following chapter, so their page counts differ
+  bool italics = false;    // Sets about one word in 13 in italics
+};
+
+// Paragraphs of 20 to 99 words
+inline std::string chapter(uint32_t seed, const int paragraphs, const bool italics = false) {
+  static const char* const kWords[] = {"the",  "reader", "turned",     "another",    "page",    "and",  "found",
+                                       "a",    "quiet",  "remarkable", "lighthouse", "morning", "of",   "hyphenation"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>T</title>"
+      "</head><body>\n";
+  for (int p = 0; p < paragraphs; p++) {
+    html += "<p>";
+    const size_t words = 20 + seed % 80;
+    for (size_t w = 0; w < words; w++) {
+      seed = seed * 1103515245u + 12345u;
+      if (w > 0) html += ' ';
+      const char* word = kWords[(seed >> 16) % kWordCount];
+      html += italics && (seed >> 8) % 13 == 0 ? std::string("<i>") + word + "</i>" : std::string(word);
+    }
+    html += ".</p>\n";
+  }
+  return html + "</body></html>\n";
+}
+
+inline bool writeEpub(const std::string& path, const std::string& title, const std::vector<std::string>& chapters) {
+  static const char* const CONTAINER_XML =
+      "<?xml version=\"1.0\"?>\n<container version=\"1.0\" xmlns=\"urn:oasis:names:tc:opendocument:xmlns:container\">"
+      "<rootfiles><rootfile full-path=\"OEBPS/content.opf\" media-type=\"application/oebps-package+xml\"/>"
+      "</rootfiles></container>\n";
+  std::string opf =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<package xmlns=\"http://www.idpf.org/2007/opf\" version=\"2.0\">"
+      "<metadata xmlns:dc=\"http://purl.org/dc/elements/1.1/\"><dc:title>" +
+      title + "</dc:title><dc:language>en</dc:language></metadata><manifest>";
+  for (size_t i = 0; i < chapters.size(); i++) {
+    opf += "<item id=\"c" + std::to_string(i) + "\" href=\"c" + std::to_string(i) +
+           ".xhtml\" media-type=\"application/xhtml+xml\"/>";
+  }
+  opf += "</manifest><spine>";
+  for (size_t i = 0; i < chapters.size(); i++) {
+    opf += "<itemref idref=\"c" + std::to_string(i) + "\"/>";
+  }
+  opf += "</spine></package>\n";
+
+  mz_zip_archive archive = {};
+  if (!mz_zip_writer_init_file(&archive, path.c_str(), 0)) return false;
+  bool ok = mz_zip_writer_add_mem(&archive, "mimetype", "application/epub+zip", 20, MZ_NO_COMPRESSION) &&
+            mz_zip_writer_add_mem(&archive, "META-INF/container.xml", CONTAINER_XML, strlen(CONTAINER_XML),
+                                  MZ_DEFAULT_LEVEL) &&
+            mz_zip_writer_add_mem(&archive, "OEBPS/content.opf", opf.data(), opf.size(), MZ_DEFAULT_LEVEL);
+  for (size_t i = 0; i < chapters.size() && ok; i++) {
+    const std::string name = "OEBPS/c" + std::to_string(i) + ".xhtml";
+    ok = mz_zip_writer_add_mem(&archive, name.c_str(), chapters[i].data(), chapters[i].size(), MZ_DEFAULT_LEVEL);
+  }
+  ok = ok && mz_zip_writer_finalize_archive(&archive);
+  mz_zip_writer_end(&archive);
+  return ok;
+}
+
+inline bool writeEpub(const std::string& path, const Book& book) {
+  std::vector<std::string> chapters;
+  for (int i = 0; i < book.chapters; i++) {
+    chapters.push_back(chapter(book.seed + i, book.paragraphs + i * book.paragraphsStep, book.italics));
+  }
+  return writeEpub(path, book.title, chapters);
+}
+
+}  // namespace test_epub
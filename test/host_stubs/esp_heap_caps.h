@@ -0,0 +1,25 @@
+#pragma once
+// Host-side heap queries: a pretend heap tests can move around to exercise the accounting built on them.
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+namespace host_heap {
+inline size_t freeBytes = 200 * 1024;
+inline size_t largestBlock = 110 * 1024;
+inline size_t minimumFree = 180 * 1024;
+
+// Sets the heap as it is now, lowering the watermark like the allocator would
+inline void set(const size_t free, const size_t largest) {
+  freeBytes = free;
+  largestBlock = largest;
+  if (free < minimumFree) {
+    minimumFree = free;
+  }
+}
+}  // namespace host_heap
+
+inline size_t heap_caps_get_free_size(uint32_t) { return host_heap::freeBytes; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return host_heap::largestBlock; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return host_heap::minimumFree; }
@@ -0,0 +1,19 @@
+#pragma once
+// Host-side FreeRTOS for the emulator. Tasks run as coroutines on one thread and are scheduled on the emulator's
+// clock, so a scripted session renders the same frames every run. Implemented in test/emulator/EmulatedRtos.cpp.
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef struct EmulatedTask* TaskHandle_t;
+typedef struct EmulatedMutex* SemaphoreHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define tskIDLE_PRIORITY 0
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <functional>
@@ -11,6 +12,7 @@
 #include <vector>
 
 #include "lib/Epub/Epub/hyphenation/HyphenationCommon.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
 #include "lib/Epub/Epub/hyphenation/LanguageHyphenator.h"
 #include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
 
@@ -134,6 +136,81 @@ std::vector<size_t> hyphenateWordWithHyphenator(const std::string& word, const L
   return hyphenator.breakIndexes(cps);
 }
 
+struct ThroughputResult {
+  double evaluatorWordsPerSecond = 0.0;
+  double bookWordsPerSecond = 0.0;
+  bool cacheConsistent = true;
+};
+
+// Times the allocation-free Liang evaluator over every test word, then Hyphenator::breakOffsets, word cache included,
+// over the words repeated as often as they occur in the source book and shuffled, as a chapter would present them.
+// Every cached answer must match what the word got the first time it was seen.
+ThroughputResult measureThroughput(const std::vector<TestCase>& testCases, const LanguageHyphenator& hyphenator,
+                                   const char* primaryTag) {
+  using Clock = std::chrono::steady_clock;
+  constexpr int kRounds = 20;
+  ThroughputResult result;
+
+  size_t sink = 0;
+  WordCodepoints cps;
+  uint8_t indexes[kMaxHyphenatedWordBytes];
+  // The fastest of several rounds, as the host may be busy with other work
+  double fastest = 0.0;
+  for (int round = 0; round < kRounds; ++round) {
+    const auto start = Clock::now();
+    for (const auto& testCase : testCases) {
+      collectCodepoints(testCase.word, cps);
+      trimSurroundingPunctuationAndFootnote(cps);
+      sink += hyphenator.breakIndexes(cps.values + cps.first, cps.count, indexes);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    fastest = round == 0 ? seconds : std::min(fastest, seconds);
+  }
+  result.evaluatorWordsPerSecond = testCases.size() / fastest;
+
+  std::vector<size_t> book;
+  for (size_t i = 0; i < testCases.size(); ++i) {
+    book.insert(book.end(), std::max(testCases[i].frequency, 1), i);
+  }
+  uint32_t seed = 1;
+  for (size_t i = book.size(); i > 1; --i) {
+    seed = seed * 1103515245u + 12345u;
+    std::swap(book[i - 1], book[(seed >> 8) % i]);
+  }
+
+  Hyphenator::setPreferredLanguage("");
+  Hyphenator::setPreferredLanguage(primaryTag);
+  std::vector<std::vector<uint8_t>> firstSeen(testCases.size());
+  std::vector<bool> seen(testCases.size(), false);
+  for (const size_t i : book) {
+    std::vector<uint8_t> offsets;
+    for (const auto& info : Hyphenator::breakOffsets(testCases[i].word, false)) {
+      offsets.push_back(info.byteOffset);
+    }
+    if (!seen[i]) {
+      seen[i] = true;
+      firstSeen[i] = std::move(offsets);
+    } else if (offsets != firstSeen[i]) {
+      result.cacheConsistent = false;
+    }
+  }
+
+  for (int round = 0; round < kRounds; ++round) {
+    const auto start = Clock::now();
+    for (const size_t i : book) {
+      sink += Hyphenator::breakOffsets(testCases[i].word, false).size();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    fastest = round == 0 ? seconds : std::min(fastest, seconds);
+  }
+  result.bookWordsPerSecond = book.size() / fastest;
+
+  if (sink == 0) {
+    std::cerr << "No breaks found while timing" << std::endl;
+  }
+  return result;
+}
+
 std::vector<LanguageConfig> resolveLanguages(const std::string& selection) {
   if (selection == "all") {
     return kSupportedLanguages;
@@ -302,8 +379,11 @@ void printResults(const std::string& language, const std::vector<TestCase>& test
 }
 
 int main(int argc, char* argv[]) {
-  const bool summaryMode = argc <= 1;
-  const std::string languageSelection = summaryMode ? "all" : argv[1];
+  // --throughput [language] prints the summary line of each language with its hyphenation speed
+  const bool throughputMode = argc > 1 && std::string(argv[1]) == "--throughput";
+  const int languageArg = throughputMode ? 2 : 1;
+  const bool summaryMode = throughputMode || argc <= 1;
+  const std::string languageSelection = argc > languageArg ? argv[languageArg] : "all";
 
   std::vector<LanguageConfig> languages = resolveLanguages(languageSelection);
   if (languages.empty()) {
@@ -311,6 +391,7 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  bool failed = false;
   for (const auto& lang : languages) {
     const auto* hyphenator = getLanguageHyphenatorForPrimaryTag(lang.primaryTag);
     if (!hyphenator) {
@@ -374,7 +455,17 @@ int main(int argc, char* argv[]) {
 
     if (summaryMode) {
       const double averageF1Percent = testCases.empty() ? 0.0 : (totalF1 / testCases.size() * 100.0);
-      std::cout << lang.cliName << ": " << averageF1Percent << "%" << std::endl;
+      std::cout << lang.cliName << ": " << averageF1Percent << "%";
+      if (throughputMode) {
+        const auto throughput = measureThroughput(testCases, *hyphenator, lang.primaryTag);
+        std::cout << "  Liang " << static_cast<long>(throughput.evaluatorWordsPerSecond) << " words/s, in book order "
+                  << static_cast<long>(throughput.bookWordsPerSecond) << " words/s"
+                  << (throughput.cacheConsistent ? "" : " (CACHE MISMATCH)");
+        if (!throughput.cacheConsistent) {
+          failed = true;
+        }
+      }
+      std::cout << std::endl;
       continue;
     }
 
@@ -385,5 +476,5 @@ int main(int argc, char* argv[]) {
                  totalRecall, totalF1, totalWeighted, totalTP, totalFP, totalFN, hyphenateFunc);
   }
 
-  return 0;
-}
\ No newline at end of file
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,412 @@
+#include "GreedyParsedText.h"
+
+#include <GfxRenderer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+
+constexpr int MAX_COST = std::numeric_limits<int>::max();
+
+namespace {
+
+// Soft hyphen byte pattern used throughout EPUBs (UTF-8 for U+00AD).
+constexpr char SOFT_HYPHEN_UTF8[] = "\xC2\xAD";
+constexpr size_t SOFT_HYPHEN_BYTES = 2;
+
+bool containsSoftHyphen(const std::string_view word) { return word.find(SOFT_HYPHEN_UTF8) != std::string_view::npos; }
+
+// Removes every soft hyphen in-place so rendered glyphs match measured widths.
+void stripSoftHyphensInPlace(std::string& word) {
+  size_t pos = 0;
+  while ((pos = word.find(SOFT_HYPHEN_UTF8, pos)) != std::string::npos) {
+    word.erase(pos, SOFT_HYPHEN_BYTES);
+  }
+}
+
+// Returns the rendered width for a word while ignoring soft hyphen glyphs and optionally appending a visible hyphen.
+// The word may be a prefix of a longer NUL-terminated string; it is only copied into scratch when it has to be.
+uint16_t measureWordWidth(const GfxRenderer& renderer, const int fontId, const std::string_view word,
+                          const EpdFontFamily::Style style, std::string& scratch, const bool appendHyphen = false) {
+  const bool hasSoftHyphen = containsSoftHyphen(word);
+  if (!hasSoftHyphen && !appendHyphen && word.data()[word.size()] == '\0') {
+    return renderer.getTextWidth(fontId, word.data(), style);
+  }
+
+  scratch.assign(word);
+  if (hasSoftHyphen) {
+    stripSoftHyphensInPlace(scratch);
+  }
+  if (appendHyphen) {
+    scratch.push_back('-');
+  }
+  return renderer.getTextWidth(fontId, scratch.c_str(), style);
+}
+
+}  // namespace
+
+void GreedyParsedText::addWord(const std::string_view word, const EpdFontFamily::Style fontStyle) {
+  if (word.empty()) return;
+
+  const auto offset = static_cast<uint32_t>(arena.size());
+  arena.append(word);
+  arena.push_back('\0');
+  words.push_back({offset, static_cast<uint16_t>(word.size()), 0, fontStyle});
+}
+
+// Copies the first length bytes of a word to the end of the arena with an optional prefix and trailing hyphen, and
+// returns the new offset. The arena is grown first so the source bytes stay put while they are copied.
+uint32_t GreedyParsedText::copyWordToArena(const Word& source, const uint16_t length, const char* prefix,
+                                           const bool appendHyphen) {
+  const size_t prefixLength = strlen(prefix);
+  arena.reserve(arena.size() + prefixLength + length + 2);
+  const auto offset = static_cast<uint32_t>(arena.size());
+  arena.append(prefix, prefixLength);
+  arena.append(wordText(source), length);
+  if (appendHyphen) {
+    arena.push_back('-');
+  }
+  arena.push_back('\0');
+  return offset;
+}
+
+// Consumes data to minimize memory usage
+void GreedyParsedText::layoutAndExtractLines(const GfxRenderer& renderer, const int fontId,
+                                             const uint16_t viewportWidth,
+                                             const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
+                                             const bool includeLastLine) {
+  if (words.empty()) {
+    return;
+  }
+
+  // Apply fixed transforms before any per-line layout work.
+  applyParagraphIndent();
+
+  const int pageWidth = viewportWidth;
+  const int spaceWidth = renderer.getSpaceWidth(fontId);
+  calculateWordWidths(renderer, fontId);
+  std::vector<size_t> lineBreakIndices;
+  if (hyphenationEnabled) {
+    // Use greedy layout that can split words mid-loop when a hyphenated prefix fits.
+    lineBreakIndices = computeHyphenatedLineBreaks(renderer, fontId, pageWidth, spaceWidth);
+  } else {
+    lineBreakIndices = computeLineBreaks(renderer, fontId, pageWidth, spaceWidth);
+  }
+  const size_t lineCount = includeLastLine ? lineBreakIndices.size() : lineBreakIndices.size() - 1;
+
+  for (size_t i = 0; i < lineCount; ++i) {
+    extractLine(i, pageWidth, spaceWidth, lineBreakIndices, processLine);
+  }
+  dropWords(lineCount > 0 ? lineBreakIndices[lineCount - 1] : 0);
+}
+
+// Removes the first count words, compacting what is left of the arena
+void GreedyParsedText::dropWords(const size_t count) {
+  if (count >= words.size()) {
+    words.clear();
+    arena.clear();
+    return;
+  }
+  if (count == 0) {
+    return;
+  }
+
+  size_t keptSize = 0;
+  for (size_t i = count; i < words.size(); i++) {
+    keptSize += words[i].length + 1;
+  }
+  std::string kept;
+  kept.reserve(keptSize);
+  for (size_t i = count; i < words.size(); i++) {
+    const auto offset = static_cast<uint32_t>(kept.size());
+    kept.append(wordText(words[i]), words[i].length + 1);
+    words[i].offset = offset;
+  }
+  words.erase(words.begin(), words.begin() + count);
+  arena.swap(kept);
+}
+
+void GreedyParsedText::calculateWordWidths(const GfxRenderer& renderer, const int fontId) {
+  for (auto& word : words) {
+    word.width = measureWordWidth(renderer, fontId, {wordText(word), word.length}, word.style, scratch);
+  }
+}
+
+std::vector<size_t> GreedyParsedText::computeLineBreaks(const GfxRenderer& renderer, const int fontId,
+                                                        const int pageWidth, const int spaceWidth) {
+  if (words.empty()) {
+    return {};
+  }
+
+  // Ensure any word that would overflow even as the first entry on a line is split using fallback hyphenation.
+  for (size_t i = 0; i < words.size(); ++i) {
+    while (words[i].width > pageWidth) {
+      if (!hyphenateWordAtIndex(i, pageWidth, renderer, fontId, /*allowFallbackBreaks=*/true)) {
+        break;
+      }
+    }
+  }
+
+  const size_t totalWordCount = words.size();
+
+  // DP table to store the minimum badness (cost) of lines starting at index i
+  std::vector<int> dp(totalWordCount);
+  // 'ans[i]' stores the index 'j' of the *last word* in the optimal line starting at 'i'
+  std::vector<size_t> ans(totalWordCount);
+
+  // Base Case
+  dp[totalWordCount - 1] = 0;
+  ans[totalWordCount - 1] = totalWordCount - 1;
+
+  for (int i = totalWordCount - 2; i >= 0; --i) {
+    int currlen = -spaceWidth;
+    dp[i] = MAX_COST;
+
+    for (size_t j = i; j < totalWordCount; ++j) {
+      // Current line length: previous width + space + current word width
+      currlen += words[j].width + spaceWidth;
+
+      if (currlen > pageWidth) {
+        break;
+      }
+
+      int cost;
+      if (j == totalWordCount - 1) {
+        cost = 0;  // Last line
+      } else {
+        const int remainingSpace = pageWidth - currlen;
+        // Use long long for the square to prevent overflow
+        const long long cost_ll = static_cast<long long>(remainingSpace) * remainingSpace + dp[j + 1];
+
+        if (cost_ll > MAX_COST) {
+          cost = MAX_COST;
+        } else {
+          cost = static_cast<int>(cost_ll);
+        }
+      }
+
+      if (cost < dp[i]) {
+        dp[i] = cost;
+        ans[i] = j;  // j is the index of the last word in this optimal line
+      }
+    }
+
+    // Handle oversized word: if no valid configuration found, force single-word line
+    // This prevents cascade failure where one oversized word breaks all preceding words
+    if (dp[i] == MAX_COST) {
+      ans[i] = i;  // Just this word on its own line
+      // Inherit cost from next word to allow subsequent words to find valid configurations
+      if (i + 1 < static_cast<int>(totalWordCount)) {
+        dp[i] = dp[i + 1];
+      } else {
+        dp[i] = 0;
+      }
+    }
+  }
+
+  // Stores the index of the word that starts the next line (last_word_index + 1)
+  std::vector<size_t> lineBreakIndices;
+  size_t currentWordIndex = 0;
+
+  while (currentWordIndex < totalWordCount) {
+    size_t nextBreakIndex = ans[currentWordIndex] + 1;
+
+    // Safety check: prevent infinite loop if nextBreakIndex doesn't advance
+    if (nextBreakIndex <= currentWordIndex) {
+      // Force advance by at least one word to avoid infinite loop
+      nextBreakIndex = currentWordIndex + 1;
+    }
+
+    lineBreakIndices.push_back(nextBreakIndex);
+    currentWordIndex = nextBreakIndex;
+  }
+
+  return lineBreakIndices;
+}
+
+void GreedyParsedText::applyParagraphIndent() {
+  if (extraParagraphSpacing || words.empty()) {
+    return;
+  }
+
+  if (style == TextBlock::JUSTIFIED || style == TextBlock::LEFT_ALIGN) {
+    Word& first = words.front();
+    first.offset = copyWordToArena(first, first.length, "\xe2\x80\x83");
+    first.length += 3;
+  }
+}
+
+// Builds break indices while opportunistically splitting the word that would overflow the current line.
+std::vector<size_t> GreedyParsedText::computeHyphenatedLineBreaks(const GfxRenderer& renderer, const int fontId,
+                                                                  const int pageWidth, const int spaceWidth) {
+  std::vector<size_t> lineBreakIndices;
+  size_t currentIndex = 0;
+
+  while (currentIndex < words.size()) {
+    const size_t lineStart = currentIndex;
+    int lineWidth = 0;
+
+    // Consume as many words as possible for current line, splitting when prefixes fit
+    while (currentIndex < words.size()) {
+      const bool isFirstWord = currentIndex == lineStart;
+      const int spacing = isFirstWord ? 0 : spaceWidth;
+      const int candidateWidth = spacing + words[currentIndex].width;
+
+      // Word fits on current line
+      if (lineWidth + candidateWidth <= pageWidth) {
+        lineWidth += candidateWidth;
+        ++currentIndex;
+        continue;
+      }
+
+      // Word would overflow — try to split based on hyphenation points
+      const int availableWidth = pageWidth - lineWidth - spacing;
+      const bool allowFallbackBreaks = isFirstWord;  // Only for first word on line
+
+      if (availableWidth > 0 &&
+          hyphenateWordAtIndex(currentIndex, availableWidth, renderer, fontId, allowFallbackBreaks)) {
+        // Prefix now fits; append it to this line and move to next line
+        lineWidth += spacing + words[currentIndex].width;
+        ++currentIndex;
+        break;
+      }
+
+      // Could not split: force at least one word per line to avoid infinite loop
+      if (currentIndex == lineStart) {
+        lineWidth += candidateWidth;
+        ++currentIndex;
+      }
+      break;
+    }
+
+    lineBreakIndices.push_back(currentIndex);
+  }
+
+  return lineBreakIndices;
+}
+
+// Splits words[wordIndex] into prefix (adding a hyphen only when needed) and remainder when a legal breakpoint fits the
+// available width.
+bool GreedyParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availableWidth,
+                                            const GfxRenderer& renderer, const int fontId,
+                                            const bool allowFallbackBreaks) {
+  // Guard against invalid indices or zero available width before attempting to split.
+  if (availableWidth <= 0 || wordIndex >= words.size()) {
+    return false;
+  }
+
+  const Word target = words[wordIndex];
+  const std::string_view word(wordText(target), target.length);
+
+  // Collect candidate breakpoints (byte offsets and hyphen requirements).
+  auto breakInfos = Hyphenator::breakOffsets(std::string(word), allowFallbackBreaks);
+  if (breakInfos.empty()) {
+    return false;
+  }
+
+  size_t chosenOffset = 0;
+  int chosenWidth = -1;
+  bool chosenNeedsHyphen = true;
+
+  // Iterate over each legal breakpoint and retain the widest prefix that still fits.
+  for (const auto& info : breakInfos) {
+    const size_t offset = info.byteOffset;
+    if (offset == 0 || offset >= word.size()) {
+      continue;
+    }
+
+    const bool needsHyphen = info.requiresInsertedHyphen;
+    const int prefixWidth =
+        measureWordWidth(renderer, fontId, word.substr(0, offset), target.style, scratch, needsHyphen);
+    if (prefixWidth > availableWidth || prefixWidth <= chosenWidth) {
+      continue;  // Skip if too wide or not an improvement
+    }
+
+    chosenWidth = prefixWidth;
+    chosenOffset = offset;
+    chosenNeedsHyphen = needsHyphen;
+  }
+
+  if (chosenWidth < 0) {
+    // No hyphenation point produced a prefix that fits in the remaining space.
+    return false;
+  }
+
+  // The remainder stays where it is in the arena, the prefix needs its own terminator so it is copied to the end
+  // (with a hyphen if required).
+  Word remainder = target;
+  remainder.offset += chosenOffset;
+  remainder.length -= chosenOffset;
+  remainder.width = measureWordWidth(renderer, fontId, word.substr(chosenOffset), target.style, scratch);
+
+  Word& prefix = words[wordIndex];
+  prefix.offset = copyWordToArena(target, chosenOffset, "", chosenNeedsHyphen);
+  prefix.length = chosenOffset + (chosenNeedsHyphen ? 1 : 0);
+  prefix.width = static_cast<uint16_t>(chosenWidth);
+
+  // Insert the remainder word (with matching style) directly after the prefix.
+  words.insert(words.begin() + wordIndex + 1, remainder);
+  return true;
+}
+
+void GreedyParsedText::extractLine(const size_t breakIndex, const int pageWidth, const int spaceWidth,
+                                   const std::vector<size_t>& lineBreakIndices,
+                                   const std::function<void(std::shared_ptr<TextBlock>)>& processLine) {
+  const size_t lineBreak = lineBreakIndices[breakIndex];
+  const size_t lastBreakAt = breakIndex > 0 ? lineBreakIndices[breakIndex - 1] : 0;
+  const size_t lineWordCount = lineBreak - lastBreakAt;
+
+  // Calculate total word width for this line
+  int lineWordWidthSum = 0;
+  size_t lineTextSize = 0;
+  for (size_t i = lastBreakAt; i < lineBreak; i++) {
+    lineWordWidthSum += words[i].width;
+    lineTextSize += words[i].length + 1;
+  }
+
+  // Calculate spacing
+  const int spareSpace = pageWidth - lineWordWidthSum;
+
+  int spacing = spaceWidth;
+  const bool isLastLine = breakIndex == lineBreakIndices.size() - 1;
+
+  if (style == TextBlock::JUSTIFIED && !isLastLine && lineWordCount >= 2) {
+    spacing = spareSpace / (lineWordCount - 1);
+  }
+
+  // Calculate initial x position
+  uint16_t xpos = 0;
+  if (style == TextBlock::RIGHT_ALIGN) {
+    xpos = spareSpace - (lineWordCount - 1) * spaceWidth;
+  } else if (style == TextBlock::CENTER_ALIGN) {
+    xpos = (spareSpace - (lineWordCount - 1) * spaceWidth) / 2;
+  }
+
+  // Copy the line's words into a text buffer of its own, dropping soft hyphens, and place them
+  std::string lineText;
+  lineText.reserve(lineTextSize);
+  std::vector<TextBlock::Word> lineWords;
+  lineWords.reserve(lineWordCount);
+  for (size_t i = lastBreakAt; i < lineBreak; i++) {
+    const Word& word = words[i];
+    const std::string_view bytes(wordText(word), word.length);
+    const auto offset = static_cast<uint16_t>(lineText.size());
+    size_t start = 0;
+    size_t pos;
+    while ((pos = bytes.find(SOFT_HYPHEN_UTF8, start)) != std::string_view::npos) {
+      lineText.append(bytes.substr(start, pos - start));
+      start = pos + SOFT_HYPHEN_BYTES;
+    }
+    lineText.append(bytes.substr(start));
+    lineWords.push_back({offset, static_cast<uint16_t>(lineText.size() - offset), xpos, word.style});
+    lineText.push_back('\0');
+    xpos += word.width + spacing;
+  }
+
+  processLine(std::make_shared<TextBlock>(std::move(lineText), std::move(lineWords), style));
+}
@@ -0,0 +1,61 @@
+#pragma once
+// ParsedText as it was before the total-fit breaker, when hyphenated text was broken greedily. Kept as the reference
+// for the line breaker benchmark.
+
+#include <EpdFontFamily.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lib/Epub/Epub/blocks/TextBlock.h"
+
+class GfxRenderer;
+
+class GreedyParsedText {
+  // A word of the paragraph. Its bytes live NUL-terminated in the arena at offset.
+  struct Word {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t width;
+    EpdFontFamily::Style style;
+  };
+
+  // Every word of the paragraph in one buffer, so a word costs a Word entry instead of a list node and a string
+  std::string arena;
+  std::vector<Word> words;
+  std::string scratch;
+  TextBlock::Style style;
+  bool extraParagraphSpacing;
+  bool hyphenationEnabled;
+
+  const char* wordText(const Word& word) const { return arena.c_str() + word.offset; }
+  uint32_t copyWordToArena(const Word& source, uint16_t length, const char* prefix, bool appendHyphen = false);
+  void applyParagraphIndent();
+  std::vector<size_t> computeLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth, int spaceWidth);
+  std::vector<size_t> computeHyphenatedLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth,
+                                                  int spaceWidth);
+  bool hyphenateWordAtIndex(size_t wordIndex, int availableWidth, const GfxRenderer& renderer, int fontId,
+                            bool allowFallbackBreaks);
+  void extractLine(size_t breakIndex, int pageWidth, int spaceWidth, const std::vector<size_t>& lineBreakIndices,
+                   const std::function<void(std::shared_ptr<TextBlock>)>& processLine);
+  void dropWords(size_t count);
+  void calculateWordWidths(const GfxRenderer& renderer, int fontId);
+
+ public:
+  explicit GreedyParsedText(const TextBlock::Style style, const bool extraParagraphSpacing,
+                            const bool hyphenationEnabled = false)
+      : style(style), extraParagraphSpacing(extraParagraphSpacing), hyphenationEnabled(hyphenationEnabled) {}
+  ~GreedyParsedText() = default;
+
+  void addWord(std::string_view word, EpdFontFamily::Style fontStyle);
+  void setStyle(const TextBlock::Style style) { this->style = style; }
+  TextBlock::Style getStyle() const { return style; }
+  size_t size() const { return words.size(); }
+  bool isEmpty() const { return words.empty(); }
+  void layoutAndExtractLines(const GfxRenderer& renderer, int fontId, uint16_t viewportWidth,
+                             const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
+                             bool includeLastLine = true);
+};
\ No newline at end of file
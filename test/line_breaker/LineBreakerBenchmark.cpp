@@ -0,0 +1,225 @@
+// Lays out justified paragraphs built from the hyphenation corpora with hyphenation on, through the total-fit breaker
+// in ParsedText and through the greedy hyphenating breaker it replaced. Reports lines per second and the quality of
+// the result: total demerits (squared space left over on every line but the last of a paragraph, plus the penalties
+// for lines ending on a hyphen), hyphenated line count and the mean and widest justified gap. Checks total fit never
+// does worse than greedy on those demerits, and that layout without hyphenation is unchanged.
+#include <GfxRenderer.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "GreedyParsedText.h"
+#include "lib/Epub/Epub/ParsedText.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr uint16_t VIEWPORT_WIDTH = 464;
+constexpr size_t FLUSH_THRESHOLD = 750;
+// As ParsedText charges them
+constexpr int64_t HYPHEN_DEMERITS = 24 * 24;
+constexpr int64_t CONSECUTIVE_HYPHEN_DEMERITS = 48 * 48;
+
+struct Corpus {
+  const char* name;
+  const char* file;
+  const char* language;
+};
+
+struct Word {
+  std::string text;
+  EpdFontFamily::Style style;
+};
+
+using Paragraph = std::vector<Word>;
+
+// Paragraphs of corpus words in a deterministic shuffle, with the odd styled word
+std::vector<Paragraph> buildParagraphs(const std::string& path) {
+  std::ifstream in(path);
+  std::vector<std::string> plain;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    const size_t bar = line.find('|');
+    if (bar == std::string::npos) continue;
+    plain.push_back(line.substr(0, bar));
+  }
+
+  std::vector<Paragraph> paragraphs;
+  uint32_t seed = 7;
+  const auto next = [&seed] { return seed = seed * 1103515245u + 12345u; };
+  size_t used = 0;
+  while (used < plain.size() * 2 && !plain.empty()) {
+    Paragraph paragraph;
+    const size_t words = 15 + (next() >> 8) % 200;
+    for (size_t w = 0; w < words; w++, used++) {
+      const uint32_t r = next();
+      const auto style = static_cast<EpdFontFamily::Style>((r >> 4) % 23 == 0 ? 1 + (r >> 2) % 3 : 0);
+      paragraph.push_back({plain[(r >> 8) % plain.size()], style});
+    }
+    paragraphs.push_back(std::move(paragraph));
+  }
+  return paragraphs;
+}
+
+struct Line {
+  std::vector<std::string> words;
+  std::vector<uint16_t> xPos;
+  std::vector<EpdFontFamily::Style> styles;
+  bool lastOfParagraph = false;
+  bool operator==(const Line& other) const { return words == other.words && xPos == other.xPos; }
+};
+
+template <typename Text>
+std::vector<Line> layout(const GfxRenderer& renderer, const std::vector<Paragraph>& paragraphs, const bool hyphenation,
+                         const bool keepLines) {
+  std::vector<Line> lines;
+  const auto onLine = [&](const std::shared_ptr<TextBlock>& block) {
+    if (!keepLines) return;
+    Line line;
+    for (const auto& word : block->getWords()) {
+      line.words.emplace_back(block->getWordText(word), word.length);
+      line.xPos.push_back(word.xPos);
+      line.styles.push_back(word.style);
+    }
+    lines.push_back(std::move(line));
+  };
+  for (const auto& paragraph : paragraphs) {
+    Text text(TextBlock::JUSTIFIED, false, hyphenation);
+    for (const auto& word : paragraph) {
+      text.addWord(word.text, word.style);
+      if (text.size() > FLUSH_THRESHOLD) {
+        text.layoutAndExtractLines(renderer, FONT_ID, VIEWPORT_WIDTH, onLine, false);
+      }
+    }
+    text.layoutAndExtractLines(renderer, FONT_ID, VIEWPORT_WIDTH, onLine);
+    if (keepLines && !lines.empty()) {
+      lines.back().lastOfParagraph = true;
+    }
+  }
+  return lines;
+}
+
+struct Quality {
+  int64_t demerits = 0;
+  size_t hyphenatedLines = 0;
+  double meanGap = 0;
+  int maxGap = 0;
+};
+
+// Measured from the rendered words themselves, so both breakers are judged the same way
+Quality assess(const GfxRenderer& renderer, const std::vector<Line>& lines) {
+  Quality quality;
+  const int spaceWidth = renderer.getSpaceWidth(FONT_ID);
+  size_t gapLines = 0;
+  bool previousHyphenated = false;
+  for (const auto& line : lines) {
+    if (line.lastOfParagraph) {
+      previousHyphenated = false;
+      continue;
+    }
+    int width = 0;
+    for (size_t i = 0; i < line.words.size(); i++) {
+      width += renderer.getTextWidth(FONT_ID, line.words[i].c_str(), line.styles[i]);
+    }
+    const int gaps = static_cast<int>(line.words.size()) - 1;
+    const int slack = std::max(0, VIEWPORT_WIDTH - width - gaps * spaceWidth);
+    quality.demerits += static_cast<int64_t>(slack) * slack;
+    const bool hyphenated = line.words.back().size() > 1 && line.words.back().back() == '-';
+    if (hyphenated) {
+      quality.demerits += previousHyphenated ? CONSECUTIVE_HYPHEN_DEMERITS : HYPHEN_DEMERITS;
+      quality.hyphenatedLines++;
+    }
+    previousHyphenated = hyphenated;
+    if (gaps > 0) {
+      const int gap = (VIEWPORT_WIDTH - width) / gaps;
+      quality.meanGap += gap;
+      quality.maxGap = std::max(quality.maxGap, gap);
+      gapLines++;
+    }
+  }
+  quality.meanGap = gapLines ? quality.meanGap / gapLines : 0;
+  return quality;
+}
+
+template <typename Text>
+double layoutSeconds(const GfxRenderer& renderer, const std::vector<Paragraph>& paragraphs) {
+  const auto start = std::chrono::steady_clock::now();
+  layout<Text>(renderer, paragraphs, true, false);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+  const std::string resources = std::string(CROSSPOINT_ROOT_DIR) + "/test/hyphenation_eval/resources";
+  const Corpus corpora[] = {
+      {"english", "english_hyphenation_tests.txt", "en"}, {"french", "french_hyphenation_tests.txt", "fr"},
+      {"german", "german_hyphenation_tests.txt", "de"},   {"russian", "russian_hyphenation_tests.txt", "ru"},
+      {"spanish", "spanish_hyphenation_tests.txt", "es"},
+  };
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+
+  int failures = 0;
+  for (const auto& corpus : corpora) {
+    const auto paragraphs = buildParagraphs(resources + "/" + corpus.file);
+    if (paragraphs.empty()) {
+      std::cerr << "FAIL could not read " << corpus.file << "\n";
+      failures++;
+      continue;
+    }
+    Hyphenator::setPreferredLanguage(corpus.language);
+
+    const bool plainSame = layout<GreedyParsedText>(renderer, paragraphs, false, true) ==
+                           layout<ParsedText>(renderer, paragraphs, false, true);
+    const auto greedyLines = layout<GreedyParsedText>(renderer, paragraphs, true, true);
+    const auto totalFitLines = layout<ParsedText>(renderer, paragraphs, true, true);
+    const Quality greedy = assess(renderer, greedyLines);
+    const Quality totalFit = assess(renderer, totalFitLines);
+    // Alternate the two so they see the same machine load
+    double greedySeconds = 0;
+    double totalFitSeconds = 0;
+    for (int i = 0; i < iterations; i++) {
+      greedySeconds += layoutSeconds<GreedyParsedText>(renderer, paragraphs);
+      totalFitSeconds += layoutSeconds<ParsedText>(renderer, paragraphs);
+    }
+    const double greedyRate = greedyLines.size() * iterations / greedySeconds;
+    const double totalFitRate = totalFitLines.size() * iterations / totalFitSeconds;
+
+    // The greedy breaks are always among those total fit considers, so it can only do better on the sum it minimises
+    const bool ok = plainSame && totalFit.demerits <= greedy.demerits;
+    if (!ok) {
+      failures++;
+    }
+    printf("%-4s %-8s plain layout %s\n", ok ? "OK" : "FAIL", corpus.name, plainSame ? "unchanged" : "DIFFERS");
+    printf("     greedy    %5zu lines, %8.0f lines/s, demerits %9lld, %4zu hyphenated, gap mean %.2f max %3d px\n",
+           greedyLines.size(), greedyRate, static_cast<long long>(greedy.demerits), greedy.hyphenatedLines,
+           greedy.meanGap, greedy.maxGap);
+    printf("     total-fit %5zu lines, %8.0f lines/s, demerits %9lld, %4zu hyphenated, gap mean %.2f max %3d px\n",
+           totalFitLines.size(), totalFitRate, static_cast<long long>(totalFit.demerits), totalFit.hyphenatedLines,
+           totalFit.meanGap, totalFit.maxGap);
+  }
+
+  if (failures) {
+    std::cerr << failures << " corpus/corpora failed\n";
+    return 1;
+  }
+  std::cout << "Total-fit line breaking beats greedy on demerits for every corpus\n";
+  return 0;
+}
@@ -0,0 +1,183 @@
+// Builds a chapter section through Epub and Section, then pages through it forwards and backwards the way
+// EpubReaderActivity does (load the current page, show it, read ahead). Checks every page handed out matches the page
+// a freshly opened section loads from the SD card, and that once read-ahead has run a page turn does no SD I/O.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <TestEpub.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub.h"
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/Section.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* CACHE_DIR = "/cache";
+constexpr uint16_t VIEWPORT_WIDTH = 464;
+constexpr uint16_t VIEWPORT_HEIGHT = 740;
+
+bool loadSection(Section& section) {
+  return section.loadSectionFile(FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, true);
+}
+
+std::vector<uint8_t> pageBytes(const Page& page) {
+  std::vector<uint8_t> bytes;
+  for (const auto& element : page.elements) {
+    element->serialize(bytes);
+  }
+  return bytes;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/page_cache_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir(CACHE_DIR);
+  if (!test_epub::writeEpub(std::string(dir) + EPUB_PATH,
+                            {.title = "Page Cache", .seed = 99, .paragraphs = 400, .italics = true})) {
+    std::cerr << "Could not write test book\n";
+    return 1;
+  }
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+
+  auto epub = std::make_shared<Epub>(EPUB_PATH, CACHE_DIR);
+  if (!epub->load()) {
+    std::cerr << "Could not load test book\n";
+    return 1;
+  }
+  {
+    Section builder(epub, 0, renderer);
+    if (!builder.createSectionFile(FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, true)) {
+      std::cerr << "Could not build section\n";
+      return 1;
+    }
+  }
+
+  // Every page as read by a section opened just for it, with nothing cached
+  int failures = 0;
+  std::vector<std::vector<uint8_t>> expected;
+  uint32_t coldIo = 0;
+  double coldMs = 0;
+  {
+    Section probe(epub, 0, renderer);
+    if (!loadSection(probe) || probe.pageCount < 10) {
+      std::cerr << "Could not load section\n";
+      return 1;
+    }
+    for (int i = 0; i < probe.pageCount; i++) {
+      Section cold(epub, 0, renderer);
+      const uint32_t ioBefore = FsFile::ioCount;
+      const auto start = Clock::now();
+      loadSection(cold);
+      cold.currentPage = i;
+      const auto page = cold.loadPageFromSectionFile();
+      coldMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      coldIo += FsFile::ioCount - ioBefore;
+      if (!page) {
+        std::cerr << "FAIL page " << i << " did not load\n";
+        failures++;
+        expected.emplace_back();
+        continue;
+      }
+      expected.push_back(pageBytes(*page));
+    }
+  }
+
+  // Forwards through the chapter, back to the start, then a few turns either way
+  Section section(epub, 0, renderer);
+  if (!loadSection(section)) {
+    std::cerr << "Could not load section\n";
+    return 1;
+  }
+  const int pageCount = section.pageCount;
+  std::vector<int> turns;
+  for (int i = 0; i < pageCount; i++) turns.push_back(i);
+  for (int i = pageCount - 2; i >= 0; i--) turns.push_back(i);
+  for (const int i : {1, 2, 3, 2, 1, 2, 3, 4}) turns.push_back(i);
+
+  uint32_t turnIo = 0;
+  uint32_t readAheadIo = 0;
+  double turnMs = 0;
+  for (size_t t = 0; t < turns.size(); t++) {
+    section.currentPage = turns[t];
+    const uint32_t ioBefore = FsFile::ioCount;
+    const auto start = Clock::now();
+    const auto page = section.loadPageFromSectionFile();
+    turnMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    const uint32_t io = FsFile::ioCount - ioBefore;
+    turnIo += io;
+
+    if (!page || pageBytes(*page) != expected[turns[t]]) {
+      std::cerr << "FAIL turn " << t << " to page " << turns[t] << " does not match the page on the SD card\n";
+      failures++;
+    }
+    // Only the first page and a turn that reverses direction may miss the cache
+    const bool reversed = t >= 2 && (turns[t] - turns[t - 1]) != (turns[t - 1] - turns[t - 2]);
+    if (io != 0 && t != 0 && !reversed) {
+      std::cerr << "FAIL turn " << t << " to page " << turns[t] << " touched the SD card " << io << " times\n";
+      failures++;
+    }
+
+    const uint32_t aheadBefore = FsFile::ioCount;
+    section.readAhead();
+    readAheadIo += FsFile::ioCount - aheadBefore;
+  }
+
+  // Page contents survive a rebuild of the same section dropping what was cached
+  section.currentPage = 0;
+  section.loadPageFromSectionFile();
+  if (!section.createSectionFile(FONT_ID, 1.0f, true, TextBlock::JUSTIFIED, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, true)) {
+    std::cerr << "FAIL could not rebuild section\n";
+    failures++;
+  } else {
+    for (int i = 0; i < pageCount; i += 7) {
+      section.currentPage = i;
+      const auto page = section.loadPageFromSectionFile();
+      if (!page || pageBytes(*page) != expected[i]) {
+        std::cerr << "FAIL page " << i << " differs after rebuilding the section\n";
+        failures++;
+      }
+    }
+  }
+
+  const size_t turnCount = turns.size();
+  printf("%d pages: cold load %.4f ms and %.2f reads/seeks per page\n", pageCount, coldMs / pageCount,
+         static_cast<double>(coldIo) / pageCount);
+  printf("%zu turns: cached load %.4f ms and %.2f reads/seeks per turn, read-ahead %.2f reads/seeks per turn\n",
+         turnCount, turnMs / turnCount, static_cast<double>(turnIo) / turnCount,
+         static_cast<double>(readAheadIo) / turnCount);
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All page cache checks passed\n";
+  return 0;
+}
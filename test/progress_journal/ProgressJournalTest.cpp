@@ -0,0 +1,151 @@
+// Turns pages in two pretend books and checks that progress stays in RAM until it is due, that a burst of page turns
+// is written as one journal record, that a journal ending in a torn or corrupt record still loads its last intact one,
+// and that a grown journal is folded into progress.bin, which is also what a book without a journal loads from.
+#include <ProgressJournal.h>
+#include <SDCardManager.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+int failures = 0;
+
+void expect(const bool condition, const std::string& what) {
+  if (!condition) {
+    std::cerr << "FAIL " << what << "\n";
+    failures++;
+  }
+}
+
+std::string root;
+
+uint64_t fileSize(const std::string& path) {
+  FsFile file;
+  if (!SdMan.openFileForRead("TEST", path, file)) {
+    return 0;
+  }
+  return file.size();
+}
+
+void appendRaw(const std::string& path, const uint8_t* data, const size_t size) {
+  FILE* file = fopen((root + path).c_str(), "ab");
+  fwrite(data, 1, size, file);
+  fclose(file);
+}
+
+void turnTo(const std::string& book, const uint8_t page) {
+  const uint8_t data[6] = {1, 0, page, 0, 40, 0};
+  PROGRESS_JOURNAL.update(book, data, sizeof(data));
+}
+
+// The page a book loads at, or -1 without progress
+int loadedPage(const std::string& book) {
+  uint8_t data[6];
+  return PROGRESS_JOURNAL.load(book, data, sizeof(data)) == sizeof(data) ? data[2] : -1;
+}
+
+// Loading another book first makes the journal read this one from the card, as after a reboot
+int reloadedPage(const std::string& book, const std::string& other) {
+  loadedPage(other);
+  return loadedPage(book);
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/progress_journal_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  root = dir;
+  SdMan.setRoot(root);
+  const std::string book = "/epub_1";
+  const std::string other = "/epub_2";
+  const std::string journal = book + "/" + ProgressJournal::JOURNAL_FILE;
+  const std::string checkpoint = book + "/" + ProgressJournal::CHECKPOINT_FILE;
+  SdMan.mkdir(book.c_str());
+  SdMan.mkdir(other.c_str());
+  constexpr uint64_t RECORD_SIZE = 6 + 5;
+
+  expect(loadedPage(book) == -1, "no progress at first");
+
+  // A progress.bin from before the journal
+  {
+    FsFile file;
+    SdMan.openFileForWrite("TEST", checkpoint, file);
+    const uint8_t data[6] = {1, 0, 7, 0, 40, 0};
+    file.write(data, sizeof(data));
+  }
+  expect(loadedPage(book) == 7, "progress.bin loads without a journal");
+
+  // Page turns stay in RAM until the delay has passed since the first unsaved one
+  const uint32_t writes = FsFile::writeCount;
+  for (uint8_t page = 8; page <= 20; page++) {
+    turnTo(book, page);
+  }
+  expect(FsFile::writeCount == writes && !SdMan.exists(journal.c_str()), "page turns don't touch the card");
+  expect(loadedPage(book) == 20, "unsaved progress loads from RAM");
+  expect(PROGRESS_JOURNAL.flushIfDue(millis()) && !SdMan.exists(journal.c_str()), "not due yet");
+  expect(PROGRESS_JOURNAL.flushIfDue(millis() + ProgressJournal::FLUSH_DELAY_MS), "due flush");
+  expect(fileSize(journal) == RECORD_SIZE, "a burst of page turns is one record");
+  expect(FsFile::writeCount == writes + 1, "a record is one write");
+  expect(fileSize(checkpoint) == 6, "progress.bin left alone");
+
+  // Back and forth to the saved page writes nothing
+  turnTo(book, 21);
+  turnTo(book, 20);
+  expect(PROGRESS_JOURNAL.flush() && fileSize(journal) == RECORD_SIZE, "saved page not written again");
+  turnTo(book, 21);
+  expect(PROGRESS_JOURNAL.flush() && fileSize(journal) == 2 * RECORD_SIZE, "records appended");
+  expect(reloadedPage(book, other) == 21, "last record wins");
+
+  // Turning a page in another book saves this one's first
+  turnTo(book, 22);
+  turnTo(other, 3);
+  expect(fileSize(journal) == 3 * RECORD_SIZE && reloadedPage(book, other) == 22, "switching books saves progress");
+  expect(reloadedPage(other, book) == 3, "loading a book saves the other one's progress");
+
+  // A record torn by a power loss, then one with a wrong checksum: the last intact record loads
+  const uint8_t torn[] = {6, 1, 0, 30};
+  appendRaw(journal, torn, sizeof(torn));
+  expect(reloadedPage(book, other) == 22, "torn record skipped");
+  const uint8_t corrupt[] = {6, 1, 0, 31, 0, 40, 0, 0xde, 0xad, 0xbe, 0xef};
+  FILE* file = fopen((root + journal).c_str(), "r+b");
+  fseek(file, 3 * RECORD_SIZE, SEEK_SET);
+  fwrite(corrupt, 1, sizeof(corrupt), file);
+  fclose(file);
+  expect(reloadedPage(book, other) == 22, "corrupt record skipped");
+
+  // Appending after a bad record would hide the new one, so the next save is folded into progress.bin
+  turnTo(book, 23);
+  expect(PROGRESS_JOURNAL.flush() && !SdMan.exists(journal.c_str()), "journal with a bad record compacted");
+  expect(reloadedPage(book, other) == 23 && fileSize(checkpoint) == 6, "compacted progress in progress.bin");
+
+  // A journal grown past its limit is folded into progress.bin too
+  uint8_t page = 24;
+  for (uint64_t size = 0; (size + 1) * RECORD_SIZE <= ProgressJournal::COMPACT_SIZE; size++, page++) {
+    turnTo(book, page);
+    PROGRESS_JOURNAL.flush();
+  }
+  expect(fileSize(journal) > ProgressJournal::COMPACT_SIZE - RECORD_SIZE, "journal grew");
+  turnTo(book, page);
+  expect(PROGRESS_JOURNAL.flush() && !SdMan.exists(journal.c_str()), "full journal compacted");
+  expect(reloadedPage(book, other) == page, "compacted progress loads");
+  turnTo(book, page + 1);
+  expect(PROGRESS_JOURNAL.flush() && fileSize(journal) == RECORD_SIZE, "journal starts over");
+  expect(reloadedPage(book, other) == page + 1, "new journal wins over progress.bin");
+
+  std::string cleanup = "rm -rf ";
+  cleanup += dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " progress journal check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All progress journal checks passed\n";
+  return 0;
+}
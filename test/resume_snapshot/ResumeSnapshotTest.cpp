@@ -0,0 +1,130 @@
+// Saves frame buffers shaped like a blank panel, a page of text and noise as resume snapshots and checks each comes
+// back byte for byte, that a page of text packs small, and that a snapshot of another book, one cut short or one with
+// a damaged byte is turned down.
+#include <HalDisplay.h>
+#include <SDCardManager.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ResumeSnapshot.h"
+
+namespace {
+int failures = 0;
+
+void expect(const bool condition, const std::string& what) {
+  if (!condition) {
+    std::cerr << "FAIL " << what << "\n";
+    failures++;
+  }
+}
+
+constexpr size_t SIZE = HalDisplay::BUFFER_SIZE;
+const std::string BOOK = "/Books/The Lighthouse.epub";
+
+// Lines of words: runs of black pixels between white, with white margins and gaps between lines
+std::vector<uint8_t> textPage() {
+  std::vector<uint8_t> page(SIZE, 0xFF);
+  std::mt19937 random(7);
+  for (int y = 40; y < HalDisplay::DISPLAY_HEIGHT - 40; y++) {
+    if (y % 24 >= 16) continue;
+    for (int x = 3; x < HalDisplay::DISPLAY_WIDTH_BYTES - 3; x++) {
+      if (random() % 6 != 0) {
+        page[y * HalDisplay::DISPLAY_WIDTH_BYTES + x] = static_cast<uint8_t>(random());
+      }
+    }
+  }
+  return page;
+}
+
+std::vector<uint8_t> noise() {
+  std::vector<uint8_t> page(SIZE);
+  std::mt19937 random(11);
+  for (auto& byte : page) byte = static_cast<uint8_t>(random());
+  return page;
+}
+
+bool roundTrips(const std::vector<uint8_t>& frame, const char* path) {
+  if (!resume::saveSnapshot(frame.data(), frame.size(), BOOK, path)) {
+    return false;
+  }
+  std::vector<uint8_t> loaded(SIZE, 0x55);
+  return resume::loadSnapshot(loaded.data(), loaded.size(), BOOK, path) && loaded == frame;
+}
+
+uint64_t fileSize(const char* path) {
+  FsFile file;
+  return SdMan.openFileForRead("TEST", path, file) ? file.size() : 0;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/resume_snapshot_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  const std::string root = dir;
+  SdMan.setRoot(root);
+  const char* path = "/resume.bin";
+  std::vector<uint8_t> frame(SIZE);
+
+  expect(!resume::loadSnapshot(frame.data(), SIZE, BOOK, path), "no snapshot at first");
+
+  expect(roundTrips(std::vector<uint8_t>(SIZE, 0xFF), path), "blank panel");
+  expect(fileSize(path) < 1024, "blank panel packs to a few hundred bytes: " + std::to_string(fileSize(path)));
+  expect(roundTrips(noise(), path), "noise");
+  expect(fileSize(path) < SIZE + SIZE / 64, "noise grows by a header per 128 bytes at most");
+  const std::vector<uint8_t> page = textPage();
+  expect(roundTrips(page, path), "page of text");
+  const uint64_t pageSize = fileSize(path);
+  expect(pageSize < SIZE * 9 / 10, "page of text packs: " + std::to_string(pageSize));
+
+  // Runs and literals at the very end of the buffer
+  std::vector<uint8_t> edges(SIZE, 0xFF);
+  edges[SIZE - 1] = 0x00;
+  edges[SIZE - 3] = 0x00;
+  expect(roundTrips(edges, path), "literals at the end");
+  edges.assign(SIZE, 0xFF);
+  edges[0] = 0x12;
+  edges[SIZE - 130] = 0x34;
+  expect(roundTrips(edges, path), "run to the end");
+
+  expect(roundTrips(page, path), "page saved again");
+  expect(!resume::loadSnapshot(frame.data(), SIZE, "/Books/Another.epub", path), "another book's snapshot");
+  expect(!resume::loadSnapshot(frame.data(), SIZE - 1, BOOK, path), "another panel size");
+
+  // A damaged byte in the middle fails the checksum
+  FILE* file = fopen((root + path).c_str(), "r+b");
+  fseek(file, static_cast<long>(pageSize / 2), SEEK_SET);
+  const int byte = fgetc(file);
+  fseek(file, static_cast<long>(pageSize / 2), SEEK_SET);
+  fputc(byte ^ 0x01, file);
+  fclose(file);
+  expect(!resume::loadSnapshot(frame.data(), SIZE, BOOK, path), "damaged snapshot");
+
+  // Cut short, as by a power loss while saving
+  expect(roundTrips(page, path), "page saved once more");
+  truncate((root + path).c_str(), static_cast<off_t>(pageSize - 100));
+  expect(!resume::loadSnapshot(frame.data(), SIZE, BOOK, path), "truncated snapshot");
+
+  resume::discardSnapshot(path);
+  expect(!SdMan.exists(path), "discarded");
+  resume::discardSnapshot(path);
+
+  std::string cleanup = "rm -rf ";
+  cleanup += dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " resume snapshot check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All resume snapshot checks passed (a page of text is " << pageSize << " of " << SIZE << " bytes)\n";
+  return 0;
+}
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/buffered_file"
+BINARY="$BUILD_DIR/BufferedFileTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/buffered_file/BufferedFileTest.cpp"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
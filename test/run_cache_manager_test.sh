@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/cache_manager"
+BINARY="$BUILD_DIR/CacheManagerTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/cache_manager/CacheManagerTest.cpp"
+  "$ROOT_DIR/src/CacheManager.cpp"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/chapter_stream"
+BINARY="$BUILD_DIR/ChapterStreamTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/chapter_stream/ChapterStreamTest.cpp"
+  "${ZIP_FILES[@]}"
+  "${CHAPTER_SOURCES[@]}"
+)
+
+compile_c_objects "${ZIP_C_SOURCES[@]}" "${CHAPTER_C_SOURCES[@]}"
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/chapter_tokens"
+BINARY="$BUILD_DIR/ChapterTokensTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/chapter_tokens/ChapterTokensTest.cpp"
+  "${EPUB_SOURCES[@]}"
+)
+
+compile_c_objects "${EPUB_C_SOURCES[@]}"
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+# Builds the host emulator (CROSSPOINT_EMULATED) and plays every script in test/emulator/scripts against the sample
+# books, failing when a screen no longer matches its recorded hash. The screens are left in build/emulator/screens.
+# Pass --update to record the current screens' hashes in the scripts instead.
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/emulator"
+BINARY="$BUILD_DIR/CrossPointEmulator"
+
+mkdir -p "$BUILD_DIR"
+
+# Every built-in font, slow to compile and rarely touched
+CACHED_SOURCES=(
+  "$ROOT_DIR/src/FontSetup.cpp"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/emulator/Emulator.cpp"
+  "$ROOT_DIR/test/emulator/EmulatedGpio.cpp"
+  "$ROOT_DIR/test/emulator/EmulatedRtos.cpp"
+  "$ROOT_DIR/src/CrossPointSettings.cpp"
+  "$ROOT_DIR/src/CrossPointState.cpp"
+  "$ROOT_DIR/src/MappedInputManager.cpp"
+  "$ROOT_DIR/src/RecentBooksStore.cpp"
+  "$ROOT_DIR/src/ScreenComponents.cpp"
+  "$ROOT_DIR/src/activities/ActivityWithSubactivity.cpp"
+  "$ROOT_DIR/src/activities/reader/EpubReaderActivity.cpp"
+  "$ROOT_DIR/src/activities/reader/EpubReaderChapterSelectionActivity.cpp"
+  "$ROOT_DIR/src/activities/reader/TxtReaderActivity.cpp"
+  "$ROOT_DIR/src/activities/reader/XtcReaderActivity.cpp"
+  "$ROOT_DIR/src/activities/reader/XtcReaderChapterSelectionActivity.cpp"
+  "${READER_SOURCES[@]}"
+)
+
+CXXFLAGS=("${COMMON_CXXFLAGS[@]}" -DCROSSPOINT_EMULATED=1)
+
+compile_c_objects "${EPUB_C_SOURCES[@]}"
+for src in "${CACHED_SOURCES[@]}"; do
+  obj="$BUILD_DIR/$(basename "$src" .cpp).o"
+  if [[ ! -f "$obj" || "$src" -nt "$obj" ]]; then
+    c++ "${CXXFLAGS[@]}" -c "$src" -o "$obj"
+  fi
+  OBJECTS+=("$obj")
+done
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -o "$BINARY"
+
+UPDATE=()
+if [[ "${1:-}" == "--update" ]]; then
+  UPDATE=(--update)
+fi
+
+SD_DIR="$BUILD_DIR/sd"
+SCREENS_DIR="$BUILD_DIR/screens"
+python3 "$ROOT_DIR/test/emulator/make_books.py" "$SD_DIR/books"
+
+failures=0
+for script in "$ROOT_DIR"/test/emulator/scripts/*.txt; do
+  name="$(basename "$script" .txt)"
+  book="$(sed -n 's/^# book: *//p' "$script")"
+  # Every script starts from a fresh card: no settings, progress or caches
+  rm -rf "$SD_DIR/.crosspoint" "$SCREENS_DIR/$name"
+  mkdir -p "$SCREENS_DIR/$name"
+  echo "== $name ($book)"
+  if ! "$BINARY" --sd "$SD_DIR" --out "$SCREENS_DIR/$name" "${UPDATE[@]}" "$book" "$script"; then
+    failures=$((failures + 1))
+  fi
+done
+
+if [[ $failures -ne 0 ]]; then
+  echo "$failures script(s) failed, screens are in $SCREENS_DIR" >&2
+  exit 1
+fi
+echo "All emulator scripts passed"
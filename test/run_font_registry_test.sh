@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/font_registry"
+BINARY="$BUILD_DIR/FontRegistryTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/font_registry/FontRegistryTest.cpp"
+  "${RENDER_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/glyph_blit"
+BINARY="$BUILD_DIR/GlyphBlitBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/glyph_blit/GlyphBlitBenchmark.cpp"
+  "${RENDER_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
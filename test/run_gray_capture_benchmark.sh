@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/gray_capture"
+BINARY="$BUILD_DIR/GrayCaptureBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/gray_capture/GrayCaptureBenchmark.cpp"
+  "${RENDER_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/line_breaker"
+BINARY="$BUILD_DIR/LineBreakerBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/line_breaker/LineBreakerBenchmark.cpp"
+  "$ROOT_DIR/test/line_breaker/GreedyParsedText.cpp"
+  "${TEXT_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" -DCROSSPOINT_ROOT_DIR="\"$ROOT_DIR\"" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
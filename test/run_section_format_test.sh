@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/section_format"
+BINARY="$BUILD_DIR/SectionFormatTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/section_format/SectionFormatTest.cpp"
+  "${CHAPTER_SOURCES[@]}"
+)
+
+compile_c_objects "${CHAPTER_C_SOURCES[@]}"
+
+c++ "${COMMON_CXXFLAGS[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
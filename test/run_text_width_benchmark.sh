@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/text_width"
+BINARY="$BUILD_DIR/TextWidthBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/text_width/TextWidthBenchmark.cpp"
+  "${RENDER_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" -DCROSSPOINT_ROOT_DIR="\"$ROOT_DIR\"" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/trace"
+BINARY="$BUILD_DIR/TraceTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/trace/TraceTest.cpp"
+  "${TRACE_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" -pthread "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source "$(dirname "${BASH_SOURCE[0]}")/common_sources.sh"
+BUILD_DIR="$ROOT_DIR/build/word_arena"
+BINARY="$BUILD_DIR/WordArenaBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/word_arena/WordArenaBenchmark.cpp"
+  "$ROOT_DIR/test/word_arena/LegacyParsedText.cpp"
+  "${TEXT_SOURCES[@]}"
+)
+
+c++ "${COMMON_CXXFLAGS[@]}" -DCROSSPOINT_ROOT_DIR="\"$ROOT_DIR\"" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,362 @@
+// Lays out a chapter, writes its pages both as compact page records and in the previous section.bin page encoding
+// (kept below as the reference), and checks both decode to exactly the pages the parser produced. Reports file size,
+// write calls and the time to load every page back the way Section::loadPageFromSectionFile does.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+#include "lib/Epub/Epub/parsers/ChapterHtmlSlimParser.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr const char* LEGACY_PATH = "/legacy.bin";
+constexpr const char* COMPACT_PATH = "/compact.bin";
+constexpr int LOAD_ROUNDS = 5;
+
+struct LayoutParams {
+  const char* name;
+  uint8_t paragraphAlignment;
+  bool extraParagraphSpacing;
+  bool hyphenationEnabled;
+};
+
+std::string buildChapter(const size_t paragraphs) {
+  static const char* const kWords[] = {
+      "the",     "reader",     "turned",      "another",  "page",          "and",       "found",   "nothing",
+      "but",     "footnotes",  "Übergrößen",  "характер", "lighthouse",    "morning",   "a",       "of",
+      "was",     "remarkable", "hyphenation", "it",       "straightforward", "quietly", "déjà-vu", "“quoted”"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>T</title>"
+      "</head><body>\n";
+  uint32_t seed = 4242;
+  for (size_t p = 0; p < paragraphs; p++) {
+    if (p % 20 == 0) {
+      html += "<h2>Chapter " + std::to_string(p / 20 + 1) + "</h2>\n";
+    }
+    html += p % 7 == 3 ? "<p style=\"text-align: center\">" : "<p>";
+    const size_t words = 10 + (seed % 90);
+    for (size_t w = 0; w < words; w++) {
+      seed = seed * 1103515245u + 12345u;
+      const char* word = kWords[(seed >> 16) % kWordCount];
+      if (w > 0) html += ' ';
+      if ((seed >> 8) % 13 == 0) {
+        html += std::string("<b>") + word + "</b>";
+      } else if ((seed >> 8) % 11 == 0) {
+        html += std::string("<i>") + word + "</i>";
+      } else if ((seed >> 8) % 29 == 0) {
+        html += std::string("<b><i>") + word + "</i></b>";
+      } else {
+        html += word;
+      }
+    }
+    html += ".</p>\n";
+  }
+  html += "</body></html>\n";
+  return html;
+}
+
+std::vector<std::unique_ptr<Page>> layoutPages(GfxRenderer& renderer, const LayoutParams& params,
+                                               const std::string& html) {
+  std::vector<std::unique_ptr<Page>> pages;
+  size_t offset = 0;
+  ChapterHtmlSlimParser parser(
+      [&html, &offset](uint8_t* buf, const size_t len) {
+        const size_t n = std::min(len, html.size() - offset);
+        memcpy(buf, html.data() + offset, n);
+        offset += n;
+        return n;
+      },
+      html.size(), renderer, FONT_ID, 1.0f, params.extraParagraphSpacing, params.paragraphAlignment, 464, 760,
+      params.hyphenationEnabled, [&pages](std::unique_ptr<Page> page) { pages.push_back(std::move(page)); });
+  if (!parser.parseAndBuildPages()) pages.clear();
+  return pages;
+}
+
+struct TestWord {
+  std::string text;
+  uint16_t xPos;
+  EpdFontFamily::Style style;
+};
+
+std::shared_ptr<TextBlock> makeBlock(const std::vector<TestWord>& testWords, const TextBlock::Style style) {
+  std::string text;
+  std::vector<TextBlock::Word> words;
+  for (const auto& w : testWords) {
+    words.push_back({static_cast<uint16_t>(text.size()), static_cast<uint16_t>(w.text.size()), w.xPos, w.style});
+    text += w.text;
+    text.push_back('\0');
+  }
+  return std::make_shared<TextBlock>(std::move(text), std::move(words), style);
+}
+
+// The section.bin version 10 page encoding: fixed-width fields and a length-prefixed string per word, each its own
+// write
+bool writeLegacyPage(FsFile& file, const Page& page) {
+  serialization::writePod(file, static_cast<uint16_t>(page.elements.size()));
+  for (const auto& el : page.elements) {
+    const auto& line = static_cast<const PageLine&>(*el);
+    const auto& block = *line.getBlock();
+    serialization::writePod(file, static_cast<uint8_t>(TAG_PageLine));
+    serialization::writePod(file, line.xPos);
+    serialization::writePod(file, line.yPos);
+    serialization::writePod(file, static_cast<uint16_t>(block.getWords().size()));
+    for (const auto& w : block.getWords()) serialization::writeString(file, block.getWordText(w));
+    for (const auto& w : block.getWords()) serialization::writePod(file, w.xPos);
+    for (const auto& w : block.getWords()) serialization::writePod(file, w.style);
+    serialization::writePod(file, block.getStyle());
+  }
+  return true;
+}
+
+std::unique_ptr<Page> readLegacyPage(FsFile& file) {
+  auto page = std::unique_ptr<Page>(new Page());
+  uint16_t count;
+  serialization::readPod(file, count);
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t tag;
+    int16_t xPos;
+    int16_t yPos;
+    uint16_t wc;
+    serialization::readPod(file, tag);
+    serialization::readPod(file, xPos);
+    serialization::readPod(file, yPos);
+    serialization::readPod(file, wc);
+    if (tag != TAG_PageLine || wc > 10000) return nullptr;
+    std::vector<TestWord> words(wc);
+    TextBlock::Style style;
+    for (auto& w : words) serialization::readString(file, w.text);
+    for (auto& w : words) serialization::readPod(file, w.xPos);
+    for (auto& w : words) serialization::readPod(file, w.style);
+    serialization::readPod(file, style);
+    page->elements.push_back(std::make_shared<PageLine>(makeBlock(words, style), xPos, yPos));
+  }
+  return page;
+}
+
+bool samePage(const Page& a, const Page& b) {
+  if (a.elements.size() != b.elements.size()) return false;
+  for (size_t i = 0; i < a.elements.size(); i++) {
+    const auto& lineA = static_cast<const PageLine&>(*a.elements[i]);
+    const auto& lineB = static_cast<const PageLine&>(*b.elements[i]);
+    const auto& blockA = *lineA.getBlock();
+    const auto& blockB = *lineB.getBlock();
+    if (lineA.xPos != lineB.xPos || lineA.yPos != lineB.yPos || blockA.getStyle() != blockB.getStyle() ||
+        blockA.getWords().size() != blockB.getWords().size()) {
+      return false;
+    }
+    for (size_t j = 0; j < blockA.getWords().size(); j++) {
+      const auto& wordA = blockA.getWords()[j];
+      const auto& wordB = blockB.getWords()[j];
+      if (wordA.xPos != wordB.xPos || wordA.style != wordB.style || wordA.length != wordB.length ||
+          strcmp(blockA.getWordText(wordA), blockB.getWordText(wordB)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Writes every page to path and returns the start offset of each, like the section LUT
+std::vector<uint32_t> writePages(const char* path, const std::vector<std::unique_ptr<Page>>& pages, const bool legacy,
+                                 uint32_t& writeCalls, uint64_t& fileSize) {
+  FsFile file;
+  std::vector<uint32_t> lut;
+  if (!SdMan.openFileForWrite("TST", path, file)) return lut;
+  const uint32_t writesBefore = FsFile::writeCount;
+  for (const auto& page : pages) {
+    lut.push_back(file.position());
+    if (!(legacy ? writeLegacyPage(file, *page) : page->serialize(file))) {
+      lut.clear();
+      break;
+    }
+  }
+  writeCalls = FsFile::writeCount - writesBefore;
+  fileSize = file.position();
+  file.close();
+  return lut;
+}
+
+std::vector<std::unique_ptr<Page>> loadPages(const char* path, const std::vector<uint32_t>& lut, const bool legacy,
+                                             double& ms) {
+  std::vector<std::unique_ptr<Page>> pages;
+  const auto start = std::chrono::steady_clock::now();
+  for (const uint32_t pos : lut) {
+    // One open per page, as the reader does
+    FsFile file;
+    if (!SdMan.openFileForRead("TST", path, file)) break;
+    file.seek(pos);
+    pages.push_back(legacy ? readLegacyPage(file) : Page::deserialize(file));
+  }
+  ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return pages;
+}
+
+int checkVarints() {
+  int failures = 0;
+  std::vector<uint8_t> record;
+  const uint32_t unsignedValues[] = {0, 1, 127, 128, 300, 16383, 16384, 65535, UINT32_MAX};
+  const int32_t signedValues[] = {0, 1, -1, 63, 64, -64, -65, 8191, -8192, INT16_MIN, INT16_MAX, INT32_MIN, INT32_MAX};
+  for (const auto v : unsignedValues) serialization::writeVarint(record, v);
+  for (const auto v : signedValues) serialization::writeSignedVarint(record, v);
+
+  serialization::RecordReader reader(record.data(), record.size());
+  for (const auto v : unsignedValues) {
+    if (reader.readVarint() != v) {
+      std::cerr << "FAIL varint " << v << "\n";
+      failures++;
+    }
+  }
+  for (const auto v : signedValues) {
+    if (reader.readSignedVarint() != v) {
+      std::cerr << "FAIL signed varint " << v << "\n";
+      failures++;
+    }
+  }
+  if (reader.hasFailed() || !reader.atEnd() || reader.readByte() != 0 || !reader.hasFailed()) {
+    std::cerr << "FAIL record reader bounds\n";
+    failures++;
+  }
+  return failures;
+}
+
+// A record cut short, or a length that points past the file, must not produce a page
+int checkCorruptRecords(const Page& page) {
+  int failures = 0;
+  FsFile file;
+  if (!SdMan.openFileForWrite("TST", COMPACT_PATH, file) || !page.serialize(file)) return 1;
+  const uint64_t size = file.position();
+  file.close();
+
+  for (const uint32_t length : {0u, static_cast<uint32_t>(size / 2), static_cast<uint32_t>(size) + 10u, 1u << 30}) {
+    std::vector<uint8_t> bytes(size);
+    if (!SdMan.openFileForRead("TST", COMPACT_PATH, file)) return 1;
+    file.read(bytes.data(), size);
+    file.close();
+    memcpy(bytes.data(), &length, sizeof(length));
+    if (!SdMan.openFileForWrite("TST", COMPACT_PATH, file)) return 1;
+    file.write(bytes.data(), bytes.size());
+    file.close();
+
+    if (!SdMan.openFileForRead("TST", COMPACT_PATH, file)) return 1;
+    if (Page::deserialize(file)) {
+      std::cerr << "FAIL record with length " << length << " of " << size << " bytes decoded\n";
+      failures++;
+    }
+    file.close();
+  }
+  return failures;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/section_format_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+  Hyphenator::setPreferredLanguage("en");
+
+  int failures = checkVarints();
+  const std::string chapter = buildChapter(600);
+  const LayoutParams layouts[] = {
+      {"justified", 0, true, false},
+      {"left+hyphenation", 1, false, true},
+  };
+  for (const auto& params : layouts) {
+    auto pages = layoutPages(renderer, params, chapter);
+    if (pages.empty()) {
+      std::cerr << "FAIL " << params.name << ": no pages\n";
+      failures++;
+      continue;
+    }
+    // Coordinates the parser never produces, and a line without words
+    auto edge = std::unique_ptr<Page>(new Page());
+    edge->elements.push_back(std::make_shared<PageLine>(makeBlock({}, TextBlock::RIGHT_ALIGN), -300, INT16_MIN));
+    edge->elements.push_back(std::make_shared<PageLine>(
+        makeBlock({{"", 65535, EpdFontFamily::BOLD_ITALIC}, {"x", 0, EpdFontFamily::REGULAR},
+                   {"wide", 40000, EpdFontFamily::ITALIC}},
+                  TextBlock::CENTER_ALIGN),
+        INT16_MAX, 12));
+    pages.push_back(std::move(edge));
+
+    uint32_t legacyWrites = 0;
+    uint32_t compactWrites = 0;
+    uint64_t legacySize = 0;
+    uint64_t compactSize = 0;
+    const auto legacyLut = writePages(LEGACY_PATH, pages, true, legacyWrites, legacySize);
+    const auto compactLut = writePages(COMPACT_PATH, pages, false, compactWrites, compactSize);
+    if (legacyLut.size() != pages.size() || compactLut.size() != pages.size()) {
+      std::cerr << "FAIL " << params.name << ": could not write pages\n";
+      failures++;
+      continue;
+    }
+
+    double legacyMs = 0;
+    double compactMs = 0;
+    for (int round = 0; round < LOAD_ROUNDS; round++) {
+      const auto legacy = loadPages(LEGACY_PATH, legacyLut, true, legacyMs);
+      const auto compact = loadPages(COMPACT_PATH, compactLut, false, compactMs);
+      for (size_t i = 0; i < pages.size(); i++) {
+        if (!legacy[i] || !compact[i] || !samePage(*pages[i], *legacy[i]) || !samePage(*legacy[i], *compact[i])) {
+          std::cerr << "FAIL " << params.name << ": page " << i << " does not round-trip\n";
+          failures++;
+          break;
+        }
+      }
+    }
+    if (compactWrites != pages.size()) {
+      std::cerr << "FAIL " << params.name << ": " << compactWrites << " write calls for " << pages.size()
+                << " pages\n";
+      failures++;
+    }
+    if (compactSize >= legacySize) {
+      std::cerr << "FAIL " << params.name << ": compact pages are not smaller\n";
+      failures++;
+    }
+    const double n = static_cast<double>(pages.size()) * LOAD_ROUNDS;
+    printf("%-17s %zu pages: v10 %llu bytes, %u writes, %.4f ms/page load; compact %llu bytes (%.0f%%), %u writes, "
+           "%.4f ms/page load\n",
+           params.name, pages.size(), static_cast<unsigned long long>(legacySize), legacyWrites, legacyMs / n,
+           static_cast<unsigned long long>(compactSize), 100.0 * compactSize / legacySize, compactWrites,
+           compactMs / n);
+
+    failures += checkCorruptRecords(*pages.front());
+  }
+
+  SdMan.remove(LEGACY_PATH);
+  SdMan.remove(COMPACT_PATH);
+  rmdir(dir);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All section format checks passed\n";
+  return 0;
+}
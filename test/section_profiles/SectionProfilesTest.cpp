@@ -0,0 +1,259 @@
+// Opens the chapters of a book under alternating layouts, the way flipping fonts or rotating the device does, and
+// checks a layout used before loads its section files instead of rebuilding them. Also checks the oldest profiles are
+// evicted past the profile count and byte limits, never the one in use, and that section files from before profiles
+// and the profile directories of a lost list are removed.
+#include <GfxRenderer.h>
+#include <SDCardManager.h>
+#include <TestEpub.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub.h"
+#include "lib/Epub/Epub/Section.h"
+#include "lib/Epub/Epub/SectionProfiles.h"
+#include "lib/Epub/Epub/blocks/TextBlock.h"
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* CACHE_DIR = "/cache";
+constexpr int CHAPTERS = 4;
+
+struct Layout {
+  const char* name;
+  uint8_t paragraphAlignment;
+  uint16_t viewportWidth;
+  uint16_t viewportHeight;
+};
+
+// Opens a chapter the way the reader does: load its section file, build it if that fails
+struct OpenResult {
+  bool ok = false;
+  bool built = false;
+  double ms = 0;
+};
+
+OpenResult openChapter(const std::shared_ptr<Epub>& epub, GfxRenderer& renderer, const int spine,
+                       const Layout& layout) {
+  OpenResult result;
+  Section section(epub, spine, renderer);
+  const auto start = std::chrono::steady_clock::now();
+  result.ok = section.loadSectionFile(FONT_ID, 1.0f, true, layout.paragraphAlignment, layout.viewportWidth,
+                                      layout.viewportHeight, true);
+  if (!result.ok) {
+    result.built = true;
+    result.ok = section.createSectionFile(FONT_ID, 1.0f, true, layout.paragraphAlignment, layout.viewportWidth,
+                                          layout.viewportHeight, true);
+  }
+  result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+std::vector<SectionProfiles::Profile> profileList(const std::string& sectionsDir) {
+  FsFile file;
+  std::vector<SectionProfiles::Profile> profiles;
+  if (!SdMan.openFileForRead("TST", sectionsDir + "/profiles.bin", file)) return profiles;
+  uint8_t header[2];
+  file.read(header, sizeof(header));
+  for (int i = 0; i < header[1]; i++) {
+    SectionProfiles::Profile profile;
+    file.read(reinterpret_cast<uint8_t*>(&profile), sizeof(profile));
+    profiles.push_back(profile);
+  }
+  file.close();
+  return profiles;
+}
+
+// What the section files under a profile directory actually take
+uint64_t profileDirBytes(const std::string& hostDir) {
+  uint64_t bytes = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(hostDir)) {
+    bytes += entry.file_size();
+  }
+  return bytes;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/section_profiles_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir(CACHE_DIR);
+  if (!test_epub::writeEpub(std::string(dir) + EPUB_PATH,
+                            {.title = "Profiles", .chapters = CHAPTERS})) {
+    std::cerr << "Could not write test book\n";
+    return 1;
+  }
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+
+  auto epub = std::make_shared<Epub>(EPUB_PATH, CACHE_DIR);
+  if (!epub->load()) {
+    std::cerr << "Could not load test book\n";
+    return 1;
+  }
+  const std::string sectionsDir = epub->getCachePath() + "/sections";
+  int failures = 0;
+
+  // A section file from before profiles
+  const std::string legacyPath = sectionsDir + "/1.bin";
+  SdMan.mkdir(sectionsDir.c_str());
+  {
+    FsFile legacy;
+    SdMan.openFileForWrite("TST", legacyPath, legacy);
+    legacy.write(reinterpret_cast<const uint8_t*>("stale"), 5);
+    legacy.close();
+  }
+
+  const Layout portrait = {"portrait", TextBlock::JUSTIFIED, 464, 740};
+  const Layout landscape = {"landscape", TextBlock::JUSTIFIED, 740, 464};
+  const Layout layouts[] = {portrait, landscape, portrait, landscape, portrait};
+  double buildMs = 0;
+  double loadMs = 0;
+  int builds = 0;
+  int loads = 0;
+  for (size_t round = 0; round < sizeof(layouts) / sizeof(layouts[0]); round++) {
+    for (int spine = 0; spine < CHAPTERS; spine++) {
+      const auto result = openChapter(epub, renderer, spine, layouts[round]);
+      if (!result.ok) {
+        std::cerr << "FAIL chapter " << spine << " did not open in " << layouts[round].name << "\n";
+        failures++;
+      }
+      // Only the first visit to each layout builds
+      if (result.built != (round < 2)) {
+        std::cerr << "FAIL chapter " << spine << " round " << round << (result.built ? " rebuilt" : " was not built")
+                  << "\n";
+        failures++;
+      }
+      (result.built ? buildMs : loadMs) += result.ms;
+      (result.built ? builds : loads)++;
+    }
+  }
+  if (SdMan.exists(legacyPath.c_str())) {
+    std::cerr << "FAIL section file from before profiles was not removed\n";
+    failures++;
+  }
+  printf("%d chapter opens built in %.2f ms each, %d reopened a profile in %.2f ms each\n", builds, buildMs / builds,
+         loads, loadMs / loads);
+
+  // More layouts than profiles: the oldest go, the one in use stays
+  const uint16_t widths[] = {400, 410, 420, 430, 440};
+  for (const uint16_t width : widths) {
+    openChapter(epub, renderer, 0, {"width", TextBlock::LEFT_ALIGN, width, 740});
+  }
+  const auto list = profileList(sectionsDir);
+  if (list.size() != SectionProfiles::MAX_PROFILES) {
+    std::cerr << "FAIL " << list.size() << " profiles kept, expected " << SectionProfiles::MAX_PROFILES << "\n";
+    failures++;
+  }
+  const auto reopened = openChapter(epub, renderer, 0, {"width", TextBlock::LEFT_ALIGN, widths[4], 740});
+  if (reopened.built) {
+    std::cerr << "FAIL profile in use was evicted\n";
+    failures++;
+  }
+  if (!openChapter(epub, renderer, 1, portrait).built) {
+    std::cerr << "FAIL oldest profile was not evicted\n";
+    failures++;
+  }
+
+  // Rebuilding or clearing a chapter's section file swaps its size in the profile rather than adding to it
+  {
+    Section section(epub, 1, renderer);
+    for (int rebuild = 0; rebuild < 3; rebuild++) {
+      section.createSectionFile(FONT_ID, 1.0f, true, portrait.paragraphAlignment, portrait.viewportWidth,
+                                portrait.viewportHeight, true);
+    }
+    const std::string hostProfileDir = std::string(dir) + section.getProfileDir();
+    if (profileList(sectionsDir).front().bytes != profileDirBytes(hostProfileDir)) {
+      std::cerr << "FAIL profile size drifted on rebuilds: " << profileList(sectionsDir).front().bytes << " vs "
+                << profileDirBytes(hostProfileDir) << " bytes on the card\n";
+      failures++;
+    }
+    section.clearCache();
+    if (profileList(sectionsDir).front().bytes != profileDirBytes(hostProfileDir)) {
+      std::cerr << "FAIL cleared section file still counted in the profile size\n";
+      failures++;
+    }
+  }
+
+  // A lost list leaves only the profile in use, measured from its files
+  {
+    SdMan.remove((sectionsDir + "/profiles.bin").c_str());
+    Section section(epub, 2, renderer);
+    section.createSectionFile(FONT_ID, 1.0f, true, portrait.paragraphAlignment, portrait.viewportWidth,
+                              portrait.viewportHeight, true);
+    int profileDirs = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(std::string(dir) + sectionsDir)) {
+      profileDirs += entry.is_directory();
+    }
+    const auto rebuilt = profileList(sectionsDir);
+    if (profileDirs != 1 || rebuilt.size() != 1) {
+      std::cerr << "FAIL " << profileDirs << " profile directories and " << rebuilt.size()
+                << " profiles after losing the list, expected 1\n";
+      failures++;
+    } else if (rebuilt.front().bytes != profileDirBytes(std::string(dir) + section.getProfileDir())) {
+      std::cerr << "FAIL profile kept after losing the list was not measured\n";
+      failures++;
+    }
+  }
+
+  // Byte limit, on a separate directory
+  const std::string budgetDir = "/budget";
+  SdMan.mkdir(budgetDir.c_str());
+  SectionProfiles budget(budgetDir, 0, 8, 1000);
+  // Writes a section file of the given size under fingerprint's profile, then touches it as Section does
+  const auto addSection = [&](const uint32_t fingerprint, const uint32_t bytes) {
+    const std::string profile = SectionProfiles::profileDir(budgetDir, fingerprint);
+    SdMan.mkdir(profile.c_str());
+    const std::string path = profile + "/" + std::to_string(profileDirBytes(std::string(dir) + profile)) + ".bin";
+    FsFile file;
+    SdMan.openFileForWrite("TST", path, file);
+    const std::vector<uint8_t> data(bytes);
+    file.write(data.data(), data.size());
+    file.close();
+    budget.touch(fingerprint, bytes);
+  };
+  addSection(1, 400);
+  addSection(2, 400);
+  addSection(3, 400);
+  const auto& kept = budget.getProfiles();
+  if (kept.size() != 2 || kept[0].fingerprint != 3 || kept[1].fingerprint != 2 ||
+      SdMan.exists(SectionProfiles::profileDir(budgetDir, 1).c_str())) {
+    std::cerr << "FAIL byte limit did not evict the oldest profile\n";
+    failures++;
+  }
+  addSection(2, 5000);
+  if (kept.size() != 1 || kept[0].fingerprint != 2) {
+    std::cerr << "FAIL profile over the byte limit on its own should be the only one kept\n";
+    failures++;
+  }
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All section profile checks passed\n";
+  return 0;
+}
@@ -0,0 +1,157 @@
+// Builds a book.bin through BookMetadataCache, then checks the in-RAM spine table and memoized TOC titles return
+// exactly what the book.bin lookups return, and that a simulated read through the book (progress, chapter index and
+// chapter title on every page, as the status bar does) only touches the SD card for the first title of a chapter.
+#include <SDCardManager.h>
+#include <ZipFile.h>
+#include <miniz.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/BookMetadataCache.h"
+
+namespace {
+const std::string EPUB_PATH = "/book.epub";
+constexpr const char* CACHE_DIR = "/cache";
+constexpr int SPINE_COUNT = 600;  // Above LARGE_SPINE_THRESHOLD, so the batch size lookup is used too
+constexpr int PAGES_PER_CHAPTER = 12;
+
+std::string chapterHref(const int i) { return "OEBPS/Text/chapter" + std::to_string(i) + ".xhtml"; }
+
+bool writeZip(const std::string& path) {
+  mz_zip_archive archive = {};
+  if (!mz_zip_writer_init_file(&archive, path.c_str(), 0)) return false;
+  bool ok = true;
+  for (int i = 0; i < SPINE_COUNT && ok; i++) {
+    const std::string content(500 + (i * 131) % 7000, static_cast<char>('a' + i % 26));
+    ok = mz_zip_writer_add_mem(&archive, chapterHref(i).c_str(), content.data(), content.size(), MZ_DEFAULT_LEVEL);
+  }
+  ok = ok && mz_zip_writer_finalize_archive(&archive);
+  mz_zip_writer_end(&archive);
+  return ok;
+}
+
+// Every third chapter starts a TOC entry, so most chapters inherit the title of the one before
+bool buildBook() {
+  BookMetadataCache cache(CACHE_DIR);
+  if (!cache.beginWrite() || !cache.beginContentOpfPass()) return false;
+  for (int i = 0; i < SPINE_COUNT; i++) {
+    cache.createSpineEntry(chapterHref(i));
+  }
+  if (!cache.endContentOpfPass() || !cache.beginTocPass()) return false;
+  for (int i = 0; i < SPINE_COUNT; i += 3) {
+    cache.createTocEntry("Chapter " + std::to_string(i / 3 + 1) + ": a title long enough to matter", chapterHref(i),
+                         "", 1);
+  }
+  if (!cache.endTocPass() || !cache.endWrite()) return false;
+
+  ZipFile zip(EPUB_PATH);
+  BookMetadataCache::BookMetadata metadata;
+  metadata.title = "Spine Table";
+  const bool ok = cache.buildBookBin(zip, metadata);
+  cache.cleanupTmpFiles();
+  return ok;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/spine_table_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir(CACHE_DIR);
+  if (!writeZip(std::string(dir) + EPUB_PATH) || !buildBook()) {
+    std::cerr << "Could not build test book\n";
+    return 1;
+  }
+
+  int failures = 0;
+  BookMetadataCache cache(CACHE_DIR);
+  if (!cache.load() || cache.getSpineCount() != SPINE_COUNT) {
+    std::cerr << "Could not load test book\n";
+    return 1;
+  }
+
+  // RAM table against the book.bin entries
+  for (int i = 0; i < SPINE_COUNT; i++) {
+    const auto entry = cache.getSpineEntry(i);
+    if (cache.getCumulativeSize(i) != entry.cumulativeSize || cache.getSpineTocIndex(i) != entry.tocIndex) {
+      std::cerr << "FAIL spine " << i << " differs from book.bin\n";
+      failures++;
+    }
+  }
+  for (int i = 0; i < cache.getTocCount(); i++) {
+    if (cache.getTocTitle(i) != cache.getTocEntry(i).title) {
+      std::cerr << "FAIL TOC title " << i << " differs from book.bin\n";
+      failures++;
+    }
+  }
+
+  // What the status bar asks for on every page, the old way and from RAM
+  const int lastSpine = SPINE_COUNT - 1;
+  const auto oldStatusBar = [&](const int spine) {
+    const size_t bookSize = cache.getSpineEntry(lastSpine).cumulativeSize;
+    const size_t previous = spine > 0 ? cache.getSpineEntry(spine - 1).cumulativeSize : 0;
+    const size_t current = cache.getSpineEntry(spine).cumulativeSize;
+    const int tocIndex = cache.getSpineEntry(spine).tocIndex;
+    return bookSize + previous + current + (tocIndex >= 0 ? cache.getTocEntry(tocIndex).title.size() : 0);
+  };
+  const auto newStatusBar = [&](const int spine) {
+    const size_t bookSize = cache.getCumulativeSize(lastSpine);
+    const size_t previous = spine > 0 ? cache.getCumulativeSize(spine - 1) : 0;
+    const size_t current = cache.getCumulativeSize(spine);
+    const int tocIndex = cache.getSpineTocIndex(spine);
+    return bookSize + previous + current + (tocIndex >= 0 ? cache.getTocTitle(tocIndex).size() : 0);
+  };
+
+  double oldMs = 0;
+  double newMs = 0;
+  uint32_t oldIo = 0;
+  uint32_t newIo = 0;
+  int pages = 0;
+  for (int spine = 0; spine < SPINE_COUNT; spine++) {
+    for (int page = 0; page < PAGES_PER_CHAPTER; page++, pages++) {
+      uint32_t ioBefore = FsFile::ioCount;
+      auto start = Clock::now();
+      const size_t expected = oldStatusBar(spine);
+      oldMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      oldIo += FsFile::ioCount - ioBefore;
+
+      ioBefore = FsFile::ioCount;
+      start = Clock::now();
+      const size_t actual = newStatusBar(spine);
+      newMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      const uint32_t io = FsFile::ioCount - ioBefore;
+      newIo += io;
+
+      if (actual != expected) {
+        std::cerr << "FAIL status bar data differs at spine " << spine << "\n";
+        failures++;
+      }
+      if (io != 0 && page != 0) {
+        std::cerr << "FAIL page " << page << " of spine " << spine << " read the SD card " << io << " times\n";
+        failures++;
+      }
+    }
+  }
+  printf("%d pages: book.bin lookups %.4f ms and %.2f reads/seeks per page, RAM table %.4f ms and %.2f per page\n",
+         pages, oldMs / pages, static_cast<double>(oldIo) / pages, newMs / pages, static_cast<double>(newIo) / pages);
+
+  std::string cleanup = std::string("rm -rf ") + dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All spine table checks passed\n";
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Measures the words of the hyphenation test corpora through GfxRenderer::getTextWidth and through
+// EpdFontFamily::getTextDimensions (the path getTextWidth used before the advance tables and word memo), checks both
+// agree for every word, style and font, and reports the time to measure a chapter's worth of words with each.
+#include <GfxRenderer.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+#include <builtinFonts/notosans_8_regular.h>
+#include <builtinFonts/ubuntu_12_bold.h>
+#include <builtinFonts/ubuntu_12_regular.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int BOOKERLY_ID = 1;
+constexpr int UI_ID = 2;
+constexpr int SMALL_ID = 3;
+
+struct Word {
+  std::string text;
+  int frequency;
+};
+
+// Same "word|hyphenated|frequency" format as the hyphenation evaluation
+std::vector<Word> loadWords(const std::string& filename) {
+  std::vector<Word> words;
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    std::cerr << "Error: Could not open file " << filename << std::endl;
+    return words;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    std::string word, hyphenated, freqStr;
+    if (std::getline(iss, word, '|') && std::getline(iss, hyphenated, '|') && std::getline(iss, freqStr, '|')) {
+      words.push_back({word, std::stoi(freqStr)});
+    }
+  }
+  return words;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+  const std::string resources = std::string(CROSSPOINT_ROOT_DIR) + "/test/hyphenation_eval/resources/";
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  EpdFont uiRegular(&ubuntu_12_regular);
+  EpdFont uiBold(&ubuntu_12_bold);
+  EpdFont small(&notosans_8_regular);
+  const EpdFontFamily bookerly(&regular, &bold, &italic, &boldItalic);
+  const EpdFontFamily ui(&uiRegular, &uiBold);
+  const EpdFontFamily smallFamily(&small);
+
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(BOOKERLY_ID, bookerly);
+  renderer.insertFont(UI_ID, ui);
+  renderer.insertFont(SMALL_ID, smallFamily);
+
+  struct FontCase {
+    const char* name;
+    int id;
+    const EpdFontFamily* family;
+  };
+  const FontCase fonts[] = {{"bookerly_14", BOOKERLY_ID, &bookerly},
+                            {"ubuntu_12", UI_ID, &ui},
+                            {"notosans_8", SMALL_ID, &smallFamily}};
+  const EpdFontFamily::Style styles[] = {EpdFontFamily::REGULAR, EpdFontFamily::BOLD, EpdFontFamily::ITALIC,
+                                         EpdFontFamily::BOLD_ITALIC};
+  const char* languages[] = {"english", "french", "german", "russian", "spanish"};
+
+  int failures = 0;
+  for (const char* language : languages) {
+    const auto words = loadWords(resources + language + "_hyphenation_tests.txt");
+    if (words.empty()) {
+      return 1;
+    }
+
+    // A "chapter": every word as often as it occurs in its source book, in random order, with the punctuation and
+    // hyphenated fragments the line breaker measures too
+    std::vector<std::string> chapter;
+    std::mt19937 rng(42);
+    for (const auto& word : words) {
+      for (int i = 0; i < word.frequency; i++) {
+        chapter.push_back(word.text);
+      }
+      chapter.push_back(word.text + ",");
+      chapter.push_back("«" + word.text + "…»");
+      chapter.push_back(word.text.substr(0, word.text.size() / 2) + "-");
+    }
+    std::shuffle(chapter.begin(), chapter.end(), rng);
+
+    for (const auto& font : fonts) {
+      for (const auto style : styles) {
+        int mismatches = 0;
+        for (const auto& text : chapter) {
+          int w = 0, h = 0;
+          font.family->getTextDimensions(text.c_str(), &w, &h, style);
+          if (renderer.getTextWidth(font.id, text.c_str(), style) != w) {
+            if (mismatches++ == 0) {
+              std::cerr << "Mismatch for \"" << text << "\": expected " << w << std::endl;
+            }
+          }
+        }
+        if (mismatches) {
+          failures++;
+        }
+
+        double referenceMs = 0;
+        double fastMs = 0;
+        long checksum = 0;
+        for (int i = 0; i < iterations; i++) {
+          auto start = Clock::now();
+          for (const auto& text : chapter) {
+            int w = 0, h = 0;
+            font.family->getTextDimensions(text.c_str(), &w, &h, style);
+            checksum += w;
+          }
+          referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+          start = Clock::now();
+          for (const auto& text : chapter) {
+            checksum -= renderer.getTextWidth(font.id, text.c_str(), style);
+          }
+          fastMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        printf("%-4s %-8s %-12s style %d  %6zu words: getTextDimensions %7.3f ms, getTextWidth %7.3f ms (%.1fx)%s\n",
+               mismatches ? "FAIL" : "OK", language, font.name, static_cast<int>(style), chapter.size(),
+               referenceMs / iterations, fastMs / iterations, fastMs > 0 ? referenceMs / fastMs : 0.0,
+               checksum ? " checksum!" : "");
+      }
+    }
+  }
+
+  if (failures) {
+    std::cerr << failures << " configuration(s) measured differently from getTextDimensions\n";
+    return 1;
+  }
+  std::cout << "getTextWidth matches getTextDimensions for every corpus word, font and style\n";
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Records spans and counters and checks the totals, the ring of recent events (oldest first, wrapping past its
+// capacity), spans recorded from two threads at once, reset, and the file written to the card. Reports what a span
+// costs to record.
+#include <SDCardManager.h>
+#include <Trace.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+namespace {
+int failures = 0;
+
+void expect(const bool condition, const std::string& what) {
+  if (!condition) {
+    std::cerr << "FAIL " << what << "\n";
+    failures++;
+  }
+}
+
+bool contains(const std::string& json, const std::string& fragment) { return json.find(fragment) != std::string::npos; }
+
+// The events array in order, as "span:value" pairs
+std::string eventList(const std::string& json) {
+  std::string out;
+  size_t at = json.find("\"events\":[");
+  while ((at = json.find("{\"span\":\"", at)) != std::string::npos) {
+    at += 9;
+    const std::string span = json.substr(at, json.find('"', at) - at);
+    const size_t valueAt = json.find("\"value\":", at) + 8;
+    out += (out.empty() ? "" : " ") + span + ":" + std::to_string(std::stoul(json.substr(valueAt)));
+  }
+  return out;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/trace_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  SdMan.mkdir("/.crosspoint");
+
+  trace::record(trace::Span::LAYOUT, 100, 40, 3);
+  trace::record(trace::Span::LAYOUT, 200, 60, 5);
+  trace::record(trace::Span::ZIP_INFLATE, 300, 1000, 4096);
+  trace::add(trace::Counter::LAID_OUT_LINES, 8);
+  trace::add(trace::Counter::SERIALIZED_PAGES);
+  trace::add(trace::Counter::SERIALIZED_PAGES);
+  {
+    trace::Scope span(trace::Span::PAGE_RENDER, 1);
+    span.setValue(7);
+  }
+
+  std::string json = trace::toJson();
+  expect(contains(json, "\"layout\":{\"count\":2,\"totalUs\":100,\"maxUs\":60}"), "layout totals");
+  expect(contains(json, "\"zipInflate\":{\"count\":1,\"totalUs\":1000,\"maxUs\":1000}"), "inflate totals");
+  expect(contains(json, "\"pageRender\":{\"count\":1,"), "scope recorded");
+  expect(contains(json, "\"xmlParse\":{\"count\":0,\"totalUs\":0,\"maxUs\":0}"), "unused span");
+  expect(contains(json, "\"laidOutLines\":8,") && contains(json, "\"serializedPages\":2}"), "counters");
+  expect(contains(json, "\"dropped\":0,"), "nothing dropped");
+  expect(eventList(json) == "layout:3 layout:5 zipInflate:4096 pageRender:7", "events in order: " + eventList(json));
+
+  // Past capacity the oldest events give way
+  trace::reset();
+  for (uint32_t i = 0; i < trace::EVENT_CAPACITY + 72; i++) {
+    trace::record(trace::Span::SECTION_SERIALIZE, i, 1, i);
+  }
+  json = trace::toJson();
+  const std::string events = eventList(json);
+  expect(contains(json, "\"dropped\":72,"), "dropped count");
+  expect(events.rfind("sectionSerialize:72 ", 0) == 0, "oldest kept event first");
+  expect(events.size() > 20 && events.compare(events.size() - 20, 20, "sectionSerialize:199") == 0 &&
+             events.find("sectionSerialize:71 ") == std::string::npos,
+         "newest kept, older dropped");
+  expect(contains(json, "\"sectionSerialize\":{\"count\":200,\"totalUs\":200,\"maxUs\":1}"), "totals cover drops");
+
+  // The reader's background task records while the main loop does
+  trace::reset();
+  constexpr int PER_THREAD = 100000;
+  const auto spam = [] {
+    for (int i = 0; i < PER_THREAD; i++) {
+      trace::record(trace::Span::DISPLAY_REFRESH, i, 2);
+      trace::add(trace::Counter::PARSED_BYTES, 3);
+    }
+  };
+  std::thread other(spam);
+  spam();
+  other.join();
+  json = trace::toJson();
+  expect(contains(json, "\"displayRefresh\":{\"count\":200000,\"totalUs\":400000,\"maxUs\":2}"), "concurrent spans");
+  expect(contains(json, "\"parsedBytes\":600000,"), "concurrent counters");
+
+  expect(trace::saveToFile(), "save to card");
+  std::ifstream saved(std::string(dir) + trace::DEFAULT_PATH);
+  const std::string savedJson((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+  expect(savedJson.size() > 100 && contains(savedJson, "\"displayRefresh\":{\"count\":200000,"),
+         "saved file matches");
+
+  trace::reset();
+  json = trace::toJson();
+  expect(contains(json, "\"displayRefresh\":{\"count\":0,") && contains(json, "\"events\":[]"), "reset");
+
+  constexpr int SPANS = 1000000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SPANS; i++) {
+    trace::Scope span(trace::Span::LAYOUT, i);
+  }
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SPANS;
+  std::cout << "Span recorded in " << ns << " ns, " << trace::toJson().size() << " bytes of JSON with a full ring\n";
+
+  std::string cleanup = "rm -rf ";
+  cleanup += dir;
+  std::system(cleanup.c_str());
+
+  if (failures) {
+    std::cerr << failures << " trace check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All trace checks passed\n";
+  return 0;
+}
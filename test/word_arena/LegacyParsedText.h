@@ -0,0 +1,58 @@
+#pragma once
+// ParsedText as it was before the word arena: words and styles in std::list, lines spliced out into lists of their
+// own. Kept as the reference for the word arena benchmark.
+
+#include <EpdFontFamily.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/blocks/TextBlock.h"
+
+class GfxRenderer;
+
+// A laid out line as the list-based TextBlock held it
+struct LegacyTextBlock {
+  std::list<std::string> words;
+  std::list<uint16_t> wordXpos;
+  std::list<EpdFontFamily::Style> wordStyles;
+  TextBlock::Style style;
+};
+
+class LegacyParsedText {
+  std::list<std::string> words;
+  std::list<EpdFontFamily::Style> wordStyles;
+  TextBlock::Style style;
+  bool extraParagraphSpacing;
+  bool hyphenationEnabled;
+
+  void applyParagraphIndent();
+  std::vector<size_t> computeLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth, int spaceWidth,
+                                        std::vector<uint16_t>& wordWidths);
+  std::vector<size_t> computeHyphenatedLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth,
+                                                  int spaceWidth, std::vector<uint16_t>& wordWidths);
+  bool hyphenateWordAtIndex(size_t wordIndex, int availableWidth, const GfxRenderer& renderer, int fontId,
+                            std::vector<uint16_t>& wordWidths, bool allowFallbackBreaks);
+  void extractLine(size_t breakIndex, int pageWidth, int spaceWidth, const std::vector<uint16_t>& wordWidths,
+                   const std::vector<size_t>& lineBreakIndices,
+                   const std::function<void(std::shared_ptr<LegacyTextBlock>)>& processLine);
+  std::vector<uint16_t> calculateWordWidths(const GfxRenderer& renderer, int fontId);
+
+ public:
+  explicit LegacyParsedText(const TextBlock::Style style, const bool extraParagraphSpacing,
+                            const bool hyphenationEnabled = false)
+      : style(style), extraParagraphSpacing(extraParagraphSpacing), hyphenationEnabled(hyphenationEnabled) {}
+  ~LegacyParsedText() = default;
+
+  void addWord(std::string word, EpdFontFamily::Style fontStyle);
+  void setStyle(const TextBlock::Style style) { this->style = style; }
+  TextBlock::Style getStyle() const { return style; }
+  size_t size() const { return words.size(); }
+  bool isEmpty() const { return words.empty(); }
+  void layoutAndExtractLines(const GfxRenderer& renderer, int fontId, uint16_t viewportWidth,
+                             const std::function<void(std::shared_ptr<LegacyTextBlock>)>& processLine,
+                             bool includeLastLine = true);
+};
\ No newline at end of file
@@ -0,0 +1,237 @@
+// Lays out paragraphs built from the hyphenation corpora through ParsedText and through the list-based version it
+// replaced, feeding words the way ChapterHtmlSlimParser does (including the early flush of long paragraphs). Checks
+// both produce identical lines without hyphenation, and reports layout time, peak heap, allocation count and the heap
+// held per line. With hyphenation the lines differ on purpose, as ParsedText breaks them by total fit rather than
+// greedily (see test/line_breaker).
+#include <GfxRenderer.h>
+#include <builtinFonts/bookerly_14_bold.h>
+#include <builtinFonts/bookerly_14_bolditalic.h>
+#include <builtinFonts/bookerly_14_italic.h>
+#include <builtinFonts/bookerly_14_regular.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "LegacyParsedText.h"
+#include "lib/Epub/Epub/ParsedText.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+
+namespace {
+size_t liveBytes = 0;
+size_t peakBytes = 0;
+size_t allocations = 0;
+}  // namespace
+
+// Every heap allocation carries its size in front, so live and peak bytes can be tracked
+void* operator new(const size_t size) {
+  auto* block = static_cast<size_t*>(malloc(size + sizeof(max_align_t)));
+  if (!block) throw std::bad_alloc();
+  *block = size;
+  liveBytes += size;
+  peakBytes = std::max(peakBytes, liveBytes);
+  allocations++;
+  return reinterpret_cast<char*>(block) + sizeof(max_align_t);
+}
+void operator delete(void* ptr) noexcept {
+  if (!ptr) return;
+  auto* block = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - sizeof(max_align_t));
+  liveBytes -= *block;
+  free(block);
+}
+void* operator new[](const size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace {
+constexpr int FONT_ID = 1;
+constexpr uint16_t VIEWPORT_WIDTH = 464;
+// ChapterHtmlSlimParser lays out and flushes all but the last line past this many buffered words
+constexpr size_t FLUSH_THRESHOLD = 750;
+
+struct Corpus {
+  const char* name;
+  const char* file;
+  const char* language;
+};
+
+struct Word {
+  std::string text;
+  EpdFontFamily::Style style;
+};
+
+using Paragraph = std::vector<Word>;
+
+struct Line {
+  std::vector<std::string> words;
+  std::vector<uint16_t> xPos;
+  std::vector<EpdFontFamily::Style> styles;
+  bool operator==(const Line&) const = default;
+};
+
+// Paragraphs of corpus words in a deterministic shuffle, some with soft hyphens at the corpus hyphenation points,
+// ending with one long enough to be flushed early
+std::vector<Paragraph> buildParagraphs(const std::string& path) {
+  std::ifstream in(path);
+  std::vector<std::string> plain;
+  std::vector<std::string> softHyphenated;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    const size_t bar = line.find('|');
+    const size_t bar2 = line.find('|', bar + 1);
+    if (bar == std::string::npos || bar2 == std::string::npos) continue;
+    plain.push_back(line.substr(0, bar));
+    std::string soft;
+    for (const char c : line.substr(bar + 1, bar2 - bar - 1)) {
+      soft += c == '=' ? std::string("\xC2\xAD") : std::string(1, c);
+    }
+    softHyphenated.push_back(soft);
+  }
+
+  std::vector<Paragraph> paragraphs;
+  uint32_t seed = 2024;
+  const auto next = [&seed] { return seed = seed * 1103515245u + 12345u; };
+  size_t used = 0;
+  while (used < plain.size() * 3 && !plain.empty()) {
+    Paragraph paragraph;
+    const size_t words = paragraphs.size() == 60 ? 2400 : 20 + (next() >> 8) % 300;
+    for (size_t w = 0; w < words; w++, used++) {
+      const uint32_t r = next();
+      const size_t index = (r >> 8) % plain.size();
+      const auto style = static_cast<EpdFontFamily::Style>((r >> 4) % 23 == 0 ? 1 + (r >> 2) % 3 : 0);
+      paragraph.push_back({(r >> 20) % 9 == 0 ? softHyphenated[index] : plain[index], style});
+    }
+    paragraphs.push_back(std::move(paragraph));
+  }
+  return paragraphs;
+}
+
+template <typename Text, typename OnLine>
+void layoutParagraph(const GfxRenderer& renderer, const Paragraph& paragraph, const bool hyphenation,
+                     const OnLine& onLine) {
+  Text text(TextBlock::JUSTIFIED, false, hyphenation);
+  for (const auto& word : paragraph) {
+    text.addWord(word.text, word.style);
+    if (text.size() > FLUSH_THRESHOLD) {
+      text.layoutAndExtractLines(renderer, FONT_ID, VIEWPORT_WIDTH, onLine, false);
+    }
+  }
+  text.layoutAndExtractLines(renderer, FONT_ID, VIEWPORT_WIDTH, onLine);
+}
+
+Line toLine(const LegacyTextBlock& block) {
+  Line line;
+  line.words.assign(block.words.begin(), block.words.end());
+  line.xPos.assign(block.wordXpos.begin(), block.wordXpos.end());
+  line.styles.assign(block.wordStyles.begin(), block.wordStyles.end());
+  return line;
+}
+
+Line toLine(const TextBlock& block) {
+  Line line;
+  for (const auto& word : block.getWords()) {
+    line.words.emplace_back(block.getWordText(word), word.length);
+    line.xPos.push_back(word.xPos);
+    line.styles.push_back(word.style);
+  }
+  return line;
+}
+
+struct Measurement {
+  double ms = 0;
+  size_t peak = 0;
+  size_t allocations = 0;
+  size_t bytesPerLine = 0;
+  std::vector<Line> lines;
+};
+
+template <typename Text, typename Block>
+Measurement measure(const GfxRenderer& renderer, const std::vector<Paragraph>& paragraphs, const bool hyphenation) {
+  Measurement result;
+
+  // Timed and heap-tracked layout, dropping each line as the parser does once it is on a page
+  size_t lineCount = 0;
+  const auto dropLine = [&lineCount](const std::shared_ptr<Block>&) { lineCount++; };
+  const size_t baseline = liveBytes;
+  peakBytes = liveBytes;
+  const size_t allocationsBefore = allocations;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& paragraph : paragraphs) {
+    layoutParagraph<Text>(renderer, paragraph, hyphenation, dropLine);
+  }
+  result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  result.peak = peakBytes - baseline;
+  result.allocations = allocations - allocationsBefore;
+
+  // Keep every line this time, to see what the lines of a page cost while the page is open
+  std::vector<std::shared_ptr<Block>> kept;
+  kept.reserve(lineCount);
+  const size_t before = liveBytes;
+  for (const auto& paragraph : paragraphs) {
+    layoutParagraph<Text>(renderer, paragraph, hyphenation,
+                          [&kept](const std::shared_ptr<Block>& block) { kept.push_back(block); });
+  }
+  result.bytesPerLine = kept.empty() ? 0 : (liveBytes - before) / kept.size();
+  for (const auto& block : kept) {
+    result.lines.push_back(toLine(*block));
+  }
+  return result;
+}
+}  // namespace
+
+int main() {
+  const std::string resources = std::string(CROSSPOINT_ROOT_DIR) + "/test/hyphenation_eval/resources";
+  const Corpus corpora[] = {
+      {"english", "english_hyphenation_tests.txt", "en"}, {"french", "french_hyphenation_tests.txt", "fr"},
+      {"german", "german_hyphenation_tests.txt", "de"},   {"russian", "russian_hyphenation_tests.txt", "ru"},
+      {"spanish", "spanish_hyphenation_tests.txt", "es"},
+  };
+
+  EpdFont regular(&bookerly_14_regular);
+  EpdFont bold(&bookerly_14_bold);
+  EpdFont italic(&bookerly_14_italic);
+  EpdFont boldItalic(&bookerly_14_bolditalic);
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  renderer.insertFont(FONT_ID, EpdFontFamily(&regular, &bold, &italic, &boldItalic));
+
+  int failures = 0;
+  for (const auto& corpus : corpora) {
+    const auto paragraphs = buildParagraphs(resources + "/" + corpus.file);
+    if (paragraphs.empty()) {
+      std::cerr << "FAIL could not read " << corpus.file << "\n";
+      failures++;
+      continue;
+    }
+    Hyphenator::setPreferredLanguage(corpus.language);
+
+    for (const bool hyphenation : {false, true}) {
+      const auto legacy = measure<LegacyParsedText, LegacyTextBlock>(renderer, paragraphs, hyphenation);
+      const auto arena = measure<ParsedText, TextBlock>(renderer, paragraphs, hyphenation);
+      const bool same = !legacy.lines.empty() && legacy.lines == arena.lines;
+      if (!same && !hyphenation) {
+        failures++;
+      }
+      const char* verdict = same ? "OK" : hyphenation ? "DIFF" : "FAIL";
+      printf("%-4s %-8s %-11s %5zu lines: lists %6.2f ms, peak %6zu B, %7zu allocs, %4zu B/line | arena %6.2f ms "
+             "(%.2fx), peak %6zu B, %7zu allocs, %4zu B/line\n",
+             verdict, corpus.name, hyphenation ? "hyphenated" : "plain", arena.lines.size(), legacy.ms, legacy.peak,
+             legacy.allocations, legacy.bytesPerLine, arena.ms, arena.ms > 0 ? legacy.ms / arena.ms : 0.0, arena.peak,
+             arena.allocations, arena.bytesPerLine);
+    }
+  }
+
+  if (failures) {
+    std::cerr << failures << " configuration(s) differ from the list-based layout\n";
+    return 1;
+  }
+  std::cout << "Word arena layout matches the list-based layout for every corpus without hyphenation\n";
+  return 0;
+}
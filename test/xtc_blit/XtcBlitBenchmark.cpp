@@ -0,0 +1,154 @@
+// Renders random XTG (1-bit) and XTH (2-bit) pages through GfxRenderer::drawXtgPage/drawXthPage and through a copy
+// of the old per-pixel XtcReaderActivity loops (drawPixel for every page pixel), checks both produce identical bits for
+// every orientation, render pass and page size, and reports the per-page time of each.
+#include <GfxRenderer.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+struct PageSize {
+  int width;
+  int height;
+};
+
+// The XTG loop from XtcReaderActivity::renderPage before the direct blit
+void referenceXtg(const GfxRenderer& renderer, const uint8_t* page, const int width, const int height) {
+  const size_t srcRowBytes = (width + 7) / 8;
+  for (int srcY = 0; srcY < height; srcY++) {
+    const size_t srcRowStart = srcY * srcRowBytes;
+    for (int srcX = 0; srcX < width; srcX++) {
+      const size_t srcByte = srcRowStart + srcX / 8;
+      const size_t srcBit = 7 - (srcX % 8);
+      if (!((page[srcByte] >> srcBit) & 1)) {
+        renderer.drawPixel(srcX, srcY, true);
+      }
+    }
+  }
+}
+
+// The XTH loops from XtcReaderActivity::renderPage before the direct blit, one per render pass
+void referenceXth(const GfxRenderer& renderer, const GfxRenderer::RenderMode mode, const uint8_t* plane1,
+                  const uint8_t* plane2, const int width, const int height) {
+  const size_t colBytes = (height + 7) / 8;
+  auto getPixelValue = [&](const int x, const int y) -> uint8_t {
+    const size_t byteOffset = (width - 1 - x) * colBytes + y / 8;
+    const size_t bitInByte = 7 - (y % 8);
+    return ((plane1[byteOffset] >> bitInByte) & 1) << 1 | ((plane2[byteOffset] >> bitInByte) & 1);
+  };
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const uint8_t pv = getPixelValue(x, y);
+      if (mode == GfxRenderer::BW && pv >= 1) {
+        renderer.drawPixel(x, y, true);
+      } else if (mode == GfxRenderer::GRAYSCALE_LSB && pv == 1) {
+        renderer.drawPixel(x, y, false);
+      } else if (mode == GfxRenderer::GRAYSCALE_MSB && (pv == 1 || pv == 2)) {
+        renderer.drawPixel(x, y, false);
+      }
+    }
+  }
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 10;
+
+  HalDisplay display;
+  GfxRenderer renderer(display);
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  std::vector<uint8_t> expected(HalDisplay::BUFFER_SIZE);
+  std::mt19937 rng(1234);
+
+  // Native sizes for both orientations, odd sizes that leave padding bits and partial bytes, and oversized pages
+  const PageSize sizes[] = {{480, 800}, {800, 480}, {477, 797}, {803, 469}, {13, 21}, {960, 960}};
+  const std::pair<GfxRenderer::Orientation, const char*> orientations[] = {
+      {GfxRenderer::Portrait, "Portrait"},
+      {GfxRenderer::LandscapeClockwise, "LandscapeCW"},
+      {GfxRenderer::PortraitInverted, "PortraitInverted"},
+      {GfxRenderer::LandscapeCounterClockwise, "LandscapeCCW"}};
+  const std::pair<GfxRenderer::RenderMode, const char*> modes[] = {
+      {GfxRenderer::BW, "BW"}, {GfxRenderer::GRAYSCALE_LSB, "LSB"}, {GfxRenderer::GRAYSCALE_MSB, "MSB"}};
+
+  int failures = 0;
+  const auto check = [&](const char* format, const PageSize& size, const char* orientationName, const char* modeName,
+                         const double referenceMs, const double blitMs) {
+    const bool exact = memcmp(expected.data(), frameBuffer, HalDisplay::BUFFER_SIZE) == 0;
+    if (!exact) {
+      failures++;
+    }
+    printf("%-4s %s %4dx%-4d %-17s %-4s per page: drawPixel %7.3f ms, direct blit %7.3f ms (%.1fx)\n",
+           exact ? "OK" : "FAIL", format, size.width, size.height, orientationName, modeName,
+           referenceMs / iterations, blitMs / iterations, blitMs > 0 ? referenceMs / blitMs : 0.0);
+  };
+
+  for (const auto& size : sizes) {
+    // Mostly white pages with dense runs, like real text, plus fully random padding bits
+    const size_t xtgBytes = static_cast<size_t>((size.width + 7) / 8) * size.height;
+    const size_t planeBytes = static_cast<size_t>((size.height + 7) / 8) * size.width;
+    std::vector<uint8_t> xtg(xtgBytes);
+    std::vector<uint8_t> xth(planeBytes * 2);
+    for (auto& b : xtg) {
+      b = rng() % 3 ? 0xFF : static_cast<uint8_t>(rng());
+    }
+    for (auto& b : xth) {
+      b = rng() % 3 ? 0x00 : static_cast<uint8_t>(rng());
+    }
+
+    for (const auto& [orientation, orientationName] : orientations) {
+      renderer.setOrientation(orientation);
+
+      for (const auto& [mode, modeName] : modes) {
+        renderer.setRenderMode(mode);
+        const uint8_t background = mode == GfxRenderer::BW ? 0xFF : 0x00;
+
+        double referenceMs = 0;
+        double blitMs = 0;
+        if (mode == GfxRenderer::BW) {
+          for (int i = 0; i < iterations; i++) {
+            memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+            auto start = Clock::now();
+            referenceXtg(renderer, xtg.data(), size.width, size.height);
+            referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            memcpy(expected.data(), frameBuffer, HalDisplay::BUFFER_SIZE);
+
+            memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+            start = Clock::now();
+            renderer.drawXtgPage(xtg.data(), size.width, size.height);
+            blitMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+          }
+          check("XTG", size, orientationName, modeName, referenceMs, blitMs);
+        }
+
+        referenceMs = 0;
+        blitMs = 0;
+        for (int i = 0; i < iterations; i++) {
+          memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+          auto start = Clock::now();
+          referenceXth(renderer, mode, xth.data(), xth.data() + planeBytes, size.width, size.height);
+          referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+          memcpy(expected.data(), frameBuffer, HalDisplay::BUFFER_SIZE);
+
+          memset(frameBuffer, background, HalDisplay::BUFFER_SIZE);
+          start = Clock::now();
+          renderer.drawXthPage(xth.data(), xth.data() + planeBytes, size.width, size.height);
+          blitMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        check("XTH", size, orientationName, modeName, referenceMs, blitMs);
+      }
+    }
+  }
+
+  if (failures) {
+    std::cerr << failures << " configuration(s) differ from the drawPixel reference\n";
+    return 1;
+  }
+  std::cout << "Direct page blit output is bit-exact in every configuration\n";
+  return 0;
+}
@@ -0,0 +1,185 @@
+// Checks that ZipFile lookups through the on-disk central directory index find exactly what the linear central
+// directory scan finds, that the index is reused while the zip is unchanged and rebuilt when it changes, and reports
+// the time per lookup of both.
+#include <SDCardManager.h>
+#include <ZipFile.h>
+#include <miniz.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr const char* EPUB_PATH = "/book.epub";
+constexpr const char* INDEX_PATH = "/zip_index.bin";
+
+struct Entry {
+  std::string name;
+  std::string content;
+};
+
+// Enough entries for several sorted runs, with names long enough to be hashed in pieces
+std::vector<Entry> buildEntries(const int count) {
+  std::vector<Entry> entries;
+  entries.push_back({"mimetype", "application/epub+zip"});
+  for (int i = 0; i < count; i++) {
+    std::string name = "OEBPS/Text/chapter" + std::to_string(i) + ".xhtml";
+    if (i % 97 == 0) {
+      name = "OEBPS/Images/" + std::string(150 + i % 50, 'x') + std::to_string(i) + ".jpg";
+    }
+    entries.push_back({name, std::string(100 + (i * 37) % 900, static_cast<char>('a' + i % 26))});
+  }
+  return entries;
+}
+
+bool writeZip(const std::string& path, const std::vector<Entry>& entries) {
+  mz_zip_archive archive = {};
+  if (!mz_zip_writer_init_file(&archive, path.c_str(), 0)) return false;
+  bool ok = true;
+  for (size_t i = 0; i < entries.size() && ok; i++) {
+    ok = mz_zip_writer_add_mem(&archive, entries[i].name.c_str(), entries[i].content.data(), entries[i].content.size(),
+                               i % 3 == 0 ? MZ_NO_COMPRESSION : MZ_DEFAULT_LEVEL);
+  }
+  ok = ok && mz_zip_writer_finalize_archive(&archive);
+  mz_zip_writer_end(&archive);
+  return ok;
+}
+
+int checkLookups(const std::vector<Entry>& entries, const std::string& epubPath) {
+  int failures = 0;
+  ZipFile indexed(epubPath, INDEX_PATH);
+  for (const auto& entry : entries) {
+    size_t size = 0;
+    if (!indexed.getInflatedFileSize(entry.name.c_str(), &size) || size != entry.content.size()) {
+      std::cerr << "FAIL size of " << entry.name << "\n";
+      failures++;
+    }
+  }
+  for (size_t i = 0; i < entries.size(); i += 41) {
+    size_t size = 0;
+    uint8_t* data = indexed.readFileToMemory(entries[i].name.c_str(), &size);
+    if (!data || size != entries[i].content.size() || memcmp(data, entries[i].content.data(), size) != 0) {
+      std::cerr << "FAIL content of " << entries[i].name << "\n";
+      failures++;
+    }
+    free(data);
+  }
+  for (const char* missing : {"OEBPS/Text/chapter.xhtml", "OEBPS/Text/chapter1.xhtm", "mimetypes", ""}) {
+    size_t size = 0;
+    if (indexed.getInflatedFileSize(missing, &size)) {
+      std::cerr << "FAIL found missing entry \"" << missing << "\"\n";
+      failures++;
+    }
+  }
+  return failures;
+}
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/zip_index_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  const std::string epubPath = EPUB_PATH;
+  const std::string hostIndexPath = std::string(dir) + INDEX_PATH;
+
+  auto entries = buildEntries(3000);
+  if (!writeZip(std::string(dir) + EPUB_PATH, entries)) {
+    std::cerr << "Could not write test zip\n";
+    return 1;
+  }
+
+  int failures = checkLookups(entries, epubPath);
+  const auto expectedIndexSize = 20 + entries.size() * sizeof(ZipFile::IndexEntry);
+  if (!std::filesystem::exists(hostIndexPath) || std::filesystem::file_size(hostIndexPath) != expectedIndexSize) {
+    std::cerr << "FAIL index file missing or wrong size\n";
+    failures++;
+  }
+  if (std::filesystem::exists(hostIndexPath + ".tmp")) {
+    std::cerr << "FAIL sorted runs left behind\n";
+    failures++;
+  }
+
+  // An unchanged zip reuses the index
+  const auto builtAt = std::filesystem::last_write_time(hostIndexPath);
+  failures += checkLookups(entries, epubPath);
+  if (std::filesystem::last_write_time(hostIndexPath) != builtAt) {
+    std::cerr << "FAIL index rebuilt for an unchanged zip\n";
+    failures++;
+  }
+
+  // Lookup cost, index vs central directory scan, over every entry in shuffled order
+  std::vector<size_t> order(entries.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = (i * 7919) % order.size();
+  double indexMs = 0;
+  double scanMs = 0;
+  {
+    ZipFile indexed(epubPath, INDEX_PATH);
+    ZipFile scanned(epubPath);
+    indexed.open();
+    scanned.open();
+    size_t size = 0;
+    auto start = Clock::now();
+    for (const size_t i : order) indexed.getInflatedFileSize(entries[i].name.c_str(), &size);
+    indexMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    for (const size_t i : order) scanned.getInflatedFileSize(entries[i].name.c_str(), &size);
+    scanMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+  printf("%zu entries: index %.4f ms per lookup, central directory scan %.4f ms per lookup\n", entries.size(),
+         indexMs / order.size(), scanMs / order.size());
+
+  // A changed zip invalidates the index
+  entries.push_back({"OEBPS/Text/appendix.xhtml", "late addition"});
+  entries.erase(entries.begin() + 5);
+  if (!writeZip(std::string(dir) + EPUB_PATH, entries)) {
+    std::cerr << "Could not rewrite test zip\n";
+    return 1;
+  }
+  failures += checkLookups(entries, epubPath);
+  if (std::filesystem::file_size(hostIndexPath) != 20 + entries.size() * sizeof(ZipFile::IndexEntry)) {
+    std::cerr << "FAIL index not rebuilt for a changed zip\n";
+    failures++;
+  }
+
+  // Corrupt index (truncated) is rebuilt as well
+  std::filesystem::resize_file(hostIndexPath, 100);
+  failures += checkLookups(entries, epubPath);
+
+  // A short index whose size matches its own entry count is still missing entries, so it is rebuilt too
+  const uintmax_t fullIndexSize = std::filesystem::file_size(hostIndexPath);
+  {
+    FILE* index = fopen(hostIndexPath.c_str(), "r+b");
+    const uint32_t shortCount = static_cast<uint32_t>(entries.size() - 1);
+    fseek(index, 16, SEEK_SET);  // IndexHeader::entryCount
+    fwrite(&shortCount, sizeof(shortCount), 1, index);
+    fclose(index);
+  }
+  std::filesystem::resize_file(hostIndexPath, fullIndexSize - sizeof(ZipFile::IndexEntry));
+  failures += checkLookups(entries, epubPath);
+  if (std::filesystem::file_size(hostIndexPath) != fullIndexSize) {
+    std::cerr << "FAIL short index not rebuilt\n";
+    failures++;
+  }
+
+  SdMan.remove(EPUB_PATH);
+  SdMan.remove(INDEX_PATH);
+  rmdir(dir);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All zip index checks passed\n";
+  return 0;
+}
@@ -0,0 +1,190 @@
+// Checks that a ZipFile kept open for a reading session streams chapter after chapter without reopening the file or
+// re-parsing the end of central directory, using the open/seek counters, and compares that with the per-chapter cost
+// of a fresh ZipFile.
+#include <SDCardManager.h>
+#include <ZipFile.h>
+#include <miniz.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+const std::string EPUB_PATH = "/book.epub";
+const std::string INDEX_PATH = "/zip_index.bin";
+constexpr int CHAPTER_COUNT = 300;
+// Binary search over the index plus the local header and data seeks
+constexpr uint32_t MAX_SEEKS_PER_CHAPTER = 14;
+
+struct Entry {
+  std::string name;
+  std::string content;
+};
+
+std::vector<Entry> buildEntries() {
+  std::vector<Entry> entries;
+  entries.push_back({"mimetype", "application/epub+zip"});
+  for (int i = 0; i < CHAPTER_COUNT; i++) {
+    std::string content;
+    for (int j = 0; j < 40 + i % 60; j++) {
+      content += "<p>Chapter " + std::to_string(i) + " paragraph " + std::to_string(j) + "</p>\n";
+    }
+    entries.push_back({"OEBPS/Text/chapter" + std::to_string(i) + ".xhtml", content});
+  }
+  return entries;
+}
+
+bool writeZip(const std::string& path, const std::vector<Entry>& entries, const std::string& comment = "") {
+  mz_zip_archive archive = {};
+  if (!mz_zip_writer_init_file(&archive, path.c_str(), 0)) return false;
+  bool ok = true;
+  for (size_t i = 0; i < entries.size() && ok; i++) {
+    ok = mz_zip_writer_add_mem(&archive, entries[i].name.c_str(), entries[i].content.data(), entries[i].content.size(),
+                               i == 0 ? MZ_NO_COMPRESSION : MZ_DEFAULT_LEVEL);
+  }
+  ok = ok && mz_zip_writer_finalize_archive(&archive);
+  mz_zip_writer_end(&archive);
+  if (!ok || comment.empty()) return ok;
+
+  // miniz writes no archive comment, so patch one onto the end of central directory record
+  std::ifstream in(path, std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  bytes[bytes.size() - 2] = static_cast<char>(comment.size() & 0xFF);
+  bytes[bytes.size() - 1] = static_cast<char>(comment.size() >> 8);
+  bytes += comment;
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  return static_cast<bool>(out);
+}
+
+bool streamChapter(ZipFile& zip, const Entry& entry) {
+  ZipFile::InflateReader reader(zip);
+  if (!reader.begin(entry.name.c_str(), 1024)) return false;
+  std::string inflated;
+  uint8_t buf[700];
+  size_t n;
+  while ((n = reader.read(buf, sizeof(buf))) > 0) {
+    inflated.append(reinterpret_cast<const char*>(buf), n);
+  }
+  const bool ok = reader.isFinished() && !reader.hasFailed() && inflated == entry.content;
+  reader.end();
+  return ok;
+}
+
+void printStats(const char* label, const ZipFile::Stats& stats, const int chapters) {
+  printf("%s: %.2f opens, %.2f EOCD reads, %.2f seeks per chapter\n", label, stats.opens / double(chapters),
+         stats.eocdReads / double(chapters), stats.seeks / double(chapters));
+}
+
+int checkSession(const std::vector<Entry>& entries, const char* label) {
+  int failures = 0;
+  ZipFile session(EPUB_PATH, INDEX_PATH);
+  if (!session.open()) {
+    std::cerr << "FAIL could not open session\n";
+    return 1;
+  }
+  // The first chapter pays for the EOCD and the index
+  if (!streamChapter(session, entries[1])) {
+    std::cerr << "FAIL first chapter of session\n";
+    failures++;
+  }
+  const ZipFile::Stats first = session.getStats();
+  if (first.eocdReads != 1) {
+    std::cerr << "FAIL expected one EOCD read to open the session, got " << first.eocdReads << "\n";
+    failures++;
+  }
+
+  session.resetStats();
+  int chapters = 0;
+  for (size_t i = 2; i < entries.size(); i += 7, chapters++) {
+    const uint32_t seeksBefore = session.getStats().seeks;
+    if (!streamChapter(session, entries[i])) {
+      std::cerr << "FAIL content of " << entries[i].name << "\n";
+      failures++;
+    }
+    const ZipFile::Stats& stats = session.getStats();
+    if (stats.opens != 0 || stats.eocdReads != 0) {
+      std::cerr << "FAIL " << entries[i].name << " reopened the zip (" << stats.opens << " opens, " << stats.eocdReads
+                << " EOCD reads)\n";
+      failures++;
+    }
+    if (stats.seeks - seeksBefore > MAX_SEEKS_PER_CHAPTER) {
+      std::cerr << "FAIL " << entries[i].name << " took " << stats.seeks - seeksBefore << " seeks\n";
+      failures++;
+    }
+    if (!session.isOpen()) {
+      std::cerr << "FAIL session closed after " << entries[i].name << "\n";
+      failures++;
+    }
+  }
+  printStats(label, session.getStats(), chapters);
+  return failures;
+}
+
+int checkFreshPerChapter(const std::vector<Entry>& entries) {
+  int failures = 0;
+  ZipFile::Stats total = {0, 0, 0};
+  int chapters = 0;
+  for (size_t i = 2; i < entries.size(); i += 7, chapters++) {
+    ZipFile zip(EPUB_PATH, INDEX_PATH);
+    if (!streamChapter(zip, entries[i])) {
+      std::cerr << "FAIL content of " << entries[i].name << " without a session\n";
+      failures++;
+    }
+    total.opens += zip.getStats().opens;
+    total.seeks += zip.getStats().seeks;
+    total.eocdReads += zip.getStats().eocdReads;
+  }
+  printStats("fresh ZipFile per chapter", total, chapters);
+  if (total.eocdReads != static_cast<uint32_t>(chapters)) {
+    std::cerr << "FAIL expected every fresh ZipFile to parse the EOCD\n";
+    failures++;
+  }
+  return failures;
+}
+}  // namespace
+
+int main() {
+  char dirTemplate[] = "/tmp/zip_session_XXXXXX";
+  const char* dir = mkdtemp(dirTemplate);
+  if (!dir) {
+    std::cerr << "Could not create temp dir\n";
+    return 1;
+  }
+  SdMan.setRoot(dir);
+  const std::string hostEpubPath = std::string(dir) + EPUB_PATH;
+
+  const auto entries = buildEntries();
+  if (!writeZip(hostEpubPath, entries)) {
+    std::cerr << "Could not write test zip\n";
+    return 1;
+  }
+
+  // First session builds the index, the second finds it on the card like a session after waking up
+  int failures = checkSession(entries, "session building the index");
+  failures += checkSession(entries, "session reusing the index");
+  failures += checkFreshPerChapter(entries);
+
+  // An archive comment hides the EOCD from the fast tail read, the fallback scan still has to find it
+  if (!writeZip(hostEpubPath, entries, std::string(300, 'c'))) {
+    std::cerr << "Could not write commented test zip\n";
+    return 1;
+  }
+  failures += checkSession(entries, "session on a zip with a comment");
+
+  SdMan.remove(EPUB_PATH.c_str());
+  SdMan.remove(INDEX_PATH.c_str());
+  rmdir(dir);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All zip session checks passed\n";
+  return 0;
+}